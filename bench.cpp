@@ -0,0 +1,546 @@
+#include "intrusive_list.h"
+#include "bench_utils.h"
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <new>
+
+#if defined(INTRUSIVE_LIST_BENCH_WITH_BOOST)
+#include <boost/intrusive/list.hpp>
+#endif
+
+/*
+Сравнение intrusive::list с std::list и с Boost.Intrusive (auto-unlink и
+normal хуки). Для всех реализаций порядок элементов в списке -- случайная
+перестановка их порядка в памяти, иначе обход большого списка был бы
+последовательным чтением и ничего не говорил бы про промахи по кешу.
+*/
+namespace
+{
+    struct node : intrusive::list_element<>
+    {
+        int value = 0;
+    };
+
+    struct normal_node : intrusive::list_element<intrusive::default_tag, intrusive::normal_link>
+    {
+        int value = 0;
+    };
+
+    /*
+    Узлы побольше для сравнения расположения хука: между хуком-базой и
+    ключом лежат 64 байта холодных данных, так что каждый шаг обхода
+    читает две кеш-линии. В member-варианте хук лежит прямо перед ключом.
+    */
+    struct cold_data
+    {
+        char bytes[64];
+    };
+
+    struct base_hook_node : intrusive::list_element<>, cold_data
+    {
+        int value = 0;
+    };
+
+    struct member_hook_node
+    {
+        cold_data cold;
+        intrusive::list_element<> hook;
+        int value = 0;
+    };
+
+    using member_hook_list = intrusive::list<member_hook_node,
+                                             intrusive::member_hook<&member_hook_node::hook, offsetof(member_hook_node, hook)>>;
+
+#if defined(INTRUSIVE_LIST_BENCH_WITH_BOOST)
+    namespace bi = boost::intrusive;
+
+    struct boost_auto_node : bi::list_base_hook<bi::link_mode<bi::auto_unlink>>
+    {
+        int value = 0;
+    };
+
+    struct boost_normal_node : bi::list_base_hook<bi::link_mode<bi::normal_link>>
+    {
+        int value = 0;
+    };
+
+    using boost_auto_list = bi::list<boost_auto_node, bi::constant_time_size<false>>;
+    using boost_normal_list = bi::list<boost_normal_node, bi::constant_time_size<false>>;
+#endif
+
+    template <typename Node>
+    std::unique_ptr<Node[]> make_nodes(std::size_t n)
+    {
+        auto nodes = std::make_unique<Node[]>(n);
+        for (std::size_t i = 0; i != n; ++i)
+            nodes[i].value = int(i);
+        return nodes;
+    }
+
+    /*
+    Сырая память под узлы для бенчмарка деструкторов: узлы создаются
+    placement new и разрушаются вручную в случайном порядке.
+    */
+    template <typename Node>
+    struct node_storage
+    {
+        explicit node_storage(std::size_t n)
+            : data(static_cast<Node*>(::operator new(n * sizeof(Node))))
+            , n(n)
+        {}
+
+        ~node_storage()
+        {
+            ::operator delete(data);
+        }
+
+        Node* construct()
+        {
+            for (std::size_t i = 0; i != n; ++i)
+                new (data + i) Node();
+            return data;
+        }
+
+        Node* data;
+        std::size_t n;
+    };
+
+    template <typename List>
+    long long sum_forward(List const& list)
+    {
+        long long sum = 0;
+        for (auto i = list.begin(); i != list.end(); ++i)
+            sum += i->value;
+        return sum;
+    }
+
+    template <typename List>
+    long long sum_reverse(List const& list)
+    {
+        long long sum = 0;
+        for (auto i = list.end(); i != list.begin();)
+        {
+            --i;
+            sum += i->value;
+        }
+        return sum;
+    }
+
+    /*
+    Бенчмарки для интрузивных списков. intrusive::list и
+    boost::intrusive::list имеют одинаковый интерфейс для этих
+    операций, поэтому код общий.
+    */
+    template <typename List, typename Node>
+    struct intrusive_suite
+    {
+        static void push_back(char const* impl, std::size_t n)
+        {
+            auto nodes = make_nodes<Node>(n);
+            auto order = bench::shuffled_indices(n);
+            List list;
+            auto r = bench::measure(n, [&] { list.clear(); }, [&] {
+                for (std::size_t i : order)
+                    list.push_back(nodes[i]);
+            });
+            bench::report("push_back", impl, n, r);
+            list.clear();
+        }
+
+        static void queue(char const* impl, std::size_t n)
+        {
+            auto nodes = make_nodes<Node>(n);
+            auto order = bench::shuffled_indices(n);
+            List list;
+            for (std::size_t i : order)
+                list.push_back(nodes[i]);
+            auto r = bench::measure(n, [] {}, [&] {
+                for (std::size_t i = 0; i != n; ++i)
+                {
+                    Node& x = list.front();
+                    list.pop_front();
+                    list.push_back(x);
+                }
+            });
+            bench::report("pop_front+push_back", impl, n, r);
+            list.clear();
+        }
+
+        static void insert(char const* impl, std::size_t n)
+        {
+            std::size_t half = n / 2;
+            auto nodes = make_nodes<Node>(n);
+            auto order = bench::shuffled_indices(half);
+            std::vector<typename List::iterator> its(half);
+            List list;
+            auto r = bench::measure(half, [&] {
+                list.clear();
+                for (std::size_t i : order)
+                    its[i] = list.insert(list.end(), nodes[i]);
+            }, [&] {
+                for (std::size_t i = 0; i != half; ++i)
+                    list.insert(its[i], nodes[half + i]);
+            });
+            bench::report("insert", impl, n, r);
+            list.clear();
+        }
+
+        static void erase(char const* impl, std::size_t n)
+        {
+            auto nodes = make_nodes<Node>(n);
+            auto link_order = bench::shuffled_indices(n, 1);
+            auto erase_order = bench::shuffled_indices(n, 2);
+            std::vector<typename List::iterator> its(n);
+            List list;
+            auto r = bench::measure(n, [&] {
+                list.clear();
+                for (std::size_t i : link_order)
+                    its[i] = list.insert(list.end(), nodes[i]);
+            }, [&] {
+                for (std::size_t i : erase_order)
+                    list.erase(its[i]);
+            });
+            bench::report("erase", impl, n, r);
+        }
+
+        static void splice(char const* impl, std::size_t n)
+        {
+            auto nodes = make_nodes<Node>(n);
+            auto order = bench::shuffled_indices(n);
+            List a, b;
+            for (std::size_t i : order)
+                a.push_back(nodes[i]);
+            auto r = bench::measure(n, [&] {
+                a.splice(a.end(), b, b.begin(), b.end());
+            }, [&] {
+                for (std::size_t i = 0; i != n; ++i)
+                    b.splice(b.end(), a, a.begin(), std::next(a.begin()));
+            });
+            bench::report("splice", impl, n, r);
+            a.clear();
+            b.clear();
+        }
+
+        static void clear(char const* impl, std::size_t n)
+        {
+            auto nodes = make_nodes<Node>(n);
+            auto order = bench::shuffled_indices(n);
+            List list;
+            auto r = bench::measure(n, [&] {
+                for (std::size_t i : order)
+                    list.push_back(nodes[i]);
+            }, [&] {
+                list.clear();
+            });
+            bench::report("clear", impl, n, r);
+        }
+
+        static void traverse(char const* impl, std::size_t n)
+        {
+            auto nodes = make_nodes<Node>(n);
+            auto order = bench::shuffled_indices(n);
+            List list;
+            for (std::size_t i : order)
+                list.push_back(nodes[i]);
+            auto fwd = bench::measure(n, [] {}, [&] {
+                bench::do_not_optimize(sum_forward(list));
+            });
+            bench::report("traverse_fwd", impl, n, fwd);
+            auto rev = bench::measure(n, [] {}, [&] {
+                bench::do_not_optimize(sum_reverse(list));
+            });
+            bench::report("traverse_rev", impl, n, rev);
+            list.clear();
+        }
+
+        /*
+        Разрушение связанных элементов. Для auto-unlink хуков деструктор
+        сам выполняет unlink. Normal хуки этого не делают, поэтому для них
+        сначала вызывается clear() и замеряется суммарная стоимость.
+        */
+        template <bool AutoUnlink>
+        static void destroy(char const* impl, std::size_t n)
+        {
+            node_storage<Node> storage(n);
+            auto link_order = bench::shuffled_indices(n, 1);
+            auto destroy_order = bench::shuffled_indices(n, 2);
+            List list;
+            Node* nodes = nullptr;
+            auto r = bench::measure(n, [&] {
+                nodes = storage.construct();
+                for (std::size_t i : link_order)
+                    list.push_back(nodes[i]);
+            }, [&] {
+                if (!AutoUnlink)
+                    list.clear();
+                for (std::size_t i : destroy_order)
+                    nodes[i].~Node();
+            });
+            bench::report("destroy", impl, n, r);
+        }
+    };
+
+    /*
+    std::list хранит значения сам, поэтому каждая вставка аллоцирует,
+    а каждое удаление освобождает память. Чтобы порядок в списке не
+    совпадал с порядком в памяти, список после заполнения "перемешивается"
+    через sort(), который только перевязывает узлы.
+    */
+    struct payload
+    {
+        int value;
+    };
+
+    using std_list = std::list<payload>;
+
+    void fill_shuffled(std_list& list, std::size_t n, std::vector<std::size_t> const& order,
+                       std::vector<std_list::iterator>* its = nullptr)
+    {
+        list.clear();
+        for (std::size_t i = 0; i != n; ++i)
+        {
+            auto it = list.insert(list.end(), payload{int(i)});
+            if (its)
+                (*its)[i] = it;
+        }
+
+        std::vector<std::size_t> rank(n);
+        for (std::size_t k = 0; k != n; ++k)
+            rank[order[k]] = k;
+        list.sort([&](payload const& a, payload const& b) {
+            return rank[a.value] < rank[b.value];
+        });
+    }
+
+    struct std_suite
+    {
+        static void push_back(char const* impl, std::size_t n)
+        {
+            auto order = bench::shuffled_indices(n);
+            std_list list;
+            auto r = bench::measure(n, [&] { list.clear(); }, [&] {
+                for (std::size_t i : order)
+                    list.push_back(payload{int(i)});
+            });
+            bench::report("push_back", impl, n, r);
+        }
+
+        static void queue(char const* impl, std::size_t n)
+        {
+            std_list list;
+            fill_shuffled(list, n, bench::shuffled_indices(n));
+            auto r = bench::measure(n, [] {}, [&] {
+                for (std::size_t i = 0; i != n; ++i)
+                {
+                    payload x = list.front();
+                    list.pop_front();
+                    list.push_back(x);
+                }
+            });
+            bench::report("pop_front+push_back", impl, n, r);
+        }
+
+        static void insert(char const* impl, std::size_t n)
+        {
+            std::size_t half = n / 2;
+            auto order = bench::shuffled_indices(half);
+            std::vector<std_list::iterator> its(half);
+            std_list list;
+            auto r = bench::measure(half, [&] {
+                fill_shuffled(list, half, order, &its);
+            }, [&] {
+                for (std::size_t i = 0; i != half; ++i)
+                    list.insert(its[i], payload{int(half + i)});
+            });
+            bench::report("insert", impl, n, r);
+        }
+
+        static void erase(char const* impl, std::size_t n)
+        {
+            auto link_order = bench::shuffled_indices(n, 1);
+            auto erase_order = bench::shuffled_indices(n, 2);
+            std::vector<std_list::iterator> its(n);
+            std_list list;
+            auto r = bench::measure(n, [&] {
+                fill_shuffled(list, n, link_order, &its);
+            }, [&] {
+                for (std::size_t i : erase_order)
+                    list.erase(its[i]);
+            });
+            bench::report("erase", impl, n, r);
+        }
+
+        static void splice(char const* impl, std::size_t n)
+        {
+            std_list a, b;
+            fill_shuffled(a, n, bench::shuffled_indices(n));
+            auto r = bench::measure(n, [&] {
+                a.splice(a.end(), b);
+            }, [&] {
+                for (std::size_t i = 0; i != n; ++i)
+                    b.splice(b.end(), a, a.begin());
+            });
+            bench::report("splice", impl, n, r);
+        }
+
+        static void clear(char const* impl, std::size_t n)
+        {
+            auto order = bench::shuffled_indices(n);
+            std_list list;
+            auto r = bench::measure(n, [&] {
+                fill_shuffled(list, n, order);
+            }, [&] {
+                list.clear();
+            });
+            bench::report("clear", impl, n, r);
+        }
+
+        static void traverse(char const* impl, std::size_t n)
+        {
+            std_list list;
+            fill_shuffled(list, n, bench::shuffled_indices(n));
+            auto fwd = bench::measure(n, [] {}, [&] {
+                bench::do_not_optimize(sum_forward(list));
+            });
+            bench::report("traverse_fwd", impl, n, fwd);
+            auto rev = bench::measure(n, [] {}, [&] {
+                bench::do_not_optimize(sum_reverse(list));
+            });
+            bench::report("traverse_rev", impl, n, rev);
+        }
+    };
+
+    using intrusive_list_suite = intrusive_suite<intrusive::list<node>, node>;
+    using intrusive_normal_suite = intrusive_suite<intrusive::list<normal_node>, normal_node>;
+#if defined(INTRUSIVE_LIST_BENCH_WITH_BOOST)
+    using boost_auto_suite = intrusive_suite<boost_auto_list, boost_auto_node>;
+    using boost_normal_suite = intrusive_suite<boost_normal_list, boost_normal_node>;
+#endif
+
+    template <typename F>
+    void for_each_impl(F f)
+    {
+        f(intrusive_list_suite(), "intrusive");
+        f(intrusive_normal_suite(), "intrusive_normal");
+        f(std_suite(), "std::list");
+#if defined(INTRUSIVE_LIST_BENCH_WITH_BOOST)
+        f(boost_auto_suite(), "boost_auto_unlink");
+        f(boost_normal_suite(), "boost_normal_link");
+#endif
+    }
+}
+
+BENCHMARK(push_back)
+{
+    for_each_impl([n](auto suite, char const* impl) { suite.push_back(impl, n); });
+}
+
+BENCHMARK(pop_front_push_back)
+{
+    for_each_impl([n](auto suite, char const* impl) { suite.queue(impl, n); });
+}
+
+BENCHMARK(insert)
+{
+    for_each_impl([n](auto suite, char const* impl) { suite.insert(impl, n); });
+}
+
+BENCHMARK(erase)
+{
+    for_each_impl([n](auto suite, char const* impl) { suite.erase(impl, n); });
+}
+
+BENCHMARK(splice)
+{
+    for_each_impl([n](auto suite, char const* impl) { suite.splice(impl, n); });
+}
+
+BENCHMARK(clear)
+{
+    for_each_impl([n](auto suite, char const* impl) { suite.clear(impl, n); });
+}
+
+BENCHMARK(traverse)
+{
+    for_each_impl([n](auto suite, char const* impl) { suite.traverse(impl, n); });
+}
+
+BENCHMARK(traverse_hook_placement)
+{
+    intrusive_suite<intrusive::list<base_hook_node>, base_hook_node>::traverse("base_hook", n);
+    intrusive_suite<member_hook_list, member_hook_node>::traverse("member_hook", n);
+}
+
+/*
+Для std::list аналогом разрушения элемента является erase, он уже
+замерен выше, поэтому здесь только интрузивные списки.
+*/
+BENCHMARK(destroy)
+{
+    intrusive_list_suite::destroy<true>("intrusive", n);
+    intrusive_normal_suite::destroy<false>("intrusive_normal", n);
+#if defined(INTRUSIVE_LIST_BENCH_WITH_BOOST)
+    boost_auto_suite::destroy<true>("boost_auto_unlink", n);
+    boost_normal_suite::destroy<false>("boost_normal_link", n);
+#endif
+}
+
+/*
+Сортировка перевязыванием узлов против распространенного обходного
+пути: собрать указатели в вектор, отсортировать его и пересобрать
+список. Ключи -- случайная перестановка, не совпадающая ни с порядком
+в памяти, ни с исходным порядком в списке.
+*/
+BENCHMARK(sort)
+{
+    auto nodes = make_nodes<node>(n);
+    auto keys = bench::shuffled_indices(n, 3);
+    for (std::size_t i = 0; i != n; ++i)
+        nodes[i].value = int(keys[i]);
+    auto order = bench::shuffled_indices(n);
+    auto less = [](node const& a, node const& b) { return a.value < b.value; };
+
+    intrusive::list<node> list;
+    auto refill = [&] {
+        list.clear();
+        for (std::size_t i : order)
+            list.push_back(nodes[i]);
+    };
+
+    auto relink = bench::measure(n, refill, [&] {
+        list.sort(less);
+    });
+    bench::report("sort", "intrusive", n, relink);
+
+    std::vector<node*> gathered;
+    gathered.reserve(n);
+    auto gather = bench::measure(n, refill, [&] {
+        gathered.clear();
+        for (node& x : list)
+            gathered.push_back(&x);
+        std::sort(gathered.begin(), gathered.end(), [](node* a, node* b) { return a->value < b->value; });
+        list.clear();
+        for (node* x : gathered)
+            list.push_back(*x);
+    });
+    bench::report("sort", "vector_gather", n, gather);
+    list.clear();
+
+    std_list slist;
+    auto std_sort = bench::measure(n, [&] {
+        slist.clear();
+        for (std::size_t i : order)
+            slist.push_back(payload{int(keys[i])});
+    }, [&] {
+        slist.sort([](payload const& a, payload const& b) { return a.value < b.value; });
+    });
+    bench::report("sort", "std::list", n, std_sort);
+}
+
+int main(int argc, char** argv)
+{
+    return bench::run_registered(argc, argv);
+}
@@ -0,0 +1,124 @@
+#include "intrusive_concurrent_list.h"
+#include "bench_utils.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+8 читателей обходят список, пока один писатель выкидывает случайный
+элемент и кладет его обратно в конец. concurrent_list сравнивается с
+intrusive::list под одним std::mutex. Все потоки работают одинаковое
+время, после чего печатаются две строки: время, деленное на количество
+операций писателя, и время, деленное на количество элементов,
+пройденных всеми читателями вместе.
+*/
+namespace
+{
+    struct cnode : intrusive::concurrent_list_element<>
+    {
+        int value = 0;
+    };
+
+    struct node : intrusive::list_element<>
+    {
+        int value = 0;
+    };
+
+    constexpr int readers = 8;
+    constexpr auto duration = std::chrono::milliseconds(200);
+    constexpr std::size_t max_items = std::size_t(1) << 16;
+
+    template <typename Traverse, typename Churn>
+    void run_mix(char const* impl, std::size_t n, Traverse traverse, Churn churn)
+    {
+        using clock = std::chrono::steady_clock;
+
+        std::atomic<bool> done{false};
+        std::atomic<std::size_t> visited{0};
+        std::vector<std::thread> threads;
+        for (int r = 0; r != readers; ++r)
+            threads.emplace_back([&] {
+                std::size_t local = 0;
+                while (!done.load(std::memory_order_relaxed))
+                    local += traverse();
+                visited.fetch_add(local);
+            });
+
+        auto order = bench::shuffled_indices(n);
+        auto start = clock::now();
+        std::size_t ops = 0;
+        for (; clock::now() - start < duration; ++ops)
+            churn(order[ops % n]);
+        auto elapsed = clock::now() - start;
+        done.store(true);
+        for (auto& t : threads)
+            t.join();
+
+        double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+        bench::report("rw_mix_writer", impl, n, {ns / ops, 0., 0., false});
+        std::size_t v = visited.load();
+        bench::report("rw_mix_reader", impl, n, {v != 0 ? ns / v : 0., 0., 0., false});
+    }
+}
+
+BENCHMARK(rw_mix)
+{
+    if (n > max_items)
+        return;
+
+    {
+        auto nodes = std::make_unique<cnode[]>(n);
+        intrusive::concurrent_list<cnode> list;
+        for (std::size_t i = 0; i != n; ++i)
+        {
+            nodes[i].value = int(i);
+            list.push_back(nodes[i]);
+        }
+
+        run_mix("concurrent_list", n, [&] {
+            std::size_t count = 0;
+            long long sum = 0;
+            list.for_each([&](cnode& x) {
+                sum += x.value;
+                ++count;
+            });
+            bench::do_not_optimize(sum);
+            return count;
+        }, [&](std::size_t i) {
+            list.erase(nodes[i]);
+            list.push_back(nodes[i]);
+        });
+    }
+
+    {
+        auto nodes = std::make_unique<node[]>(n);
+        intrusive::list<node> list;
+        std::mutex mutex;
+        for (std::size_t i = 0; i != n; ++i)
+        {
+            nodes[i].value = int(i);
+            list.push_back(nodes[i]);
+        }
+
+        run_mix("mutex_list", n, [&] {
+            std::size_t count = 0;
+            long long sum = 0;
+            std::lock_guard<std::mutex> lock(mutex);
+            for (node const& x : list)
+            {
+                sum += x.value;
+                ++count;
+            }
+            bench::do_not_optimize(sum);
+            return count;
+        }, [&](std::size_t i) {
+            std::lock_guard<std::mutex> lock(mutex);
+            nodes[i].unlink();
+            list.push_back(nodes[i]);
+        });
+        list.clear();
+    }
+}
@@ -0,0 +1,135 @@
+#include "intrusive_lazy_list.h"
+#include "intrusive_concurrent_list.h"
+#include "intrusive_list.h"
+#include "bench_utils.h"
+#include <memory>
+#include <thread>
+#include <vector>
+
+/*
+Отмена половины элементов списка из n элементов в случайном порядке и
+следующий за ней обход списка: list_element::unlink(),
+concurrent_list_element::unlink() (лок и запись в соседей) и
+lazy_list_element::unlink() (пометка), после которой мертвые
+выкидывает for_each. ns/op -- на одну отмену вместе с ее долей обхода.
+
+lazy_cancel_threads -- то же самое, только отменяют 4 потока, а
+обходит список основной поток после того, как они закончили. Выигрыш
+от того, что отменяющие не пишут в соседей, виден только на
+нескольких ядрах.
+*/
+namespace
+{
+    struct node : intrusive::list_element<>
+    {
+        std::size_t value = 0;
+    };
+
+    struct cnode : intrusive::concurrent_list_element<>
+    {
+        std::size_t value = 0;
+    };
+
+    struct lnode : intrusive::lazy_list_element<>
+    {
+        std::size_t value = 0;
+    };
+
+    constexpr unsigned cancel_threads = 4;
+
+    template <typename F>
+    void run_cancellers(std::vector<std::size_t> const& victims, F cancel)
+    {
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t != cancel_threads; ++t)
+            threads.emplace_back([&, t] {
+                for (std::size_t i = t; i < victims.size(); i += cancel_threads)
+                    cancel(victims[i]);
+            });
+        for (std::thread& t : threads)
+            t.join();
+    }
+}
+
+BENCHMARK(lazy_list)
+{
+    auto order = bench::shuffled_indices(n, 31);
+    std::vector<std::size_t> victims(order.begin(), order.begin() + std::ptrdiff_t(n / 2));
+    std::size_t ops = victims.size() != 0 ? victims.size() : 1;
+
+    {
+        auto nodes = std::make_unique<node[]>(n);
+        intrusive::list<node> list;
+        auto setup = [&] {
+            list.clear();
+            for (std::size_t i = 0; i != n; ++i)
+                list.push_back(nodes[i]);
+        };
+        auto r = bench::measure(ops, setup, [&] {
+            for (std::size_t i : victims)
+                nodes[i].unlink();
+            std::size_t sum = 0;
+            for (node const& x : list)
+                sum += x.value;
+            bench::do_not_optimize(sum);
+        });
+        bench::report("lazy_cancel", "list_element", n, r);
+        list.clear();
+    }
+
+    {
+        auto nodes = std::make_unique<cnode[]>(n);
+        intrusive::concurrent_list<cnode> list;
+        auto setup = [&] {
+            list.clear();
+            for (std::size_t i = 0; i != n; ++i)
+                list.push_back(nodes[i]);
+        };
+        auto walk = [&] {
+            std::size_t sum = 0;
+            list.for_each([&](cnode const& x) { sum += x.value; });
+            bench::do_not_optimize(sum);
+        };
+        auto r = bench::measure(ops, setup, [&] {
+            for (std::size_t i : victims)
+                nodes[i].unlink();
+            walk();
+        });
+        bench::report("lazy_cancel", "concurrent_list", n, r);
+
+        r = bench::measure(ops, setup, [&] {
+            run_cancellers(victims, [&](std::size_t i) { nodes[i].unlink(); });
+            walk();
+        });
+        bench::report("lazy_cancel_threads", "concurrent_list", n, r);
+        list.clear();
+    }
+
+    {
+        auto nodes = std::make_unique<lnode[]>(n);
+        intrusive::lazy_list<lnode> list;
+        auto setup = [&] {
+            list.clear();
+            for (std::size_t i = 0; i != n; ++i)
+                list.push_back(nodes[i]);
+        };
+        auto walk = [&] {
+            std::size_t sum = 0;
+            list.for_each([&](lnode const& x) { sum += x.value; });
+            bench::do_not_optimize(sum);
+        };
+        auto r = bench::measure(ops, setup, [&] {
+            for (std::size_t i : victims)
+                nodes[i].unlink();
+            walk();
+        });
+        bench::report("lazy_cancel", "lazy_list", n, r);
+
+        r = bench::measure(ops, setup, [&] {
+            run_cancellers(victims, [&](std::size_t i) { nodes[i].unlink(); });
+            walk();
+        });
+        bench::report("lazy_cancel_threads", "lazy_list", n, r);
+        list.clear();
+    }
+}
@@ -0,0 +1,70 @@
+#include "intrusive_list_elements.h"
+#include "bench_utils.h"
+#include <new>
+#include <vector>
+
+/*
+Удаление в случайном порядке n объектов, каждый из которых лежит в
+трех списках: три базы list_element<Tag> против одного
+list_elements<Tags...>. ns/op -- на один деструктор со всеми тремя
+отвязками.
+*/
+namespace
+{
+    struct tag_a;
+    struct tag_b;
+    struct tag_c;
+
+    struct separate_node : intrusive::list_element<tag_a>, intrusive::list_element<tag_b>, intrusive::list_element<tag_c>
+    {
+        std::size_t value = 0;
+    };
+
+    struct bundled_node : intrusive::list_elements<tag_a, tag_b, tag_c>
+    {
+        std::size_t value = 0;
+    };
+
+    struct aligned_node : intrusive::basic_list_elements<64, tag_a, tag_b, tag_c>
+    {
+        std::size_t value = 0;
+    };
+
+    template <typename Node>
+    void destroy_linked(char const* impl, std::size_t n)
+    {
+        auto order = bench::shuffled_indices(n, 53);
+        auto victims = bench::shuffled_indices(n, 59);
+        std::size_t ops = n != 0 ? n : 1;
+
+        auto* nodes = static_cast<Node*>(operator new(ops * sizeof(Node), std::align_val_t(alignof(Node))));
+        intrusive::list<Node, tag_a> list_a;
+        intrusive::list<Node, tag_b> list_b;
+        intrusive::list<Node, tag_c> list_c;
+
+        auto setup = [&] {
+            for (std::size_t i = 0; i != n; ++i)
+                new (&nodes[i]) Node();
+            for (std::size_t i : order)
+            {
+                list_a.push_back(nodes[i]);
+                list_b.push_front(nodes[i]);
+            }
+            for (std::size_t i = 0; i != n; ++i)
+                list_c.push_back(nodes[order[n - 1 - i]]);
+        };
+        auto r = bench::measure(ops, setup, [&] {
+            for (std::size_t i : victims)
+                nodes[i].~Node();
+        });
+        bench::report("destroy_3_tags", impl, n, r);
+        operator delete(nodes, std::align_val_t(alignof(Node)));
+    }
+}
+
+BENCHMARK(list_elements)
+{
+    destroy_linked<separate_node>("list_element x3", n);
+    destroy_linked<bundled_node>("list_elements", n);
+    destroy_linked<aligned_node>("list_elements<64>", n);
+}
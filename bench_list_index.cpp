@@ -0,0 +1,99 @@
+#include "intrusive_list_index.h"
+#include "bench_utils.h"
+#include <iterator>
+#include <memory>
+#include <random>
+#include <vector>
+
+/*
+Позиционный доступ к списку из n элементов: list_index против
+std::next от begin().
+
+index_nth -- k-й элемент для случайного k, index_split -- отрезать
+вторую половину списка в другой список (splice'ом с известным
+размером, как и в list_index::split_at), index_insert_at -- вставка на
+случайную позицию. Для std::next каждая операция -- это обход в
+среднем половины списка, поэтому запросов немного: ns/op -- на один
+запрос.
+*/
+namespace
+{
+    struct node : intrusive::list_element<>
+    {
+        std::size_t value = 0;
+    };
+
+    using node_list = intrusive::list<node>;
+    using index_type = intrusive::list_index<node_list>;
+
+    constexpr std::size_t queries = 256;
+}
+
+BENCHMARK(list_index)
+{
+    auto nodes = std::make_unique<node[]>(n + queries);
+    node_list list;
+    for (std::size_t i = 0; i != n; ++i)
+        list.push_back(nodes[i]);
+
+    std::mt19937 rng(23);
+    std::vector<std::size_t> positions(queries);
+    for (std::size_t& k : positions)
+        k = rng() % n;
+
+    index_type index(list);
+
+    auto r = bench::measure(queries, [] {}, [&] {
+        for (std::size_t k : positions)
+            bench::do_not_optimize(&*std::next(list.begin(), std::ptrdiff_t(k)));
+    });
+    bench::report("index_nth", "std::next", n, r);
+
+    r = bench::measure(queries, [] {}, [&] {
+        for (std::size_t k : positions)
+            bench::do_not_optimize(&*index.nth(k));
+    });
+    bench::report("index_nth", "list_index", n, r);
+
+    node_list rest;
+    auto rejoin = [&] {
+        list.splice(list.end(), rest, rest.begin(), rest.end());
+        index.invalidate();
+        index.size();
+    };
+
+    r = bench::measure(1, rejoin, [&] {
+        auto middle = std::next(list.begin(), std::ptrdiff_t(n / 2));
+        rest.splice(rest.end(), list, middle, list.end(), n - n / 2);
+    });
+    bench::report("index_split", "std::next", n, r);
+
+    r = bench::measure(1, rejoin, [&] {
+        index.split_at(n / 2, rest);
+    });
+    bench::report("index_split", "list_index", n, r);
+    rejoin();
+
+    auto unlink_extra = [&] {
+        for (std::size_t i = n; i != n + queries; ++i)
+            if (nodes[i].is_linked())
+                nodes[i].unlink();
+        index.invalidate();
+        index.size();
+    };
+
+    r = bench::measure(queries, unlink_extra, [&] {
+        for (std::size_t i = 0; i != queries; ++i)
+            list.insert(std::next(list.begin(), std::ptrdiff_t(positions[i])), nodes[n + i]);
+    });
+    bench::report("index_insert_at", "std::next", n, r);
+
+    r = bench::measure(queries, unlink_extra, [&] {
+        for (std::size_t i = 0; i != queries; ++i)
+            index.insert_at(positions[i], nodes[n + i]);
+    });
+    bench::report("index_insert_at", "list_index", n, r);
+    unlink_extra();
+
+    list.clear();
+}
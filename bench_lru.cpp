@@ -0,0 +1,75 @@
+#include "intrusive_lru_cache.h"
+#include "bench_utils.h"
+#include <memory>
+#include <unordered_map>
+
+/*
+Попадания в кеш из n элементов в случайном порядке. lru_cache в LRU и
+CLOCK режимах сравнивается с тем, что было раньше: std::unordered_map
+от ключа к узлу и intrusive::list, в которой попадание -- unlink() +
+push_front().
+*/
+namespace
+{
+    struct entry : intrusive::lru_cache_element<>
+    {
+        int key = 0;
+    };
+
+    struct node : intrusive::list_element<>
+    {
+        int key = 0;
+    };
+
+    using lru = intrusive::lru_cache<int, entry>;
+    using clock_lru = intrusive::lru_cache<int, entry, intrusive::default_tag, intrusive::clock_replacement>;
+
+    template <typename Cache>
+    void bench_cache(char const* impl, std::size_t n)
+    {
+        auto entries = std::make_unique<entry[]>(n);
+        Cache cache(n);
+        for (std::size_t i = 0; i != n; ++i)
+        {
+            entries[i].key = int(i);
+            cache.insert(entries[i]);
+        }
+
+        auto order = bench::shuffled_indices(n, 7);
+        auto r = bench::measure(n, [] {}, [&] {
+            for (std::size_t i : order)
+                bench::do_not_optimize(cache.find(int(i)));
+        });
+        bench::report("cache_hit", impl, n, r);
+        cache.clear_and_dispose([](entry*) {});
+    }
+}
+
+BENCHMARK(cache_hit)
+{
+    bench_cache<lru>("lru_cache", n);
+    bench_cache<clock_lru>("lru_cache_clock", n);
+
+    auto nodes = std::make_unique<node[]>(n);
+    intrusive::list<node> recency;
+    std::unordered_map<int, node*> index;
+    index.reserve(n);
+    for (std::size_t i = 0; i != n; ++i)
+    {
+        nodes[i].key = int(i);
+        recency.push_front(nodes[i]);
+        index.emplace(int(i), &nodes[i]);
+    }
+
+    auto order = bench::shuffled_indices(n, 7);
+    auto r = bench::measure(n, [] {}, [&] {
+        for (std::size_t i : order)
+        {
+            node* p = index.find(int(i))->second;
+            p->unlink();
+            recency.push_front(*p);
+            bench::do_not_optimize(p);
+        }
+    });
+    bench::report("cache_hit", "unordered_map+list", n, r);
+}
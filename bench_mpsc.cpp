@@ -0,0 +1,122 @@
+#include "intrusive_mpsc_queue.h"
+#include "bench_utils.h"
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+Пропускная способность очереди от producer'ов к одному consumer'у:
+mpsc_queue с try_pop и с drain против того, что было раньше, --
+intrusive::list под мьютексом, из которого consumer забирает всё
+разом через splice. Время включает запуск и join потоков producer'ов,
+поэтому маленькие размеры не меряются.
+*/
+namespace
+{
+    struct item : intrusive::list_element<>
+    {
+        int value = 0;
+    };
+
+    constexpr std::size_t producer_counts[] = {1, 2, 4, 8, 16, 32, 64};
+    constexpr std::size_t min_items = std::size_t(1) << 16;
+
+    template <typename Produce, typename Consume>
+    void run_threads(std::size_t producers, std::size_t n, item* items, Produce produce, Consume consume)
+    {
+        std::vector<std::thread> threads;
+        threads.reserve(producers);
+        for (std::size_t p = 0; p != producers; ++p)
+            threads.emplace_back([=] {
+                for (std::size_t i = p; i < n; i += producers)
+                    produce(items[i]);
+            });
+
+        std::size_t received = 0;
+        while (received != n)
+        {
+            std::size_t got = consume();
+            if (got == 0)
+                std::this_thread::yield();
+            received += got;
+        }
+
+        for (auto& t : threads)
+            t.join();
+    }
+
+    std::size_t consume_batch(intrusive::list<item>& batch)
+    {
+        std::size_t n = 0;
+        long long sum = 0;
+        for (item const& x : batch)
+        {
+            sum += x.value;
+            ++n;
+        }
+        bench::do_not_optimize(sum);
+        batch.clear();
+        return n;
+    }
+}
+
+BENCHMARK(mpsc)
+{
+    if (n < min_items)
+        return;
+
+    auto items = std::make_unique<item[]>(n);
+    for (std::size_t i = 0; i != n; ++i)
+        items[i].value = int(i);
+
+    for (std::size_t producers : producer_counts)
+    {
+        char group[32];
+        std::snprintf(group, sizeof group, "mpsc_%zup", producers);
+
+        intrusive::mpsc_queue<item> queue;
+        auto pop = bench::measure(n, [] {}, [&] {
+            run_threads(producers, n, items.get(),
+                [&](item& x) { queue.push(x); },
+                [&]() -> std::size_t {
+                    item* x = queue.try_pop();
+                    if (x == nullptr)
+                        return 0;
+                    bench::do_not_optimize(x->value);
+                    return 1;
+                });
+        });
+        bench::report(group, "mpsc_try_pop", n, pop);
+
+        intrusive::list<item> batch;
+        auto drain = bench::measure(n, [] {}, [&] {
+            run_threads(producers, n, items.get(),
+                [&](item& x) { queue.push(x); },
+                [&] {
+                    queue.drain(batch);
+                    return consume_batch(batch);
+                });
+        });
+        bench::report(group, "mpsc_drain", n, drain);
+
+        std::mutex mutex;
+        intrusive::list<item> shared;
+        auto locked = bench::measure(n, [] {}, [&] {
+            run_threads(producers, n, items.get(),
+                [&](item& x) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    shared.push_back(x);
+                },
+                [&] {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        batch.splice(batch.end(), shared, shared.begin(), shared.end());
+                    }
+                    return consume_batch(batch);
+                });
+        });
+        bench::report(group, "mutex_list", n, locked);
+    }
+}
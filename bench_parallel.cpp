@@ -0,0 +1,110 @@
+#include "intrusive_parallel.h"
+#include "intrusive_list_index.h"
+#include "bench_utils.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+/*
+Пересчет данных каждой ноды списка из n нод, связанных в случайном
+порядке: обычный цикл против parallel::for_each на 1, 2, 4 и
+default_threads() потоках, тот же for_each с границами из list_index
+и parallel::transform_reduce.
+
+parallel_split -- только поиск границ диапазонов: обход списка
+(split_ranges по списку) и через list_index. Это последовательная часть
+parallel::for_each, которая не ускоряется потоками. ns/op -- на один
+элемент.
+*/
+namespace
+{
+    struct node : intrusive::list_element<>
+    {
+        std::uint64_t words[7] = {};
+    };
+
+    using node_list = intrusive::list<node>;
+
+    void recompute(node& x) noexcept
+    {
+        std::uint64_t h = x.words[0];
+        for (int round = 0; round != 4; ++round)
+            for (std::uint64_t& w : x.words)
+            {
+                h = (h ^ w) * 0x100000001b3ull;
+                w = h;
+            }
+    }
+}
+
+BENCHMARK(parallel)
+{
+    auto nodes = std::make_unique<node[]>(n);
+    auto order = bench::shuffled_indices(n, 5);
+    node_list list;
+    for (std::size_t i : order)
+    {
+        nodes[i].words[0] = i;
+        list.push_back(nodes[i]);
+    }
+
+    auto r = bench::measure(n, [] {}, [&] {
+        for (node& x : list)
+            recompute(x);
+    });
+    bench::report("parallel_for_each", "loop", n, r);
+
+    struct variant
+    {
+        char const* name;
+        std::size_t threads;
+    };
+    variant const variants[] = {
+        {"threads_1", 1},
+        {"threads_2", 2},
+        {"threads_4", 4},
+        {"threads_all", intrusive::parallel::default_threads()},
+    };
+
+    for (variant const& v : variants)
+    {
+        r = bench::measure(n, [] {}, [&] {
+            intrusive::parallel::for_each(list, recompute, v.threads);
+        });
+        bench::report("parallel_for_each", v.name, n, r);
+    }
+
+    intrusive::list_index<node_list> index(list);
+    r = bench::measure(n, [] {}, [&] {
+        intrusive::parallel::for_each(index, recompute);
+    });
+    bench::report("parallel_for_each", "threads_all_index", n, r);
+
+    r = bench::measure(n, [] {}, [&] {
+        std::uint64_t sum = 0;
+        for (node const& x : list)
+            sum += x.words[6];
+        bench::do_not_optimize(sum);
+    });
+    bench::report("parallel_reduce", "loop", n, r);
+
+    r = bench::measure(n, [] {}, [&] {
+        std::uint64_t sum = intrusive::parallel::transform_reduce(list, std::uint64_t(0), std::plus<>(),
+            [](node const& x) { return x.words[6]; });
+        bench::do_not_optimize(sum);
+    });
+    bench::report("parallel_reduce", "threads_all", n, r);
+
+    std::size_t parts = intrusive::parallel::default_threads() * intrusive::detail::chunks_per_thread;
+    r = bench::measure(n, [] {}, [&] {
+        bench::do_not_optimize(intrusive::detail::split_ranges(list, parts).size());
+    });
+    bench::report("parallel_split", "list_walk", n, r);
+
+    r = bench::measure(n, [] {}, [&] {
+        bench::do_not_optimize(intrusive::detail::split_ranges(index, parts).size());
+    });
+    bench::report("parallel_split", "list_index", n, r);
+
+    list.clear();
+}
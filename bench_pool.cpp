@@ -0,0 +1,98 @@
+#include "intrusive_object_pool.h"
+#include "intrusive_list.h"
+#include "bench_utils.h"
+#include <memory>
+#include <vector>
+
+/*
+object_pool против new/delete для узлов, которые ходят через list.
+
+pool_cycle -- создать n узлов, сложить в список и удалить их все через
+clear_and_dispose. pool_traverse -- обход списка из n узлов, между
+созданиями которых программа выделяла еще что-то (здесь 48 байт на
+узел, как строка или буфер): из malloc узлы ложатся вперемешку с этими
+кусками, а из пула -- подряд.
+*/
+namespace
+{
+    struct node : intrusive::list_element<>
+    {
+        explicit node(std::size_t value)
+            : value(value)
+        {}
+
+        std::size_t value;
+    };
+
+    struct deleter
+    {
+        void operator()(node* p) const noexcept
+        {
+            delete p;
+        }
+    };
+
+    void traverse(char const* impl, intrusive::list<node>& list, std::size_t n)
+    {
+        auto r = bench::measure(n, [] {}, [&] {
+            std::size_t sum = 0;
+            for (node const& x : list)
+                sum += x.value;
+            bench::do_not_optimize(sum);
+        });
+        bench::report("pool_traverse", impl, n, r);
+    }
+}
+
+BENCHMARK(object_pool)
+{
+    intrusive::list<node> list;
+
+    auto r = bench::measure(n, [] {}, [&] {
+        for (std::size_t i = 0; i != n; ++i)
+            list.push_back(*new node(i));
+        list.clear_and_dispose(deleter{});
+    });
+    bench::report("pool_cycle", "new/delete", n, r);
+
+    {
+        intrusive::object_pool<node> pool;
+        r = bench::measure(n, [] {}, [&] {
+            for (std::size_t i = 0; i != n; ++i)
+                list.push_back(*pool.create(i));
+            list.clear_and_dispose(pool.disposer());
+        });
+        bench::report("pool_cycle", "object_pool", n, r);
+    }
+
+    {
+        intrusive::object_pool<node, intrusive::synchronized_pool> pool;
+        intrusive::object_pool_cache<node, intrusive::synchronized_pool> cache(pool);
+        r = bench::measure(n, [] {}, [&] {
+            for (std::size_t i = 0; i != n; ++i)
+                list.push_back(*cache.create(i));
+            list.clear_and_dispose(cache.disposer());
+        });
+        bench::report("pool_cycle", "object_pool_cache", n, r);
+    }
+
+    std::vector<std::unique_ptr<char[]>> payloads;
+    payloads.reserve(n);
+    for (std::size_t i = 0; i != n; ++i)
+    {
+        list.push_back(*new node(i));
+        payloads.emplace_back(new char[48]);
+    }
+    traverse("new/delete", list, n);
+    list.clear_and_dispose(deleter{});
+    payloads.clear();
+
+    intrusive::object_pool<node> pool;
+    for (std::size_t i = 0; i != n; ++i)
+    {
+        list.push_back(*pool.create(i));
+        payloads.emplace_back(new char[48]);
+    }
+    traverse("object_pool", list, n);
+    list.clear_and_dispose(pool.disposer());
+}
@@ -0,0 +1,101 @@
+#include "intrusive_prefetch.h"
+#include "intrusive_list.h"
+#include "bench_utils.h"
+#include <cstdint>
+#include <memory>
+
+/*
+Обход списка из n нод по 128 байт, связанных в случайном порядке,
+обычным циклом по list_iterator, for_each_prefetch с разными distance и
+gather'ом пачками по 64.
+
+prefetch_scan_light -- f только читает одно поле, prefetch_scan_heavy
+-- f перемешивает все 28 слов ноды, то есть трогает обе ее строки кеша
+и делает несколько десятков тактов работы. ns/op -- на один элемент.
+*/
+namespace
+{
+    struct node : intrusive::list_element<>
+    {
+        std::uint32_t words[28] = {};
+    };
+
+    static_assert(sizeof(node) == 128, "node should take two cache lines");
+
+    using node_list = intrusive::list<node>;
+
+    struct light
+    {
+        void operator()(node const& x) noexcept
+        {
+            sum += x.words[0];
+        }
+
+        std::uint64_t sum = 0;
+    };
+
+    struct heavy
+    {
+        void operator()(node const& x) noexcept
+        {
+            std::uint64_t h = sum;
+            for (std::uint32_t w : x.words)
+                h = (h ^ w) * 0x100000001b3ull;
+            sum = h;
+        }
+
+        std::uint64_t sum = 0;
+    };
+
+    template <typename F>
+    void bench_scan(char const* group, node_list& list, std::size_t n)
+    {
+        auto r = bench::measure(n, [] {}, [&] {
+            F f;
+            for (node const& x : list)
+                f(x);
+            bench::do_not_optimize(f.sum);
+        });
+        bench::report(group, "list_iterator", n, r);
+
+        static char const* const names[] = {"prefetch_1", "prefetch_2", "prefetch_4", "prefetch_8", "prefetch_16"};
+        std::size_t distance = 1;
+        for (char const* name : names)
+        {
+            r = bench::measure(n, [] {}, [&] {
+                F f;
+                intrusive::for_each_prefetch(list, [&](node const& x) { f(x); }, distance);
+                bench::do_not_optimize(f.sum);
+            });
+            bench::report(group, name, n, r);
+            distance *= 2;
+        }
+
+        r = bench::measure(n, [] {}, [&] {
+            F f;
+            node* chunk[64];
+            auto pos = list.begin();
+            while (std::size_t got = intrusive::gather(pos, list.end(), chunk, 64))
+                for (std::size_t i = 0; i != got; ++i)
+                    f(*chunk[i]);
+            bench::do_not_optimize(f.sum);
+        });
+        bench::report(group, "gather_64", n, r);
+    }
+}
+
+BENCHMARK(prefetch)
+{
+    auto nodes = std::make_unique<node[]>(n);
+    auto order = bench::shuffled_indices(n, 13);
+    node_list list;
+    for (std::size_t i : order)
+    {
+        nodes[i].words[0] = std::uint32_t(i);
+        list.push_back(nodes[i]);
+    }
+
+    bench_scan<light>("prefetch_scan_light", list, n);
+    bench_scan<heavy>("prefetch_scan_heavy", list, n);
+    list.clear();
+}
@@ -0,0 +1,146 @@
+#include "intrusive_rcu_list.h"
+#include "bench_utils.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+Read-mostly сценарий: 1, 2, 4 и 8 читателей обходят список, один
+писатель раз в 100 мкс выкидывает элемент и кладет его обратно.
+rcu_list сравнивается с intrusive::list под std::shared_timed_mutex.
+pthread_rwlock в glibc отдает предпочтение читателям, и при нескольких
+читателях писатель может не дождаться лока вообще, поэтому он берет лок
+с таймаутом и пропускает операцию, если не дождался. Печатается
+время, деленное на количество элементов, пройденных одним читателем в
+среднем: если читатели масштабируются линейно, число не растет с
+количеством потоков (при условии, что ядер хватает на всех).
+*/
+namespace
+{
+    struct rnode : intrusive::rcu_list_element<>
+    {
+        int value = 0;
+    };
+
+    struct node : intrusive::list_element<>
+    {
+        int value = 0;
+    };
+
+    constexpr int reader_counts[] = {1, 2, 4, 8};
+    constexpr auto duration = std::chrono::milliseconds(200);
+    constexpr auto writer_pause = std::chrono::microseconds(100);
+    constexpr std::size_t max_items = std::size_t(1) << 16;
+
+    template <typename MakeTraverse, typename Churn>
+    void run_read_mostly(char const* impl, int readers, std::size_t n, MakeTraverse make_traverse, Churn churn)
+    {
+        using clock = std::chrono::steady_clock;
+
+        std::atomic<bool> done{false};
+        std::atomic<std::size_t> visited{0};
+        std::vector<std::thread> threads;
+        for (int r = 0; r != readers; ++r)
+            threads.emplace_back([&] {
+                auto traverse = make_traverse();
+                std::size_t local = 0;
+                while (!done.load(std::memory_order_relaxed))
+                    local += traverse();
+                visited.fetch_add(local);
+            });
+
+        auto order = bench::shuffled_indices(n);
+        auto start = clock::now();
+        for (std::size_t ops = 0; clock::now() - start < duration; ++ops)
+        {
+            churn(order[ops % n]);
+            std::this_thread::sleep_for(writer_pause);
+        }
+        auto elapsed = clock::now() - start;
+        done.store(true);
+        for (auto& t : threads)
+            t.join();
+
+        double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+        std::size_t per_reader = visited.load() / readers;
+        std::string name = std::string(impl) + "/" + std::to_string(readers);
+        bench::report("read_mostly_reader", name.c_str(), n, {per_reader != 0 ? ns / per_reader : 0., 0., 0., false});
+    }
+}
+
+BENCHMARK(read_mostly)
+{
+    if (n > max_items)
+        return;
+
+    for (int readers : reader_counts)
+    {
+        intrusive::rcu_domain domain;
+        auto nodes = std::make_unique<rnode[]>(n);
+        intrusive::rcu_list<rnode> list(domain);
+        for (std::size_t i = 0; i != n; ++i)
+        {
+            nodes[i].value = int(i);
+            list.push_back(nodes[i]);
+        }
+
+        run_read_mostly("rcu_list", readers, n, [&] {
+            return [&, reader = std::make_shared<intrusive::rcu_reader>(domain)] {
+                std::size_t count = 0;
+                long long sum = 0;
+                intrusive::rcu_read_guard guard(*reader);
+                for (rnode const& x : list)
+                {
+                    sum += x.value;
+                    ++count;
+                }
+                bench::do_not_optimize(sum);
+                return count;
+            };
+        }, [&](std::size_t i) {
+            list.erase(nodes[i]);
+            list.reclaim();
+            list.push_back(nodes[i]);
+        });
+        list.clear();
+        list.reclaim();
+    }
+
+    for (int readers : reader_counts)
+    {
+        auto nodes = std::make_unique<node[]>(n);
+        intrusive::list<node> list;
+        std::shared_timed_mutex mutex;
+        for (std::size_t i = 0; i != n; ++i)
+        {
+            nodes[i].value = int(i);
+            list.push_back(nodes[i]);
+        }
+
+        run_read_mostly("shared_mutex_list", readers, n, [&] {
+            return [&] {
+                std::size_t count = 0;
+                long long sum = 0;
+                std::shared_lock<std::shared_timed_mutex> lock(mutex);
+                for (node const& x : list)
+                {
+                    sum += x.value;
+                    ++count;
+                }
+                bench::do_not_optimize(sum);
+                return count;
+            };
+        }, [&](std::size_t i) {
+            std::unique_lock<std::shared_timed_mutex> lock(mutex, duration);
+            if (!lock)
+                return;
+            nodes[i].unlink();
+            list.push_back(nodes[i]);
+        });
+        list.clear();
+    }
+}
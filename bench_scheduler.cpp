@@ -0,0 +1,150 @@
+#include "intrusive_work_stealing_deque.h"
+#include "bench_utils.h"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+Планировщик с воровством работы: все n задач рождаются у worker'а 0,
+остальные worker'ы получают их только воровством половины чужой
+очереди. intrusive::work_stealing_deque сравнивается с тем, что обычно
+пишут руками: std::deque<task*> под std::mutex у каждого worker'а, вор
+перекладывает половину указателей к себе. Задача -- несколько десятков
+тактов работы. Время включает запуск и join потоков, поэтому маленькие
+размеры не меряются.
+*/
+namespace
+{
+    struct ready_tag;
+
+    struct task : intrusive::list_element<ready_tag>
+    {
+        unsigned value = 0;
+    };
+
+    constexpr int worker_counts[] = {1, 2, 4, 8};
+    constexpr std::size_t min_items = std::size_t(1) << 14;
+
+    void run_task(task& t) noexcept
+    {
+        unsigned x = t.value;
+        for (int i = 0; i != 16; ++i)
+            x = x * 1664525u + 1013904223u;
+        bench::do_not_optimize(x);
+    }
+
+    struct locked_deque
+    {
+        void push(task& t)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            items.push_back(&t);
+        }
+
+        task* pop()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (items.empty())
+                return nullptr;
+            task* t = items.back();
+            items.pop_back();
+            return t;
+        }
+
+        task* steal_from(locked_deque& victim)
+        {
+            std::vector<task*> batch;
+            {
+                std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+                if (!lock || victim.items.empty())
+                    return nullptr;
+                std::size_t k = (victim.items.size() + 1) / 2;
+                batch.assign(victim.items.begin(), victim.items.begin() + k);
+                victim.items.erase(victim.items.begin(), victim.items.begin() + k);
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            items.insert(items.end(), batch.begin() + 1, batch.end());
+            return batch.front();
+        }
+
+        std::mutex mutex;
+        std::deque<task*> items;
+    };
+
+    template <typename Deque>
+    double run_scheduler(int workers, std::size_t n, task* tasks)
+    {
+        using clock = std::chrono::steady_clock;
+
+        std::vector<Deque> deques(workers);
+        std::atomic<std::size_t> done{0};
+
+        auto start = clock::now();
+        std::vector<std::thread> threads;
+        for (int w = 0; w != workers; ++w)
+            threads.emplace_back([&, w] {
+                Deque& own = deques[w];
+                if (w == 0)
+                    for (std::size_t i = 0; i != n; ++i)
+                        own.push(tasks[i]);
+
+                /*
+                Общий счетчик выполненных задач обновляется пачками, когда
+                своя очередь кончилась, чтобы не мерить его вместо очередей.
+                */
+                std::size_t local = 0;
+                while (done.load(std::memory_order_relaxed) != n)
+                {
+                    task* t = own.pop();
+                    if (t == nullptr && local != 0)
+                    {
+                        done.fetch_add(local, std::memory_order_relaxed);
+                        local = 0;
+                    }
+                    for (int v = 1; t == nullptr && v != workers; ++v)
+                        t = own.steal_from(deques[(w + v) % workers]);
+                    if (t == nullptr)
+                    {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    run_task(*t);
+                    ++local;
+                }
+            });
+        for (auto& t : threads)
+            t.join();
+        auto elapsed = clock::now() - start;
+        return std::chrono::duration<double, std::nano>(elapsed).count() / n;
+    }
+}
+
+BENCHMARK(work_stealing)
+{
+    if (n < min_items)
+        return;
+
+    auto tasks = std::make_unique<task[]>(n);
+    for (std::size_t i = 0; i != n; ++i)
+        tasks[i].value = unsigned(i);
+
+    for (int workers : worker_counts)
+    {
+        std::string name = "intrusive/" + std::to_string(workers);
+        double ns = run_scheduler<intrusive::work_stealing_deque<task, ready_tag>>(workers, n, tasks.get());
+        bench::report("work_stealing", name.c_str(), n, {ns, 0., 0., false});
+    }
+
+    for (int workers : worker_counts)
+    {
+        std::string name = "deque_mutex/" + std::to_string(workers);
+        double ns = run_scheduler<locked_deque>(workers, n, tasks.get());
+        bench::report("work_stealing", name.c_str(), n, {ns, 0., 0., false});
+    }
+}
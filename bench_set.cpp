@@ -0,0 +1,116 @@
+#include "intrusive_set.h"
+#include "intrusive_list.h"
+#include "bench_utils.h"
+#include <memory>
+#include <set>
+#include <vector>
+
+/*
+Очередь дедлайнов из n элементов, ключи в случайном порядке:
+- multiset_insert -- вставка всех n элементов и затем удаление их в
+  случайном порядке. sorted_list -- то же на intrusive::list с поиском
+  места линейным проходом, это O(n) на вставку, поэтому он гоняется
+  только до 16k элементов;
+- multiset_insert_hint -- почти отсортированный ввод (ключи растут),
+  insert_hint(end()) против insert без подсказки.
+ns/op -- на одну вставку вместе с ее удалением.
+*/
+namespace
+{
+    struct snode : intrusive::set_element<>
+    {
+        std::size_t key = 0;
+
+        friend bool operator<(snode const& a, snode const& b)
+        {
+            return a.key < b.key;
+        }
+    };
+
+    struct lnode : intrusive::list_element<>
+    {
+        std::size_t key = 0;
+    };
+
+    constexpr std::size_t sorted_list_max_size = 16384;
+}
+
+BENCHMARK(multiset_insert)
+{
+    auto keys = bench::shuffled_indices(n, 41);
+    auto victims = bench::shuffled_indices(n, 43);
+    std::size_t ops = n != 0 ? n : 1;
+
+    {
+        auto nodes = std::make_unique<snode[]>(n);
+        for (std::size_t i = 0; i != n; ++i)
+            nodes[i].key = keys[i];
+        intrusive::multiset<snode> set;
+        auto r = bench::measure(ops, [] {}, [&] {
+            for (std::size_t i = 0; i != n; ++i)
+                set.insert(nodes[i]);
+            for (std::size_t i : victims)
+                set.erase(nodes[i]);
+        });
+        bench::report("multiset_insert", "intrusive::multiset", n, r);
+    }
+
+    {
+        std::multiset<std::size_t> set;
+        std::vector<std::multiset<std::size_t>::iterator> its(n);
+        auto r = bench::measure(ops, [] {}, [&] {
+            for (std::size_t i = 0; i != n; ++i)
+                its[i] = set.insert(keys[i]);
+            for (std::size_t i : victims)
+                set.erase(its[i]);
+        });
+        bench::report("multiset_insert", "std::multiset", n, r);
+    }
+
+    if (n <= sorted_list_max_size)
+    {
+        auto nodes = std::make_unique<lnode[]>(n);
+        for (std::size_t i = 0; i != n; ++i)
+            nodes[i].key = keys[i];
+        intrusive::list<lnode> list;
+        auto r = bench::measure(ops, [] {}, [&] {
+            for (std::size_t i = 0; i != n; ++i)
+            {
+                auto it = list.begin();
+                while (it != list.end() && !(nodes[i].key < it->key))
+                    ++it;
+                list.insert(it, nodes[i]);
+            }
+            for (std::size_t i : victims)
+                nodes[i].unlink();
+        });
+        bench::report("multiset_insert", "sorted_list", n, r);
+    }
+}
+
+BENCHMARK(multiset_insert_hint)
+{
+    auto victims = bench::shuffled_indices(n, 47);
+    std::size_t ops = n != 0 ? n : 1;
+
+    auto nodes = std::make_unique<snode[]>(n);
+    for (std::size_t i = 0; i != n; ++i)
+        nodes[i].key = i;
+    intrusive::multiset<snode> set;
+
+    auto r = bench::measure(ops, [] {}, [&] {
+        for (std::size_t i = 0; i != n; ++i)
+            set.insert(nodes[i]);
+        for (std::size_t i : victims)
+            set.erase(nodes[i]);
+    });
+    bench::report("multiset_insert_hint", "insert", n, r);
+
+    r = bench::measure(ops, [] {}, [&] {
+        for (std::size_t i = 0; i != n; ++i)
+            set.insert_hint(set.end(), nodes[i]);
+        for (std::size_t i : victims)
+            set.erase(nodes[i]);
+    });
+    bench::report("multiset_insert_hint", "insert_hint(end)", n, r);
+}
@@ -0,0 +1,65 @@
+#include "intrusive_slim_list.h"
+#include "bench_utils.h"
+#include <memory>
+#include <vector>
+
+/*
+Массив из 4n списков, в которые разложены n элементов, то есть почти
+все списки пустые, как бакеты хеш-таблицы или очереди по приоритетам.
+Головы list занимают 64n байт, головы slim_list -- 32n.
+
+slim_heads_push -- разложить n элементов по случайным спискам и
+очистить, slim_heads_scan -- обойти все списки и все элементы в них.
+ns/op -- на один элемент.
+*/
+namespace
+{
+    struct list_node : intrusive::list_element<>
+    {
+        std::size_t value = 0;
+    };
+
+    struct slim_node : intrusive::slim_list_element<>
+    {
+        std::size_t value = 0;
+    };
+
+    template <typename List, typename Node>
+    void bench_heads(char const* impl, std::size_t n)
+    {
+        std::size_t heads = 4 * n;
+        std::vector<List> lists(heads);
+        auto nodes = std::make_unique<Node[]>(n);
+        auto order = bench::shuffled_indices(heads, 11);
+        for (std::size_t i = 0; i != n; ++i)
+            nodes[i].value = i;
+
+        auto r = bench::measure(n, [] {}, [&] {
+            for (std::size_t i = 0; i != n; ++i)
+                lists[order[i]].push_front(nodes[i]);
+            for (std::size_t i = 0; i != n; ++i)
+                lists[order[i]].clear();
+        });
+        bench::report("slim_heads_push", impl, n, r);
+
+        for (std::size_t i = 0; i != n; ++i)
+            lists[order[i]].push_front(nodes[i]);
+        r = bench::measure(n, [] {}, [&] {
+            std::size_t sum = 0;
+            for (List const& list : lists)
+                for (Node const& x : list)
+                    sum += x.value;
+            bench::do_not_optimize(sum);
+        });
+        bench::report("slim_heads_scan", impl, n, r);
+
+        for (List& list : lists)
+            list.clear();
+    }
+}
+
+BENCHMARK(slim_list)
+{
+    bench_heads<intrusive::list<list_node>, list_node>("list", n);
+    bench_heads<intrusive::slim_list<slim_node>, slim_node>("slim_list", n);
+}
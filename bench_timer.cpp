@@ -0,0 +1,128 @@
+#include "intrusive_timer_wheel.h"
+#include "bench_utils.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+/*
+n таймеров со сроками, случайными в пределах 65536 тиков.
+timer_wheel сравнивается с тем, что обычно пишут вместо него:
+std::multimap от срока к соединению, итератор на свою запись
+соединение хранит у себя, чтобы отменять без поиска.
+
+timer_cancel -- запланировать и отменить, timer_reschedule --
+перепланировать уже запланированный таймер (продление таймаута на
+каждом пакете), timer_expire -- дождаться срабатывания всех таймеров.
+*/
+namespace
+{
+    constexpr std::uint64_t horizon = 65536;
+
+    struct connection : intrusive::timer_wheel_element<>
+    {
+        std::multimap<std::uint64_t, connection*>::iterator entry;
+    };
+
+    using wheel = intrusive::timer_wheel<connection>;
+    using timer_map = std::multimap<std::uint64_t, connection*>;
+
+    std::vector<std::uint64_t> deadlines(std::size_t n, std::uint32_t seed)
+    {
+        auto order = bench::shuffled_indices(n, seed);
+        std::vector<std::uint64_t> result(n);
+        for (std::size_t i = 0; i != n; ++i)
+            result[i] = 1 + order[i] * horizon / n;
+        return result;
+    }
+
+    void bench_wheel(std::size_t n)
+    {
+        auto conns = std::make_unique<connection[]>(n);
+        auto first = deadlines(n, 5);
+        auto second = deadlines(n, 6);
+        auto order = bench::shuffled_indices(n, 7);
+        auto w = std::make_unique<wheel>();
+
+        auto r = bench::measure(n, [] {}, [&] {
+            for (std::size_t i = 0; i != n; ++i)
+                w->schedule(conns[i], first[i]);
+            for (std::size_t i : order)
+                wheel::cancel(conns[i]);
+        });
+        bench::report("timer_cancel", "timer_wheel", n, r);
+
+        for (std::size_t i = 0; i != n; ++i)
+            w->schedule(conns[i], first[i]);
+        r = bench::measure(n, [] {}, [&] {
+            for (std::size_t i : order)
+                w->schedule(conns[i], second[i]);
+        });
+        bench::report("timer_reschedule", "timer_wheel", n, r);
+
+        r = bench::measure(n, [&] {
+            w = std::make_unique<wheel>();
+            for (std::size_t i = 0; i != n; ++i)
+                w->schedule(conns[i], first[i]);
+        }, [&] {
+            for (std::uint64_t t = 1; t <= horizon; t += 64)
+            {
+                auto expired = w->advance(t);
+                while (!expired.empty())
+                {
+                    bench::do_not_optimize(&expired.front());
+                    expired.pop_front();
+                }
+            }
+        });
+        bench::report("timer_expire", "timer_wheel", n, r);
+    }
+
+    void bench_multimap(std::size_t n)
+    {
+        auto conns = std::make_unique<connection[]>(n);
+        auto first = deadlines(n, 5);
+        auto second = deadlines(n, 6);
+        auto order = bench::shuffled_indices(n, 7);
+        timer_map timers;
+
+        auto r = bench::measure(n, [] {}, [&] {
+            for (std::size_t i = 0; i != n; ++i)
+                conns[i].entry = timers.emplace(first[i], &conns[i]);
+            for (std::size_t i : order)
+                timers.erase(conns[i].entry);
+        });
+        bench::report("timer_cancel", "multimap", n, r);
+
+        for (std::size_t i = 0; i != n; ++i)
+            conns[i].entry = timers.emplace(first[i], &conns[i]);
+        r = bench::measure(n, [] {}, [&] {
+            for (std::size_t i : order)
+            {
+                timers.erase(conns[i].entry);
+                conns[i].entry = timers.emplace(second[i], &conns[i]);
+            }
+        });
+        bench::report("timer_reschedule", "multimap", n, r);
+
+        r = bench::measure(n, [&] {
+            timers.clear();
+            for (std::size_t i = 0; i != n; ++i)
+                conns[i].entry = timers.emplace(first[i], &conns[i]);
+        }, [&] {
+            for (std::uint64_t t = 1; t <= horizon; t += 64)
+                while (!timers.empty() && timers.begin()->first <= t)
+                {
+                    bench::do_not_optimize(timers.begin()->second);
+                    timers.erase(timers.begin());
+                }
+        });
+        bench::report("timer_expire", "multimap", n, r);
+    }
+}
+
+BENCHMARK(timer_wheel)
+{
+    bench_wheel(n);
+    bench_multimap(n);
+}
@@ -0,0 +1,206 @@
+#include "intrusive_unordered_set.h"
+#include "bench_utils.h"
+#include <chrono>
+#include <memory>
+#include <vector>
+
+/*
+intrusive::unordered_set против самодельной таблицы из
+std::vector<intrusive::list<T, bucket_tag>>. Самодельная таблица
+меряется в двух вариантах: с n бакетами сразу (не рехеширует вообще) и
+растущая удвоением с полным рехешем, как ее обычно и пишут.
+unordered_set начинает с 8 бакетов и растет по одному. Ключи
+вставляются и ищутся в случайном порядке.
+
+hash_insert_max -- самая долгая одиночная вставка из n, ради нее
+инкрементальный рехеш и нужен. Каждая вставка меряется отдельно, так
+что в число входит и цена вызова часов.
+*/
+namespace
+{
+    struct bucket_tag;
+
+    struct node : intrusive::unordered_set_element<>
+    {
+        unsigned key = 0;
+    };
+
+    struct hashed_node : intrusive::unordered_set_element<intrusive::default_tag, intrusive::store_hash>
+    {
+        unsigned key = 0;
+    };
+
+    struct list_node : intrusive::list_element<bucket_tag, intrusive::normal_link>
+    {
+        unsigned key = 0;
+    };
+
+    struct key_hash
+    {
+        template <typename T>
+        std::size_t operator()(T const& x) const noexcept
+        {
+            return x.key * 0x9e3779b97f4a7c15ull;
+        }
+    };
+
+    struct key_eq
+    {
+        template <typename T>
+        bool operator()(T const& a, T const& b) const noexcept
+        {
+            return a.key == b.key;
+        }
+    };
+
+    template <typename Insert>
+    double worst_insert(std::size_t n, Insert insert)
+    {
+        using clock = std::chrono::steady_clock;
+        double worst = 0;
+        for (std::size_t i = 0; i != n; ++i)
+        {
+            auto start = clock::now();
+            insert(i);
+            double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+            if (ns > worst)
+                worst = ns;
+        }
+        return worst;
+    }
+
+    template <typename Node>
+    void bench_set(char const* impl, std::size_t n)
+    {
+        using set = intrusive::unordered_set<Node, intrusive::default_tag, key_hash, key_eq>;
+
+        auto nodes = std::make_unique<Node[]>(n);
+        auto order = bench::shuffled_indices(n, 3);
+        for (std::size_t i = 0; i != n; ++i)
+            nodes[i].key = unsigned(order[i]);
+
+        std::unique_ptr<set> s;
+        auto r = bench::measure(n, [&] {
+            if (s)
+                s->clear();
+            s = std::make_unique<set>();
+        }, [&] {
+            for (std::size_t i = 0; i != n; ++i)
+                s->insert(nodes[i]);
+        });
+        bench::report("hash_insert", impl, n, r);
+
+        r = bench::measure(n, [] {}, [&] {
+            for (std::size_t i = 0; i != n; ++i)
+                bench::do_not_optimize(s->contains(nodes[order[i]]));
+        });
+        bench::report("hash_find", impl, n, r);
+        s->clear();
+
+        set fresh;
+        double worst = worst_insert(n, [&](std::size_t i) { fresh.insert(nodes[i]); });
+        bench::report("hash_insert_max", impl, n, {worst, 0., 0., false});
+        fresh.clear();
+    }
+
+    void bench_vector_of_lists(std::size_t n)
+    {
+        using bucket = intrusive::list<list_node, bucket_tag>;
+
+        auto nodes = std::make_unique<list_node[]>(n);
+        auto order = bench::shuffled_indices(n, 3);
+        for (std::size_t i = 0; i != n; ++i)
+            nodes[i].key = unsigned(order[i]);
+
+        std::vector<bucket> buckets;
+        auto index_of = [&](list_node const& x) {
+            return (key_hash{}(x) >> 17) % buckets.size();
+        };
+
+        auto r = bench::measure(n, [&] {
+            std::vector<bucket> fresh(n);
+            buckets.swap(fresh);
+        }, [&] {
+            for (std::size_t i = 0; i != n; ++i)
+            {
+                bucket& b = buckets[index_of(nodes[i])];
+                bool found = false;
+                for (list_node const& x : b)
+                    if (x.key == nodes[i].key)
+                    {
+                        found = true;
+                        break;
+                    }
+                if (!found)
+                    b.push_front(nodes[i]);
+            }
+        });
+        bench::report("hash_insert", "vector<list>", n, r);
+
+        r = bench::measure(n, [] {}, [&] {
+            for (std::size_t i = 0; i != n; ++i)
+            {
+                list_node const& key = nodes[order[i]];
+                bool found = false;
+                for (list_node const& x : buckets[index_of(key)])
+                    if (x.key == key.key)
+                    {
+                        found = true;
+                        break;
+                    }
+                bench::do_not_optimize(found);
+            }
+        });
+        bench::report("hash_find", "vector<list>", n, r);
+
+        /*
+        Растущий вариант: при size > bucket_count бакетов становится
+        вдвое больше, и все элементы перекладываются.
+        */
+        std::size_t size = 0;
+        auto insert_growing = [&](std::size_t i) {
+            if (size == buckets.size())
+            {
+                std::vector<bucket> bigger(buckets.size() * 2);
+                for (bucket& old : buckets)
+                    while (!old.empty())
+                    {
+                        list_node& x = old.front();
+                        old.pop_front();
+                        bigger[(key_hash{}(x) >> 17) % bigger.size()].push_front(x);
+                    }
+                buckets.swap(bigger);
+            }
+
+            bucket& b = buckets[index_of(nodes[i])];
+            for (list_node const& x : b)
+                if (x.key == nodes[i].key)
+                    return;
+            b.push_front(nodes[i]);
+            ++size;
+        };
+
+        r = bench::measure(n, [&] {
+            std::vector<bucket> fresh(8);
+            buckets.swap(fresh);
+            size = 0;
+        }, [&] {
+            for (std::size_t i = 0; i != n; ++i)
+                insert_growing(i);
+        });
+        bench::report("hash_insert", "vector<list>_rehash", n, r);
+
+        std::vector<bucket> fresh(8);
+        buckets.swap(fresh);
+        size = 0;
+        double worst = worst_insert(n, insert_growing);
+        bench::report("hash_insert_max", "vector<list>_rehash", n, {worst, 0., 0., false});
+    }
+}
+
+BENCHMARK(unordered_set)
+{
+    bench_set<node>("unordered_set", n);
+    bench_set<hashed_node>("unordered_set_store_hash", n);
+    bench_vector_of_lists(n);
+}
@@ -0,0 +1,210 @@
+#include "bench_utils.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <string>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    struct registered_benchmark
+    {
+        char const* name;
+        bench::benchmark_fn fn;
+    };
+
+    std::vector<registered_benchmark>& registry()
+    {
+        static std::vector<registered_benchmark> instance;
+        return instance;
+    }
+
+    std::vector<std::size_t>& mutable_sizes()
+    {
+        static std::vector<std::size_t> instance = {
+            std::size_t(1) << 8,
+            std::size_t(1) << 12,
+            std::size_t(1) << 16,
+            std::size_t(1) << 20,
+            std::size_t(1) << 22,
+        };
+        return instance;
+    }
+
+#if defined(__linux__)
+    int open_counter(std::uint32_t type, std::uint64_t config) noexcept
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof attr);
+        attr.size = sizeof attr;
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    std::uint64_t read_counter(int fd) noexcept
+    {
+        std::uint64_t value = 0;
+        if (fd < 0 || read(fd, &value, sizeof value) != sizeof value)
+            return 0;
+        return value;
+    }
+#endif
+
+    bool parse_size_flag(char const* arg, char const* flag, std::size_t& out)
+    {
+        std::size_t len = std::strlen(flag);
+        if (std::strncmp(arg, flag, len) != 0)
+            return false;
+        out = std::size_t(std::strtoull(arg + len, nullptr, 10));
+        return true;
+    }
+}
+
+bench::perf_counters::perf_counters() noexcept
+    : llc_fd(-1)
+    , l1d_fd(-1)
+    , llc_value(0)
+    , l1d_value(0)
+{
+#if defined(__linux__)
+    llc_fd = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    l1d_fd = open_counter(PERF_TYPE_HW_CACHE,
+        PERF_COUNT_HW_CACHE_L1D
+        | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+        | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+#endif
+}
+
+bench::perf_counters::~perf_counters()
+{
+#if defined(__linux__)
+    if (llc_fd >= 0)
+        close(llc_fd);
+    if (l1d_fd >= 0)
+        close(l1d_fd);
+#endif
+}
+
+bool bench::perf_counters::available() const noexcept
+{
+    return llc_fd >= 0;
+}
+
+void bench::perf_counters::start() noexcept
+{
+#if defined(__linux__)
+    for (int fd : {llc_fd, l1d_fd})
+    {
+        if (fd < 0)
+            continue;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+void bench::perf_counters::stop() noexcept
+{
+#if defined(__linux__)
+    for (int fd : {llc_fd, l1d_fd})
+        if (fd >= 0)
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    llc_value = read_counter(llc_fd);
+    l1d_value = read_counter(l1d_fd);
+#endif
+}
+
+std::uint64_t bench::perf_counters::llc_misses() const noexcept
+{
+    return llc_value;
+}
+
+std::uint64_t bench::perf_counters::l1d_misses() const noexcept
+{
+    return l1d_value;
+}
+
+bench::registrar::registrar(char const* name, benchmark_fn fn)
+{
+    registry().push_back({name, fn});
+}
+
+std::vector<std::size_t> const& bench::sizes()
+{
+    return mutable_sizes();
+}
+
+void bench::report(char const* group, char const* impl, std::size_t n, result const& r)
+{
+    if (r.has_counters)
+        std::printf("%-22s %-18s %10zu %10.2f ns/op %8.3f llc/op %8.3f l1d/op\n",
+            group, impl, n, r.ns_per_op, r.llc_misses_per_op, r.l1d_misses_per_op);
+    else
+        std::printf("%-22s %-18s %10zu %10.2f ns/op %8s llc/op %8s l1d/op\n",
+            group, impl, n, r.ns_per_op, "n/a", "n/a");
+    std::fflush(stdout);
+}
+
+std::vector<std::size_t> bench::shuffled_indices(std::size_t n, std::uint32_t seed)
+{
+    std::vector<std::size_t> result(n);
+    std::iota(result.begin(), result.end(), std::size_t(0));
+    std::mt19937 rng(seed);
+    std::shuffle(result.begin(), result.end(), rng);
+    return result;
+}
+
+/*
+Использование: intrusive_list_bench [--filter=substr] [--min-size=N] [--max-size=N]
+*/
+int bench::run_registered(int argc, char** argv)
+{
+    std::string filter;
+    std::size_t min_size = 0;
+    std::size_t max_size = std::size_t(-1);
+
+    for (int i = 1; i != argc; ++i)
+    {
+        char const* arg = argv[i];
+        if (std::strncmp(arg, "--filter=", 9) == 0)
+            filter = arg + 9;
+        else if (parse_size_flag(arg, "--min-size=", min_size) || parse_size_flag(arg, "--max-size=", max_size))
+            ;
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--filter=substr] [--min-size=N] [--max-size=N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    auto& s = mutable_sizes();
+    s.erase(std::remove_if(s.begin(), s.end(), [&](std::size_t n) {
+        return n < min_size || n > max_size;
+    }), s.end());
+
+    if (!perf_counters().available())
+        std::printf("# perf_event_open is unavailable, cache-miss counters are not reported\n");
+
+    for (auto const& b : registry())
+    {
+        if (!filter.empty() && std::string(b.name).find(filter) == std::string::npos)
+            continue;
+        for (std::size_t n : s)
+            b.fn(n);
+    }
+
+    return 0;
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <vector>
+
+/*
+Маленький самописный харнес для микробенчмарков. Я не стал тащить
+Google Benchmark, чтобы бенчмарки, как и тесты, собирались без внешних
+зависимостей.
+
+Каждый бенчмарк регистрируется макросом BENCHMARK и вызывается для
+каждого размера списка из bench::sizes(). Результат печатается в виде
+таблицы: группа, реализация, размер, ns/op и, если ядро разрешает
+perf_event_open, промахи по кешу на операцию.
+*/
+namespace bench
+{
+    struct result
+    {
+        double ns_per_op;
+        double llc_misses_per_op;
+        double l1d_misses_per_op;
+        bool has_counters;
+    };
+
+    /*
+    Аппаратные счетчики через perf_event_open. Если ядро или
+    песочница их не дает, available() возвращает false, а
+    промахи в отчете печатаются как "n/a".
+    */
+    struct perf_counters
+    {
+        perf_counters() noexcept;
+        ~perf_counters();
+        perf_counters(perf_counters const&) = delete;
+        perf_counters& operator=(perf_counters const&) = delete;
+
+        bool available() const noexcept;
+        void start() noexcept;
+        void stop() noexcept;
+
+        std::uint64_t llc_misses() const noexcept;
+        std::uint64_t l1d_misses() const noexcept;
+
+    private:
+        int llc_fd;
+        int l1d_fd;
+        std::uint64_t llc_value;
+        std::uint64_t l1d_value;
+    };
+
+    using benchmark_fn = void (*)(std::size_t n);
+
+    struct registrar
+    {
+        registrar(char const* name, benchmark_fn fn);
+    };
+
+    /*
+    Размеры списков: от горячих в L1 до заметно больших, чем LLC.
+    Верхнюю границу можно поменять ключом --max-size.
+    */
+    std::vector<std::size_t> const& sizes();
+
+    void report(char const* group, char const* impl, std::size_t n, result const&);
+
+    int run_registered(int argc, char** argv);
+
+    /*
+    Случайная перестановка [0, n). Генератор с фиксированным seed'ом,
+    чтобы запуски были сравнимы между собой.
+    */
+    std::vector<std::size_t> shuffled_indices(std::size_t n, std::uint32_t seed = 42);
+
+    template <typename T>
+    void do_not_optimize(T const& value) noexcept
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    inline void clobber_memory() noexcept
+    {
+        asm volatile("" : : : "memory");
+    }
+
+    /*
+    setup() выполняется вне замера, body() -- внутри. body() должен
+    выполнить ops операций. Из нескольких повторов берется лучший,
+    чтобы отфильтровать шум планировщика.
+    */
+    template <typename Setup, typename Body>
+    result measure(std::size_t ops, Setup&& setup, Body&& body)
+    {
+        using clock = std::chrono::steady_clock;
+        constexpr int min_reps = 3;
+        constexpr int max_reps = 50;
+        constexpr auto min_total = std::chrono::milliseconds(50);
+
+        perf_counters counters;
+        result best{1e300, 0., 0., counters.available()};
+        clock::duration total{};
+
+        for (int rep = 0; rep != max_reps && (rep < min_reps || total < min_total); ++rep)
+        {
+            setup();
+            clobber_memory();
+            counters.start();
+            auto start = clock::now();
+            body();
+            clobber_memory();
+            auto elapsed = clock::now() - start;
+            counters.stop();
+            total += elapsed;
+
+            double ns = std::chrono::duration<double, std::nano>(elapsed).count() / ops;
+            if (ns < best.ns_per_op)
+            {
+                best.ns_per_op = ns;
+                best.llc_misses_per_op = double(counters.llc_misses()) / ops;
+                best.l1d_misses_per_op = double(counters.l1d_misses()) / ops;
+            }
+        }
+
+        return best;
+    }
+}
+
+#define BENCHMARK(name) \
+    static void name(std::size_t); \
+    static ::bench::registrar name##_registrar(#name, &name); \
+    static void name(std::size_t n)
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include "intrusive_concurrent_list.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct cnode : intrusive::concurrent_list_element<>
+    {
+        explicit cnode(int value = 0)
+            : value(value)
+        {}
+
+        int value;
+    };
+
+    using clist = intrusive::concurrent_list<cnode>;
+
+    std::vector<int> values(clist& list)
+    {
+        std::vector<int> result;
+        list.for_each([&](cnode& x) { result.push_back(x.value); });
+        return result;
+    }
+}
+
+TEST(intrusive_concurrent_list_testing, push_and_for_each)
+{
+    clist list;
+    EXPECT_TRUE(list.empty());
+    cnode a(1), b(2), c(3);
+    list.push_back(b);
+    list.push_back(c);
+    list.push_front(a);
+    EXPECT_FALSE(list.empty());
+    EXPECT_EQ(3u, list.size());
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), values(list));
+    EXPECT_TRUE(b.is_linked());
+}
+
+TEST(intrusive_concurrent_list_testing, erase_and_pop_front)
+{
+    clist list;
+    cnode a(1), b(2), c(3);
+    list.push_back(a);
+    list.push_back(b);
+    list.push_back(c);
+
+    EXPECT_TRUE(list.erase(b));
+    EXPECT_FALSE(b.is_linked());
+    EXPECT_FALSE(list.erase(b));
+    EXPECT_EQ((std::vector<int>{1, 3}), values(list));
+
+    EXPECT_EQ(&a, list.pop_front());
+    EXPECT_EQ(&c, list.pop_front());
+    EXPECT_EQ(nullptr, list.pop_front());
+    EXPECT_TRUE(list.empty());
+}
+
+TEST(intrusive_concurrent_list_testing, auto_unlink)
+{
+    clist list;
+    cnode a(1);
+    list.push_back(a);
+    {
+        cnode b(2);
+        list.push_back(b);
+        cnode c(3);
+        list.push_back(c);
+        c.unlink();
+        EXPECT_FALSE(c.is_linked());
+    }
+    EXPECT_EQ((std::vector<int>{1}), values(list));
+}
+
+TEST(intrusive_concurrent_list_testing, erase_from_other_list)
+{
+    clist l1, l2;
+    cnode a(1);
+    l1.push_back(a);
+    EXPECT_FALSE(l2.erase(a));
+    EXPECT_TRUE(a.is_linked());
+}
+
+TEST(intrusive_concurrent_list_testing, clear)
+{
+    clist list;
+    cnode a(1), b(2);
+    list.push_back(a);
+    list.push_back(b);
+    list.clear();
+    EXPECT_TRUE(list.empty());
+    EXPECT_FALSE(a.is_linked());
+    list.push_back(b);
+    EXPECT_EQ((std::vector<int>{2}), values(list));
+}
+
+TEST(intrusive_concurrent_list_testing, destroy_while_iterating)
+{
+    constexpr int killers = 3;
+    constexpr int per_killer = 2000;
+
+    clist list;
+    std::vector<std::unique_ptr<cnode>> nodes;
+    for (int i = 0; i != killers * per_killer; ++i)
+    {
+        nodes.push_back(std::make_unique<cnode>(i));
+        list.push_back(*nodes.back());
+    }
+
+    std::atomic<bool> done{false};
+    std::thread reader([&] {
+        while (!done.load())
+        {
+            long long sum = 0;
+            list.for_each([&](cnode& x) { sum += x.value; });
+            EXPECT_GE(sum, 0);
+        }
+    });
+
+    std::vector<std::thread> threads;
+    for (int k = 0; k != killers; ++k)
+        threads.emplace_back([&, k] {
+            for (int i = k; i < killers * per_killer; i += killers)
+                nodes[i].reset();
+        });
+    for (auto& t : threads)
+        t.join();
+    done.store(true);
+    reader.join();
+
+    EXPECT_TRUE(list.empty());
+}
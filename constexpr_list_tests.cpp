@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+#include "intrusive_list.h"
+#include <cstddef>
+
+namespace
+{
+    struct handler : intrusive::list_element<>
+    {
+        constexpr explicit handler(int value) noexcept
+            : value(value)
+        {}
+
+        int value;
+    };
+
+    struct registry
+    {
+        handler first{1};
+        handler second{2};
+        handler third{3};
+        intrusive::list<handler> all;
+
+        constexpr registry() noexcept
+        {
+            all.push_back(second);
+            all.push_front(first);
+            all.insert(all.end(), third);
+        }
+    };
+
+    struct member_handler
+    {
+        constexpr explicit member_handler(int value) noexcept
+            : value(value)
+        {}
+
+        int value;
+        intrusive::list_element<> hook;
+    };
+
+    using member_handler_hook = intrusive::member_hook<&member_handler::hook, offsetof(member_handler, hook)>;
+
+    static_assert(member_handler_hook::offset == offsetof(member_handler, hook));
+    static_assert(member_handler_hook::offset != 0);
+
+    struct member_registry
+    {
+        member_handler first{1};
+        member_handler second{2};
+        intrusive::list<member_handler, member_handler_hook> all;
+
+        constexpr member_registry() noexcept
+        {
+            all.push_back(second);
+            all.push_front(first);
+        }
+    };
+
+    extern registry handlers;
+    extern member_registry member_handlers;
+    extern intrusive::list<handler> plugins;
+
+    /*
+    Динамические инициализаторы выполняются в порядке определения, а
+    handlers и plugins определены ниже. Если бы они инициализировались
+    динамически, здесь их память была бы еще заполнена нулями.
+    */
+    bool const handlers_linked_early = handlers.first.is_linked() && handlers.third.is_linked();
+    bool const plugins_ready_early = plugins.empty();
+    bool const member_handlers_linked_early = member_handlers.first.hook.is_linked() && member_handlers.second.hook.is_linked();
+
+    registry handlers;
+    member_registry member_handlers;
+    intrusive::list<handler> plugins;
+    handler late_plugin{4};
+
+    int sum(intrusive::list<handler> const& list)
+    {
+        int result = 0;
+        for (handler const& h : list)
+            result = result * 10 + h.value;
+        return result;
+    }
+}
+
+TEST(intrusive_constexpr_list_testing, static_registry_is_constant_initialized)
+{
+    EXPECT_TRUE(handlers_linked_early);
+    EXPECT_TRUE(plugins_ready_early);
+    EXPECT_EQ(123, sum(handlers.all));
+    EXPECT_EQ(&handlers.first, &handlers.all.front());
+    EXPECT_EQ(&handlers.third, &handlers.all.back());
+}
+
+TEST(intrusive_constexpr_list_testing, member_hook_registry_is_constant_initialized)
+{
+    EXPECT_TRUE(member_handlers_linked_early);
+    EXPECT_EQ(&member_handlers.first, &member_handlers.all.front());
+    EXPECT_EQ(&member_handlers.second, &member_handlers.all.back());
+    EXPECT_EQ(2, member_handlers.all.back().value);
+}
+
+TEST(intrusive_constexpr_list_testing, constant_initialized_list_is_mutable)
+{
+    plugins.push_back(late_plugin);
+    EXPECT_EQ(4, sum(plugins));
+    late_plugin.unlink();
+    EXPECT_TRUE(plugins.empty());
+
+    handlers.second.unlink();
+    EXPECT_EQ(13, sum(handlers.all));
+    handlers.all.insert(handlers.all.iterator_to(handlers.third), handlers.second);
+    EXPECT_EQ(123, sum(handlers.all));
+}
+
+#if __cpp_constexpr >= 201907L
+namespace
+{
+    constinit registry constant_handlers;
+    constinit intrusive::list<handler> constant_plugins;
+
+    constexpr int build_and_sum()
+    {
+        handler a{1}, b{2}, c{3}, d{4};
+        intrusive::list<handler> x;
+        intrusive::list<handler> y;
+        x.push_back(a);
+        x.push_back(b);
+        y.push_back(c);
+        y.push_front(d);
+        x.splice(x.end(), y, y.begin(), y.end());
+        x.erase(x.iterator_to(b));
+        x.pop_front();
+
+        int result = 0;
+        for (handler const& h : x)
+            result = result * 10 + h.value;
+        return result * 10 + static_cast<int>(x.size()) + (y.empty() ? 0 : 1000);
+    }
+
+    static_assert(build_and_sum() == 432);
+
+    constexpr bool build_with_member_hook()
+    {
+        member_handler a{1}, b{2}, c{3};
+        intrusive::list<member_handler, member_handler_hook> x;
+        intrusive::list<member_handler, member_handler_hook> y;
+        x.push_back(a);
+        x.push_back(b);
+        y.push_back(c);
+        x.splice(x.end(), y, y.begin(), y.end());
+        x.erase(x.iterator_to(b));
+        return x.size() == 2 && y.empty() && !b.hook.is_linked() && c.hook.is_linked();
+    }
+
+    static_assert(build_with_member_hook());
+}
+
+TEST(intrusive_constexpr_list_testing, constinit)
+{
+    EXPECT_EQ(123, sum(constant_handlers.all));
+    EXPECT_TRUE(constant_plugins.empty());
+}
+#endif
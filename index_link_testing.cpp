@@ -0,0 +1,86 @@
+#include "test_utils.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <pthread.h>
+#include <sys/mman.h>
+
+static_assert(sizeof(intrusive::list_element<intrusive::default_tag, test_link>) == 8,
+    "index_link hook should be two 32-bit indices");
+
+/*
+Арена -- один mmap на 1 ГиБ, память под нее выделяется лениво.
+operator new отдает память из нее подряд и никогда не освобождает:
+тестам этого хватает с запасом. Поскольку operator new вызывается и
+до main, арена создается при первом обращении.
+*/
+namespace
+{
+    constexpr std::size_t arena_size = std::size_t(1) << 30;
+    constexpr std::size_t stack_size = std::size_t(16) << 20;
+    constexpr std::size_t page_size = 4096;
+
+    char* arena_begin = nullptr;
+    std::atomic<std::size_t> arena_used{0};
+
+    char* arena() noexcept
+    {
+        if (arena_begin == nullptr)
+        {
+            void* p = mmap(nullptr, arena_size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (p == MAP_FAILED)
+                std::abort();
+            arena_begin = static_cast<char*>(p);
+        }
+        return arena_begin;
+    }
+
+    void* arena_allocate(std::size_t size, std::size_t alignment)
+    {
+        char* begin = arena();
+        std::size_t rounded = (size + alignment - 1) / alignment * alignment;
+        std::size_t offset = arena_used.fetch_add(rounded + alignment);
+        offset = (offset + alignment - 1) / alignment * alignment;
+        if (offset + rounded > arena_size)
+            throw std::bad_alloc();
+        return begin + offset;
+    }
+
+    void* run_tests(void* result)
+    {
+        *static_cast<int*>(result) = RUN_ALL_TESTS();
+        return nullptr;
+    }
+}
+
+char* testing_arena::base() noexcept
+{
+    return arena();
+}
+
+int run_all_tests_in_arena()
+{
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, arena_allocate(stack_size, page_size), stack_size);
+
+    int result = 1;
+    pthread_t thread;
+    if (pthread_create(&thread, &attr, &run_tests, &result) != 0)
+        std::abort();
+    pthread_join(thread, nullptr);
+    pthread_attr_destroy(&attr);
+    return result;
+}
+
+void* operator new(std::size_t size)
+{
+    return arena_allocate(size, alignof(std::max_align_t));
+}
+
+void operator delete(void*) noexcept
+{}
+
+void operator delete(void*, std::size_t) noexcept
+{}
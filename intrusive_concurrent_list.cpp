@@ -0,0 +1,197 @@
+#include "intrusive_concurrent_list.h"
+#include <cassert>
+#include <thread>
+
+namespace intrusive::detail
+{
+    /*
+    Сначала немного крутимся с pause, потом уступаем процессор: держатель
+    лока может быть вытеснен, и тогда крутиться бесполезно.
+    */
+    INTRUSIVE_LIST_INLINE void spin_pause(unsigned& spins) noexcept
+    {
+        if (++spins < 64)
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::spinlock::lock() noexcept
+{
+    unsigned spins = 0;
+    while (locked.exchange(true, std::memory_order_acquire))
+    {
+        while (locked.load(std::memory_order_relaxed))
+            spin_pause(spins);
+    }
+}
+
+INTRUSIVE_LIST_INLINE bool intrusive::detail::spinlock::try_lock() noexcept
+{
+    return !locked.load(std::memory_order_relaxed) && !locked.exchange(true, std::memory_order_acquire);
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::spinlock::unlock() noexcept
+{
+    locked.store(false, std::memory_order_release);
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::rw_spinlock::lock() noexcept
+{
+    unsigned spins = 0;
+    std::uint32_t s = state.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        if ((s & 1) == 0 && state.compare_exchange_weak(s, s | 1, std::memory_order_acquire, std::memory_order_relaxed))
+            break;
+        spin_pause(spins);
+        s = state.load(std::memory_order_relaxed);
+    }
+
+    while (state.load(std::memory_order_acquire) != 1)
+        spin_pause(spins);
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::rw_spinlock::unlock() noexcept
+{
+    state.fetch_sub(1, std::memory_order_release);
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::rw_spinlock::lock_shared() noexcept
+{
+    unsigned spins = 0;
+    for (;;)
+    {
+        if ((state.fetch_add(2, std::memory_order_acquire) & 1) == 0)
+            return;
+        state.fetch_sub(2, std::memory_order_relaxed);
+        while ((state.load(std::memory_order_relaxed) & 1) != 0)
+            spin_pause(spins);
+    }
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::rw_spinlock::unlock_shared() noexcept
+{
+    state.fetch_sub(2, std::memory_order_release);
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::concurrent_list_element_base::unlink() noexcept
+{
+    /*
+    Пока мы ждали лок, элемент могли выкинуть из списка и положить в
+    другой, поэтому под локом owner проверяется еще раз. Если он
+    сменился, повторяем с новым владельцем, пока элемент не окажется
+    отвязан.
+    */
+    for (;;)
+    {
+        detail::concurrent_list_base* list = owner.load(std::memory_order_acquire);
+        if (list == nullptr)
+            return;
+
+        list->lock.lock();
+        bool still_owner = owner.load(std::memory_order_relaxed) == list;
+        if (still_owner)
+            list->unlink_locked(*this);
+        list->lock.unlock();
+        if (still_owner)
+            return;
+    }
+}
+
+INTRUSIVE_LIST_INLINE intrusive::detail::concurrent_list_base::concurrent_list_base() noexcept
+    : fake{&fake, &fake, {nullptr}}
+{}
+
+INTRUSIVE_LIST_INLINE intrusive::detail::concurrent_list_base::~concurrent_list_base()
+{
+    clear();
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::concurrent_list_base::insert_locked(concurrent_list_element_base& pos, concurrent_list_element_base& obj) noexcept
+{
+    assert(obj.owner.load(std::memory_order_relaxed) == nullptr && "element is already linked");
+    obj.next = &pos;
+    obj.prev = pos.prev;
+    pos.prev->next = &obj;
+    pos.prev = &obj;
+    obj.owner.store(this, std::memory_order_relaxed);
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::concurrent_list_base::unlink_locked(concurrent_list_element_base& obj) noexcept
+{
+    obj.prev->next = obj.next;
+    obj.next->prev = obj.prev;
+    obj.prev = nullptr;
+    obj.next = nullptr;
+    obj.owner.store(nullptr, std::memory_order_release);
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::concurrent_list_base::push_back(concurrent_list_element_base& obj) noexcept
+{
+    lock.lock();
+    insert_locked(fake, obj);
+    lock.unlock();
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::concurrent_list_base::push_front(concurrent_list_element_base& obj) noexcept
+{
+    lock.lock();
+    insert_locked(*fake.next, obj);
+    lock.unlock();
+}
+
+INTRUSIVE_LIST_INLINE bool intrusive::detail::concurrent_list_base::erase(concurrent_list_element_base& obj) noexcept
+{
+    lock.lock();
+    bool linked = obj.owner.load(std::memory_order_relaxed) == this;
+    if (linked)
+        unlink_locked(obj);
+    lock.unlock();
+    return linked;
+}
+
+INTRUSIVE_LIST_INLINE intrusive::concurrent_list_element_base* intrusive::detail::concurrent_list_base::pop_front() noexcept
+{
+    lock.lock();
+    concurrent_list_element_base* first = fake.next;
+    if (first == &fake)
+        first = nullptr;
+    else
+        unlink_locked(*first);
+    lock.unlock();
+    return first;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::concurrent_list_base::clear() noexcept
+{
+    lock.lock();
+    while (fake.next != &fake)
+        unlink_locked(*fake.next);
+    lock.unlock();
+}
+
+INTRUSIVE_LIST_INLINE bool intrusive::detail::concurrent_list_base::empty() const noexcept
+{
+    lock.lock_shared();
+    bool result = fake.next == &fake;
+    lock.unlock_shared();
+    return result;
+}
+
+INTRUSIVE_LIST_INLINE std::size_t intrusive::detail::concurrent_list_base::size() const noexcept
+{
+    lock.lock_shared();
+    std::size_t n = 0;
+    for (concurrent_list_element_base const* p = fake.next; p != &fake; p = p->next)
+        ++n;
+    lock.unlock_shared();
+    return n;
+}
@@ -0,0 +1,303 @@
+#pragma once
+#include "intrusive_list.h"
+#include <atomic>
+#include <cstdint>
+
+/*
+Список, элементы которого можно удалять из любого потока, пока другие
+потоки его обходят. Обычный list_element в деструкторе пишет в prev/next
+соседей без всякой синхронизации, поэтому с list так делать нельзя.
+
+Каждый concurrent_list защищен одним легким reader-writer спинлоком.
+Обход (for_each) берет его на чтение, так что читатели друг другу не
+мешают. Вставка, erase и отвязывание элемента в деструкторе берут его
+на запись. Элемент помнит, в каком списке он лежит, поэтому деструктор
+знает, чей лок брать.
+
+Ограничения:
+- итераторов наружу нет, обход только через for_each. Функция,
+  переданная в for_each, не должна менять этот список и удалять его
+  элементы: лок уже взят на чтение;
+- деструктор хука выполняется после деструктора T. Если читатели
+  трогают поля T, T должен первым делом вызвать unlink() в своем
+  деструкторе;
+- список должен пережить свои элементы, которые удаляются в других
+  потоках: деструктор элемента берет лок списка.
+*/
+namespace intrusive
+{
+    namespace detail
+    {
+        /*
+        Бит 0 -- писатель, остальные биты -- количество читателей,
+        умноженное на 2. Писатель сначала ставит свой бит, после этого
+        новые читатели не входят, и дожидается ухода старых, так что
+        постоянный поток читателей его не "замораживает".
+        */
+        struct rw_spinlock
+        {
+            void lock() noexcept;
+            void unlock() noexcept;
+            void lock_shared() noexcept;
+            void unlock_shared() noexcept;
+
+            std::atomic<std::uint32_t> state{0};
+        };
+
+        /*
+        Простой test-and-test-and-set спинлок. Незанятый лок берется
+        одним exchange'ем.
+        */
+        struct spinlock
+        {
+            void lock() noexcept;
+            bool try_lock() noexcept;
+            void unlock() noexcept;
+
+            std::atomic<bool> locked{false};
+        };
+
+        struct concurrent_list_base;
+    }
+
+    struct concurrent_list_element_base
+    {
+        /*
+        Потокобезопасно отвязывает элемент от списка, в котором он лежит.
+        Если элемент ни в каком списке не лежит, ничего не делает.
+        */
+        void unlink() noexcept;
+
+        concurrent_list_element_base* prev;
+        concurrent_list_element_base* next;
+        std::atomic<detail::concurrent_list_base*> owner;
+    };
+
+    namespace detail
+    {
+        struct concurrent_list_base
+        {
+            concurrent_list_base() noexcept;
+            ~concurrent_list_base();
+            concurrent_list_base(concurrent_list_base const&) = delete;
+            concurrent_list_base& operator=(concurrent_list_base const&) = delete;
+
+            void push_back(concurrent_list_element_base&) noexcept;
+            void push_front(concurrent_list_element_base&) noexcept;
+            bool erase(concurrent_list_element_base&) noexcept;
+            concurrent_list_element_base* pop_front() noexcept;
+            void clear() noexcept;
+            bool empty() const noexcept;
+            std::size_t size() const noexcept;
+
+            /*
+            Вызываются под локом, который уже взят.
+            */
+            void insert_locked(concurrent_list_element_base& pos, concurrent_list_element_base&) noexcept;
+            void unlink_locked(concurrent_list_element_base&) noexcept;
+
+            mutable rw_spinlock lock;
+            concurrent_list_element_base fake;
+        };
+    }
+
+    template <typename Tag>
+    struct concurrent_list_element;
+
+    namespace detail
+    {
+        template <typename Tag>
+        concurrent_list_element<Tag>& find_concurrent_hook(concurrent_list_element<Tag>&) noexcept;
+
+        template <typename T, typename Tag>
+        using concurrent_hook_t = std::remove_reference_t<decltype(find_concurrent_hook<Tag>(std::declval<std::remove_const_t<T>&>()))>;
+
+        template <typename T, typename Tag, typename = void>
+        constexpr bool has_concurrent_hook_v = false;
+
+        template <typename T, typename Tag>
+        constexpr bool has_concurrent_hook_v<T, Tag, std::void_t<concurrent_hook_t<T, Tag>>> = true;
+    }
+
+    /*
+    Хук для concurrent_list. Всегда auto-unlink: деструктор отвязывает
+    элемент под локом списка. Занимает 24 байта: prev, next и список,
+    в котором элемент лежит.
+    */
+    template <typename Tag = default_tag>
+    struct concurrent_list_element : private concurrent_list_element_base
+    {
+        concurrent_list_element() noexcept;
+        ~concurrent_list_element() noexcept;
+        concurrent_list_element(concurrent_list_element const&) = delete;
+        concurrent_list_element& operator=(concurrent_list_element const&) = delete;
+
+        /*
+        Можно звать из любого потока.
+        */
+        void unlink() noexcept;
+
+        /*
+        Результат может устареть сразу после возврата, если элемент
+        одновременно удаляют из списка в другом потоке.
+        */
+        bool is_linked() const noexcept;
+
+        template <typename T, typename Tag1>
+        friend struct concurrent_list;
+
+        template <typename Tag1, typename T>
+        friend std::enable_if_t<detail::has_concurrent_hook_v<T, Tag1>, concurrent_list_element_base&> to_base(T&) noexcept;
+
+        template <typename T1, typename Tag1>
+        friend T1& from_base(concurrent_list_element_base&) noexcept;
+    };
+
+    template <typename Tag, typename T>
+    std::enable_if_t<detail::has_concurrent_hook_v<T, Tag>, concurrent_list_element_base&> to_base(T&) noexcept;
+
+    template <typename T, typename Tag>
+    T& from_base(concurrent_list_element_base&) noexcept;
+
+    template <typename T, typename Tag = default_tag>
+    struct concurrent_list : private detail::concurrent_list_base
+    {
+        static_assert(detail::has_concurrent_hook_v<T, Tag>,
+            "value type is not convertible to concurrent_list_element");
+
+        concurrent_list() noexcept = default;
+
+        /*
+        Отвязывает все элементы. В этот момент их никто не должен
+        удалять.
+        */
+        ~concurrent_list() = default;
+
+        void push_back(T&) noexcept;
+        void push_front(T&) noexcept;
+
+        /*
+        false, если элемента в этом списке уже нет (например, его
+        только что отвязал другой поток).
+        */
+        bool erase(T&) noexcept;
+
+        /*
+        nullptr, если список пуст.
+        */
+        T* pop_front() noexcept;
+
+        void clear() noexcept;
+
+        bool empty() const noexcept;
+        std::size_t size() const noexcept;
+
+        /*
+        Вызывает f(T&) для каждого элемента под локом на чтение.
+        */
+        template <typename F>
+        void for_each(F f);
+    };
+}
+
+template <typename Tag>
+intrusive::concurrent_list_element<Tag>::concurrent_list_element() noexcept
+    : concurrent_list_element_base{nullptr, nullptr, {nullptr}}
+{}
+
+template <typename Tag>
+intrusive::concurrent_list_element<Tag>::~concurrent_list_element() noexcept
+{
+    concurrent_list_element_base::unlink();
+}
+
+template <typename Tag>
+void intrusive::concurrent_list_element<Tag>::unlink() noexcept
+{
+    concurrent_list_element_base::unlink();
+}
+
+template <typename Tag>
+bool intrusive::concurrent_list_element<Tag>::is_linked() const noexcept
+{
+    return owner.load(std::memory_order_acquire) != nullptr;
+}
+
+template <typename Tag, typename T>
+std::enable_if_t<intrusive::detail::has_concurrent_hook_v<T, Tag>, intrusive::concurrent_list_element_base&> intrusive::to_base(T& obj) noexcept
+{
+    return static_cast<detail::concurrent_hook_t<T, Tag>&>(obj);
+}
+
+template <typename T, typename Tag>
+T& intrusive::from_base(concurrent_list_element_base& base) noexcept
+{
+    return static_cast<T&>(static_cast<detail::concurrent_hook_t<T, Tag>&>(base));
+}
+
+template <typename T, typename Tag>
+void intrusive::concurrent_list<T, Tag>::push_back(T& obj) noexcept
+{
+    detail::concurrent_list_base::push_back(to_base<Tag>(obj));
+}
+
+template <typename T, typename Tag>
+void intrusive::concurrent_list<T, Tag>::push_front(T& obj) noexcept
+{
+    detail::concurrent_list_base::push_front(to_base<Tag>(obj));
+}
+
+template <typename T, typename Tag>
+bool intrusive::concurrent_list<T, Tag>::erase(T& obj) noexcept
+{
+    return detail::concurrent_list_base::erase(to_base<Tag>(obj));
+}
+
+template <typename T, typename Tag>
+T* intrusive::concurrent_list<T, Tag>::pop_front() noexcept
+{
+    concurrent_list_element_base* base = detail::concurrent_list_base::pop_front();
+    return base != nullptr ? &from_base<T, Tag>(*base) : nullptr;
+}
+
+template <typename T, typename Tag>
+void intrusive::concurrent_list<T, Tag>::clear() noexcept
+{
+    detail::concurrent_list_base::clear();
+}
+
+template <typename T, typename Tag>
+bool intrusive::concurrent_list<T, Tag>::empty() const noexcept
+{
+    return detail::concurrent_list_base::empty();
+}
+
+template <typename T, typename Tag>
+std::size_t intrusive::concurrent_list<T, Tag>::size() const noexcept
+{
+    return detail::concurrent_list_base::size();
+}
+
+template <typename T, typename Tag>
+template <typename F>
+void intrusive::concurrent_list<T, Tag>::for_each(F f)
+{
+    struct shared_guard
+    {
+        ~shared_guard()
+        {
+            lock.unlock_shared();
+        }
+
+        detail::rw_spinlock& lock;
+    };
+
+    lock.lock_shared();
+    shared_guard guard{lock};
+    for (concurrent_list_element_base* p = fake.next; p != &fake; p = p->next)
+        f(from_base<T, Tag>(*p));
+}
+
+#ifdef INTRUSIVE_LIST_HEADER_ONLY
+#include "intrusive_concurrent_list.cpp"
+#endif
@@ -0,0 +1,74 @@
+#pragma once
+#include "intrusive_list.h"
+#include <cstdint>
+
+/*
+Хук со сжатыми ссылками для элементов, которые лежат в одной арене:
+
+struct arena { static char* base() noexcept; };
+struct node : intrusive::list_element<my_tag, intrusive::index_link<arena>> {};
+
+prev/next хранятся как 32-битные смещения от Arena::base(), поэтому
+хук занимает 8 байт вместо 16. Смещение считается в единицах по
+4 байта (хук выровнен хотя бы так), то есть арена может быть размером
+до 16 ГиБ. Значение 0xFFFFFFFF зарезервировано под nullptr.
+
+В арене должны лежать не только элементы, но и сами list'ы: элементы
+ссылаются на fake внутри list. Итератор хранит обычный указатель и
+распаковывает ссылку только при переходе к соседу.
+*/
+namespace intrusive
+{
+    template <typename Node, typename Arena>
+    struct index_ptr
+    {
+        static constexpr std::uint32_t null_index = ~std::uint32_t(0);
+        static constexpr std::size_t unit = sizeof(std::uint32_t);
+
+        index_ptr() = default;
+        index_ptr(Node*) noexcept;
+
+        operator Node*() const noexcept;
+        Node* operator->() const noexcept;
+
+        std::uint32_t index;
+    };
+
+    template <typename Arena>
+    struct index_link
+    {
+        using kind = detail::link_kind;
+
+        template <typename Node>
+        using pointer = index_ptr<Node, Arena>;
+
+        using node_type = basic_list_element_base<index_link>;
+    };
+}
+
+template <typename Node, typename Arena>
+intrusive::index_ptr<Node, Arena>::index_ptr(Node* p) noexcept
+    : index(null_index)
+{
+    if (p == nullptr)
+        return;
+
+    std::uintptr_t offset = reinterpret_cast<std::uintptr_t>(p) - reinterpret_cast<std::uintptr_t>(Arena::base());
+    assert(offset % unit == 0);
+    assert(offset / unit < null_index && "element is outside of the arena");
+    index = static_cast<std::uint32_t>(offset / unit);
+}
+
+template <typename Node, typename Arena>
+intrusive::index_ptr<Node, Arena>::operator Node*() const noexcept
+{
+    if (index == null_index)
+        return nullptr;
+    return reinterpret_cast<Node*>(Arena::base() + std::size_t(index) * unit);
+}
+
+template <typename Node, typename Arena>
+Node* intrusive::index_ptr<Node, Arena>::operator->() const noexcept
+{
+    return *this;
+}
@@ -0,0 +1,182 @@
+#include "intrusive_lazy_list.h"
+#include <cassert>
+
+/*
+Помечающий поток и владелец договариваются через state. Пометка --
+CAS, который ставит бит tombstone, только если элемент в списке.
+Владелец выкидывает элемент, записывая в state 0 с release, поэтому
+если помечающий поток увидел 0 через is_linked(), владелец уже не
+трогает элемент. Мертвый элемент живым больше не становится, так что
+владелец, однажды увидев tombstone, может выкинуть элемент без CAS.
+*/
+INTRUSIVE_LIST_INLINE void intrusive::lazy_list_element_base::unlink() noexcept
+{
+    std::uintptr_t s = state.load(std::memory_order_relaxed);
+    while (s != 0 && (s & tombstone) == 0)
+    {
+        if (state.compare_exchange_weak(s, s | tombstone, std::memory_order_release, std::memory_order_relaxed))
+        {
+            reinterpret_cast<detail::lazy_list_base*>(s)->marked.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+INTRUSIVE_LIST_INLINE intrusive::detail::lazy_list_base::lazy_list_base() noexcept
+    : fake{&fake, &fake, {0}}
+    , reclaimed_count(0)
+    , marked(0)
+{}
+
+INTRUSIVE_LIST_INLINE intrusive::detail::lazy_list_base::~lazy_list_base()
+{
+    clear();
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::lazy_list_base::push_back(lazy_list_element_base& obj) noexcept
+{
+    insert(fake, obj);
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::lazy_list_base::push_front(lazy_list_element_base& obj) noexcept
+{
+    insert(*fake.next, obj);
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::lazy_list_base::insert(lazy_list_element_base& pos, lazy_list_element_base& obj) noexcept
+{
+    assert(obj.state.load(std::memory_order_relaxed) == 0 && "element is already linked");
+    obj.next = &pos;
+    obj.prev = pos.prev;
+    pos.prev->next = &obj;
+    pos.prev = &obj;
+    obj.state.store(reinterpret_cast<std::uintptr_t>(this), std::memory_order_release);
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::lazy_list_base::erase(lazy_list_element_base& obj) noexcept
+{
+    /*
+    exchange, а не store: элемент могли пометить только что, и тогда
+    он попадает в reclaimed.
+    */
+    obj.prev->next = obj.next;
+    obj.next->prev = obj.prev;
+    obj.prev = nullptr;
+    obj.next = nullptr;
+    std::uintptr_t s = obj.state.exchange(0, std::memory_order_acq_rel);
+    assert((s & ~lazy_list_element_base::tombstone) == reinterpret_cast<std::uintptr_t>(this) && "element is not in this list");
+    if ((s & lazy_list_element_base::tombstone) != 0)
+        ++reclaimed_count;
+}
+
+INTRUSIVE_LIST_INLINE intrusive::lazy_list_element_base* intrusive::detail::lazy_list_base::pop_front() noexcept
+{
+    lazy_list_element_base* first = fake.next;
+    if (first->is_tombstone())
+    {
+        lazy_list_element_base* survivor = detach_run(first);
+        while (first != survivor)
+        {
+            lazy_list_element_base* next = first->next;
+            release(*first);
+            first = next;
+        }
+    }
+    if (first == &fake)
+        return nullptr;
+    erase(*first);
+    return first;
+}
+
+INTRUSIVE_LIST_INLINE std::size_t intrusive::detail::lazy_list_base::compact() noexcept
+{
+    std::size_t before = reclaimed_count;
+    lazy_list_element_base* p = fake.next;
+    while (p != &fake)
+    {
+        if (!p->is_tombstone())
+        {
+            p = p->next;
+            continue;
+        }
+
+        lazy_list_element_base* survivor = detach_run(p);
+        while (p != survivor)
+        {
+            lazy_list_element_base* next = p->next;
+            release(*p);
+            p = next;
+        }
+    }
+    return reclaimed_count - before;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::lazy_list_base::clear() noexcept
+{
+    /*
+    Живые элементы здесь могут пометить в любой момент, поэтому, как и
+    в erase, state обнуляется exchange'ем, и tombstone считается по тому,
+    что было в state до обнуления.
+    */
+    lazy_list_element_base* p = fake.next;
+    while (p != &fake)
+    {
+        lazy_list_element_base* next = p->next;
+        p->prev = nullptr;
+        p->next = nullptr;
+        std::uintptr_t s = p->state.exchange(0, std::memory_order_acq_rel);
+        if ((s & lazy_list_element_base::tombstone) != 0)
+            ++reclaimed_count;
+        p = next;
+    }
+    fake.prev = &fake;
+    fake.next = &fake;
+}
+
+INTRUSIVE_LIST_INLINE bool intrusive::detail::lazy_list_base::empty() const noexcept
+{
+    return skip_tombstones(fake.next) == &fake;
+}
+
+INTRUSIVE_LIST_INLINE std::size_t intrusive::detail::lazy_list_base::size() const noexcept
+{
+    std::size_t n = 0;
+    for (lazy_list_element_base const* p = fake.next; p != &fake; p = p->next)
+        if (!p->is_tombstone())
+            ++n;
+    return n;
+}
+
+/*
+marked увеличивается уже после того, как бит поставлен, поэтому
+владелец может выкинуть элемент раньше, чем его пометка попадет в
+счетчик, и на мгновение reclaimed обгоняет marked.
+*/
+INTRUSIVE_LIST_INLINE std::size_t intrusive::detail::lazy_list_base::pending() const noexcept
+{
+    std::size_t m = marked.load(std::memory_order_relaxed);
+    return m > reclaimed_count ? m - reclaimed_count : 0;
+}
+
+INTRUSIVE_LIST_INLINE intrusive::lazy_list_element_base* intrusive::detail::lazy_list_base::detach_run(lazy_list_element_base* first) noexcept
+{
+    lazy_list_element_base* before = first->prev;
+    lazy_list_element_base* survivor = first;
+    do
+    {
+        survivor = survivor->next;
+        ++reclaimed_count;
+    }
+    while (survivor->is_tombstone());
+
+    before->next = survivor;
+    survivor->prev = before;
+    return survivor;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::lazy_list_base::release(lazy_list_element_base& obj) noexcept
+{
+    obj.prev = nullptr;
+    obj.next = nullptr;
+    obj.state.store(0, std::memory_order_release);
+}
@@ -0,0 +1,561 @@
+#pragma once
+#include "intrusive_list.h"
+#include <atomic>
+#include <cstdint>
+
+/*
+Список с ленивым удалением. unlink() элемента не трогает соседей: он
+только помечает элемент как удаленный (tombstone), и это одна запись в
+кеш-линию самого элемента. Физически помеченные элементы выкидывает из
+списка поток-владелец: при обходе через for_each, в pop_front или
+явным compact(). Идущие подряд мертвые элементы выкидываются пачкой,
+одной парой записей в живых соседей.
+
+intrusive::lazy_list<subscriber> subscribers;   // владелец -- поток рассылки
+subscribers.push_back(s);
+s.unlink();                                     // из любого потока
+subscribers.for_each([](subscriber& s) { s.notify(); });
+
+Это нужно, когда элементы отменяют из многих потоков, а список
+обходит один. Обычный unlink() пишет в prev/next обоих соседей, и
+соседи отменяемых элементов -- это строки кеша, которые в этот момент
+читает обходящий поток и пишут другие отменяющие. В concurrent_list к
+этому добавляется еще и лок на запись.
+
+Кто что может делать:
+- unlink() и is_linked() -- из любого потока, в любой момент, пока
+  жив список;
+- все остальное (вставка, erase, обход, compact, clear) -- только из
+  одного потока-владельца или под внешним локом. Пока владелец
+  обходит список, мертвые элементы, до которых он уже дошел, никуда не
+  деваются, поэтому итераторы остаются валидными, даже если элемент
+  под итератором в этот момент помечают из другого потока;
+- элемент, помеченный через unlink(), остается в списке, пока его не
+  выкинет владелец. Освобождать его память можно только после этого:
+  когда is_linked() вернет false, или в disposer'е
+  compact_and_dispose(). Деструктор хука проверяет это assert'ом.
+
+Итераторы и for_each пропускают мертвые элементы. Итераторы при этом
+ничего не выкидывают (обход через begin()/end() может быть и const),
+for_each и compact выкидывают.
+
+Счетчики: pending() -- сколько помеченных элементов еще лежат в
+списке, reclaimed() -- сколько всего выкинуто. Помечающий поток
+увеличивает один общий счетчик списка. Он лежит в отдельной строке
+кеша, которую не читает обход и не пишет владелец, так что unlink() --
+это запись в свой элемент и атомарное сложение в эту строку, а не
+запись в двух соседей под локом.
+
+Если отменяет тот же поток, что и обходит, lazy_list не нужен:
+обычный list_element::unlink() дешевле пометки, а обход потом все
+равно проходит по мертвым элементам (см. bench_lazy_list.cpp).
+*/
+namespace intrusive
+{
+    namespace detail
+    {
+        struct lazy_list_base;
+    }
+
+    struct lazy_list_element_base
+    {
+        /*
+        Младший бит state -- tombstone, остальные -- список, в котором
+        лежит элемент. 0 -- элемент ни в каком списке.
+        */
+        static constexpr std::uintptr_t tombstone = 1;
+
+        /*
+        Помечает элемент как удаленный. Из любого потока. Если элемент
+        ни в каком списке не лежит или уже помечен, ничего не делает.
+        */
+        void unlink() noexcept;
+
+        bool is_tombstone() const noexcept
+        {
+            return (state.load(std::memory_order_acquire) & tombstone) != 0;
+        }
+
+        lazy_list_element_base* prev;
+        lazy_list_element_base* next;
+        std::atomic<std::uintptr_t> state;
+    };
+
+    namespace detail
+    {
+        struct lazy_list_base
+        {
+            lazy_list_base() noexcept;
+            ~lazy_list_base();
+            lazy_list_base(lazy_list_base const&) = delete;
+            lazy_list_base& operator=(lazy_list_base const&) = delete;
+
+            void push_back(lazy_list_element_base&) noexcept;
+            void push_front(lazy_list_element_base&) noexcept;
+            void insert(lazy_list_element_base& pos, lazy_list_element_base&) noexcept;
+
+            /*
+            Выкидывает элемент сразу, живой он или уже помеченный.
+            */
+            void erase(lazy_list_element_base&) noexcept;
+
+            /*
+            Первый живой элемент, отвязанный от списка; мертвые перед
+            ним выкидываются. nullptr, если живых нет.
+            */
+            lazy_list_element_base* pop_front() noexcept;
+
+            std::size_t compact() noexcept;
+            void clear() noexcept;
+            bool empty() const noexcept;
+            std::size_t size() const noexcept;
+            std::size_t pending() const noexcept;
+
+            /*
+            Первый живой элемент начиная с p, или &fake.
+            */
+            static lazy_list_element_base* skip_tombstones(lazy_list_element_base* p) noexcept
+            {
+                while (p->is_tombstone())
+                    p = p->next;
+                return p;
+            }
+
+            /*
+            first -- мертвый элемент. Выкидывает его и все мертвые
+            элементы за ним до первого живого (или fake), который и
+            возвращает. next у выкинутых по-прежнему ведут от first к
+            этому живому элементу, но сами элементы еще не освобождены:
+            их надо пройти через release().
+            */
+            lazy_list_element_base* detach_run(lazy_list_element_base* first) noexcept;
+
+            /*
+            Обнуляет выкинутый элемент. После этого is_linked() в
+            других потоках вернет false, и элемент можно удалять.
+            */
+            static void release(lazy_list_element_base&) noexcept;
+
+            lazy_list_element_base fake;
+            std::size_t reclaimed_count;
+
+            /*
+            Пишут только помечающие потоки.
+            */
+            alignas(64) std::atomic<std::size_t> marked;
+        };
+    }
+
+    template <typename Tag>
+    struct lazy_list_element;
+
+    namespace detail
+    {
+        template <typename Tag>
+        lazy_list_element<Tag>& find_lazy_list_hook(lazy_list_element<Tag>&) noexcept;
+
+        template <typename T, typename Tag>
+        using lazy_list_hook_t = std::remove_reference_t<decltype(find_lazy_list_hook<Tag>(std::declval<std::remove_const_t<T>&>()))>;
+
+        template <typename T, typename Tag, typename = void>
+        constexpr bool has_lazy_list_hook_v = false;
+
+        template <typename T, typename Tag>
+        constexpr bool has_lazy_list_hook_v<T, Tag, std::void_t<lazy_list_hook_t<T, Tag>>> = true;
+    }
+
+    /*
+    Хук для lazy_list. 24 байта: prev, next и список с битом
+    tombstone. Сам в деструкторе не отвязывается: отвязывать может
+    только владелец списка, а деструктор может выполняться в любом
+    потоке.
+    */
+    template <typename Tag = default_tag>
+    struct lazy_list_element : private lazy_list_element_base
+    {
+        lazy_list_element() noexcept;
+        ~lazy_list_element() noexcept;
+        lazy_list_element(lazy_list_element const&) = delete;
+        lazy_list_element& operator=(lazy_list_element const&) = delete;
+
+        void unlink() noexcept;
+
+        /*
+        true, пока элемент в списке, в том числе помеченный, но еще
+        не выкинутый.
+        */
+        bool is_linked() const noexcept;
+
+        bool is_tombstone() const noexcept;
+
+        template <typename T, typename Tag1>
+        friend struct lazy_list;
+
+        template <typename Tag1, typename T>
+        friend std::enable_if_t<detail::has_lazy_list_hook_v<T, Tag1>, lazy_list_element_base&> to_base(T&) noexcept;
+
+        template <typename T1, typename Tag1>
+        friend T1& from_base(lazy_list_element_base&) noexcept;
+    };
+
+    template <typename Tag, typename T>
+    std::enable_if_t<detail::has_lazy_list_hook_v<T, Tag>, lazy_list_element_base&> to_base(T&) noexcept;
+
+    template <typename T, typename Tag>
+    T& from_base(lazy_list_element_base&) noexcept;
+
+    template <typename T, typename Tag>
+    struct lazy_list_iterator
+    {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::remove_const_t<T>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = value_type*;
+        using reference = value_type&;
+
+        lazy_list_iterator() = default;
+        template <typename NonConstIterator>
+        lazy_list_iterator(NonConstIterator other,
+            std::enable_if_t<
+                std::is_same_v<NonConstIterator, lazy_list_iterator<std::remove_const_t<T>, Tag>> &&
+                std::is_const_v<T>>* = nullptr) noexcept
+            : current(other.current)
+        {}
+
+        T& operator*() const noexcept;
+        T* operator->() const noexcept;
+
+        /*
+        К следующему живому элементу.
+        */
+        lazy_list_iterator& operator++() & noexcept;
+        lazy_list_iterator operator++(int) & noexcept;
+
+        bool operator==(lazy_list_iterator const& rhs) const& noexcept;
+        bool operator!=(lazy_list_iterator const& rhs) const& noexcept;
+
+    private:
+        explicit lazy_list_iterator(lazy_list_element_base* current) noexcept;
+
+    private:
+        lazy_list_element_base* current;
+
+        template <typename T1, typename Tag1>
+        friend struct lazy_list_iterator;
+
+        template <typename T1, typename Tag1>
+        friend struct lazy_list;
+    };
+
+    template <typename T, typename Tag = default_tag>
+    struct lazy_list : private detail::lazy_list_base
+    {
+        static_assert(detail::has_lazy_list_hook_v<T, Tag>,
+            "value type is not convertible to lazy_list_element");
+
+        using iterator = lazy_list_iterator<T, Tag>;
+        using const_iterator = lazy_list_iterator<T const, Tag>;
+
+        lazy_list() noexcept = default;
+
+        /*
+        Отвязывает все элементы, живые и мертвые. В этот момент их
+        никто не должен помечать.
+        */
+        ~lazy_list() = default;
+
+        void push_back(T&) noexcept;
+        void push_front(T&) noexcept;
+        iterator insert(const_iterator pos, T&) noexcept;
+
+        /*
+        Только из потока-владельца.
+        */
+        void erase(T&) noexcept;
+
+        /*
+        nullptr, если живых элементов нет.
+        */
+        T* pop_front() noexcept;
+
+        /*
+        Выкидывает все мертвые элементы, возвращает их количество.
+        */
+        std::size_t compact() noexcept;
+
+        /*
+        То же, но каждый выкинутый элемент передается в disposer(T*)
+        уже отвязанным, и disposer может его удалить.
+        */
+        template <typename Disposer>
+        std::size_t compact_and_dispose(Disposer disposer);
+
+        /*
+        Вызывает f(T&) для каждого живого элемента и по дороге
+        выкидывает мертвые. f может помечать элементы этого списка
+        через unlink(), но не вставлять и не выкидывать их.
+        */
+        template <typename F>
+        void for_each(F f);
+
+        void clear() noexcept;
+
+        iterator begin() noexcept;
+        const_iterator begin() const noexcept;
+        iterator end() noexcept;
+        const_iterator end() const noexcept;
+
+        /*
+        Только живые элементы, O(n).
+        */
+        bool empty() const noexcept;
+        std::size_t size() const noexcept;
+
+        /*
+        Помечено, но еще не выкинуто. Помеченные другими потоками
+        элементы могут появиться в счетчике чуть позже, чем в списке.
+        */
+        std::size_t pending() const noexcept;
+
+        /*
+        Сколько мертвых элементов выкинуто за все время.
+        */
+        std::size_t reclaimed() const noexcept;
+    };
+}
+
+template <typename Tag>
+intrusive::lazy_list_element<Tag>::lazy_list_element() noexcept
+    : lazy_list_element_base{nullptr, nullptr, {0}}
+{}
+
+template <typename Tag>
+intrusive::lazy_list_element<Tag>::~lazy_list_element() noexcept
+{
+    assert(state.load(std::memory_order_acquire) == 0 && "element is still in a lazy_list");
+}
+
+template <typename Tag>
+void intrusive::lazy_list_element<Tag>::unlink() noexcept
+{
+    lazy_list_element_base::unlink();
+}
+
+template <typename Tag>
+bool intrusive::lazy_list_element<Tag>::is_linked() const noexcept
+{
+    return state.load(std::memory_order_acquire) != 0;
+}
+
+template <typename Tag>
+bool intrusive::lazy_list_element<Tag>::is_tombstone() const noexcept
+{
+    return lazy_list_element_base::is_tombstone();
+}
+
+template <typename Tag, typename T>
+std::enable_if_t<intrusive::detail::has_lazy_list_hook_v<T, Tag>, intrusive::lazy_list_element_base&> intrusive::to_base(T& obj) noexcept
+{
+    return static_cast<detail::lazy_list_hook_t<T, Tag>&>(obj);
+}
+
+template <typename T, typename Tag>
+T& intrusive::from_base(lazy_list_element_base& base) noexcept
+{
+    return static_cast<T&>(static_cast<detail::lazy_list_hook_t<T, Tag>&>(base));
+}
+
+template <typename T, typename Tag>
+T& intrusive::lazy_list_iterator<T, Tag>::operator*() const noexcept
+{
+    return from_base<std::remove_const_t<T>, Tag>(*current);
+}
+
+template <typename T, typename Tag>
+T* intrusive::lazy_list_iterator<T, Tag>::operator->() const noexcept
+{
+    return &from_base<std::remove_const_t<T>, Tag>(*current);
+}
+
+template <typename T, typename Tag>
+intrusive::lazy_list_iterator<T, Tag>& intrusive::lazy_list_iterator<T, Tag>::operator++() & noexcept
+{
+    current = detail::lazy_list_base::skip_tombstones(current->next);
+    return *this;
+}
+
+template <typename T, typename Tag>
+intrusive::lazy_list_iterator<T, Tag> intrusive::lazy_list_iterator<T, Tag>::operator++(int) & noexcept
+{
+    lazy_list_iterator copy = *this;
+    ++*this;
+    return copy;
+}
+
+template <typename T, typename Tag>
+bool intrusive::lazy_list_iterator<T, Tag>::operator==(lazy_list_iterator const& rhs) const& noexcept
+{
+    return current == rhs.current;
+}
+
+template <typename T, typename Tag>
+bool intrusive::lazy_list_iterator<T, Tag>::operator!=(lazy_list_iterator const& rhs) const& noexcept
+{
+    return current != rhs.current;
+}
+
+template <typename T, typename Tag>
+intrusive::lazy_list_iterator<T, Tag>::lazy_list_iterator(lazy_list_element_base* current) noexcept
+    : current(current)
+{}
+
+template <typename T, typename Tag>
+void intrusive::lazy_list<T, Tag>::push_back(T& obj) noexcept
+{
+    detail::lazy_list_base::push_back(to_base<Tag>(obj));
+}
+
+template <typename T, typename Tag>
+void intrusive::lazy_list<T, Tag>::push_front(T& obj) noexcept
+{
+    detail::lazy_list_base::push_front(to_base<Tag>(obj));
+}
+
+template <typename T, typename Tag>
+typename intrusive::lazy_list<T, Tag>::iterator intrusive::lazy_list<T, Tag>::insert(const_iterator pos, T& obj) noexcept
+{
+    lazy_list_element_base& base = to_base<Tag>(obj);
+    detail::lazy_list_base::insert(*pos.current, base);
+    return iterator(&base);
+}
+
+template <typename T, typename Tag>
+void intrusive::lazy_list<T, Tag>::erase(T& obj) noexcept
+{
+    detail::lazy_list_base::erase(to_base<Tag>(obj));
+}
+
+template <typename T, typename Tag>
+T* intrusive::lazy_list<T, Tag>::pop_front() noexcept
+{
+    lazy_list_element_base* base = detail::lazy_list_base::pop_front();
+    return base != nullptr ? &from_base<T, Tag>(*base) : nullptr;
+}
+
+template <typename T, typename Tag>
+std::size_t intrusive::lazy_list<T, Tag>::compact() noexcept
+{
+    return detail::lazy_list_base::compact();
+}
+
+template <typename T, typename Tag>
+template <typename Disposer>
+std::size_t intrusive::lazy_list<T, Tag>::compact_and_dispose(Disposer disposer)
+{
+    std::size_t before = reclaimed_count;
+    lazy_list_element_base* p = fake.next;
+    while (p != &fake)
+    {
+        if (!p->is_tombstone())
+        {
+            p = p->next;
+            continue;
+        }
+
+        lazy_list_element_base* survivor = detach_run(p);
+        while (p != survivor)
+        {
+            lazy_list_element_base* next = p->next;
+            release(*p);
+            disposer(&from_base<T, Tag>(*p));
+            p = next;
+        }
+    }
+    return reclaimed_count - before;
+}
+
+template <typename T, typename Tag>
+template <typename F>
+void intrusive::lazy_list<T, Tag>::for_each(F f)
+{
+    lazy_list_element_base* p = fake.next;
+    while (p != &fake)
+    {
+        if (p->is_tombstone())
+        {
+            lazy_list_element_base* survivor = detach_run(p);
+            while (p != survivor)
+            {
+                lazy_list_element_base* next = p->next;
+                release(*p);
+                p = next;
+            }
+            continue;
+        }
+
+        /*
+        next читается после f: f может пометить и следующий элемент,
+        тогда его выкинет следующая итерация.
+        */
+        f(from_base<T, Tag>(*p));
+        p = p->next;
+    }
+}
+
+template <typename T, typename Tag>
+void intrusive::lazy_list<T, Tag>::clear() noexcept
+{
+    detail::lazy_list_base::clear();
+}
+
+template <typename T, typename Tag>
+typename intrusive::lazy_list<T, Tag>::iterator intrusive::lazy_list<T, Tag>::begin() noexcept
+{
+    return iterator(skip_tombstones(fake.next));
+}
+
+template <typename T, typename Tag>
+typename intrusive::lazy_list<T, Tag>::const_iterator intrusive::lazy_list<T, Tag>::begin() const noexcept
+{
+    return const_iterator(skip_tombstones(fake.next));
+}
+
+template <typename T, typename Tag>
+typename intrusive::lazy_list<T, Tag>::iterator intrusive::lazy_list<T, Tag>::end() noexcept
+{
+    return iterator(&fake);
+}
+
+template <typename T, typename Tag>
+typename intrusive::lazy_list<T, Tag>::const_iterator intrusive::lazy_list<T, Tag>::end() const noexcept
+{
+    return const_iterator(const_cast<lazy_list_element_base*>(&fake));
+}
+
+template <typename T, typename Tag>
+bool intrusive::lazy_list<T, Tag>::empty() const noexcept
+{
+    return detail::lazy_list_base::empty();
+}
+
+template <typename T, typename Tag>
+std::size_t intrusive::lazy_list<T, Tag>::size() const noexcept
+{
+    return detail::lazy_list_base::size();
+}
+
+template <typename T, typename Tag>
+std::size_t intrusive::lazy_list<T, Tag>::pending() const noexcept
+{
+    return detail::lazy_list_base::pending();
+}
+
+template <typename T, typename Tag>
+std::size_t intrusive::lazy_list<T, Tag>::reclaimed() const noexcept
+{
+    return reclaimed_count;
+}
+
+#ifdef INTRUSIVE_LIST_HEADER_ONLY
+#include "intrusive_lazy_list.cpp"
+#endif
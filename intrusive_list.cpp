@@ -1,65 +1,47 @@
 #include "intrusive_list.h"
 #include <cassert>
 
-namespace
+/*
+Этот файл либо компилируется как обычная единица трансляции, либо, если
+определен INTRUSIVE_LIST_HEADER_ONLY, включается в конец intrusive_list.h
+и тогда все функции ниже становятся inline.
+*/
+INTRUSIVE_LIST_INLINE std::size_t intrusive::detail::traversal_bucket(std::size_t length) noexcept
 {
-    template <typename T>
-    void triswap(T& a, T& b, T& c) noexcept
-    {
-        T copy = a;
-        a = b;
-        b = c;
-        c = copy;
-    }
+    std::size_t bucket = length == 0 ? 0 : std::size_t(64 - __builtin_clzll(length));
+    return bucket < list_statistics::histogram_buckets ? bucket : list_statistics::histogram_buckets - 1;
 }
 
-void intrusive::list_element_base::unlink() noexcept
+INTRUSIVE_LIST_INLINE void intrusive::detail::tag_statistics_storage::add(list_statistics const& s) noexcept
 {
-    assert(prev != nullptr);
-    assert(next != nullptr);
-    assert(prev != this);
-    assert(next != this);
-    prev->next = next;
-    next->prev = prev;
-    prev = nullptr;
-    next = nullptr;
+    links.fetch_add(s.links, std::memory_order_relaxed);
+    unlinks.fetch_add(s.unlinks, std::memory_order_relaxed);
+    splices.fetch_add(s.splices, std::memory_order_relaxed);
+    spliced_elements.fetch_add(s.spliced_elements, std::memory_order_relaxed);
+    clears.fetch_add(s.clears, std::memory_order_relaxed);
+    cleared_elements.fetch_add(s.cleared_elements, std::memory_order_relaxed);
+
+    std::uint64_t watermark = high_watermark.load(std::memory_order_relaxed);
+    while (watermark < s.high_watermark
+        && !high_watermark.compare_exchange_weak(watermark, s.high_watermark, std::memory_order_relaxed))
+    {}
+
+    for (std::size_t i = 0; i != list_statistics::histogram_buckets; ++i)
+        if (s.traversals[i] != 0)
+            traversals[i].fetch_add(s.traversals[i], std::memory_order_relaxed);
 }
 
-void intrusive::list_element_base::try_unlink() noexcept
+INTRUSIVE_LIST_INLINE intrusive::list_statistics intrusive::detail::tag_statistics_storage::load() const noexcept
 {
-    assert((prev == nullptr) == (next == nullptr));
-    if (prev)
-        unlink();
-}
-
-void intrusive::list_element_base::clear() noexcept
-{
-    auto* p = next;    
-    while (p != this)
-    {
-        auto* n = p->next;
-        p->prev = nullptr;
-        p->next = nullptr;
-        p = n;
-    }
-
-    prev = this;
-    next = this;
-}
-
-void intrusive::list_element_base::insert(list_element_base& obj) noexcept
-{
-    obj.next = this;
-    obj.prev = prev;
-    prev->next = &obj;
-    prev = &obj;
-}
-
-void intrusive::list_element_base::splice(list_element_base& first, list_element_base& last) noexcept
-{
-    if (&first == &last)
-        return;
-
-    triswap(prev->next, first.prev->next, last.prev->next);
-    triswap(prev, last.prev, first.prev);
+    list_statistics s;
+    s.links = links.load(std::memory_order_relaxed);
+    s.unlinks = unlinks.load(std::memory_order_relaxed);
+    s.splices = splices.load(std::memory_order_relaxed);
+    s.spliced_elements = spliced_elements.load(std::memory_order_relaxed);
+    s.clears = clears.load(std::memory_order_relaxed);
+    s.cleared_elements = cleared_elements.load(std::memory_order_relaxed);
+    s.high_watermark = high_watermark.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i != list_statistics::histogram_buckets; ++i)
+        s.traversals[i] = traversals[i].load(std::memory_order_relaxed);
+    return s;
 }
@@ -1,8 +1,72 @@
 #pragma once
+#include <atomic>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iterator>
 #include <type_traits>
 
+/*
+Операции нешаблонной list_element_base, list_element, list_iterator и
+основные операции list (вставка, удаление, splice, обход) -- constexpr.
+Список, который собирается в constexpr-конструкторе статического
+объекта, инициализируется константно: он попадает в .data уже
+связанным, и при запуске не выполняется ни одной инструкции.
+
+struct handler : intrusive::list_element<>
+{
+    constexpr handler(char const* name) noexcept : name(name) {}
+    char const* name;
+};
+
+struct registry
+{
+    handler open{"open"}, close{"close"};
+    intrusive::list<handler> all;
+
+    constexpr registry() noexcept
+    {
+        all.push_back(open);
+        all.push_back(close);
+    }
+};
+
+constinit registry handlers;    // в C++17 -- просто registry handlers;
+
+Пустой глобальный list тоже инициализируется константно, поэтому в
+него можно добавлять элементы из динамических инициализаторов других
+единиц трансляции, не думая о порядке инициализации.
+
+constexpr-функции неявно inline, поэтому операции list_element_base
+определены прямо здесь, а не в intrusive_list.cpp, и каждый push_back
+инлайнится. База при этом осталась нешаблонной, так что код
+по-прежнему не дублируется для каждого тега. Хуки index_link и
+offset_link в константных выражениях не работают: их ссылки
+вычисляются через reinterpret_cast.
+
+В intrusive_list.cpp осталась статистика списков. Если определить
+INTRUSIVE_LIST_HEADER_ONLY, он включается в этот заголовок, функции
+становятся inline, а сам .cpp собирать не нужно.
+*/
+#ifdef INTRUSIVE_LIST_HEADER_ONLY
+#define INTRUSIVE_LIST_INLINE inline
+#else
+#define INTRUSIVE_LIST_INLINE
+#endif
+
+/*
+constexpr-деструкторы появились только в C++20. В C++17 list и
+list_element тоже инициализируются константно (деструктор для этого не
+нужен), но создать и разрушить список внутри constexpr-функции можно
+только начиная с C++20.
+*/
+#if __cpp_constexpr >= 201907L
+#define INTRUSIVE_LIST_CONSTEXPR_DESTRUCTOR constexpr
+#else
+#define INTRUSIVE_LIST_CONSTEXPR_DESTRUCTOR
+#endif
+
 /*
 Я разместил всё в неймспейсе, чтобы подсократить имена:
 intrusive_list         -> list
@@ -13,25 +77,473 @@ namespace intrusive
 {
     struct default_tag;
 
+    namespace detail
+    {
+        struct link_mode_kind;
+        struct size_kind;
+        struct link_kind;
+        struct stats_kind;
+    }
+
+    /*
+    Режимы связывания, как в Boost.Intrusive.
+    https://www.boost.org/doc/libs/1_74_0/doc/html/intrusive/safe_hook.html
+
+    auto_unlink -- элемент сам отвязывается от списка при удалении.
+    Это режим по умолчанию.
+
+    safe_link -- элемент при удалении не отвязывается, а проверяет
+    assert'ом, что он ни в каком списке не лежит. list::clear() и
+    erase() по-прежнему обнуляют prev/next у выкинутых элементов.
+
+    normal_link -- никаких обнулений и проверок. list::clear(), ~list()
+    и move-присваивание становятся O(1): ноды не обходятся, их
+    prev/next остаются висячими. Пользователь сам отвечает за то,
+    чтобы не удалять элемент, пока он лежит в списке.
+    */
+    struct auto_unlink
+    {
+        using kind = detail::link_mode_kind;
+    };
+
+    struct safe_link
+    {
+        using kind = detail::link_mode_kind;
+    };
+
+    struct normal_link
+    {
+        using kind = detail::link_mode_kind;
+    };
+
+    /*
+    Опция list: хранить размер списка и отдавать size() за O(1).
+    Без нее size() обходит список.
+
+    Счетчик обновляют только операции list, поэтому такой список нельзя
+    использовать с auto_unlink элементами: элемент, отвязавшийся сам в
+    деструкторе или через unlink(), не может уменьшить размер. Это
+    проверяется static_assert'ом, так же сделано в Boost.Intrusive.
+    */
+    struct constant_time_size
+    {
+        using kind = detail::size_kind;
+    };
+
+    namespace detail
+    {
+        /*
+        Опции передаются списком типов. У каждой опции есть вложенный
+        kind, по нему ищется опция нужного вида. Если такой нет,
+        используется Default.
+        */
+        template <typename Kind, typename Default, typename... Options>
+        struct find_option
+        {
+            using type = Default;
+        };
+
+        template <typename Kind, typename Default, typename Option, typename... Options>
+        struct find_option<Kind, Default, Option, Options...>
+            : std::conditional_t<std::is_same_v<typename Option::kind, Kind>,
+                                 std::enable_if<true, Option>,
+                                 find_option<Kind, Default, Options...>>
+        {};
+
+        template <typename Kind, typename Default, typename... Options>
+        using find_option_t = typename find_option<Kind, Default, Options...>::type;
+
+        /*
+        Счетчик размера для list. Версия без счетчика пустая и list
+        наследуется от нее приватно, поэтому из-за EBO она не занимает
+        места, а все обновления компилируются в ничто.
+        */
+        template <bool Counted>
+        struct size_counter
+        {
+            constexpr void set_size(std::size_t) noexcept {}
+            constexpr void add_size(std::size_t) noexcept {}
+            constexpr void sub_size(std::size_t) noexcept {}
+        };
+
+        template <>
+        struct size_counter<true>
+        {
+            constexpr void set_size(std::size_t n) noexcept { count = n; }
+            constexpr void add_size(std::size_t n) noexcept { count += n; }
+            constexpr void sub_size(std::size_t n) noexcept { count -= n; }
+
+            std::size_t count = 0;
+        };
+
+        template <typename... Options>
+        constexpr bool constant_time_size_v =
+            std::is_same_v<find_option_t<size_kind, void, Options...>, constant_time_size>;
+    }
+
+    /*
+    Опция list: считать операции над списком. Счетчики лежат в самом
+    списке и читаются через list::stats(), а при удалении списка (или
+    по publish_stats()) прибавляются к общим счетчикам его тега,
+    которые отдает tag_statistics<Tag>().
+
+    С TraversalHistogram список еще собирает гистограмму длин обходов:
+    for (node& x : list.tracked()) ... считает шаги итератора и по
+    окончании цикла кладет их в гистограмму.
+
+    Без опции счетчики -- пустая база, как size_counter, и все вызовы
+    компилируются в ничто: код list получается тем же, что и без
+    статистики вообще.
+
+    Список видит только свои операции, а auto_unlink элемент может
+    отвязаться и мимо него, и тогда unlinks, length и high_watermark
+    разъехались бы с правдой. Поэтому list_stats, как и
+    constant_time_size, требует safe_link или normal_link элементов.
+    */
+    template <bool TraversalHistogram = false>
+    struct list_stats
+    {
+        using kind = detail::stats_kind;
+        static constexpr bool traversal_histogram = TraversalHistogram;
+    };
+
+    struct list_statistics
+    {
+        static constexpr std::size_t histogram_buckets = 32;
+
+        std::uint64_t links = 0;
+        std::uint64_t unlinks = 0;
+        std::uint64_t splices = 0;
+        std::uint64_t spliced_elements = 0;
+        std::uint64_t clears = 0;
+
+        /*
+        Сколько элементов обошли clear() и clear_and_dispose(). Для
+        normal_link clear() никого не обходит.
+        */
+        std::uint64_t cleared_elements = 0;
+
+        std::uint64_t length = 0;
+        std::uint64_t high_watermark = 0;
+
+        /*
+        traversals[0] -- пустые обходы, traversals[k] -- обходы длиной
+        от 2^(k-1) до 2^k - 1.
+        */
+        std::uint64_t traversals[histogram_buckets] = {};
+    };
+
+    namespace detail
+    {
+        template <typename... Options>
+        constexpr bool has_stats_v = !std::is_void_v<find_option_t<stats_kind, void, Options...>>;
+
+        template <typename Stats>
+        constexpr bool traversal_histogram_v = Stats::traversal_histogram;
+
+        template <>
+        constexpr bool traversal_histogram_v<void> = false;
+
+        template <typename... Options>
+        constexpr bool has_traversal_histogram_v = traversal_histogram_v<find_option_t<stats_kind, void, Options...>>;
+
+        std::size_t traversal_bucket(std::size_t length) noexcept;
+
+        /*
+        Общие счетчики всех списков одного тега. Списки разных потоков
+        прибавляют к ним свои, поэтому они атомарные.
+        */
+        struct tag_statistics_storage
+        {
+            void add(list_statistics const&) noexcept;
+            list_statistics load() const noexcept;
+
+            std::atomic<std::uint64_t> links{0};
+            std::atomic<std::uint64_t> unlinks{0};
+            std::atomic<std::uint64_t> splices{0};
+            std::atomic<std::uint64_t> spliced_elements{0};
+            std::atomic<std::uint64_t> clears{0};
+            std::atomic<std::uint64_t> cleared_elements{0};
+            std::atomic<std::uint64_t> high_watermark{0};
+            std::atomic<std::uint64_t> traversals[list_statistics::histogram_buckets] = {};
+        };
+
+        template <typename Tag>
+        inline tag_statistics_storage tag_statistics_v;
+
+        template <typename Tag, bool Enabled>
+        struct stats_recorder
+        {
+            constexpr void note_link(std::size_t) noexcept {}
+            constexpr void note_unlink(std::size_t) noexcept {}
+            constexpr void note_splice_in(std::size_t) noexcept {}
+            constexpr void note_splice_out(std::size_t) noexcept {}
+            constexpr void note_clear(std::size_t) noexcept {}
+        };
+
+        template <typename Tag>
+        struct stats_recorder<Tag, true>
+        {
+            stats_recorder() = default;
+            stats_recorder(stats_recorder const&) = delete;
+            stats_recorder& operator=(stats_recorder const&) = delete;
+
+            ~stats_recorder()
+            {
+                publish();
+            }
+
+            void note_link(std::size_t n) noexcept
+            {
+                data.links += n;
+                grow(n);
+            }
+
+            void note_unlink(std::size_t n) noexcept
+            {
+                data.unlinks += n;
+                shrink(n);
+            }
+
+            void note_splice_in(std::size_t n) noexcept
+            {
+                ++data.splices;
+                data.spliced_elements += n;
+                grow(n);
+            }
+
+            void note_splice_out(std::size_t n) noexcept
+            {
+                shrink(n);
+            }
+
+            void note_clear(std::size_t walked) noexcept
+            {
+                ++data.clears;
+                data.cleared_elements += walked;
+                data.length = 0;
+            }
+
+            void note_traversal(std::size_t length) noexcept
+            {
+                ++data.traversals[traversal_bucket(length)];
+            }
+
+            /*
+            Прибавляет счетчики к общим счетчикам тега и обнуляет их.
+            Длина при этом остается: элементы никуда не делись.
+            */
+            void publish() noexcept
+            {
+                tag_statistics_v<Tag>.add(data);
+                std::uint64_t length = data.length;
+                data = list_statistics();
+                data.length = length;
+                data.high_watermark = length;
+            }
+
+            list_statistics data;
+
+        private:
+            void grow(std::size_t n) noexcept
+            {
+                data.length += n;
+                if (data.length > data.high_watermark)
+                    data.high_watermark = data.length;
+            }
+
+            void shrink(std::size_t n) noexcept
+            {
+                data.length -= n < data.length ? n : data.length;
+            }
+        };
+
+        template <typename List>
+        struct tracked_range;
+    }
+
+    /*
+    Сумма счетчиков всех удаленных списков тега Tag и тех, что
+    вызывали publish_stats(). high_watermark -- максимум по спискам.
+    */
+    template <typename Tag>
+    list_statistics tag_statistics() noexcept;
+
     struct list_element_base
     {
-        void unlink() noexcept;
-        void try_unlink() noexcept;
-        void clear() noexcept;
-        void insert(list_element_base&) noexcept;
-        void splice(list_element_base& first, list_element_base& last) noexcept;
+        constexpr void unlink() noexcept;
+        constexpr void try_unlink() noexcept;
+        constexpr void clear() noexcept;
+        constexpr void insert(list_element_base&) noexcept;
+        constexpr void splice(list_element_base& first, list_element_base& last) noexcept;
+
+        /*
+        Варианты для normal_link: detach() не обнуляет prev/next
+        отвязанного элемента, а reset() делает из fake пустой список,
+        не трогая ноды.
+        */
+        constexpr void detach() noexcept;
+        constexpr void reset() noexcept;
+
+        /*
+        Операции над диапазоном [*this, last). unlink_range обнуляет
+        prev/next у выкинутых элементов и возвращает их количество,
+        detach_range только перевязывает границы. insert_chain вставляет
+        перед *this уже связанную между собой цепочку [first, last]
+        (last включительно).
+        */
+        constexpr std::size_t unlink_range(list_element_base& last) noexcept;
+        constexpr void detach_range(list_element_base& last) noexcept;
+        constexpr void insert_chain(list_element_base& first, list_element_base& last) noexcept;
 
         list_element_base* prev;
         list_element_base* next;
     };
 
-    template <typename Tag = default_tag>
-    struct list_element : private list_element_base
+    /*
+    Способ хранения prev/next в хуке. pointer_link -- обычные
+    указатели, он используется по умолчанию. Другие способы (например,
+    index_link из intrusive_index_link.h) задают шаблон pointer<Node>:
+    указатель, который неявно приводится к Node* и конструируется из
+    него. Такие хуки наследуются от basic_list_element_base<Link>.
+    */
+    struct pointer_link
+    {
+        using kind = detail::link_kind;
+        using node_type = list_element_base;
+    };
+
+    /*
+    То же самое, что list_element_base, только prev/next хранятся в
+    виде Link::pointer. list_element_base я оставил отдельным
+    нешаблонным классом, чтобы его операции по-прежнему можно было
+    держать в intrusive_list.cpp.
+    */
+    template <typename Link>
+    struct basic_list_element_base
+    {
+        using pointer = typename Link::template pointer<basic_list_element_base>;
+
+        constexpr void unlink() noexcept;
+        constexpr void try_unlink() noexcept;
+        constexpr void clear() noexcept;
+        constexpr void insert(basic_list_element_base&) noexcept;
+        constexpr void splice(basic_list_element_base& first, basic_list_element_base& last) noexcept;
+        constexpr void detach() noexcept;
+        constexpr void reset() noexcept;
+        constexpr std::size_t unlink_range(basic_list_element_base& last) noexcept;
+        constexpr void detach_range(basic_list_element_base& last) noexcept;
+        constexpr void insert_chain(basic_list_element_base& first, basic_list_element_base& last) noexcept;
+
+        pointer prev;
+        pointer next;
+    };
+
+    namespace detail
+    {
+        template <typename... Options>
+        using link_node_t = typename find_option_t<link_kind, pointer_link, Options...>::node_type;
+    }
+
+    template <typename Tag, typename... Options>
+    struct list_element;
+
+    /*
+    Хук в виде поля вместо базового класса:
+
+    struct node
+    {
+        int key;
+        intrusive::list_element<> hook;
+    };
+    intrusive::list<node, intrusive::member_hook<&node::hook, offsetof(node, hook)>> list;
+
+    member_hook передается на место тега. Так хук можно положить рядом
+    с полями, которые читаются при обходе, и использовать list с типами,
+    базовые классы которых поменять нельзя (если в них нет полей).
+
+    Смещение передается отдельно: из указателя на член его в
+    константном выражении не достать. Поэтому offset -- настоящая
+    константа, и from_base вычитает ее из адреса хука без всяких
+    временных объектов. offsetof определен только для standard-layout
+    типов, это проверяется static_assert'ом, а то, что смещение
+    действительно от Member, -- assert'ом в from_base.
+
+    В константных выражениях с member_hook работает всё, что идет от
+    объекта к хуку (вставка, удаление, splice), но не разыменование
+    итераторов: переход от хука к объекту -- это reinterpret_cast.
+    */
+    template <auto Member, std::size_t Offset>
+    struct member_hook;
+
+    template <typename T, typename Hook, Hook T::*Member, std::size_t Offset>
+    struct member_hook<Member, Offset>
+    {
+        static_assert(std::is_standard_layout_v<T>,
+            "member_hook requires a standard-layout value type");
+        static_assert(Offset + sizeof(Hook) <= sizeof(T), "Offset is outside of the value type");
+
+        using value_type = T;
+        using hook_type = Hook;
+        static constexpr Hook T::*member = Member;
+        static constexpr std::ptrdiff_t offset = Offset;
+    };
+
+    namespace detail
+    {
+        /*
+        По T и Tag находим, от какого именно list_element<Tag, ...>
+        унаследован T: вывод шаблонных параметров умеет приводить к
+        базовому классу. Функция только объявлена, она используется
+        лишь внутри decltype.
+        */
+        template <typename Tag, typename... Options>
+        list_element<Tag, Options...>& find_hook(list_element<Tag, Options...>&) noexcept;
+
+        template <typename Tag>
+        constexpr bool is_member_hook_v = false;
+
+        template <auto Member, std::size_t Offset>
+        constexpr bool is_member_hook_v<member_hook<Member, Offset>> = true;
+
+        template <typename T, typename Tag, typename = void>
+        struct member_hook_of
+        {};
+
+        template <typename T, auto Member, std::size_t Offset>
+        struct member_hook_of<T, member_hook<Member, Offset>,
+                              std::enable_if_t<std::is_same_v<T, typename member_hook<Member, Offset>::value_type>>>
+        {
+            using type = typename member_hook<Member, Offset>::hook_type;
+        };
+
+        /*
+        Для member_hook<&T::hook, ...> хук -- это тип поля hook.
+        */
+        template <typename Tag, typename T>
+        typename member_hook_of<T, Tag>::type& find_hook(T&) noexcept;
+
+        template <typename T, typename Tag>
+        using hook_t = std::remove_reference_t<decltype(find_hook<Tag>(std::declval<std::remove_const_t<T>&>()))>;
+
+        template <typename T, typename Tag>
+        using hook_node_t = typename hook_t<T, Tag>::node_type;
+
+        template <typename T, typename Tag, typename = void>
+        constexpr bool has_hook_v = false;
+
+        template <typename T, typename Tag>
+        constexpr bool has_hook_v<T, Tag, std::void_t<hook_t<T, Tag>>> = true;
+    }
+
+    template <typename Tag = default_tag, typename... Options>
+    struct list_element : private detail::link_node_t<Options...>
     {
         /*
         Вся содержательная функциональность вынесена в
         нешаблонную базу, чтобы не дублировался код для
-        каждого отдельного тега (Tag).
+        каждого отдельного тега (Tag). Какая именно это база,
+        задает опция вида link_kind, по умолчанию pointer_link.
 
         База private и считается деталью реализации.
         */
@@ -42,32 +554,45 @@ namespace intrusive
         простое в использовании поведение. В терминах
         Boost.Intrusive это называется "Auto-unlink hook".
         https://www.boost.org/doc/libs/1_74_0/doc/html/intrusive/auto_unlink_hooks.html
+
+        Режим можно поменять опцией safe_link или normal_link:
+        struct node : intrusive::list_element<my_tag, intrusive::normal_link>.
+        list сам определяет режим по типу хука.
         */
+        using link_mode = detail::find_option_t<detail::link_mode_kind, auto_unlink, Options...>;
+        using node_type = detail::link_node_t<Options...>;
 
-        list_element() noexcept;
-        ~list_element() noexcept;
+        constexpr list_element() noexcept;
+        INTRUSIVE_LIST_CONSTEXPR_DESTRUCTOR ~list_element() noexcept;
         list_element(list_element const&) = delete;
         list_element& operator=(list_element const&) = delete;
 
         /*
         unlink() вытащен в public интерфейс так же как в Boost.Intrusive.
+        Как и там, он есть только у auto-unlink хуков.
+        */
+        constexpr void unlink() noexcept;
+
+        /*
+        Лежит ли элемент сейчас в каком-нибудь списке. Для normal_link
+        недоступно: там prev/next после удаления из списка висячие.
         */
-        using list_element_base::unlink;
+        constexpr bool is_linked() const noexcept;
 
-        template <typename T, typename Tag1>
+        template <typename T, typename Tag1, typename... Options1>
         friend struct list;
 
         template <typename Tag1, typename T>
-        friend list_element_base& to_base(T&) noexcept;
+        friend constexpr detail::hook_node_t<T, Tag1>& to_base(T&) noexcept;
 
         template <typename Tag1, typename T>
-        friend list_element_base const& to_base(T const&) noexcept;
+        friend constexpr detail::hook_node_t<T, Tag1> const& to_base(T const&) noexcept;
 
         template <typename T1, typename Tag1>
-        friend T1& from_base(list_element_base&) noexcept;
+        friend constexpr T1& from_base(detail::hook_node_t<T1, Tag1>&) noexcept;
 
         template <typename T1, typename Tag1>
-        friend T1 const& from_base(list_element_base const&) noexcept;
+        friend constexpr T1 const& from_base(detail::hook_node_t<T1, Tag1> const&) noexcept;
     };
 
     template <typename T, typename Tag>
@@ -81,44 +606,50 @@ namespace intrusive
 
         list_iterator() = default;
         template <typename NonConstIterator>
-        list_iterator(NonConstIterator other,
+        constexpr list_iterator(NonConstIterator other,
             std::enable_if_t<
                 std::is_same_v<NonConstIterator, list_iterator<std::remove_const_t<T>, Tag>> &&
                 std::is_const_v<T>>* = nullptr) noexcept
             : current(other.current)
         {}
 
-        T& operator*() const noexcept;
-        T* operator->() const noexcept;
+        constexpr T& operator*() const noexcept;
+        constexpr T* operator->() const noexcept;
 
-        list_iterator& operator++() & noexcept;
-        list_iterator& operator--() & noexcept;
+        constexpr list_iterator& operator++() & noexcept;
+        constexpr list_iterator& operator--() & noexcept;
 
-        list_iterator operator++(int) & noexcept;
-        list_iterator operator--(int) & noexcept;
+        constexpr list_iterator operator++(int) & noexcept;
+        constexpr list_iterator operator--(int) & noexcept;
 
-        bool operator==(list_iterator const& rhs) const& noexcept;
-        bool operator!=(list_iterator const& rhs) const& noexcept;
+        constexpr bool operator==(list_iterator const& rhs) const& noexcept;
+        constexpr bool operator!=(list_iterator const& rhs) const& noexcept;
 
     private:
+        using node_type = detail::hook_node_t<T, Tag>;
+
         /*
         Это важно иметь этот конструктор private, чтобы итератор нельзя было создать
         от nullptr.
         */
-        explicit list_iterator(list_element_base* current) noexcept;
+        constexpr explicit list_iterator(node_type* current) noexcept;
 
     private:
         /*
-        Хранить list_element_base*, а не T* важно.
+        Хранить node_type*, а не T* важно.
         Иначе нельзя будет создать list_iterator для
         end().
+
+        Даже если в хуке ссылки сжаты (index_link), итератор
+        держит обычный указатель: он живет недолго, а
+        распаковывать ссылку на каждом разыменовании незачем.
         */
-        list_element_base* current;
+        node_type* current;
 
         template <typename T1, typename Tag1>
         friend struct list_iterator;
 
-        template <typename T1, typename Tag1>
+        template <typename T1, typename Tag1, typename... Options1>
         friend struct list;
     };
 
@@ -130,45 +661,93 @@ namespace intrusive
     его в конец. Из-за этого to_base имеет не тот порядок параметров
     как все остальные функции и классы. Это не очень хорошо. Может
     быть забить и сделать порядок параметров как везде. Я не знаю.
+
+    Тип базы берется из хука, поэтому если у T нет list_element с
+    тегом Tag, подстановка в тип возврата не проходит. Это нужно,
+    чтобы to_base и from_base для других видов хуков (например,
+    slist_element) можно было перегрузить.
     */
     template <typename Tag, typename T>
-    list_element_base& to_base(T&) noexcept;
+    constexpr detail::hook_node_t<T, Tag>& to_base(T&) noexcept;
 
     template <typename Tag, typename T>
-    list_element_base const& to_base(T const&) noexcept;
+    constexpr detail::hook_node_t<T, Tag> const& to_base(T const&) noexcept;
 
     template <typename T, typename Tag>
-    T& from_base(list_element_base&) noexcept;
+    constexpr T& from_base(detail::hook_node_t<T, Tag>&) noexcept;
 
     template <typename T, typename Tag>
-    T const& from_base(list_element_base const&) noexcept;
+    constexpr T const& from_base(detail::hook_node_t<T, Tag> const&) noexcept;
 
-    template <typename T, typename Tag = default_tag>
-    struct list
+    namespace detail
+    {
+        template <typename T>
+        constexpr void triswap(T& a, T& b, T& c) noexcept
+        {
+            T copy = a;
+            a = b;
+            b = c;
+            c = copy;
+        }
+
+        /*
+        Алгоритмы сортировки работают с голыми базами (Node -- это
+        list_element_base или basic_list_element_base): head -- это
+        fake списка. Сравнение передается уже обернутым, так что сами
+        алгоритмы зависят только от типа базы и компаратора, а не от
+        T и Tag.
+        */
+        template <typename Node, typename Less>
+        void merge_heads(Node& dst, Node& src, Less& less);
+
+        template <typename Node, typename Less>
+        Node* merge_chains(Node* a, Node* b, Less& less);
+
+        template <typename Node, typename Less>
+        void sort_head(Node& head, Less& less);
+    }
+
+    template <typename T, typename Tag = default_tag, typename... Options>
+    struct list : private detail::size_counter<detail::constant_time_size_v<Options...>>
+                , private detail::stats_recorder<Tag, detail::has_stats_v<Options...>>
     {
         using iterator = list_iterator<T, Tag>;
         using const_iterator = list_iterator<T const, Tag>;
+        using size_type = std::size_t;
 
         /*
         Я не рассказывал на лекции про static_assert. Можно рассказать
         им про него на практике.
         */
-        static_assert(std::is_convertible_v<T&, list_element<Tag>&>,
+        static_assert(detail::has_hook_v<T, Tag>,
             "value type is not convertible to list_element");
 
+        using link_mode = typename detail::hook_t<T, Tag>::link_mode;
+
+        static constexpr bool has_constant_time_size = detail::constant_time_size_v<Options...>;
+
+        static_assert(!has_constant_time_size || !std::is_same_v<link_mode, auto_unlink>,
+            "constant_time_size requires safe_link or normal_link elements");
+
+        static constexpr bool has_stats = detail::has_stats_v<Options...>;
+
+        static_assert(!has_stats || !std::is_same_v<link_mode, auto_unlink>,
+            "list_stats requires safe_link or normal_link elements");
+        static constexpr bool has_traversal_histogram = detail::has_traversal_histogram_v<Options...>;
+
         /*
         Практически все операции получились noexcept, поскольку мы нигде не
         аллоцируем память и не вызываем пользовательские функции.
         */
-        list() noexcept;
+        constexpr list() noexcept;
         list(list const&) = delete;
-        list(list&&) noexcept;
-        ~list();
+        constexpr list(list&&) noexcept;
+        INTRUSIVE_LIST_CONSTEXPR_DESTRUCTOR ~list();
 
         list& operator=(list const&) = delete;
-        list& operator=(list&&) noexcept;
+        constexpr list& operator=(list&&) noexcept;
 
-        void clear() noexcept;
+        constexpr void clear() noexcept;
 
         /*
         Реализуя интрузивный список, я вижу два способа предоставлять
@@ -182,72 +761,288 @@ namespace intrusive
         Поскольку вставка изменяет данные в list_element
         мы принимаем неконстантный T&.
         */
-        void push_back(T&) noexcept;
-        void pop_back() noexcept;
-        T& back() noexcept;
-        T const& back() const noexcept;
+        constexpr void push_back(T&) noexcept;
+        constexpr void pop_back() noexcept;
+        constexpr T& back() noexcept;
+        constexpr T const& back() const noexcept;
+
+        constexpr void push_front(T&) noexcept;
+        constexpr void pop_front() noexcept;
+        constexpr T& front() noexcept;
+        constexpr T const& front() const noexcept;
+
+        constexpr bool empty() const noexcept;
+
+        /*
+        O(1) с опцией constant_time_size и O(n) без нее.
+        */
+        constexpr size_type size() const noexcept;
+
+        constexpr iterator begin() noexcept;
+        constexpr const_iterator begin() const noexcept;
+
+        constexpr iterator end() noexcept;
+        constexpr const_iterator end() const noexcept;
+
+        constexpr iterator insert(const_iterator pos, T&) noexcept;
+        constexpr iterator erase(const_iterator pos) noexcept;
+
+        /*
+        Вставка диапазона, разыменование итераторов которого дает T&.
+        Сначала элементы связываются между собой в цепочку, а потом
+        цепочка целиком вставляется в список. Итераторы не должны
+        бросать исключения.
+        */
+        template <typename InputIterator>
+        constexpr void insert(const_iterator pos, InputIterator first, InputIterator last) noexcept;
+
+        /*
+        Границы диапазона перевязываются один раз. Для normal_link
+        (без constant_time_size) это O(1), в остальных режимах элементы
+        внутри диапазона всё равно надо обойти, чтобы обнулить их.
+        */
+        constexpr iterator erase(const_iterator first, const_iterator last) noexcept;
+
+        /*
+        Варианты с disposer'ом. Элемент сначала отвязывается, а потом
+        передается в disposer(T*), который может его удалить. Так
+        элементы отвязываются и освобождаются за один проход.
+
+        Disposer не должен бросать исключения. Predicate в remove_if
+        бросать может: до вызова disposer'ов список не меняется.
+        */
+        template <typename Disposer>
+        iterator erase_and_dispose(const_iterator pos, Disposer disposer);
+
+        template <typename Disposer>
+        iterator erase_and_dispose(const_iterator first, const_iterator last, Disposer disposer);
+
+        template <typename Disposer>
+        void clear_and_dispose(Disposer disposer);
+
+        /*
+        Подряд идущие подходящие элементы выкидываются одним
+        диапазоном. Возвращают количество выкинутых элементов.
+        */
+        template <typename Predicate>
+        size_type remove_if(Predicate pred);
+
+        template <typename Predicate, typename Disposer>
+        size_type remove_and_dispose_if(Predicate pred, Disposer disposer);
+
+        /*
+        sort, merge и unique только перевязывают узлы, элементы не
+        перемещаются и память не выделяется. sort -- восходящая сортировка
+        слиянием, как в std::list::sort из libstdc++: временные цепочки
+        лежат в массиве из 64 указателей на стеке. Обе сортировки устойчивые.
+        Компаратор не должен бросать исключения.
+        */
+        void sort();
+
+        template <typename Compare>
+        void sort(Compare comp);
+
+        void merge(list& other);
+
+        template <typename Compare>
+        void merge(list& other, Compare comp);
+
+        /*
+        Из каждой группы подряд идущих эквивалентных элементов остается
+        первый. Возвращают количество выкинутых элементов.
+        */
+        size_type unique();
+
+        template <typename BinaryPredicate>
+        size_type unique(BinaryPredicate pred);
+
+        template <typename BinaryPredicate, typename Disposer>
+        size_type unique_and_dispose(BinaryPredicate pred, Disposer disposer);
+        constexpr void splice(const_iterator pos, list&, const_iterator first, const_iterator last) noexcept;
+
+        /*
+        splice с заранее известным количеством элементов в [first, last).
+        С опцией constant_time_size обычный splice вынужден посчитать
+        расстояние между first и last (кроме случая переноса всего
+        списка), а этот всегда O(1).
+        */
+        constexpr void splice(const_iterator pos, list&, const_iterator first, const_iterator last, size_type n) noexcept;
 
-        void push_front(T&) noexcept;
-        void pop_front() noexcept;
-        T& front() noexcept;
-        T const& front() const noexcept;
+        /*
+        Итератор на элемент, который уже лежит в списке, за O(1). Список
+        для этого не нужен, поэтому функции статические. Элемент обязан
+        быть в списке: итератор на отвязанный элемент нельзя ни сдвинуть,
+        ни передать в erase.
+        */
+        static constexpr iterator iterator_to(T&) noexcept;
+        static constexpr const_iterator iterator_to(T const&) noexcept;
 
-        bool empty() const noexcept;
+        /*
+        Только с опцией list_stats.
+        */
+        list_statistics const& stats() const noexcept;
+        void publish_stats() noexcept;
 
-        iterator begin() noexcept;
-        const_iterator begin() const noexcept;
+        /*
+        Только с list_stats<true>. Диапазон для range-based for, который
+        считает шаги по списку и при удалении кладет их в гистограмму.
+        */
+        detail::tracked_range<list> tracked() noexcept;
+
+    private:
+        using node_type = detail::hook_node_t<T, Tag>;
+        using stats_type = detail::stats_recorder<Tag, has_stats>;
 
-        iterator end() noexcept;
-        const_iterator end() const noexcept;
+        constexpr void unlink_node(node_type&) noexcept;
 
-        iterator insert(const_iterator pos, T&) noexcept;
-        iterator erase(const_iterator pos) noexcept;
-        void splice(const_iterator pos, list&, const_iterator first, const_iterator last) noexcept;
+        template <typename Disposer>
+        size_type dispose_chain(node_type* first, node_type* last, Disposer& disposer);
 
     private:
-        mutable list_element_base fake;
+        node_type fake;
+
+        /*
+        mpsc_queue::drain вставляет в список уже связанную цепочку.
+        */
+        template <typename T1, typename Tag1>
+        friend struct mpsc_queue;
+
+        template <typename List>
+        friend struct detail::tracked_range;
     };
+
+    namespace detail
+    {
+        template <typename List>
+        struct tracked_range
+        {
+            struct iterator
+            {
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = typename List::iterator::value_type;
+                using difference_type = std::ptrdiff_t;
+                using pointer = value_type*;
+                using reference = value_type&;
+
+                reference operator*() const noexcept
+                {
+                    return *current;
+                }
+
+                pointer operator->() const noexcept
+                {
+                    return &*current;
+                }
+
+                iterator& operator++() & noexcept
+                {
+                    ++current;
+                    ++*steps;
+                    return *this;
+                }
+
+                bool operator==(iterator const& rhs) const& noexcept
+                {
+                    return current == rhs.current;
+                }
+
+                bool operator!=(iterator const& rhs) const& noexcept
+                {
+                    return current != rhs.current;
+                }
+
+                typename List::iterator current;
+                std::size_t* steps;
+            };
+
+            explicit tracked_range(List& list) noexcept
+                : list(list)
+                , steps(0)
+            {}
+
+            tracked_range(tracked_range const&) = delete;
+            tracked_range& operator=(tracked_range const&) = delete;
+
+            ~tracked_range()
+            {
+                static_cast<typename List::stats_type&>(list).note_traversal(steps);
+            }
+
+            iterator begin() noexcept
+            {
+                return {list.begin(), &steps};
+            }
+
+            iterator end() noexcept
+            {
+                return {list.end(), &steps};
+            }
+
+            List& list;
+            std::size_t steps;
+        };
+    }
 }
 
-template <typename Tag>
-intrusive::list_element<Tag>::list_element() noexcept
-    : list_element_base{nullptr, nullptr}
+template <typename Tag, typename... Options>
+constexpr intrusive::list_element<Tag, Options...>::list_element() noexcept
+    : node_type{nullptr, nullptr}
 {}
 
-template <typename Tag>
-intrusive::list_element<Tag>::~list_element() noexcept
+template <typename Tag, typename... Options>
+INTRUSIVE_LIST_CONSTEXPR_DESTRUCTOR intrusive::list_element<Tag, Options...>::~list_element() noexcept
+{
+    if constexpr (std::is_same_v<link_mode, auto_unlink>)
+        this->try_unlink();
+    else if constexpr (std::is_same_v<link_mode, safe_link>)
+        assert(this->prev == nullptr && "safe_link element is destroyed while linked");
+}
+
+template <typename Tag, typename... Options>
+constexpr void intrusive::list_element<Tag, Options...>::unlink() noexcept
+{
+    static_assert(std::is_same_v<link_mode, auto_unlink>,
+        "unlink() is available only for auto_unlink elements, use list::erase()");
+    node_type::unlink();
+}
+
+template <typename Tag, typename... Options>
+constexpr bool intrusive::list_element<Tag, Options...>::is_linked() const noexcept
 {
-    try_unlink();
+    static_assert(!std::is_same_v<link_mode, normal_link>,
+        "is_linked() is not available for normal_link elements");
+    assert((this->prev == nullptr) == (this->next == nullptr));
+    return this->prev != nullptr;
 }
 
 template <typename T, typename Tag>
-T& intrusive::list_iterator<T, Tag>::operator*() const noexcept
+constexpr T& intrusive::list_iterator<T, Tag>::operator*() const noexcept
 {
     return from_base<T, Tag>(*current);
 }
 
 template <typename T, typename Tag>
-T* intrusive::list_iterator<T, Tag>::operator->() const noexcept
+constexpr T* intrusive::list_iterator<T, Tag>::operator->() const noexcept
 {
     return &from_base<T, Tag>(*current);
 }
 
 template <typename T, typename Tag>
-intrusive::list_iterator<T, Tag>& intrusive::list_iterator<T, Tag>::operator++() & noexcept
+constexpr intrusive::list_iterator<T, Tag>& intrusive::list_iterator<T, Tag>::operator++() & noexcept
 {
     current = current->next;
     return *this;
 }
 
 template <typename T, typename Tag>
-intrusive::list_iterator<T, Tag>& intrusive::list_iterator<T, Tag>::operator--() & noexcept
+constexpr intrusive::list_iterator<T, Tag>& intrusive::list_iterator<T, Tag>::operator--() & noexcept
 {
     current = current->prev;
     return *this;
 }
 
 template <typename T, typename Tag>
-intrusive::list_iterator<T, Tag> intrusive::list_iterator<T, Tag>::operator++(int) & noexcept
+constexpr intrusive::list_iterator<T, Tag> intrusive::list_iterator<T, Tag>::operator++(int) & noexcept
 {
     list_iterator copy = *this;
     ++*this;
@@ -255,7 +1050,7 @@ intrusive::list_iterator<T, Tag> intrusive::list_iterator<T, Tag>::operator++(in
 }
 
 template <typename T, typename Tag>
-intrusive::list_iterator<T, Tag> intrusive::list_iterator<T, Tag>::operator--(int) & noexcept
+constexpr intrusive::list_iterator<T, Tag> intrusive::list_iterator<T, Tag>::operator--(int) & noexcept
 {
     list_iterator copy = *this;
     --*this;
@@ -263,53 +1058,77 @@ intrusive::list_iterator<T, Tag> intrusive::list_iterator<T, Tag>::operator--(in
 }
 
 template <typename T, typename Tag>
-bool intrusive::list_iterator<T, Tag>::operator==(list_iterator const& rhs) const& noexcept
+constexpr bool intrusive::list_iterator<T, Tag>::operator==(list_iterator const& rhs) const& noexcept
 {
     return current == rhs.current;
 }
 
 template <typename T, typename Tag>
-bool intrusive::list_iterator<T, Tag>::operator!=(list_iterator const& rhs) const& noexcept
+constexpr bool intrusive::list_iterator<T, Tag>::operator!=(list_iterator const& rhs) const& noexcept
 {
     return current != rhs.current;
 }
 
 template <typename T, typename Tag>
-intrusive::list_iterator<T, Tag>::list_iterator(list_element_base* current) noexcept
+constexpr intrusive::list_iterator<T, Tag>::list_iterator(node_type* current) noexcept
     : current(current)
 {}
 
 template <typename Tag, typename T>
-intrusive::list_element_base& intrusive::to_base(T& obj) noexcept
+constexpr intrusive::detail::hook_node_t<T, Tag>& intrusive::to_base(T& obj) noexcept
 {
-    return static_cast<list_element<Tag>&>(obj);
+    if constexpr (detail::is_member_hook_v<Tag>)
+        return obj.*Tag::member;
+    else
+        return static_cast<detail::hook_t<T, Tag>&>(obj);
 }
 
 template <typename Tag, typename T>
-intrusive::list_element_base const& intrusive::to_base(T const& obj) noexcept
+constexpr intrusive::detail::hook_node_t<T, Tag> const& intrusive::to_base(T const& obj) noexcept
 {
-    return static_cast<list_element<Tag> const&>(obj);
+    if constexpr (detail::is_member_hook_v<Tag>)
+        return obj.*Tag::member;
+    else
+        return static_cast<detail::hook_t<T, Tag> const&>(obj);
 }
 
 template <typename T, typename Tag>
-T& intrusive::from_base(list_element_base& base) noexcept
+constexpr T& intrusive::from_base(detail::hook_node_t<T, Tag>& base) noexcept
 {
-    return static_cast<T&>(static_cast<list_element<Tag>&>(base));
+    auto& hook = static_cast<detail::hook_t<T, Tag>&>(base);
+    if constexpr (detail::is_member_hook_v<Tag>)
+    {
+        char* p = reinterpret_cast<char*>(&hook) - Tag::offset;
+        auto& obj = *reinterpret_cast<std::remove_const_t<T>*>(p);
+        assert(&(obj.*Tag::member) == &hook && "member_hook offset does not match the member");
+        return obj;
+    }
+    else
+        return static_cast<T&>(hook);
 }
 
 template <typename T, typename Tag>
-T const& intrusive::from_base(list_element_base const& base) noexcept
+constexpr T const& intrusive::from_base(detail::hook_node_t<T, Tag> const& base) noexcept
 {
-    return static_cast<T const&>(static_cast<list_element<Tag> const&>(base));
+    auto& hook = static_cast<detail::hook_t<T, Tag> const&>(base);
+    if constexpr (detail::is_member_hook_v<Tag>)
+    {
+        char const* p = reinterpret_cast<char const*>(&hook) - Tag::offset;
+        auto const& obj = *reinterpret_cast<T const*>(p);
+        assert(&(obj.*Tag::member) == &hook && "member_hook offset does not match the member");
+        return obj;
+    }
+    else
+        return static_cast<T const&>(hook);
 }
 
-template <typename Node, typename Tag>
-intrusive::list<Node, Tag>::list() noexcept
+template <typename T, typename Tag, typename... Options>
+constexpr intrusive::list<T, Tag, Options...>::list() noexcept
     : fake{&fake, &fake}
 {}
 
-template <typename T, typename Tag>
-intrusive::list<T, Tag>::list(list&& other) noexcept
+template <typename T, typename Tag, typename... Options>
+constexpr intrusive::list<T, Tag, Options...>::list(list&& other) noexcept
     : list()
 {
     /*
@@ -328,122 +1147,803 @@ intrusive::list<T, Tag>::list(list&& other) noexcept
     splice(end(), other, other.begin(), other.end());
 }
 
-template <typename Node, typename Tag>
-intrusive::list<Node, Tag>::~list()
+template <typename T, typename Tag, typename... Options>
+INTRUSIVE_LIST_CONSTEXPR_DESTRUCTOR intrusive::list<T, Tag, Options...>::~list()
 {
-    fake.clear();
+    clear();
 }
 
-template <typename T, typename Tag>
-intrusive::list<T, Tag>& intrusive::list<T, Tag>::operator=(list&& other) noexcept
+template <typename T, typename Tag, typename... Options>
+constexpr intrusive::list<T, Tag, Options...>& intrusive::list<T, Tag, Options...>::operator=(list&& other) noexcept
 {
-    fake.clear();
+    clear();
     splice(end(), other, other.begin(), other.end());
     return *this;
 }
 
-template <typename Node, typename Tag>
-void intrusive::list<Node, Tag>::clear() noexcept
+template <typename T, typename Tag, typename... Options>
+constexpr void intrusive::list<T, Tag, Options...>::clear() noexcept
 {
-    fake.clear();
+    if constexpr (std::is_same_v<link_mode, normal_link>)
+    {
+        fake.reset();
+        this->note_clear(0);
+    }
+    else
+    {
+        if constexpr (has_stats)
+            this->note_clear(static_cast<size_type>(std::distance(begin(), end())));
+        fake.clear();
+    }
+    this->set_size(0);
 }
 
-template <typename T, typename Tag>
-void intrusive::list<T, Tag>::push_back(T& obj) noexcept
+template <typename T, typename Tag, typename... Options>
+constexpr void intrusive::list<T, Tag, Options...>::push_back(T& obj) noexcept
 {
-    fake.insert(to_base<Tag>(obj));
+    insert(end(), obj);
 }
 
-template <typename T, typename Tag>
-void intrusive::list<T, Tag>::pop_back() noexcept
+template <typename T, typename Tag, typename... Options>
+constexpr void intrusive::list<T, Tag, Options...>::pop_back() noexcept
 {
-    fake.prev->unlink();
+    unlink_node(*fake.prev);
 }
 
-template <typename T, typename Tag>
-T& intrusive::list<T, Tag>::back() noexcept
+template <typename T, typename Tag, typename... Options>
+constexpr T& intrusive::list<T, Tag, Options...>::back() noexcept
 {
     return from_base<T, Tag>(*fake.prev);
 }
 
-template <typename T, typename Tag>
-T const& intrusive::list<T, Tag>::back() const noexcept
+template <typename T, typename Tag, typename... Options>
+constexpr T const& intrusive::list<T, Tag, Options...>::back() const noexcept
 {
     return from_base<T, Tag>(*fake.prev);
 }
 
-template <typename T, typename Tag>
-void intrusive::list<T, Tag>::push_front(T& obj) noexcept
+template <typename T, typename Tag, typename... Options>
+constexpr void intrusive::list<T, Tag, Options...>::push_front(T& obj) noexcept
 {
-    fake.next->insert(to_base<Tag>(obj));
+    insert(begin(), obj);
 }
 
-template <typename T, typename Tag>
-void intrusive::list<T, Tag>::pop_front() noexcept
+template <typename T, typename Tag, typename... Options>
+constexpr void intrusive::list<T, Tag, Options...>::pop_front() noexcept
 {
-    fake.next->unlink();
+    unlink_node(*fake.next);
 }
 
-template <typename T, typename Tag>
-T& intrusive::list<T, Tag>::front() noexcept
+template <typename T, typename Tag, typename... Options>
+constexpr T& intrusive::list<T, Tag, Options...>::front() noexcept
 {
     return from_base<T, Tag>(*fake.next);
 }
 
-template <typename T, typename Tag>
-T const& intrusive::list<T, Tag>::front() const noexcept
+template <typename T, typename Tag, typename... Options>
+constexpr T const& intrusive::list<T, Tag, Options...>::front() const noexcept
 {
     return from_base<T, Tag>(*fake.next);
 }
 
-template <typename T, typename Tag>
-bool intrusive::list<T, Tag>::empty() const noexcept
+template <typename T, typename Tag, typename... Options>
+constexpr bool intrusive::list<T, Tag, Options...>::empty() const noexcept
 {
     return fake.prev == &fake;
 }
 
-template <typename T, typename Tag>
-typename intrusive::list<T, Tag>::iterator intrusive::list<T, Tag>::begin() noexcept
+template <typename T, typename Tag, typename... Options>
+constexpr typename intrusive::list<T, Tag, Options...>::size_type intrusive::list<T, Tag, Options...>::size() const noexcept
+{
+    if constexpr (has_constant_time_size)
+        return this->count;
+    else
+        return static_cast<size_type>(std::distance(begin(), end()));
+}
+
+template <typename T, typename Tag, typename... Options>
+constexpr typename intrusive::list<T, Tag, Options...>::iterator intrusive::list<T, Tag, Options...>::begin() noexcept
 {
     return iterator(fake.next);
 }
 
-template <typename T, typename Tag>
-typename intrusive::list<T, Tag>::const_iterator intrusive::list<T, Tag>::begin() const noexcept
+template <typename T, typename Tag, typename... Options>
+constexpr typename intrusive::list<T, Tag, Options...>::const_iterator intrusive::list<T, Tag, Options...>::begin() const noexcept
 {
     return const_iterator(fake.next);
 }
 
-template <typename T, typename Tag>
-typename intrusive::list<T, Tag>::iterator intrusive::list<T, Tag>::end() noexcept
+template <typename T, typename Tag, typename... Options>
+constexpr typename intrusive::list<T, Tag, Options...>::iterator intrusive::list<T, Tag, Options...>::end() noexcept
 {
     return iterator(&fake);
 }
 
-template <typename T, typename Tag>
-typename intrusive::list<T, Tag>::const_iterator intrusive::list<T, Tag>::end() const noexcept
+template <typename T, typename Tag, typename... Options>
+constexpr typename intrusive::list<T, Tag, Options...>::const_iterator intrusive::list<T, Tag, Options...>::end() const noexcept
 {
-    return const_iterator(&fake);
+    return const_iterator(const_cast<node_type*>(&fake));
 }
 
-template <typename T, typename Tag>
-typename intrusive::list<T, Tag>::iterator intrusive::list<T, Tag>::insert(const_iterator pos, T& obj) noexcept
+template <typename T, typename Tag, typename... Options>
+constexpr typename intrusive::list<T, Tag, Options...>::iterator intrusive::list<T, Tag, Options...>::insert(const_iterator pos, T& obj) noexcept
 {
-    list_element_base& base = to_base<Tag>(obj);
+    node_type& base = to_base<Tag>(obj);
+    if constexpr (!std::is_same_v<link_mode, normal_link>)
+        assert(base.prev == nullptr && "element is already linked");
     pos.current->insert(base);
+    this->add_size(1);
+    this->note_link(1);
     return iterator(&base);
 }
 
-template <typename T, typename Tag>
-typename intrusive::list<T, Tag>::iterator intrusive::list<T, Tag>::erase(const_iterator pos) noexcept
+template <typename T, typename Tag, typename... Options>
+constexpr typename intrusive::list<T, Tag, Options...>::iterator intrusive::list<T, Tag, Options...>::erase(const_iterator pos) noexcept
 {
-    list_element_base* next = pos.current->next;
-    pos.current->unlink();
+    node_type* next = pos.current->next;
+    unlink_node(*pos.current);
     return iterator(next);
 }
 
-template <typename T, typename Tag>
-void intrusive::list<T, Tag>::splice(const_iterator pos, list&, const_iterator first, const_iterator last) noexcept
+template <typename T, typename Tag, typename... Options>
+template <typename InputIterator>
+constexpr void intrusive::list<T, Tag, Options...>::insert(const_iterator pos, InputIterator first, InputIterator last) noexcept
+{
+    if (first == last)
+        return;
+
+    node_type& head = to_base<Tag>(*first);
+    node_type* tail = &head;
+    size_type n = 1;
+    if constexpr (!std::is_same_v<link_mode, normal_link>)
+        assert(head.prev == nullptr && "element is already linked");
+
+    for (++first; first != last; ++first)
+    {
+        node_type& base = to_base<Tag>(*first);
+        if constexpr (!std::is_same_v<link_mode, normal_link>)
+            assert(base.prev == nullptr && "element is already linked");
+        tail->next = &base;
+        base.prev = tail;
+        tail = &base;
+        ++n;
+    }
+
+    pos.current->insert_chain(head, *tail);
+    this->add_size(n);
+    this->note_link(n);
+}
+
+template <typename T, typename Tag, typename... Options>
+constexpr typename intrusive::list<T, Tag, Options...>::iterator intrusive::list<T, Tag, Options...>::erase(const_iterator first, const_iterator last) noexcept
+{
+    if constexpr (std::is_same_v<link_mode, normal_link>)
+    {
+        if constexpr (has_constant_time_size || has_stats)
+        {
+            size_type n = static_cast<size_type>(std::distance(first, last));
+            this->sub_size(n);
+            this->note_unlink(n);
+        }
+        first.current->detach_range(*last.current);
+    }
+    else
+    {
+        size_type n = first.current->unlink_range(*last.current);
+        this->sub_size(n);
+        this->note_unlink(n);
+    }
+    return iterator(last.current);
+}
+
+template <typename T, typename Tag, typename... Options>
+template <typename Disposer>
+typename intrusive::list<T, Tag, Options...>::iterator intrusive::list<T, Tag, Options...>::erase_and_dispose(const_iterator pos, Disposer disposer)
+{
+    T& obj = from_base<T, Tag>(*pos.current);
+    iterator next = erase(pos);
+    disposer(&obj);
+    return next;
+}
+
+template <typename T, typename Tag, typename... Options>
+template <typename Disposer>
+typename intrusive::list<T, Tag, Options...>::iterator intrusive::list<T, Tag, Options...>::erase_and_dispose(const_iterator first, const_iterator last, Disposer disposer)
+{
+    /*
+    Сначала диапазон целиком вырезается из списка, потом его
+    элементы обходятся один раз: обнуляются и отдаются disposer'у.
+    */
+    first.current->detach_range(*last.current);
+    size_type n = dispose_chain(first.current, last.current, disposer);
+    this->sub_size(n);
+    this->note_unlink(n);
+    return iterator(last.current);
+}
+
+template <typename T, typename Tag, typename... Options>
+template <typename Disposer>
+void intrusive::list<T, Tag, Options...>::clear_and_dispose(Disposer disposer)
+{
+    node_type* first = fake.next;
+    fake.reset();
+    this->set_size(0);
+    this->note_clear(dispose_chain(first, &fake, disposer));
+}
+
+template <typename T, typename Tag, typename... Options>
+template <typename Predicate>
+typename intrusive::list<T, Tag, Options...>::size_type intrusive::list<T, Tag, Options...>::remove_if(Predicate pred)
+{
+    return remove_and_dispose_if(pred, [](T*) {});
+}
+
+template <typename T, typename Tag, typename... Options>
+template <typename Predicate, typename Disposer>
+typename intrusive::list<T, Tag, Options...>::size_type intrusive::list<T, Tag, Options...>::remove_and_dispose_if(Predicate pred, Disposer disposer)
+{
+    size_type removed = 0;
+    for (const_iterator i = begin(); i != end();)
+    {
+        if (!pred(*i))
+        {
+            ++i;
+            continue;
+        }
+
+        const_iterator first = i;
+        size_type n = 1;
+        for (++i; i != end() && pred(*i); ++i)
+            ++n;
+
+        first.current->detach_range(*i.current);
+        this->sub_size(n);
+        this->note_unlink(n);
+        removed += n;
+        dispose_chain(first.current, i.current, disposer);
+    }
+    return removed;
+}
+
+template <typename T, typename Tag, typename... Options>
+void intrusive::list<T, Tag, Options...>::sort()
+{
+    sort(std::less<>());
+}
+
+template <typename T, typename Tag, typename... Options>
+template <typename Compare>
+void intrusive::list<T, Tag, Options...>::sort(Compare comp)
+{
+    auto less = [&comp](node_type const& a, node_type const& b) {
+        return comp(from_base<T, Tag>(a), from_base<T, Tag>(b));
+    };
+    detail::sort_head(fake, less);
+}
+
+template <typename T, typename Tag, typename... Options>
+void intrusive::list<T, Tag, Options...>::merge(list& other)
+{
+    merge(other, std::less<>());
+}
+
+template <typename T, typename Tag, typename... Options>
+template <typename Compare>
+void intrusive::list<T, Tag, Options...>::merge(list& other, Compare comp)
 {
+    if (&other == this)
+        return;
+
+    auto less = [&comp](node_type const& a, node_type const& b) {
+        return comp(from_base<T, Tag>(a), from_base<T, Tag>(b));
+    };
+    if constexpr (has_constant_time_size || has_stats)
+    {
+        size_type n = other.size();
+        this->add_size(n);
+        other.set_size(0);
+        this->note_splice_in(n);
+        other.note_splice_out(n);
+    }
+    detail::merge_heads(fake, other.fake, less);
+}
+
+template <typename T, typename Tag, typename... Options>
+typename intrusive::list<T, Tag, Options...>::size_type intrusive::list<T, Tag, Options...>::unique()
+{
+    return unique(std::equal_to<>());
+}
+
+template <typename T, typename Tag, typename... Options>
+template <typename BinaryPredicate>
+typename intrusive::list<T, Tag, Options...>::size_type intrusive::list<T, Tag, Options...>::unique(BinaryPredicate pred)
+{
+    return unique_and_dispose(pred, [](T*) {});
+}
+
+template <typename T, typename Tag, typename... Options>
+template <typename BinaryPredicate, typename Disposer>
+typename intrusive::list<T, Tag, Options...>::size_type intrusive::list<T, Tag, Options...>::unique_and_dispose(BinaryPredicate pred, Disposer disposer)
+{
+    size_type removed = 0;
+    if (empty())
+        return removed;
+
+    const_iterator kept = begin();
+    for (const_iterator i = std::next(kept); i != end();)
+    {
+        if (!pred(*kept, *i))
+        {
+            kept = i;
+            ++i;
+            continue;
+        }
+
+        const_iterator first = i;
+        size_type n = 1;
+        for (++i; i != end() && pred(*kept, *i); ++i)
+            ++n;
+
+        first.current->detach_range(*i.current);
+        this->sub_size(n);
+        this->note_unlink(n);
+        removed += n;
+        dispose_chain(first.current, i.current, disposer);
+    }
+    return removed;
+}
+
+template <typename T, typename Tag, typename... Options>
+constexpr void intrusive::list<T, Tag, Options...>::splice(const_iterator pos, list& other, const_iterator first, const_iterator last) noexcept
+{
+    if constexpr (has_constant_time_size || has_stats)
+    {
+        if (&other != this || has_stats)
+        {
+            size_type n = has_constant_time_size && first == other.begin() && last == other.end()
+                ? other.size()
+                : static_cast<size_type>(std::distance(first, last));
+            splice(pos, other, first, last, n);
+            return;
+        }
+    }
+
     pos.current->splice(*first.current, *last.current);
 }
+
+template <typename T, typename Tag, typename... Options>
+constexpr void intrusive::list<T, Tag, Options...>::splice(const_iterator pos, list& other, const_iterator first, const_iterator last, size_type n) noexcept
+{
+    assert(static_cast<size_type>(std::distance(first, last)) == n);
+    if (&other != this)
+    {
+        other.sub_size(n);
+        this->add_size(n);
+    }
+    this->note_splice_in(n);
+    other.note_splice_out(n);
+    pos.current->splice(*first.current, *last.current);
+}
+
+template <typename T, typename Tag, typename... Options>
+template <typename Disposer>
+typename intrusive::list<T, Tag, Options...>::size_type intrusive::list<T, Tag, Options...>::dispose_chain(node_type* first, node_type* last, Disposer& disposer)
+{
+    /*
+    [first, last) уже вырезан из списка, но внутри него ссылки еще
+    целы. Элемент обнуляется до вызова disposer'а, чтобы деструктор
+    auto_unlink элемента не полез к соседям.
+    */
+    size_type n = 0;
+    while (first != last)
+    {
+        node_type* next = first->next;
+        if constexpr (!std::is_same_v<link_mode, normal_link>)
+        {
+            first->prev = nullptr;
+            first->next = nullptr;
+        }
+        disposer(&from_base<T, Tag>(*first));
+        first = next;
+        ++n;
+    }
+    return n;
+}
+
+template <typename T, typename Tag, typename... Options>
+constexpr typename intrusive::list<T, Tag, Options...>::iterator intrusive::list<T, Tag, Options...>::iterator_to(T& obj) noexcept
+{
+    return iterator(&to_base<Tag>(obj));
+}
+
+template <typename T, typename Tag, typename... Options>
+constexpr typename intrusive::list<T, Tag, Options...>::const_iterator intrusive::list<T, Tag, Options...>::iterator_to(T const& obj) noexcept
+{
+    return const_iterator(const_cast<node_type*>(&to_base<Tag>(obj)));
+}
+
+template <typename T, typename Tag, typename... Options>
+intrusive::list_statistics const& intrusive::list<T, Tag, Options...>::stats() const noexcept
+{
+    static_assert(has_stats, "stats() requires the list_stats option");
+    return stats_type::data;
+}
+
+template <typename T, typename Tag, typename... Options>
+void intrusive::list<T, Tag, Options...>::publish_stats() noexcept
+{
+    static_assert(has_stats, "publish_stats() requires the list_stats option");
+    stats_type::publish();
+}
+
+template <typename T, typename Tag, typename... Options>
+intrusive::detail::tracked_range<intrusive::list<T, Tag, Options...>> intrusive::list<T, Tag, Options...>::tracked() noexcept
+{
+    static_assert(has_traversal_histogram, "tracked() requires the list_stats<true> option");
+    return detail::tracked_range<list>(*this);
+}
+
+template <typename Tag>
+intrusive::list_statistics intrusive::tag_statistics() noexcept
+{
+    return detail::tag_statistics_v<Tag>.load();
+}
+
+template <typename T, typename Tag, typename... Options>
+constexpr void intrusive::list<T, Tag, Options...>::unlink_node(node_type& base) noexcept
+{
+    if constexpr (std::is_same_v<link_mode, normal_link>)
+        base.detach();
+    else
+        base.unlink();
+    this->sub_size(1);
+    this->note_unlink(1);
+}
+
+template <typename Node, typename Less>
+void intrusive::detail::merge_heads(Node& dst, Node& src, Less& less)
+{
+    /*
+    Подряд идущие элементы src, меньшие текущего элемента dst,
+    переносятся одним splice'ом. Равные элементы src оказываются
+    после элементов dst, поэтому слияние устойчивое.
+    */
+    Node* i = dst.next;
+    Node* j = src.next;
+    while (j != &src)
+    {
+        if (i == &dst)
+        {
+            dst.splice(*j, src);
+            return;
+        }
+
+        if (!less(*j, *i))
+        {
+            i = i->next;
+            continue;
+        }
+
+        Node* k = j->next;
+        while (k != &src && less(*k, *i))
+            k = k->next;
+        i->splice(*j, *k);
+        j = k;
+    }
+}
+
+template <typename Node, typename Less>
+Node* intrusive::detail::merge_chains(Node* a, Node* b, Less& less)
+{
+    /*
+    a и b -- цепочки, связанные только через next и заканчивающиеся
+    nullptr'ом. При равенстве первым идет элемент из a.
+    */
+    Node* first;
+    if (less(*b, *a))
+    {
+        first = b;
+        b = b->next;
+    }
+    else
+    {
+        first = a;
+        a = a->next;
+    }
+
+    Node* last = first;
+    while (a != nullptr && b != nullptr)
+    {
+        if (less(*b, *a))
+        {
+            last->next = b;
+            last = b;
+            b = b->next;
+        }
+        else
+        {
+            last->next = a;
+            last = a;
+            a = a->next;
+        }
+    }
+    last->next = a != nullptr ? a : b;
+    return first;
+}
+
+template <typename Node, typename Less>
+void intrusive::detail::sort_head(Node& head, Less& less)
+{
+    if (head.next == &head || head.next->next == &head)
+        return;
+
+    /*
+    counter[i] -- либо пустая, либо отсортированная цепочка из 2^i
+    элементов. Каждый следующий элемент "проталкивается" по
+    counter'ам, как перенос при сложении двоичных чисел.
+
+    Пока идет сортировка, элементы связаны только через next, а prev
+    восстанавливаются одним проходом в конце. Временных голов на стеке
+    нет: у хуков со сжатыми ссылками (index_link) все узлы обязаны
+    лежать в арене, а стек в нее не входит.
+    */
+    Node* counter[64] = {};
+    std::size_t fill = 0;
+
+    head.prev->next = nullptr;
+    Node* p = head.next;
+    while (p != nullptr)
+    {
+        Node* carry = p;
+        p = p->next;
+        carry->next = nullptr;
+
+        std::size_t i = 0;
+        while (i != fill && counter[i] != nullptr)
+        {
+            carry = merge_chains(counter[i], carry, less);
+            counter[i] = nullptr;
+            ++i;
+        }
+        counter[i] = carry;
+        if (i == fill)
+            ++fill;
+    }
+
+    /*
+    В старших counter'ах лежат более ранние элементы, поэтому для
+    устойчивости они передаются в merge_chains первыми.
+    */
+    Node* result = nullptr;
+    for (std::size_t i = 0; i != fill; ++i)
+        if (counter[i] != nullptr)
+            result = result == nullptr ? counter[i] : merge_chains(counter[i], result, less);
+
+    Node* prev = &head;
+    for (Node* q = result; q != nullptr; q = q->next)
+    {
+        prev->next = q;
+        q->prev = prev;
+        prev = q;
+    }
+    prev->next = &head;
+    head.prev = prev;
+}
+
+constexpr void intrusive::list_element_base::unlink() noexcept
+{
+    assert(prev != nullptr);
+    assert(next != nullptr);
+    assert(prev != this);
+    assert(next != this);
+    prev->next = next;
+    next->prev = prev;
+    prev = nullptr;
+    next = nullptr;
+}
+
+constexpr void intrusive::list_element_base::try_unlink() noexcept
+{
+    assert((prev == nullptr) == (next == nullptr));
+    if (prev)
+        unlink();
+}
+
+constexpr void intrusive::list_element_base::clear() noexcept
+{
+    auto* p = next;
+    while (p != this)
+    {
+        auto* n = p->next;
+        p->prev = nullptr;
+        p->next = nullptr;
+        p = n;
+    }
+
+    prev = this;
+    next = this;
+}
+
+constexpr void intrusive::list_element_base::detach() noexcept
+{
+    assert(prev != this);
+    assert(next != this);
+    prev->next = next;
+    next->prev = prev;
+}
+
+constexpr void intrusive::list_element_base::reset() noexcept
+{
+    prev = this;
+    next = this;
+}
+
+constexpr void intrusive::list_element_base::insert(list_element_base& obj) noexcept
+{
+    obj.next = this;
+    obj.prev = prev;
+    prev->next = &obj;
+    prev = &obj;
+}
+
+constexpr std::size_t intrusive::list_element_base::unlink_range(list_element_base& last) noexcept
+{
+    if (this == &last)
+        return 0;
+
+    list_element_base* p = this;
+    detach_range(last);
+
+    std::size_t n = 0;
+    while (p != &last)
+    {
+        auto* next = p->next;
+        p->prev = nullptr;
+        p->next = nullptr;
+        p = next;
+        ++n;
+    }
+    return n;
+}
+
+constexpr void intrusive::list_element_base::detach_range(list_element_base& last) noexcept
+{
+    if (this == &last)
+        return;
+
+    prev->next = &last;
+    last.prev = prev;
+}
+
+constexpr void intrusive::list_element_base::insert_chain(list_element_base& first, list_element_base& last) noexcept
+{
+    first.prev = prev;
+    last.next = this;
+    prev->next = &first;
+    prev = &last;
+}
+
+constexpr void intrusive::list_element_base::splice(list_element_base& first, list_element_base& last) noexcept
+{
+    if (&first == &last)
+        return;
+
+    detail::triswap(prev->next, first.prev->next, last.prev->next);
+    detail::triswap(prev, last.prev, first.prev);
+}
+
+template <typename Link>
+constexpr void intrusive::basic_list_element_base<Link>::unlink() noexcept
+{
+    assert(prev != nullptr);
+    assert(next != nullptr);
+    assert(prev != this);
+    assert(next != this);
+    prev->next = next;
+    next->prev = prev;
+    prev = nullptr;
+    next = nullptr;
+}
+
+template <typename Link>
+constexpr void intrusive::basic_list_element_base<Link>::try_unlink() noexcept
+{
+    assert((prev == nullptr) == (next == nullptr));
+    if (prev != nullptr)
+        unlink();
+}
+
+template <typename Link>
+constexpr void intrusive::basic_list_element_base<Link>::clear() noexcept
+{
+    basic_list_element_base* p = next;
+    while (p != this)
+    {
+        basic_list_element_base* n = p->next;
+        p->prev = nullptr;
+        p->next = nullptr;
+        p = n;
+    }
+
+    prev = this;
+    next = this;
+}
+
+template <typename Link>
+constexpr void intrusive::basic_list_element_base<Link>::detach() noexcept
+{
+    assert(prev != this);
+    assert(next != this);
+    prev->next = next;
+    next->prev = prev;
+}
+
+template <typename Link>
+constexpr void intrusive::basic_list_element_base<Link>::reset() noexcept
+{
+    prev = this;
+    next = this;
+}
+
+template <typename Link>
+constexpr void intrusive::basic_list_element_base<Link>::insert(basic_list_element_base& obj) noexcept
+{
+    obj.next = this;
+    obj.prev = prev;
+    prev->next = &obj;
+    prev = &obj;
+}
+
+template <typename Link>
+constexpr std::size_t intrusive::basic_list_element_base<Link>::unlink_range(basic_list_element_base& last) noexcept
+{
+    if (this == &last)
+        return 0;
+
+    basic_list_element_base* p = this;
+    detach_range(last);
+
+    std::size_t n = 0;
+    while (p != &last)
+    {
+        basic_list_element_base* next = p->next;
+        p->prev = nullptr;
+        p->next = nullptr;
+        p = next;
+        ++n;
+    }
+    return n;
+}
+
+template <typename Link>
+constexpr void intrusive::basic_list_element_base<Link>::detach_range(basic_list_element_base& last) noexcept
+{
+    if (this == &last)
+        return;
+
+    prev->next = &last;
+    last.prev = prev;
+}
+
+template <typename Link>
+constexpr void intrusive::basic_list_element_base<Link>::insert_chain(basic_list_element_base& first, basic_list_element_base& last) noexcept
+{
+    first.prev = prev;
+    last.next = this;
+    prev->next = &first;
+    prev = &last;
+}
+
+template <typename Link>
+constexpr void intrusive::basic_list_element_base<Link>::splice(basic_list_element_base& first, basic_list_element_base& last) noexcept
+{
+    if (&first == &last)
+        return;
+
+    detail::triswap(prev->next, first.prev->next, last.prev->next);
+    detail::triswap(prev, last.prev, first.prev);
+}
+
+#ifdef INTRUSIVE_LIST_HEADER_ONLY
+#include "intrusive_list.cpp"
+#endif
@@ -0,0 +1,175 @@
+#pragma once
+#include "intrusive_list.h"
+#include <cstddef>
+
+/*
+Хуки нескольких тегов одним блоком:
+
+struct node : intrusive::list_elements<by_time, by_owner, by_state>
+{
+    ...
+};
+intrusive::list<node, by_time> timeline;
+intrusive::list<node, by_owner> owned;
+
+Когда node наследуется от list_element<by_time>, list_element<by_owner>
+и list_element<by_state> вперемежку с другими базами, хуки лежат там,
+где их положил компилятор: между ними могут оказаться чужие поля и
+выравнивание, и три хука легко расползаются по двум строкам кеша. А
+деструктор node -- это три отдельных деструктора list_element, каждый
+со своей проверкой и отвязкой.
+
+list_elements<Tags...> кладет prev/next всех тегов подряд, в порядке
+Tags, без промежутков: блок занимает ровно sizeof...(Tags) * 16 байт.
+basic_list_elements<Align, Tags...> вдобавок выравнивает блок на Align;
+если блок не больше Align, он целиком попадает в одну строку кеша
+(basic_list_elements<64, ...> для 64-байтной строки). Выравнивание
+переходит на node, так что sizeof(node) округляется до Align.
+
+list<node, Tag> находит хук нужного тега в блоке при компиляции, так
+же как базу list_element<Tag>; to_base/from_base -- все те же
+static_cast'ы. Деструктор блока отвязывает все теги за один проход,
+который целиком инлайнится.
+
+Сам по себе этот проход не быстрее трех деструкторов list_element:
+они тоже инлайнятся (см. bench_list_elements.cpp). Выигрыш дает
+выравнивание: 56-байтный объект с тремя хуками без него часто лежит
+на двух строках кеша, а с basic_list_elements<64, ...> -- на одной.
+
+Хуки блока всегда auto_unlink и хранят обычные указатели (pointer_link).
+Для safe_link, normal_link или index_link/offset_link нужны отдельные
+list_element с этими опциями. Отвязать один тег можно через
+unlink<Tag>(), проверить -- через is_linked<Tag>().
+*/
+namespace intrusive
+{
+    template <std::size_t Align, typename... Tags>
+    struct basic_list_elements;
+
+    namespace detail
+    {
+        /*
+        Хук одного тега внутри basic_list_elements. Своего деструктора
+        у него нет: отвязывает весь блок сразу.
+        */
+        template <typename Tag>
+        struct bundled_list_element : private list_element_base
+        {
+            using link_mode = auto_unlink;
+            using node_type = list_element_base;
+
+            constexpr bundled_list_element() noexcept
+                : node_type{nullptr, nullptr}
+            {}
+
+            bundled_list_element(bundled_list_element const&) = delete;
+            bundled_list_element& operator=(bundled_list_element const&) = delete;
+
+            template <std::size_t Align, typename... Tags>
+            friend struct intrusive::basic_list_elements;
+
+            template <typename T, typename Tag1, typename... Options1>
+            friend struct intrusive::list;
+
+            template <typename Tag1, typename T>
+            friend constexpr detail::hook_node_t<T, Tag1>& intrusive::to_base(T&) noexcept;
+
+            template <typename Tag1, typename T>
+            friend constexpr detail::hook_node_t<T, Tag1> const& intrusive::to_base(T const&) noexcept;
+
+            template <typename T1, typename Tag1>
+            friend constexpr T1& intrusive::from_base(detail::hook_node_t<T1, Tag1>&) noexcept;
+
+            template <typename T1, typename Tag1>
+            friend constexpr T1 const& intrusive::from_base(detail::hook_node_t<T1, Tag1> const&) noexcept;
+        };
+
+        /*
+        Перегрузка для hook_t: находится через ADL, bundled_list_element
+        -- база T.
+        */
+        template <typename Tag>
+        bundled_list_element<Tag>& find_hook(bundled_list_element<Tag>&) noexcept;
+    }
+
+    template <std::size_t Align, typename... Tags>
+    struct alignas(Align) basic_list_elements : detail::bundled_list_element<Tags>...
+    {
+        static_assert(sizeof...(Tags) != 0, "list_elements needs at least one tag");
+        static_assert((Align & (Align - 1)) == 0 && Align >= alignof(list_element_base),
+            "Align must be a power of two not less than the alignment of a pointer");
+
+        constexpr basic_list_elements() noexcept = default;
+        INTRUSIVE_LIST_CONSTEXPR_DESTRUCTOR ~basic_list_elements() noexcept;
+        basic_list_elements(basic_list_elements const&) = delete;
+        basic_list_elements& operator=(basic_list_elements const&) = delete;
+
+        template <typename Tag>
+        constexpr void unlink() noexcept;
+
+        template <typename Tag>
+        constexpr bool is_linked() const noexcept;
+
+    private:
+        /*
+        Весь блок умирает сразу, поэтому prev/next отвязанного хука
+        можно не обнулять. try_unlink их обнуляет, и после инлайна эти
+        записи не выкидываются: компилятор не знает, что следующие
+        отвязки не читают через них тот же объект.
+        */
+        static constexpr void detach_if_linked(list_element_base& n) noexcept;
+
+        template <typename Tag>
+        constexpr list_element_base& node() noexcept;
+
+        template <typename Tag>
+        constexpr list_element_base const& node() const noexcept;
+    };
+
+    template <typename... Tags>
+    using list_elements = basic_list_elements<alignof(list_element_base), Tags...>;
+}
+
+template <std::size_t Align, typename... Tags>
+INTRUSIVE_LIST_CONSTEXPR_DESTRUCTOR intrusive::basic_list_elements<Align, Tags...>::~basic_list_elements() noexcept
+{
+    (detach_if_linked(node<Tags>()), ...);
+}
+
+template <std::size_t Align, typename... Tags>
+constexpr void intrusive::basic_list_elements<Align, Tags...>::detach_if_linked(list_element_base& n) noexcept
+{
+    assert((n.prev == nullptr) == (n.next == nullptr));
+    if (n.prev)
+        n.detach();
+}
+
+template <std::size_t Align, typename... Tags>
+template <typename Tag>
+constexpr void intrusive::basic_list_elements<Align, Tags...>::unlink() noexcept
+{
+    node<Tag>().unlink();
+}
+
+template <std::size_t Align, typename... Tags>
+template <typename Tag>
+constexpr bool intrusive::basic_list_elements<Align, Tags...>::is_linked() const noexcept
+{
+    list_element_base const& n = node<Tag>();
+    assert((n.prev == nullptr) == (n.next == nullptr));
+    return n.prev != nullptr;
+}
+
+template <std::size_t Align, typename... Tags>
+template <typename Tag>
+constexpr intrusive::list_element_base& intrusive::basic_list_elements<Align, Tags...>::node() noexcept
+{
+    return static_cast<detail::bundled_list_element<Tag>&>(*this);
+}
+
+template <std::size_t Align, typename... Tags>
+template <typename Tag>
+constexpr intrusive::list_element_base const& intrusive::basic_list_elements<Align, Tags...>::node() const noexcept
+{
+    return static_cast<detail::bundled_list_element<Tag> const&>(*this);
+}
@@ -0,0 +1,101 @@
+#include "intrusive_list_index.h"
+
+INTRUSIVE_LIST_INLINE intrusive::detail::list_index_base::list_index_base(std::size_t stride)
+    : stride(stride == 0 ? 1 : stride)
+    , total(0)
+    , stale(false)
+    , tree(1, 0)
+{}
+
+/*
+Спуск по дереву Фенвика: идем от старшего бита номера сегмента к
+младшему и берем узел, если сумма с ним еще не больше k.
+*/
+INTRUSIVE_LIST_INLINE std::size_t intrusive::detail::list_index_base::locate(std::size_t k, std::size_t& offset) const noexcept
+{
+    assert(k < total);
+
+    std::size_t count = sizes.size();
+    std::size_t step = 1;
+    while (step * 2 <= count)
+        step *= 2;
+
+    std::size_t position = 0;
+    for (; step != 0; step /= 2)
+    {
+        std::size_t next = position + step;
+        if (next <= count && tree[next] <= k)
+        {
+            position = next;
+            k -= tree[next];
+        }
+    }
+
+    offset = k;
+    return position;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::list_index_base::add(std::size_t segment, std::ptrdiff_t delta) noexcept
+{
+    sizes[segment] += static_cast<std::size_t>(delta);
+    total += static_cast<std::size_t>(delta);
+    for (std::size_t i = segment + 1; i < tree.size(); i += i & -i)
+        tree[i] += static_cast<std::size_t>(delta);
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::list_index_base::insert_segment(std::size_t segment, std::size_t size)
+{
+    sizes.insert(sizes.begin() + static_cast<std::ptrdiff_t>(segment), size);
+    tree.push_back(0);
+    total += size;
+    rebuild_tree();
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::list_index_base::divide_segment(std::size_t segment, std::size_t first_size)
+{
+    std::size_t rest = sizes[segment] - first_size;
+    sizes.insert(sizes.begin() + static_cast<std::ptrdiff_t>(segment + 1), rest);
+    sizes[segment] = first_size;
+    tree.push_back(0);
+    rebuild_tree();
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::list_index_base::erase_segment(std::size_t segment)
+{
+    total -= sizes[segment];
+    sizes.erase(sizes.begin() + static_cast<std::ptrdiff_t>(segment));
+    tree.pop_back();
+    rebuild_tree();
+}
+
+/*
+Узел i дерева покрывает только сегменты с номерами меньше i, поэтому
+после отрезания хвоста префикс дерева остается верным.
+*/
+INTRUSIVE_LIST_INLINE void intrusive::detail::list_index_base::truncate(std::size_t count)
+{
+    for (std::size_t i = count; i != sizes.size(); ++i)
+        total -= sizes[i];
+    sizes.resize(count);
+    tree.resize(count + 1);
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::list_index_base::clear() noexcept
+{
+    total = 0;
+    sizes.clear();
+    tree.assign(1, 0);
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::list_index_base::rebuild_tree() noexcept
+{
+    tree.resize(sizes.size() + 1);
+    for (std::size_t i = 1; i != tree.size(); ++i)
+        tree[i] = sizes[i - 1];
+    for (std::size_t i = 1; i != tree.size(); ++i)
+    {
+        std::size_t parent = i + (i & -i);
+        if (parent < tree.size())
+            tree[parent] += tree[i];
+    }
+}
@@ -0,0 +1,348 @@
+#pragma once
+#include "intrusive_list.h"
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+/*
+Индекс по позициям поверх list: k-й элемент, диапазон [a, b) и
+разрезание списка пополам без обхода половины списка.
+
+intrusive::list<node> list;
+intrusive::list_index<intrusive::list<node>> index(list);
+index.push_back(x);
+node& middle = *index.nth(index.size() / 2);
+
+Список разбит на сегменты, в среднем по stride элементов. Индекс
+хранит итератор на первый элемент каждого сегмента и дерево Фенвика
+по размерам сегментов. nth(k) находит сегмент спуском по дереву за
+O(log(n / stride)) и доходит до элемента внутри сегмента не больше
+чем за 2 * stride шагов. Сами ноды индекс не меняет, памяти в хуках
+не занимает.
+
+Позиционные вставка и удаление (insert_at, erase_at, push_*, pop_*)
+идут через индекс и обновляют его: размер сегмента меняется в дереве
+за O(log(n / stride)). Сегмент, выросший до 2 * stride, делится
+пополам, опустевший удаляется. При этом сдвигается массив сегментов,
+то есть это O(n / stride), но случается не чаще раза на stride
+вставок.
+
+Если список меняли мимо индекса (list::insert, splice, unlink()
+у auto_unlink элемента и т. п.), надо вызвать invalidate(): индекс
+перестроится целиком за O(n) при следующем обращении. Без этого
+результаты не определены.
+
+Своего положения итератор не знает, поэтому «advance_fast» в этом
+интерфейсе -- это nth(k + d) для элемента с номером k.
+*/
+namespace intrusive
+{
+    namespace detail
+    {
+        /*
+        Все, что не зависит от типа списка: размеры сегментов и дерево
+        Фенвика по ним.
+        */
+        struct list_index_base
+        {
+            explicit list_index_base(std::size_t stride);
+
+            /*
+            Номер сегмента, в котором лежит элемент с номером k < total,
+            и номер элемента внутри сегмента.
+            */
+            std::size_t locate(std::size_t k, std::size_t& offset) const noexcept;
+
+            void add(std::size_t segment, std::ptrdiff_t delta) noexcept;
+
+            /*
+            Вставить сегмент из size новых элементов перед segment,
+            разделить сегмент на два, первый из которых размера
+            first_size, удалить сегмент, оставить только первые count
+            сегментов. Дерево пересчитывается.
+            */
+            void insert_segment(std::size_t segment, std::size_t size);
+            void divide_segment(std::size_t segment, std::size_t first_size);
+            void erase_segment(std::size_t segment);
+            void truncate(std::size_t count);
+
+            void clear() noexcept;
+            void rebuild_tree() noexcept;
+
+            std::size_t stride;
+            std::size_t total;
+            bool stale;
+            std::vector<std::size_t> sizes;
+
+            /*
+            tree[i] -- сумма sizes[i - lowbit(i), i), нумерация с 1.
+            */
+            std::vector<std::size_t> tree;
+        };
+    }
+
+    template <typename List>
+    struct list_index : private detail::list_index_base
+    {
+        using value_type = typename List::iterator::value_type;
+        using iterator = typename List::iterator;
+        using const_iterator = typename List::const_iterator;
+        using size_type = std::size_t;
+
+        /*
+        Индекс строится сразу по текущему содержимому списка. list
+        должен жить дольше индекса.
+        */
+        explicit list_index(List& list, size_type stride = 64);
+        list_index(list_index const&) = delete;
+        list_index& operator=(list_index const&) = delete;
+
+        size_type size();
+
+        iterator nth(size_type k);
+
+        /*
+        Элементы [first, last) и их количество, для splice с
+        известным n и для обхода по страницам.
+        */
+        struct range
+        {
+            iterator first;
+            iterator last;
+            size_type size;
+        };
+
+        range slice(size_type first, size_type last);
+
+        /*
+        Переносит элементы начиная с k в конец to одним splice'ом.
+        Индекс после этого описывает оставшиеся k элементов.
+        */
+        void split_at(size_type k, List& to);
+
+        iterator insert_at(size_type k, value_type&);
+        void erase_at(size_type k);
+
+        void push_back(value_type&);
+        void push_front(value_type&);
+        void pop_back();
+        void pop_front();
+
+        /*
+        Список изменили мимо индекса.
+        */
+        void invalidate() noexcept;
+
+    private:
+        void refresh();
+        void rebuild();
+        void split_segment(size_type segment);
+
+    private:
+        List& list;
+        std::vector<iterator> firsts;
+    };
+}
+
+template <typename List>
+intrusive::list_index<List>::list_index(List& list, size_type stride)
+    : detail::list_index_base(stride)
+    , list(list)
+{
+    rebuild();
+}
+
+template <typename List>
+typename intrusive::list_index<List>::size_type intrusive::list_index<List>::size()
+{
+    refresh();
+    return total;
+}
+
+template <typename List>
+typename intrusive::list_index<List>::iterator intrusive::list_index<List>::nth(size_type k)
+{
+    refresh();
+    if (k >= total)
+        return list.end();
+
+    size_type offset;
+    size_type segment = locate(k, offset);
+    return std::next(firsts[segment], static_cast<std::ptrdiff_t>(offset));
+}
+
+template <typename List>
+typename intrusive::list_index<List>::range intrusive::list_index<List>::slice(size_type first, size_type last)
+{
+    refresh();
+    if (last > total)
+        last = total;
+    if (first > last)
+        first = last;
+    return {nth(first), nth(last), last - first};
+}
+
+template <typename List>
+void intrusive::list_index<List>::split_at(size_type k, List& to)
+{
+    refresh();
+    if (k >= total)
+        return;
+
+    size_type offset;
+    size_type segment = locate(k, offset);
+    iterator first = std::next(firsts[segment], static_cast<std::ptrdiff_t>(offset));
+    to.splice(to.end(), list, first, list.end(), total - k);
+
+    if (offset == 0)
+    {
+        truncate(segment);
+        firsts.resize(segment);
+    }
+    else
+    {
+        add(segment, static_cast<std::ptrdiff_t>(offset) - static_cast<std::ptrdiff_t>(sizes[segment]));
+        truncate(segment + 1);
+        firsts.resize(segment + 1);
+    }
+}
+
+template <typename List>
+typename intrusive::list_index<List>::iterator intrusive::list_index<List>::insert_at(size_type k, value_type& obj)
+{
+    refresh();
+    assert(k <= total);
+
+    if (total == 0)
+    {
+        iterator it = list.insert(list.end(), obj);
+        stale = true;
+        insert_segment(0, 1);
+        firsts.push_back(it);
+        stale = false;
+        return it;
+    }
+
+    size_type segment;
+    iterator it;
+    if (k == total)
+    {
+        segment = sizes.size() - 1;
+        it = list.insert(list.end(), obj);
+    }
+    else
+    {
+        size_type offset;
+        segment = locate(k, offset);
+        it = list.insert(std::next(firsts[segment], static_cast<std::ptrdiff_t>(offset)), obj);
+        if (offset == 0)
+            firsts[segment] = it;
+    }
+
+    add(segment, 1);
+    if (sizes[segment] >= 2 * stride)
+        split_segment(segment);
+    return it;
+}
+
+template <typename List>
+void intrusive::list_index<List>::erase_at(size_type k)
+{
+    refresh();
+    assert(k < total);
+
+    size_type offset;
+    size_type segment = locate(k, offset);
+    iterator it = std::next(firsts[segment], static_cast<std::ptrdiff_t>(offset));
+    iterator next = list.erase(it);
+    if (offset == 0)
+        firsts[segment] = next;
+
+    add(segment, -1);
+    if (sizes[segment] == 0)
+    {
+        erase_segment(segment);
+        firsts.erase(firsts.begin() + static_cast<std::ptrdiff_t>(segment));
+    }
+}
+
+template <typename List>
+void intrusive::list_index<List>::push_back(value_type& obj)
+{
+    insert_at(size(), obj);
+}
+
+template <typename List>
+void intrusive::list_index<List>::push_front(value_type& obj)
+{
+    insert_at(0, obj);
+}
+
+template <typename List>
+void intrusive::list_index<List>::pop_back()
+{
+    erase_at(size() - 1);
+}
+
+template <typename List>
+void intrusive::list_index<List>::pop_front()
+{
+    erase_at(0);
+}
+
+template <typename List>
+void intrusive::list_index<List>::invalidate() noexcept
+{
+    stale = true;
+}
+
+template <typename List>
+void intrusive::list_index<List>::refresh()
+{
+    if (stale)
+        rebuild();
+}
+
+template <typename List>
+void intrusive::list_index<List>::rebuild()
+{
+    firsts.clear();
+    detail::list_index_base::clear();
+
+    size_type in_segment = 0;
+    for (iterator it = list.begin(); it != list.end(); ++it, ++in_segment)
+    {
+        if (in_segment == stride)
+            in_segment = 0;
+        if (in_segment == 0)
+        {
+            firsts.push_back(it);
+            sizes.push_back(0);
+        }
+        ++sizes.back();
+        ++total;
+    }
+
+    rebuild_tree();
+    stale = false;
+}
+
+template <typename List>
+void intrusive::list_index<List>::split_segment(size_type segment)
+{
+    size_type half = sizes[segment] / 2;
+    iterator middle = std::next(firsts[segment], static_cast<std::ptrdiff_t>(half));
+
+    /*
+    Если вектор не вырастет, индекс перестроится на следующем
+    обращении.
+    */
+    stale = true;
+    divide_segment(segment, half);
+    firsts.insert(firsts.begin() + static_cast<std::ptrdiff_t>(segment + 1), middle);
+    stale = false;
+}
+
+#ifdef INTRUSIVE_LIST_HEADER_ONLY
+#include "intrusive_list_index.cpp"
+#endif
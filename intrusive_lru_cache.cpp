@@ -0,0 +1,106 @@
+#include "intrusive_lru_cache.h"
+#include <cassert>
+#include <cstdint>
+
+/*
+Бакет выбирается фибоначчиевым хешированием: хеш умножается на 2^64/phi
+и берутся старшие биты. std::hash для целых -- тождественная функция,
+и без перемешивания ключи с одинаковыми младшими битами попадали бы в
+один бакет.
+*/
+INTRUSIVE_LIST_INLINE intrusive::detail::lru_cache_base::lru_cache_base(std::size_t bucket_count)
+    : shift(64)
+    , count(0)
+    , total_charge(0)
+    , fake{&fake, &fake}
+{
+    std::size_t n = 1;
+    while (n < bucket_count)
+    {
+        n *= 2;
+        --shift;
+    }
+    if (shift == 64)
+    {
+        n = 2;
+        shift = 63;
+    }
+    buckets.reset(new lru_cache_element_base*[n]());
+}
+
+INTRUSIVE_LIST_INLINE intrusive::detail::lru_cache_base::~lru_cache_base()
+{
+    for (list_element_base* p = fake.next; p != &fake;)
+    {
+        list_element_base* next = p->next;
+        auto* node = static_cast<lru_cache_element_base*>(p);
+        node->prev = nullptr;
+        node->next = nullptr;
+        node->bucket_next = nullptr;
+        p = next;
+    }
+}
+
+INTRUSIVE_LIST_INLINE intrusive::lru_cache_element_base*& intrusive::detail::lru_cache_base::bucket_slot(std::size_t hash) const noexcept
+{
+    return buckets[(std::uint64_t(hash) * 0x9e3779b97f4a7c15ull) >> shift];
+}
+
+INTRUSIVE_LIST_INLINE intrusive::lru_cache_element_base* intrusive::detail::lru_cache_base::bucket(std::size_t hash) const noexcept
+{
+    return bucket_slot(hash);
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::lru_cache_base::link(lru_cache_element_base& obj, std::size_t hash, std::size_t charge) noexcept
+{
+    lru_cache_element_base*& head = bucket_slot(hash);
+    obj.bucket_next = head;
+    head = &obj;
+    obj.hash = hash;
+    obj.charge = charge;
+    obj.referenced = false;
+    fake.next->insert(obj);
+    ++count;
+    total_charge += charge;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::lru_cache_base::unlink(lru_cache_element_base& obj) noexcept
+{
+    assert(obj.prev != nullptr && "element is not in the cache");
+    lru_cache_element_base** pp = &bucket_slot(obj.hash);
+    while (*pp != &obj)
+        pp = &(*pp)->bucket_next;
+    *pp = obj.bucket_next;
+    obj.bucket_next = nullptr;
+    obj.unlink();
+    --count;
+    total_charge -= obj.charge;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::lru_cache_base::move_to_front(lru_cache_element_base& obj) noexcept
+{
+    if (fake.next == &obj)
+        return;
+    obj.detach();
+    fake.next->insert(obj);
+}
+
+INTRUSIVE_LIST_INLINE intrusive::lru_cache_element_base* intrusive::detail::lru_cache_base::lru_victim() noexcept
+{
+    return fake.prev != &fake ? static_cast<lru_cache_element_base*>(fake.prev) : nullptr;
+}
+
+INTRUSIVE_LIST_INLINE intrusive::lru_cache_element_base* intrusive::detail::lru_cache_base::clock_victim() noexcept
+{
+    /*
+    Каждый проход сбрасывает бит, так что больше count шагов не будет.
+    */
+    for (;;)
+    {
+        lru_cache_element_base* p = lru_victim();
+        if (p == nullptr || !p->referenced)
+            return p;
+        p->referenced = false;
+        move_to_front(*p);
+    }
+}
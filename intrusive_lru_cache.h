@@ -0,0 +1,435 @@
+#pragma once
+#include "intrusive_list.h"
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+/*
+Интрузивный LRU кеш: хеш-индекс по ключу плюс список по давности
+использования. Оба индекса живут в одном хуке lru_cache_element<Tag>,
+так что кеш не аллоцирует ничего, кроме массива бакетов в конструкторе.
+Объекты создает и удаляет пользователь: кеш отдает вытесненные объекты
+в disposer.
+
+struct entry : intrusive::lru_cache_element<>
+{
+    std::string key;
+    blob value;
+};
+
+intrusive::lru_cache<std::string, entry> cache(4096);
+cache.insert(*new entry{...}, bytes);
+if (entry* e = cache.find(key))
+    use(*e);
+cache.evict_to(budget, [](entry* e) { delete e; });
+
+Попадание в LRU режиме -- перевязывание элемента в начало списка: шесть
+записей указателей, если элемент не первый, и ни одной, если первый.
+erase + push_front из list делает на две записи больше, потому что
+обнуляет отвязанный элемент.
+
+С опцией clock_replacement попадание элемент не перевязывает, а только
+ставит ему бит "использовался" (и не пишет в память, если бит уже
+стоит). Вытеснение смотрит на самый старый элемент: если бит стоит, он
+сбрасывается, а элемент переносится в начало (second chance). Это
+тот же CLOCK, только стрелкой служит конец списка. На read-heavy
+нагрузке попадания не пачкают кеш-линии соседних элементов.
+
+Количество бакетов задается в конструкторе и не меняется: размер кеша
+ограничен бюджетом, и его обычно знают заранее.
+*/
+namespace intrusive
+{
+    namespace detail
+    {
+        struct key_of_kind;
+        struct hash_kind;
+        struct key_equal_kind;
+        struct replacement_kind;
+
+        /*
+        Ключ по умолчанию -- поле key у value_type.
+        */
+        struct member_key
+        {
+            template <typename V>
+            auto operator()(V const& value) const noexcept -> decltype((value.key))
+            {
+                return value.key;
+            }
+        };
+    }
+
+    /*
+    Опции lru_cache. Функторы должны быть без состояния: кеш создает их
+    на каждый вызов.
+    */
+    template <typename KeyOf>
+    struct key_of
+    {
+        using kind = detail::key_of_kind;
+        using type = KeyOf;
+    };
+
+    template <typename Hash>
+    struct hash
+    {
+        using kind = detail::hash_kind;
+        using type = Hash;
+    };
+
+    template <typename KeyEqual>
+    struct key_equal
+    {
+        using kind = detail::key_equal_kind;
+        using type = KeyEqual;
+    };
+
+    struct lru_replacement
+    {
+        using kind = detail::replacement_kind;
+    };
+
+    struct clock_replacement
+    {
+        using kind = detail::replacement_kind;
+    };
+
+    /*
+    prev/next из list_element_base -- список по давности, самый свежий
+    элемент в начале. bucket_next связывает элементы одного бакета. hash
+    запоминается, чтобы при поиске сравнивать сначала его, а не ключи, и
+    чтобы отвязывание не считало хеш заново.
+    */
+    struct lru_cache_element_base : list_element_base
+    {
+        lru_cache_element_base* bucket_next;
+        std::size_t hash;
+        std::size_t charge;
+        bool referenced;
+    };
+
+    namespace detail
+    {
+        struct lru_cache_base
+        {
+            explicit lru_cache_base(std::size_t bucket_count);
+            ~lru_cache_base();
+            lru_cache_base(lru_cache_base const&) = delete;
+            lru_cache_base& operator=(lru_cache_base const&) = delete;
+
+            lru_cache_element_base* bucket(std::size_t hash) const noexcept;
+            lru_cache_element_base*& bucket_slot(std::size_t hash) const noexcept;
+
+            /*
+            Кладет элемент в бакет и в начало списка.
+            */
+            void link(lru_cache_element_base&, std::size_t hash, std::size_t charge) noexcept;
+            void unlink(lru_cache_element_base&) noexcept;
+            void move_to_front(lru_cache_element_base&) noexcept;
+
+            /*
+            Следующий кандидат на вытеснение, nullptr если кеш пуст.
+            clock_victim по дороге дает второй шанс элементам с битом.
+            */
+            lru_cache_element_base* lru_victim() noexcept;
+            lru_cache_element_base* clock_victim() noexcept;
+
+            std::unique_ptr<lru_cache_element_base*[]> buckets;
+            unsigned shift;
+            std::size_t count;
+            std::size_t total_charge;
+            list_element_base fake;
+        };
+    }
+
+    template <typename Tag>
+    struct lru_cache_element;
+
+    namespace detail
+    {
+        template <typename Tag>
+        lru_cache_element<Tag>& find_lru_hook(lru_cache_element<Tag>&) noexcept;
+
+        template <typename T, typename Tag>
+        using lru_hook_t = std::remove_reference_t<decltype(find_lru_hook<Tag>(std::declval<std::remove_const_t<T>&>()))>;
+
+        template <typename T, typename Tag, typename = void>
+        constexpr bool has_lru_hook_v = false;
+
+        template <typename T, typename Tag>
+        constexpr bool has_lru_hook_v<T, Tag, std::void_t<lru_hook_t<T, Tag>>> = true;
+    }
+
+    /*
+    Хук lru_cache. Работает как safe_link: отвязать себя сам он не
+    может (кешу надо поправить размер и бюджет), поэтому деструктор
+    проверяет assert'ом, что элемента в кеше нет.
+    */
+    template <typename Tag = default_tag>
+    struct lru_cache_element : private lru_cache_element_base
+    {
+        lru_cache_element() noexcept;
+        ~lru_cache_element() noexcept;
+        lru_cache_element(lru_cache_element const&) = delete;
+        lru_cache_element& operator=(lru_cache_element const&) = delete;
+
+        bool is_linked() const noexcept;
+
+        template <typename K, typename V, typename Tag1, typename... Options>
+        friend struct lru_cache;
+
+        template <typename Tag1, typename T>
+        friend std::enable_if_t<detail::has_lru_hook_v<T, Tag1>, lru_cache_element_base&> to_base(T&) noexcept;
+
+        template <typename T1, typename Tag1>
+        friend T1& from_base(lru_cache_element_base&) noexcept;
+    };
+
+    template <typename Tag, typename T>
+    std::enable_if_t<detail::has_lru_hook_v<T, Tag>, lru_cache_element_base&> to_base(T&) noexcept;
+
+    template <typename T, typename Tag>
+    T& from_base(lru_cache_element_base&) noexcept;
+
+    template <typename K, typename V, typename Tag = default_tag, typename... Options>
+    struct lru_cache : private detail::lru_cache_base
+    {
+        static_assert(detail::has_lru_hook_v<V, Tag>,
+            "value type is not convertible to lru_cache_element");
+
+        using key_type = K;
+        using value_type = V;
+        using size_type = std::size_t;
+
+        using key_of_type = typename detail::find_option_t<detail::key_of_kind, key_of<detail::member_key>, Options...>::type;
+        using hasher = typename detail::find_option_t<detail::hash_kind, hash<std::hash<K>>, Options...>::type;
+        using key_equal_type = typename detail::find_option_t<detail::key_equal_kind, key_equal<std::equal_to<K>>, Options...>::type;
+
+        static constexpr bool is_clock = std::is_same_v<
+            detail::find_option_t<detail::replacement_kind, lru_replacement, Options...>, clock_replacement>;
+
+        /*
+        bucket_count округляется вверх до степени двойки.
+        */
+        explicit lru_cache(size_type bucket_count);
+
+        /*
+        Элементы, оставшиеся в кеше, отвязываются, но не удаляются.
+        Перед этим обычно зовут clear_and_dispose.
+        */
+        ~lru_cache() = default;
+
+        /*
+        Ищет элемент и отмечает его как использованный. nullptr, если
+        элемента с таким ключом нет.
+        */
+        V* find(K const&) noexcept;
+
+        /*
+        Поиск без отметки об использовании.
+        */
+        V* peek(K const&) const noexcept;
+
+        /*
+        Кладет элемент в кеш как самый свежий. charge -- сколько байт
+        элемент тратит из бюджета. false, если элемент с таким ключом в
+        кеше уже есть: тогда новый элемент не вставляется.
+        */
+        bool insert(V&, size_type charge = sizeof(V)) noexcept;
+
+        void erase(V&) noexcept;
+
+        /*
+        Отмечает элемент, который уже лежит в кеше, как использованный.
+        */
+        void touch(V&) noexcept;
+
+        /*
+        Вытесняет один элемент и отдает его в disposer(V*). false, если
+        кеш пуст.
+        */
+        template <typename Disposer>
+        bool evict_lru(Disposer disposer);
+
+        /*
+        Вытесняет элементы, пока суммарный charge больше budget.
+        Возвращает количество вытесненных.
+        */
+        template <typename Disposer>
+        size_type evict_to(size_type budget, Disposer disposer);
+
+        template <typename Disposer>
+        void clear_and_dispose(Disposer disposer);
+
+        size_type size() const noexcept;
+        bool empty() const noexcept;
+
+        /*
+        Сумма charge всех элементов в кеше.
+        */
+        size_type charge() const noexcept;
+
+    private:
+        lru_cache_element_base* lookup(K const&) const noexcept;
+    };
+}
+
+template <typename Tag>
+intrusive::lru_cache_element<Tag>::lru_cache_element() noexcept
+    : lru_cache_element_base{{nullptr, nullptr}, nullptr, 0, 0, false}
+{}
+
+template <typename Tag>
+intrusive::lru_cache_element<Tag>::~lru_cache_element() noexcept
+{
+    assert(!is_linked() && "lru_cache_element is destroyed while in a cache");
+}
+
+template <typename Tag>
+bool intrusive::lru_cache_element<Tag>::is_linked() const noexcept
+{
+    return prev != nullptr;
+}
+
+template <typename Tag, typename T>
+std::enable_if_t<intrusive::detail::has_lru_hook_v<T, Tag>, intrusive::lru_cache_element_base&> intrusive::to_base(T& obj) noexcept
+{
+    return static_cast<detail::lru_hook_t<T, Tag>&>(obj);
+}
+
+template <typename T, typename Tag>
+T& intrusive::from_base(lru_cache_element_base& base) noexcept
+{
+    return static_cast<T&>(static_cast<detail::lru_hook_t<T, Tag>&>(base));
+}
+
+template <typename K, typename V, typename Tag, typename... Options>
+intrusive::lru_cache<K, V, Tag, Options...>::lru_cache(size_type bucket_count)
+    : detail::lru_cache_base(bucket_count)
+{}
+
+template <typename K, typename V, typename Tag, typename... Options>
+intrusive::lru_cache_element_base* intrusive::lru_cache<K, V, Tag, Options...>::lookup(K const& key) const noexcept
+{
+    std::size_t h = hasher{}(key);
+    for (lru_cache_element_base* p = bucket(h); p != nullptr; p = p->bucket_next)
+        if (p->hash == h && key_equal_type{}(key_of_type{}(from_base<V, Tag>(*p)), key))
+            return p;
+    return nullptr;
+}
+
+template <typename K, typename V, typename Tag, typename... Options>
+V* intrusive::lru_cache<K, V, Tag, Options...>::find(K const& key) noexcept
+{
+    lru_cache_element_base* p = lookup(key);
+    if (p == nullptr)
+        return nullptr;
+
+    V& value = from_base<V, Tag>(*p);
+    touch(value);
+    return &value;
+}
+
+template <typename K, typename V, typename Tag, typename... Options>
+V* intrusive::lru_cache<K, V, Tag, Options...>::peek(K const& key) const noexcept
+{
+    lru_cache_element_base* p = lookup(key);
+    return p != nullptr ? &from_base<V, Tag>(*p) : nullptr;
+}
+
+template <typename K, typename V, typename Tag, typename... Options>
+bool intrusive::lru_cache<K, V, Tag, Options...>::insert(V& value, size_type charge) noexcept
+{
+    lru_cache_element_base& base = to_base<Tag>(value);
+    assert(base.prev == nullptr && "element is already in a cache");
+
+    auto const& key = key_of_type{}(static_cast<V const&>(value));
+    if (lookup(key) != nullptr)
+        return false;
+
+    link(base, hasher{}(key), charge);
+    return true;
+}
+
+template <typename K, typename V, typename Tag, typename... Options>
+void intrusive::lru_cache<K, V, Tag, Options...>::erase(V& value) noexcept
+{
+    unlink(to_base<Tag>(value));
+}
+
+template <typename K, typename V, typename Tag, typename... Options>
+void intrusive::lru_cache<K, V, Tag, Options...>::touch(V& value) noexcept
+{
+    lru_cache_element_base& base = to_base<Tag>(value);
+    if constexpr (is_clock)
+    {
+        if (!base.referenced)
+            base.referenced = true;
+    }
+    else
+    {
+        move_to_front(base);
+    }
+}
+
+template <typename K, typename V, typename Tag, typename... Options>
+template <typename Disposer>
+bool intrusive::lru_cache<K, V, Tag, Options...>::evict_lru(Disposer disposer)
+{
+    lru_cache_element_base* victim;
+    if constexpr (is_clock)
+        victim = clock_victim();
+    else
+        victim = lru_victim();
+
+    if (victim == nullptr)
+        return false;
+
+    unlink(*victim);
+    disposer(&from_base<V, Tag>(*victim));
+    return true;
+}
+
+template <typename K, typename V, typename Tag, typename... Options>
+template <typename Disposer>
+typename intrusive::lru_cache<K, V, Tag, Options...>::size_type intrusive::lru_cache<K, V, Tag, Options...>::evict_to(size_type budget, Disposer disposer)
+{
+    size_type n = 0;
+    while (total_charge > budget && evict_lru(disposer))
+        ++n;
+    return n;
+}
+
+template <typename K, typename V, typename Tag, typename... Options>
+template <typename Disposer>
+void intrusive::lru_cache<K, V, Tag, Options...>::clear_and_dispose(Disposer disposer)
+{
+    while (lru_cache_element_base* victim = lru_victim())
+    {
+        unlink(*victim);
+        disposer(&from_base<V, Tag>(*victim));
+    }
+}
+
+template <typename K, typename V, typename Tag, typename... Options>
+typename intrusive::lru_cache<K, V, Tag, Options...>::size_type intrusive::lru_cache<K, V, Tag, Options...>::size() const noexcept
+{
+    return count;
+}
+
+template <typename K, typename V, typename Tag, typename... Options>
+bool intrusive::lru_cache<K, V, Tag, Options...>::empty() const noexcept
+{
+    return count == 0;
+}
+
+template <typename K, typename V, typename Tag, typename... Options>
+typename intrusive::lru_cache<K, V, Tag, Options...>::size_type intrusive::lru_cache<K, V, Tag, Options...>::charge() const noexcept
+{
+    return total_charge;
+}
+
+#ifdef INTRUSIVE_LIST_HEADER_ONLY
+#include "intrusive_lru_cache.cpp"
+#endif
@@ -0,0 +1,144 @@
+#include "intrusive_mpsc_queue.h"
+#include <cassert>
+#include <thread>
+
+/*
+Порядок памяти. Producer сначала обнуляет next своего элемента, потом
+exchange'ем делает его новой головой, записывает prev и release-записью
+цепляет к предыдущей голове. Consumer читает next с acquire, так что
+увидев ссылку на элемент, он видит и его prev, и обнуленный next.
+*/
+INTRUSIVE_LIST_INLINE intrusive::detail::mpsc_queue_base::mpsc_queue_base() noexcept
+    : head(&stub)
+    , tail(&stub)
+    , stub{nullptr, nullptr}
+{}
+
+INTRUSIVE_LIST_INLINE intrusive::list_element_base* intrusive::detail::mpsc_queue_base::load_next(list_element_base& obj) noexcept
+{
+    return __atomic_load_n(&obj.next, __ATOMIC_ACQUIRE);
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::mpsc_queue_base::push(list_element_base& obj) noexcept
+{
+    __atomic_store_n(&obj.next, nullptr, __ATOMIC_RELAXED);
+    list_element_base* prev = head.exchange(&obj, std::memory_order_acq_rel);
+    obj.prev = prev;
+    __atomic_store_n(&prev->next, &obj, __ATOMIC_RELEASE);
+}
+
+INTRUSIVE_LIST_INLINE intrusive::list_element_base* intrusive::detail::mpsc_queue_base::try_pop() noexcept
+{
+    list_element_base* first = tail;
+    list_element_base* next = load_next(*first);
+    if (first == &stub)
+    {
+        if (next == nullptr)
+            return nullptr;
+        tail = next;
+        first = next;
+        next = load_next(*next);
+    }
+
+    if (next == nullptr)
+    {
+        /*
+        first -- последний дописанный элемент. Если голова дальше,
+        producer еще не прицепил следующий элемент. Иначе за first
+        ставится stub, чтобы first можно было отдать.
+        */
+        if (first != head.load(std::memory_order_acquire))
+            return nullptr;
+        push(stub);
+        next = load_next(*first);
+        if (next == nullptr)
+            return nullptr;
+    }
+
+    tail = next;
+    first->prev = nullptr;
+    first->next = nullptr;
+    return first;
+}
+
+INTRUSIVE_LIST_INLINE intrusive::list_element_base* intrusive::detail::mpsc_queue_base::wait_next(list_element_base& obj) noexcept
+{
+    list_element_base* next;
+    while ((next = load_next(obj)) == nullptr)
+        std::this_thread::yield();
+    return next;
+}
+
+INTRUSIVE_LIST_INLINE std::size_t intrusive::detail::mpsc_queue_base::take_all(list_element_base*& first, list_element_base*& last) noexcept
+{
+    list_element_base* p = tail;
+    first = p;
+    std::size_t n = 1;
+
+    if (p == &stub)
+    {
+        p = load_next(stub);
+        if (p == nullptr)
+            return 0;
+        first = p;
+    }
+    else
+    {
+        /*
+        tail не на stub'е: значит, try_pop уже ставил stub в конец, и
+        он может до сих пор лежать в цепочке после tail (try_pop
+        проиграл гонку producer'у, и за вынутым элементом успел
+        встать чужой). Второй раз поставить его в конец нельзя:
+        push затрет его next, и всё, что за ним, потеряется.
+
+        Сам stub ставит только consumer, поэтому если он в цепочке, то
+        не дальше головы, прочитанной сейчас. Если stub и есть голова,
+        граница уже стоит. Иначе он посередине: вырезаем его и ставим
+        в конец как обычно.
+        */
+        list_element_base* h = head.load(std::memory_order_acquire);
+        while (p != h)
+        {
+            list_element_base* next = wait_next(*p);
+            if (next == &stub)
+            {
+                if (h == &stub)
+                {
+                    last = p;
+                    tail = &stub;
+                    return n;
+                }
+                next = wait_next(stub);
+                next->prev = p;
+                __atomic_store_n(&p->next, next, __ATOMIC_RELAXED);
+                continue;
+            }
+            p = next;
+            ++n;
+        }
+    }
+
+    /*
+    stub ставится в конец и служит границей: всё, что до него, наше.
+    Producer'ы, которые сделали exchange раньше, дописывают ссылки за
+    несколько инструкций, их мы дожидаемся.
+    */
+    push(stub);
+    for (;;)
+    {
+        list_element_base* next = wait_next(*p);
+        if (next == &stub)
+            break;
+        p = next;
+        ++n;
+    }
+
+    last = p;
+    tail = &stub;
+    return n;
+}
+
+INTRUSIVE_LIST_INLINE bool intrusive::detail::mpsc_queue_base::empty() const noexcept
+{
+    return tail == &stub && head.load(std::memory_order_acquire) == &stub;
+}
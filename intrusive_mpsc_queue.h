@@ -0,0 +1,158 @@
+#pragma once
+#include "intrusive_list.h"
+#include <atomic>
+
+/*
+Интрузивная MPSC очередь (много producer'ов, один consumer) по схеме
+Дмитрия Вьюкова:
+https://www.1024cores.net/home/lock-free-algorithms/queues/intrusive-mpsc-node-based-queue
+
+Элементы связываются через тот же list_element<Tag>, что и в list,
+поэтому элемент можно вынуть из очереди и сразу положить в список, и
+наоборот. Пока элемент лежит в очереди, он считается привязанным:
+удалять его нельзя, а is_linked() возвращает true.
+
+push() можно звать из любого потока, он wait-free: один exchange и одна
+запись. try_pop(), drain() и empty() -- только из потока consumer'а.
+
+У схемы есть известная особенность: producer, который уже сделал
+exchange, но еще не дописал ссылку на свой элемент, на короткое время
+"разрывает" очередь. try_pop() в этот момент возвращает nullptr, даже
+если за разрывом есть элементы, а drain() дожидается, пока ссылка
+будет дописана.
+
+Нужны обычные указатели в хуке (pointer_link): next читается и
+пишется атомарно через __atomic builtin'ы. Я не стал заводить в хуке
+std::atomic, чтобы не менять размер и тип list_element_base.
+*/
+namespace intrusive
+{
+    namespace detail
+    {
+        struct mpsc_queue_base
+        {
+            mpsc_queue_base() noexcept;
+            mpsc_queue_base(mpsc_queue_base const&) = delete;
+            mpsc_queue_base& operator=(mpsc_queue_base const&) = delete;
+
+            void push(list_element_base&) noexcept;
+            list_element_base* try_pop() noexcept;
+
+            /*
+            Забирает из очереди всё, что было в нее положено до вызова.
+            Элементы остаются связанными в цепочку [first, last]:
+            producer'ы сами проставляют prev своих элементов, поэтому
+            цепочку остается только обойти и проверить, что все ссылки
+            дописаны. Возвращает количество элементов.
+            */
+            std::size_t take_all(list_element_base*& first, list_element_base*& last) noexcept;
+
+            bool empty() const noexcept;
+
+        private:
+            static list_element_base* load_next(list_element_base&) noexcept;
+            static list_element_base* wait_next(list_element_base&) noexcept;
+
+        protected:
+            /*
+            head пишут producer'ы, tail -- только consumer. Они лежат в
+            разных кеш-линиях, чтобы consumer и producer'ы не отбирали
+            их друг у друга.
+
+            protected -- для тестов: гонки try_pop с producer'ами они
+            собирают руками.
+            */
+            alignas(64) std::atomic<list_element_base*> head;
+            alignas(64) list_element_base* tail;
+            list_element_base stub;
+        };
+    }
+
+    template <typename T, typename Tag = default_tag>
+    struct mpsc_queue : protected detail::mpsc_queue_base
+    {
+        static_assert(detail::has_hook_v<T, Tag>,
+            "value type is not convertible to list_element");
+
+        static_assert(std::is_same_v<detail::hook_node_t<T, Tag>, list_element_base>,
+            "mpsc_queue requires elements with plain pointer links");
+
+        using link_mode = typename detail::hook_t<T, Tag>::link_mode;
+
+        mpsc_queue() noexcept = default;
+
+        /*
+        Очередь должна быть пуста: оставшиеся в ней элементы ссылаются
+        на stub внутри очереди.
+        */
+        ~mpsc_queue();
+
+        void push(T&) noexcept;
+
+        /*
+        nullptr, если очередь пуста или если первый элемент еще не
+        дописан producer'ом. Вынутый элемент отвязан, как после
+        list::erase.
+        */
+        T* try_pop() noexcept;
+
+        /*
+        Переносит в конец out всё, что было положено в очередь до
+        вызова. Элементы обходятся один раз, только на чтение, а в
+        список цепочка вставляется целиком. Возвращает количество
+        перенесенных элементов.
+        */
+        template <typename... Options>
+        std::size_t drain(list<T, Tag, Options...>& out) noexcept;
+
+        bool empty() const noexcept;
+    };
+}
+
+template <typename T, typename Tag>
+intrusive::mpsc_queue<T, Tag>::~mpsc_queue()
+{
+    assert(empty() && "mpsc_queue is destroyed while not empty");
+}
+
+template <typename T, typename Tag>
+void intrusive::mpsc_queue<T, Tag>::push(T& obj) noexcept
+{
+    list_element_base& base = to_base<Tag>(obj);
+    if constexpr (!std::is_same_v<link_mode, normal_link>)
+        assert(base.prev == nullptr && "element is already linked");
+    detail::mpsc_queue_base::push(base);
+}
+
+template <typename T, typename Tag>
+T* intrusive::mpsc_queue<T, Tag>::try_pop() noexcept
+{
+    list_element_base* base = detail::mpsc_queue_base::try_pop();
+    return base != nullptr ? &from_base<T, Tag>(*base) : nullptr;
+}
+
+template <typename T, typename Tag>
+template <typename... Options>
+std::size_t intrusive::mpsc_queue<T, Tag>::drain(list<T, Tag, Options...>& out) noexcept
+{
+    list_element_base* first;
+    list_element_base* last;
+    std::size_t n = take_all(first, last);
+    if (n != 0)
+    {
+        out.fake.insert_chain(*first, *last);
+        out.add_size(n);
+        out.note_link(n);
+    }
+    return n;
+}
+
+template <typename T, typename Tag>
+bool intrusive::mpsc_queue<T, Tag>::empty() const noexcept
+{
+    return detail::mpsc_queue_base::empty();
+}
+
+#ifdef INTRUSIVE_LIST_HEADER_ONLY
+#include "intrusive_mpsc_queue.cpp"
+#endif
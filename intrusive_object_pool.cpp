@@ -0,0 +1,147 @@
+#include "intrusive_object_pool.h"
+#include <cassert>
+
+/*
+Слабы связаны в список через заголовок в начале каждого слаба, чтобы
+пул не держал отдельного массива указателей на них.
+*/
+struct intrusive::detail::object_pool_slab
+{
+    object_pool_slab* next;
+};
+
+INTRUSIVE_LIST_INLINE std::size_t intrusive::detail::object_pool_base::round_up(std::size_t value, std::size_t align) noexcept
+{
+    return (value + align - 1) / align * align;
+}
+
+INTRUSIVE_LIST_INLINE intrusive::detail::object_pool_base::object_pool_base(std::size_t object_size, std::size_t object_align, std::size_t slots_per_slab)
+    : slot_align(object_align < alignof(object_pool_slot) ? alignof(object_pool_slot) : object_align)
+    , free_list(nullptr)
+    , bump(nullptr)
+    , bump_end(nullptr)
+    , slabs(nullptr)
+    , slab_count(0)
+    , live(0)
+{
+    slot_size = round_up(object_size < sizeof(object_pool_slot) ? sizeof(object_pool_slot) : object_size, slot_align);
+    if (slots_per_slab == 0)
+    {
+        constexpr std::size_t default_slab_bytes = 64 * 1024;
+        slots_per_slab = default_slab_bytes / slot_size;
+        if (slots_per_slab < 16)
+            slots_per_slab = 16;
+    }
+    this->slots_per_slab = slots_per_slab;
+}
+
+INTRUSIVE_LIST_INLINE intrusive::detail::object_pool_base::~object_pool_base()
+{
+    assert(live == 0 && "object_pool is destroyed while some objects are alive");
+    while (slabs != nullptr)
+    {
+        object_pool_slab* next = slabs->next;
+        ::operator delete(slabs, std::align_val_t(slot_align));
+        slabs = next;
+    }
+}
+
+INTRUSIVE_LIST_INLINE void* intrusive::detail::object_pool_base::allocate()
+{
+    ++live;
+    if (free_list != nullptr)
+    {
+        object_pool_slot* slot = free_list;
+        free_list = slot->next;
+        return slot;
+    }
+
+    if (bump == bump_end)
+    {
+        try
+        {
+            add_slab();
+        }
+        catch (...)
+        {
+            --live;
+            throw;
+        }
+    }
+
+    void* p = bump;
+    bump += slot_size;
+    return p;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::object_pool_base::deallocate(void* p) noexcept
+{
+    assert(live != 0);
+    --live;
+    auto* slot = static_cast<object_pool_slot*>(p);
+    slot->next = free_list;
+    free_list = slot;
+}
+
+/*
+Цепочка собирается сначала из списка свободных, а остаток -- подряд из
+текущего слаба. Новый слаб выделяется, только если не нашлось ни
+одного слота.
+*/
+INTRUSIVE_LIST_INLINE intrusive::detail::object_pool_slot* intrusive::detail::object_pool_base::allocate_chain(std::size_t n, std::size_t& got)
+{
+    if (free_list == nullptr && bump == bump_end)
+        add_slab();
+
+    object_pool_slot* first = nullptr;
+    object_pool_slot** tail = &first;
+    got = 0;
+
+    while (got != n && free_list != nullptr)
+    {
+        *tail = free_list;
+        tail = &free_list->next;
+        free_list = free_list->next;
+        ++got;
+    }
+
+    while (got != n && bump != bump_end)
+    {
+        auto* slot = reinterpret_cast<object_pool_slot*>(bump);
+        bump += slot_size;
+        *tail = slot;
+        tail = &slot->next;
+        ++got;
+    }
+
+    *tail = nullptr;
+    live += got;
+    return first;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::object_pool_base::deallocate_chain(object_pool_slot* first, object_pool_slot* last, std::size_t n) noexcept
+{
+    assert(live >= n);
+    live -= n;
+    last->next = free_list;
+    free_list = first;
+}
+
+INTRUSIVE_LIST_INLINE std::size_t intrusive::detail::object_pool_base::capacity() const noexcept
+{
+    return slab_count * slots_per_slab;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::object_pool_base::add_slab()
+{
+    std::size_t header = round_up(sizeof(object_pool_slab), slot_align);
+    void* memory = ::operator new(header + slot_size * slots_per_slab, std::align_val_t(slot_align));
+
+    auto* slab = static_cast<object_pool_slab*>(memory);
+    slab->next = slabs;
+    slabs = slab;
+    ++slab_count;
+
+    bump = static_cast<char*>(memory) + header;
+    bump_end = bump + slot_size * slots_per_slab;
+}
@@ -0,0 +1,392 @@
+#pragma once
+#include "intrusive_concurrent_list.h"
+#include <cstddef>
+#include <new>
+#include <utility>
+
+/*
+Пул объектов: память под T берется из слабов, больших кусков на много
+объектов сразу, а освобожденные объекты складываются в список
+свободных. Указатель на следующий свободный объект лежит в памяти
+самого объекта (там, где у живого объекта был хук), так что свободный
+объект не стоит ни байта сверху.
+
+intrusive::object_pool<node> pool;
+node* n = pool.create(args...);
+list.push_back(*n);
+...
+list.clear_and_dispose(pool.disposer());
+
+Новые объекты сначала берутся из списка свободных (последний
+освобожденный, скорее всего, еще в кеше), а когда он пуст -- подряд из
+текущего слаба. Объекты, созданные подряд, лежат подряд, и обход
+списка, собранного в порядке создания, идет по памяти последовательно.
+
+Код пула не зависит от T, только от размера и выравнивания слота: пулы
+для типов одного размера используют одну и ту же нешаблонную базу.
+
+По умолчанию пул не потокобезопасный. С опцией synchronized_pool
+create() и destroy() берут спинлок, а потоки, которые часто создают и
+удаляют объекты, могут завести себе object_pool_cache: он держит
+небольшой запас свободных объектов и ходит в общий пул за ними пачками.
+
+Пул при удалении освобождает слабы, но деструкторы живых объектов не
+вызывает: к этому моменту все объекты должны быть удалены через него.
+*/
+namespace intrusive
+{
+    namespace detail
+    {
+        struct pool_sync_kind;
+    }
+
+    /*
+    Опция object_pool: create() и destroy() можно вызывать из разных
+    потоков, и можно заводить object_pool_cache.
+    */
+    struct synchronized_pool
+    {
+        using kind = detail::pool_sync_kind;
+    };
+
+    struct unsynchronized_pool
+    {
+        using kind = detail::pool_sync_kind;
+    };
+
+    namespace detail
+    {
+        struct object_pool_slot
+        {
+            object_pool_slot* next;
+        };
+
+        struct object_pool_slab;
+
+        struct object_pool_base
+        {
+            object_pool_base(std::size_t object_size, std::size_t object_align, std::size_t slots_per_slab);
+            ~object_pool_base();
+            object_pool_base(object_pool_base const&) = delete;
+            object_pool_base& operator=(object_pool_base const&) = delete;
+
+            /*
+            Бросает std::bad_alloc, если нужен новый слаб, а памяти нет.
+            */
+            void* allocate();
+            void deallocate(void*) noexcept;
+
+            /*
+            Для object_pool_cache: выдать до n слотов цепочкой (последний
+            указывает в nullptr) и вернуть цепочку из n слотов.
+            */
+            object_pool_slot* allocate_chain(std::size_t n, std::size_t& got);
+            void deallocate_chain(object_pool_slot* first, object_pool_slot* last, std::size_t n) noexcept;
+
+            std::size_t capacity() const noexcept;
+
+        private:
+            static std::size_t round_up(std::size_t value, std::size_t align) noexcept;
+            void add_slab();
+
+        private:
+            std::size_t slot_size;
+            std::size_t slot_align;
+            std::size_t slots_per_slab;
+
+            object_pool_slot* free_list;
+            char* bump;
+            char* bump_end;
+            object_pool_slab* slabs;
+            std::size_t slab_count;
+            std::size_t live;
+        };
+
+        /*
+        Лок пула. Без synchronized_pool пустой, и пул наследуется от него
+        приватно, так что из-за EBO он не занимает места.
+        */
+        template <bool Synchronized>
+        struct pool_lock
+        {
+            void lock() noexcept {}
+            void unlock() noexcept {}
+        };
+
+        template <>
+        struct pool_lock<true> : spinlock
+        {};
+
+        template <typename Lock>
+        struct pool_guard
+        {
+            explicit pool_guard(Lock& lock) noexcept
+                : lock(lock)
+            {
+                lock.lock();
+            }
+
+            ~pool_guard()
+            {
+                lock.unlock();
+            }
+
+            pool_guard(pool_guard const&) = delete;
+            pool_guard& operator=(pool_guard const&) = delete;
+
+            Lock& lock;
+        };
+
+        template <typename... Options>
+        constexpr bool pool_synchronized_v
+            = std::is_same_v<find_option_t<pool_sync_kind, unsynchronized_pool, Options...>, synchronized_pool>;
+
+        template <typename Owner, typename T>
+        struct pool_disposer
+        {
+            void operator()(T* p) const noexcept
+            {
+                owner->destroy(p);
+            }
+
+            Owner* owner;
+        };
+    }
+
+    template <typename T, typename... Options>
+    struct object_pool_cache;
+
+    template <typename T, typename... Options>
+    struct object_pool
+        : private detail::object_pool_base
+        , private detail::pool_lock<detail::pool_synchronized_v<Options...>>
+    {
+        static constexpr bool is_synchronized = detail::pool_synchronized_v<Options...>;
+
+        /*
+        slots_per_slab -- сколько объектов помещается в один слаб. По
+        умолчанию столько, чтобы слаб был около 64 КБ.
+        */
+        explicit object_pool(std::size_t slots_per_slab = 0);
+
+        /*
+        Выделяет память и конструирует T. Если конструктор бросает,
+        память возвращается в пул.
+        */
+        template <typename... Args>
+        T* create(Args&&... args);
+
+        void destroy(T*) noexcept;
+
+        /*
+        Функтор для erase_and_dispose, clear_and_dispose и прочих
+        операций с disposer'ом: элементы отвязываются и возвращаются в
+        пул за один проход.
+        */
+        detail::pool_disposer<object_pool, T> disposer() noexcept;
+
+        /*
+        Сколько объектов помещается во все выделенные слабы.
+        */
+        std::size_t capacity() const noexcept;
+
+    private:
+        using lock_type = detail::pool_lock<is_synchronized>;
+
+        template <typename T1, typename... Options1>
+        friend struct object_pool_cache;
+    };
+
+    /*
+    Запас свободных объектов одного потока. Заводится на стеке потока
+    (или в thread_local) и используется только им. create() и destroy()
+    работают без лока, пока в запасе есть объекты и пока он не
+    переполнен; за новыми объектами и с лишними кеш ходит в пул пачками
+    по batch штук. Деструктор возвращает весь запас в пул.
+
+    Объект, созданный через кеш одного потока, можно удалить через пул
+    или через кеш другого потока.
+    */
+    template <typename T, typename... Options>
+    struct object_pool_cache
+    {
+        static_assert(object_pool<T, Options...>::is_synchronized,
+            "object_pool_cache requires synchronized_pool");
+
+        explicit object_pool_cache(object_pool<T, Options...>&, std::size_t batch = 32) noexcept;
+        ~object_pool_cache();
+        object_pool_cache(object_pool_cache const&) = delete;
+        object_pool_cache& operator=(object_pool_cache const&) = delete;
+
+        template <typename... Args>
+        T* create(Args&&... args);
+
+        void destroy(T*) noexcept;
+
+        detail::pool_disposer<object_pool_cache, T> disposer() noexcept;
+
+    private:
+        void* allocate();
+        void deallocate(void*) noexcept;
+
+        /*
+        Отдает в пул все объекты запаса, кроме первых keep.
+        */
+        void flush(std::size_t keep) noexcept;
+
+    private:
+        object_pool<T, Options...>& pool;
+        detail::object_pool_slot* head;
+        std::size_t count;
+        std::size_t batch;
+    };
+}
+
+template <typename T, typename... Options>
+intrusive::object_pool<T, Options...>::object_pool(std::size_t slots_per_slab)
+    : detail::object_pool_base(sizeof(T), alignof(T), slots_per_slab)
+{}
+
+template <typename T, typename... Options>
+template <typename... Args>
+T* intrusive::object_pool<T, Options...>::create(Args&&... args)
+{
+    void* p;
+    {
+        detail::pool_guard<lock_type> guard(*this);
+        p = allocate();
+    }
+
+    try
+    {
+        return ::new (p) T(std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+        detail::pool_guard<lock_type> guard(*this);
+        deallocate(p);
+        throw;
+    }
+}
+
+template <typename T, typename... Options>
+void intrusive::object_pool<T, Options...>::destroy(T* p) noexcept
+{
+    p->~T();
+    detail::pool_guard<lock_type> guard(*this);
+    deallocate(p);
+}
+
+template <typename T, typename... Options>
+intrusive::detail::pool_disposer<intrusive::object_pool<T, Options...>, T> intrusive::object_pool<T, Options...>::disposer() noexcept
+{
+    return {this};
+}
+
+template <typename T, typename... Options>
+std::size_t intrusive::object_pool<T, Options...>::capacity() const noexcept
+{
+    return object_pool_base::capacity();
+}
+
+template <typename T, typename... Options>
+intrusive::object_pool_cache<T, Options...>::object_pool_cache(object_pool<T, Options...>& pool, std::size_t batch) noexcept
+    : pool(pool)
+    , head(nullptr)
+    , count(0)
+    , batch(batch == 0 ? 1 : batch)
+{}
+
+template <typename T, typename... Options>
+intrusive::object_pool_cache<T, Options...>::~object_pool_cache()
+{
+    flush(0);
+}
+
+template <typename T, typename... Options>
+template <typename... Args>
+T* intrusive::object_pool_cache<T, Options...>::create(Args&&... args)
+{
+    void* p = allocate();
+    try
+    {
+        return ::new (p) T(std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+        deallocate(p);
+        throw;
+    }
+}
+
+template <typename T, typename... Options>
+void intrusive::object_pool_cache<T, Options...>::destroy(T* p) noexcept
+{
+    p->~T();
+    deallocate(p);
+}
+
+template <typename T, typename... Options>
+intrusive::detail::pool_disposer<intrusive::object_pool_cache<T, Options...>, T> intrusive::object_pool_cache<T, Options...>::disposer() noexcept
+{
+    return {this};
+}
+
+template <typename T, typename... Options>
+void* intrusive::object_pool_cache<T, Options...>::allocate()
+{
+    if (head == nullptr)
+    {
+        typename object_pool<T, Options...>::lock_type& lock = pool;
+        detail::pool_guard<typename object_pool<T, Options...>::lock_type> guard(lock);
+        head = static_cast<detail::object_pool_base&>(pool).allocate_chain(batch, count);
+    }
+
+    detail::object_pool_slot* slot = head;
+    head = slot->next;
+    --count;
+    return slot;
+}
+
+template <typename T, typename... Options>
+void intrusive::object_pool_cache<T, Options...>::deallocate(void* p) noexcept
+{
+    auto* slot = static_cast<detail::object_pool_slot*>(p);
+    slot->next = head;
+    head = slot;
+    if (++count > 2 * batch)
+        flush(batch);
+}
+
+template <typename T, typename... Options>
+void intrusive::object_pool_cache<T, Options...>::flush(std::size_t keep) noexcept
+{
+    if (count <= keep)
+        return;
+
+    detail::object_pool_slot* before = nullptr;
+    detail::object_pool_slot* first = head;
+    for (std::size_t i = 0; i != keep; ++i)
+    {
+        before = first;
+        first = first->next;
+    }
+
+    detail::object_pool_slot* last = first;
+    while (last->next != nullptr)
+        last = last->next;
+
+    if (before != nullptr)
+        before->next = nullptr;
+    else
+        head = nullptr;
+
+    typename object_pool<T, Options...>::lock_type& lock = pool;
+    detail::pool_guard<typename object_pool<T, Options...>::lock_type> guard(lock);
+    static_cast<detail::object_pool_base&>(pool).deallocate_chain(first, last, count - keep);
+    count = keep;
+}
+
+#ifdef INTRUSIVE_LIST_HEADER_ONLY
+#include "intrusive_object_pool.cpp"
+#endif
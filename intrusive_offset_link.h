@@ -0,0 +1,107 @@
+#pragma once
+#include "intrusive_list.h"
+#include <cstdint>
+
+/*
+Хук с самоотносительными ссылками, для списков в разделяемой памяти и
+в mmap'нутых файлах:
+
+struct node : intrusive::list_element<my_tag, intrusive::offset_link> {};
+
+prev/next хранятся как смещение цели от адреса самого поля, а не как
+абсолютный адрес. Если область, в которой лежат и элементы, и list'ы
+(элементы ссылаются на fake внутри list), отобразить по другому адресу
+или скопировать memcpy'ем, ссылки внутри нее остаются верными без
+всякого прохода по исправлению указателей. Ссылки наружу области при
+этом, конечно, ломаются.
+
+Размер хука тот же, что у pointer_link, а каждый переход к соседу
+стоит одного лишнего сложения. Смещение 1 зарезервировано под nullptr:
+хук выровнен как указатель, так что настоящее смещение нечетным не
+бывает. Смещение 0 законно: prev внутри fake пустого списка указывает
+на сам fake, то есть на свой же адрес.
+
+Копирование offset_ptr -- это не копирование смещения: копия
+указывает туда же, куда оригинал, и смещение пересчитывается от ее
+собственного адреса. Итератор хранит обычный указатель, поэтому
+итераторы, как и у index_link, после переезда области недействительны.
+*/
+namespace intrusive
+{
+    template <typename Node>
+    struct offset_ptr
+    {
+        static constexpr std::uintptr_t null_offset = 1;
+
+        offset_ptr() = default;
+        offset_ptr(Node*) noexcept;
+        offset_ptr(offset_ptr const&) noexcept;
+        offset_ptr& operator=(offset_ptr const&) noexcept;
+        offset_ptr& operator=(Node*) noexcept;
+
+        operator Node*() const noexcept;
+        Node* operator->() const noexcept;
+
+        /*
+        Смещение считается по модулю 2^N, чтобы цель могла лежать и
+        до, и после поля без знаковой арифметики.
+        */
+        std::uintptr_t offset;
+    };
+
+    struct offset_link
+    {
+        using kind = detail::link_kind;
+
+        template <typename Node>
+        using pointer = offset_ptr<Node>;
+
+        using node_type = basic_list_element_base<offset_link>;
+    };
+}
+
+template <typename Node>
+intrusive::offset_ptr<Node>::offset_ptr(Node* p) noexcept
+{
+    *this = p;
+}
+
+template <typename Node>
+intrusive::offset_ptr<Node>::offset_ptr(offset_ptr const& other) noexcept
+{
+    *this = static_cast<Node*>(other);
+}
+
+template <typename Node>
+intrusive::offset_ptr<Node>& intrusive::offset_ptr<Node>::operator=(offset_ptr const& other) noexcept
+{
+    return *this = static_cast<Node*>(other);
+}
+
+template <typename Node>
+intrusive::offset_ptr<Node>& intrusive::offset_ptr<Node>::operator=(Node* p) noexcept
+{
+    if (p == nullptr)
+    {
+        offset = null_offset;
+        return *this;
+    }
+
+    offset = reinterpret_cast<std::uintptr_t>(p) - reinterpret_cast<std::uintptr_t>(this);
+    assert(offset != null_offset && "offset_link element is misaligned");
+    return *this;
+}
+
+template <typename Node>
+intrusive::offset_ptr<Node>::operator Node*() const noexcept
+{
+    if (offset == null_offset)
+        return nullptr;
+    return reinterpret_cast<Node*>(reinterpret_cast<std::uintptr_t>(this) + offset);
+}
+
+template <typename Node>
+Node* intrusive::offset_ptr<Node>::operator->() const noexcept
+{
+    return *this;
+}
@@ -0,0 +1,122 @@
+#include "intrusive_parallel.h"
+#include "intrusive_work_stealing_deque.h"
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace intrusive
+{
+    namespace detail
+    {
+        struct chunk_task : list_element<>
+        {
+            std::size_t index = 0;
+        };
+
+        /*
+        Очереди в одном массиве, поэтому выравнивание на кеш-линию
+        внутри work_stealing_deque тут и нужно.
+        */
+        using chunk_deque = work_stealing_deque<chunk_task>;
+    }
+}
+
+INTRUSIVE_LIST_INLINE std::size_t intrusive::detail::default_parallelism() noexcept
+{
+    return std::thread::hardware_concurrency();
+}
+
+/*
+Диапазоны раздаются потокам подряд: первому -- первые chunks / threads
+и т. д. Соседние диапазоны соседние и в памяти, если список собирали
+по порядку, а воры забирают у жертвы ее самые первые, еще не
+начатые. Задача выполнена, когда remaining дошел до нуля; после ошибки
+новые задачи не берутся, и оставшиеся в очередях отвязываются
+деструкторами очередей, когда все потоки уже остановились.
+*/
+INTRUSIVE_LIST_INLINE void intrusive::detail::run_chunks(std::size_t chunks, std::size_t threads, chunk_function run, void* context)
+{
+    if (threads > chunks)
+        threads = chunks;
+    if (threads <= 1)
+    {
+        for (std::size_t i = 0; i != chunks; ++i)
+            run(context, i);
+        return;
+    }
+
+    auto tasks = std::make_unique<chunk_task[]>(chunks);
+    auto deques = std::make_unique<chunk_deque[]>(threads);
+
+    /*
+    Владелец берет задачи с конца своей очереди, поэтому кладем их в
+    обратном порядке: свои диапазоны поток проходит от начала к концу.
+    */
+    for (std::size_t w = 0; w != threads; ++w)
+    {
+        std::size_t first = chunks * w / threads;
+        std::size_t last = chunks * (w + 1) / threads;
+        for (std::size_t i = last; i != first; --i)
+        {
+            tasks[i - 1].index = i - 1;
+            deques[w].push(tasks[i - 1]);
+        }
+    }
+
+    std::atomic<std::size_t> remaining{chunks};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto worker = [&](std::size_t w) {
+        chunk_deque& own = deques[w];
+        while (remaining.load(std::memory_order_acquire) != 0 && !failed.load(std::memory_order_relaxed))
+        {
+            chunk_task* t = own.pop();
+            for (std::size_t v = 1; t == nullptr && v != threads; ++v)
+                t = own.steal_from(deques[(w + v) % threads]);
+            if (t == nullptr)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            try
+            {
+                run(context, t->index);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error)
+                    error = std::current_exception();
+                failed.store(true, std::memory_order_relaxed);
+            }
+            remaining.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    try
+    {
+        for (std::size_t w = 1; w != threads; ++w)
+            pool.emplace_back(worker, w);
+    }
+    catch (...)
+    {
+        /*
+        Не удалось создать поток: задачи из его очереди разворуют
+        остальные.
+        */
+    }
+
+    worker(0);
+    for (std::thread& t : pool)
+        t.join();
+
+    if (error)
+        std::rethrow_exception(error);
+}
@@ -0,0 +1,228 @@
+#pragma once
+#include "intrusive_list.h"
+#include "intrusive_list_index.h"
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+/*
+Параллельный обход списка: список режется на непрерывные диапазоны
+[first, last) примерно одинаковой длины, и диапазоны выполняются на
+нескольких потоках.
+
+intrusive::parallel::for_each(list, [](node& x) { x.value = f(x); });
+int sum = intrusive::parallel::transform_reduce(list, 0, std::plus<>(),
+                                                [](node const& x) { return x.value; });
+
+Параллельно идет только работа f над элементами: сами диапазоны
+приходится находить одним последовательным обходом списка, у
+итератора нет произвольного доступа. Этот обход -- та же цепочка
+зависимых загрузок, что и обычный цикл, и на списке больше кеша он
+стоит почти столько же, сколько весь однопоточный пересчет с
+недорогой f (см. bench_parallel.cpp). Потоками он не делится, так
+что быстрее чем вдвое такой обход не станет ни на каком числе ядер.
+Если над списком уже есть list_index, его можно передать вместо
+списка: границы найдутся через nth() за O(parts * log), без обхода.
+
+Диапазонов берется по chunks_per_thread на поток, так что поток,
+которому достались элементы подороже, не задерживает остальных:
+у каждого потока своя work_stealing_deque с диапазонами, и
+освободившийся поток ворует их у соседей. Потоки создаются на каждый
+вызов, вызывающий поток работает вместе с ними. Это десятки
+микросекунд на вызов, поэтому обход коротких списков выгоднее делать
+обычным циклом.
+
+Пока идет обход, список менять нельзя: ни вставлять, ни удалять
+элементы, ни перевязывать их. f может читать элемент и менять его
+данные, но не хуки. f для разных элементов вызывается одновременно из
+разных потоков, поэтому все, что она трогает помимо своего элемента,
+должно быть потокобезопасным.
+
+transform_reduce сворачивает каждый диапазон слева направо, а потом
+результаты диапазонов -- по порядку, начиная с init. reduce должна
+быть ассоциативной, коммутативность не нужна, и результат не зависит
+от того, какой поток какой диапазон выполнил. Но от threads он зависит:
+при другом разбиении скобки расставлены по-другому, и для float
+результат может отличаться в последних битах.
+
+Если f бросила исключение, потоки дорабатывают начатые диапазоны и
+больше новых не берут, а исключение перебрасывается из вызова. Какие
+элементы к этому моменту обработаны, не определено.
+*/
+namespace intrusive
+{
+    namespace detail
+    {
+        constexpr std::size_t chunks_per_thread = 8;
+
+        using chunk_function = void (*)(void* context, std::size_t chunk);
+
+        /*
+        Выполняет run(context, i) для i из [0, chunks) на threads
+        потоках, включая текущий. Возвращается, когда выполнены все, и
+        перебрасывает первое исключение, брошенное из run.
+        */
+        void run_chunks(std::size_t chunks, std::size_t threads, chunk_function run, void* context);
+
+        /*
+        0 -- если hardware_concurrency() не знает ответа.
+        */
+        std::size_t default_parallelism() noexcept;
+
+        /*
+        Границы диапазонов за один проход: каждый step-й итератор, а
+        когда их набралось 2 * parts, каждый второй выкидывается и
+        step удваивается. Получается от parts до 2 * parts диапазонов
+        по step элементов, последний короче. Последняя граница -- end().
+        */
+        template <typename List>
+        std::vector<decltype(std::declval<List&>().begin())> split_ranges(List& list, std::size_t parts)
+        {
+            std::vector<decltype(list.begin())> bounds;
+            bounds.reserve(2 * parts + 1);
+
+            std::size_t step = 1;
+            std::size_t i = 0;
+            for (auto it = list.begin(); it != list.end(); ++it, ++i)
+            {
+                if ((i & (step - 1)) != 0)
+                    continue;
+                if (bounds.size() == 2 * parts)
+                {
+                    for (std::size_t j = 0; j != parts; ++j)
+                        bounds[j] = bounds[2 * j];
+                    bounds.resize(parts);
+                    step *= 2;
+                    if ((i & (step - 1)) != 0)
+                        continue;
+                }
+                bounds.push_back(it);
+            }
+            bounds.push_back(list.end());
+            return bounds;
+        }
+
+        template <typename List>
+        std::vector<typename List::iterator> split_ranges(list_index<List>& index, std::size_t parts)
+        {
+            std::size_t size = index.size();
+            if (parts > size)
+                parts = size;
+
+            std::vector<typename List::iterator> bounds;
+            bounds.reserve(parts + 1);
+            for (std::size_t j = 0; j != parts; ++j)
+                bounds.push_back(index.nth(j * size / parts));
+            bounds.push_back(index.nth(size));
+            return bounds;
+        }
+
+        template <typename Iterator, typename F>
+        struct for_each_job
+        {
+            static void run(void* context, std::size_t chunk)
+            {
+                auto& job = *static_cast<for_each_job*>(context);
+                for (Iterator it = job.bounds[chunk]; it != job.bounds[chunk + 1]; ++it)
+                    job.f(*it);
+            }
+
+            std::vector<Iterator> const& bounds;
+            F& f;
+        };
+
+        template <typename Iterator, typename T, typename Reduce, typename Transform>
+        struct transform_reduce_job
+        {
+            static void run(void* context, std::size_t chunk)
+            {
+                auto& job = *static_cast<transform_reduce_job*>(context);
+                Iterator it = job.bounds[chunk];
+                Iterator last = job.bounds[chunk + 1];
+
+                T acc = job.transform(*it);
+                for (++it; it != last; ++it)
+                    acc = job.reduce(std::move(acc), job.transform(*it));
+                job.partial[chunk].emplace(std::move(acc));
+            }
+
+            std::vector<Iterator> const& bounds;
+            Reduce& reduce;
+            Transform& transform;
+            std::vector<std::optional<T>> partial;
+        };
+
+        template <typename Container, typename F>
+        void parallel_for_each(Container& c, F& f, std::size_t threads)
+        {
+            if (threads == 0)
+                threads = 1;
+            auto bounds = split_ranges(c, threads * chunks_per_thread);
+            using iterator = typename decltype(bounds)::value_type;
+
+            for_each_job<iterator, F> job{bounds, f};
+            run_chunks(bounds.size() - 1, threads, &for_each_job<iterator, F>::run, &job);
+        }
+
+        template <typename Container, typename T, typename Reduce, typename Transform>
+        T parallel_transform_reduce(Container& c, T init, Reduce& reduce, Transform& transform, std::size_t threads)
+        {
+            if (threads == 0)
+                threads = 1;
+            auto bounds = split_ranges(c, threads * chunks_per_thread);
+            using iterator = typename decltype(bounds)::value_type;
+            using job_type = transform_reduce_job<iterator, T, Reduce, Transform>;
+
+            std::size_t chunks = bounds.size() - 1;
+            job_type job{bounds, reduce, transform, std::vector<std::optional<T>>(chunks)};
+            run_chunks(chunks, threads, &job_type::run, &job);
+
+            for (std::optional<T>& p : job.partial)
+                init = reduce(std::move(init), std::move(*p));
+            return init;
+        }
+    }
+
+    namespace parallel
+    {
+        /*
+        По умолчанию потоков столько, сколько ядер.
+        */
+        inline std::size_t default_threads() noexcept
+        {
+            std::size_t n = detail::default_parallelism();
+            return n != 0 ? n : 1;
+        }
+
+        template <typename List, typename F>
+        void for_each(List& list, F f, std::size_t threads = default_threads())
+        {
+            detail::parallel_for_each(list, f, threads);
+        }
+
+        template <typename List, typename F>
+        void for_each(list_index<List>& index, F f, std::size_t threads = default_threads())
+        {
+            detail::parallel_for_each(index, f, threads);
+        }
+
+        template <typename List, typename T, typename Reduce, typename Transform>
+        T transform_reduce(List& list, T init, Reduce reduce, Transform transform,
+                           std::size_t threads = default_threads())
+        {
+            return detail::parallel_transform_reduce(list, std::move(init), reduce, transform, threads);
+        }
+
+        template <typename List, typename T, typename Reduce, typename Transform>
+        T transform_reduce(list_index<List>& index, T init, Reduce reduce, Transform transform,
+                           std::size_t threads = default_threads())
+        {
+            return detail::parallel_transform_reduce(index, std::move(init), reduce, transform, threads);
+        }
+    }
+}
+
+#ifdef INTRUSIVE_LIST_HEADER_ONLY
+#include "intrusive_parallel.cpp"
+#endif
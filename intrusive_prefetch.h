@@ -0,0 +1,133 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+
+/*
+Обход списка с программной предвыборкой. Обычный цикл по list -- это
+цепочка зависимых загрузок current->next: следующий адрес известен
+только после того, как приехала текущая нода, и на больших списках
+обход упирается в латентность памяти.
+
+intrusive::for_each_prefetch(list, [](node& x) { ... }, 8);
+
+Перепрыгнуть через цепочку нельзя: чтобы узнать адрес ноды на k шагов
+вперед, надо пройти все k. Поэтому for_each_prefetch держит второй
+итератор на distance элементов впереди: он делает один шаг по цепочке
+на каждый вызов f и предвыбирает каждую ноду, до которой дошел,
+целиком, все ее строки кеша. Промах по следующей ноде цепочки
+перекрывается с работой f над текущей, так что обход стоит примерно
+max(латентность, f) на элемент, а не их сумму.
+
+Для короткой f то же самое делает и сам процессор: следующая загрузка
+next попадает в окно внеочередного исполнения, и обычный цикл уже
+стоит max(латентность, f). Выигрыш появляется, когда f длиннее этого
+окна (ветвления, вызовы, много работы на элемент). А если f почти
+ничего не делает, остается чистая цепочка загрузок, и ускорять нечего.
+См. bench_prefetch.cpp.
+
+distance больше 1 нужен, когда f тратит на разные элементы разное
+время или трогает у них несколько строк кеша. Больше
+max_prefetch_distance он не бывает.
+
+gather() выписывает указатели на следующие n элементов в массив и
+двигает итератор. Дальше с массивом можно работать пачками: без
+зависимых загрузок и с предвыборкой на любое расстояние вперед.
+
+Обе функции работают с любым контейнером с однонаправленными
+итераторами: list, slist, slim_list.
+*/
+namespace intrusive
+{
+    namespace detail
+    {
+        constexpr std::size_t cache_line_size = 64;
+        constexpr std::size_t max_prefetch_distance = 64;
+
+        /*
+        Не iterator_traits::pointer: у const_iterator list'а он
+        неконстантный.
+        */
+        template <typename Iterator>
+        using element_pointer_t = decltype(&*std::declval<Iterator const&>());
+
+        template <typename T>
+        void prefetch_object(T const* p) noexcept
+        {
+            char const* bytes = reinterpret_cast<char const*>(p);
+            for (std::size_t offset = 0; offset < sizeof(T); offset += cache_line_size)
+                __builtin_prefetch(bytes + offset);
+        }
+    }
+
+    /*
+    Вызывает f для каждого элемента по порядку. f может отвязать или
+    удалить текущий элемент (итератор впереди уже ушел дальше), но не
+    должна трогать следующие distance элементов и вставлять в список.
+    distance 0 считается за 1.
+    */
+    template <typename List, typename F>
+    void for_each_prefetch(List& list, F f, std::size_t distance = 8);
+
+    /*
+    Записывает в out указатели на элементы [first, last), но не больше
+    n, и сдвигает first за последний записанный. Возвращает, сколько
+    записано. Каждый записанный элемент предвыбирается.
+    */
+    template <typename Iterator>
+    std::size_t gather(Iterator& first, Iterator last,
+        detail::element_pointer_t<Iterator>* out, std::size_t n) noexcept;
+}
+
+template <typename List, typename F>
+void intrusive::for_each_prefetch(List& list, F f, std::size_t distance)
+{
+    using pointer = detail::element_pointer_t<decltype(list.begin())>;
+
+    if (distance == 0)
+        distance = 1;
+    if (distance > detail::max_prefetch_distance)
+        distance = detail::max_prefetch_distance;
+
+    /*
+    window -- кольцо из distance элементов между текущим и ahead.
+    Пока ahead не дошел до конца, кольцо заполнено целиком, потом
+    только убывает, и его хвост разбирается по порядку.
+    */
+    pointer window[detail::max_prefetch_distance];
+    auto ahead = list.begin();
+    auto last = list.end();
+
+    std::size_t filled = 0;
+    for (; filled != distance && ahead != last; ++filled, ++ahead)
+    {
+        window[filled] = &*ahead;
+        detail::prefetch_object(window[filled]);
+    }
+
+    for (std::size_t head = 0; filled != 0; head = head + 1 == distance ? 0 : head + 1)
+    {
+        pointer current = window[head];
+        if (ahead != last)
+        {
+            window[head] = &*ahead;
+            detail::prefetch_object(window[head]);
+            ++ahead;
+        }
+        else
+            --filled;
+        f(*current);
+    }
+}
+
+template <typename Iterator>
+std::size_t intrusive::gather(Iterator& first, Iterator last,
+    detail::element_pointer_t<Iterator>* out, std::size_t n) noexcept
+{
+    std::size_t count = 0;
+    for (; count != n && first != last; ++count, ++first)
+    {
+        out[count] = &*first;
+        detail::prefetch_object(out[count]);
+    }
+    return count;
+}
@@ -0,0 +1,183 @@
+#include "intrusive_rcu_list.h"
+#include <cassert>
+#include <thread>
+
+/*
+Почему этого достаточно. Писатель сначала отвязывает элемент, потом
+увеличивает эпоху и делает seq_cst fence, потом читает слоты. Читатель
+записывает эпоху в свой слот, делает seq_cst fence и только потом
+читает список. Из двух fence'ов какой-то идет первым: либо писатель
+увидит слот читателя и дождется его, либо читатель увидит список уже
+без элемента. Эпоху читатель читает acquire'ом, поэтому если он успел
+прочитать новую эпоху, отвязывание ему уже видно.
+*/
+INTRUSIVE_LIST_INLINE intrusive::rcu_reader::rcu_reader(rcu_domain& domain)
+    : domain(domain)
+    , depth(0)
+    , active_epoch(0)
+{
+    std::lock_guard<std::mutex> lock(domain.readers_mutex);
+    domain.readers.push_back(*this);
+}
+
+INTRUSIVE_LIST_INLINE intrusive::rcu_reader::~rcu_reader()
+{
+    assert(depth == 0 && "rcu_reader is destroyed inside a read-side section");
+    std::lock_guard<std::mutex> lock(domain.readers_mutex);
+    unlink();
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::rcu_reader::lock() noexcept
+{
+    if (depth++ != 0)
+        return;
+    active_epoch.store(domain.epoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::rcu_reader::unlock() noexcept
+{
+    assert(depth != 0);
+    if (--depth == 0)
+        active_epoch.store(0, std::memory_order_release);
+}
+
+INTRUSIVE_LIST_INLINE intrusive::rcu_domain::rcu_domain() noexcept
+    : epoch(1)
+{}
+
+INTRUSIVE_LIST_INLINE intrusive::rcu_domain::~rcu_domain()
+{
+    assert(readers.empty() && "rcu_domain is destroyed while readers are registered");
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::rcu_domain::synchronize() noexcept
+{
+    std::uint64_t target = epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    std::lock_guard<std::mutex> lock(readers_mutex);
+    for (rcu_reader& r : readers)
+    {
+        for (;;)
+        {
+            std::uint64_t e = r.active_epoch.load(std::memory_order_acquire);
+            if (e == 0 || e >= target)
+                break;
+            std::this_thread::yield();
+        }
+    }
+}
+
+INTRUSIVE_LIST_INLINE intrusive::rcu_read_guard::rcu_read_guard(rcu_reader& reader) noexcept
+    : reader(reader)
+{
+    reader.lock();
+}
+
+INTRUSIVE_LIST_INLINE intrusive::rcu_read_guard::~rcu_read_guard()
+{
+    reader.unlock();
+}
+
+INTRUSIVE_LIST_INLINE intrusive::detail::rcu_list_base::rcu_list_base(rcu_domain& domain) noexcept
+    : domain(domain)
+    , retired(nullptr)
+    , fake{&fake, {&fake}}
+{}
+
+INTRUSIVE_LIST_INLINE intrusive::detail::rcu_list_base::~rcu_list_base()
+{
+    rcu_list_element_base* p = fake.next.load(std::memory_order_relaxed);
+    while (p != &fake)
+    {
+        rcu_list_element_base* next = p->next.load(std::memory_order_relaxed);
+        p->prev = nullptr;
+        p->next.store(nullptr, std::memory_order_relaxed);
+        p = next;
+    }
+
+    while (retired != nullptr)
+    {
+        rcu_list_element_base* next = retired->prev;
+        retired->prev = nullptr;
+        retired->next.store(nullptr, std::memory_order_relaxed);
+        retired = next;
+    }
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::rcu_list_base::insert_locked(rcu_list_element_base& pos, rcu_list_element_base& obj) noexcept
+{
+    assert(obj.prev == nullptr && obj.next.load(std::memory_order_relaxed) == nullptr
+        && "element is already linked or not reclaimed yet");
+    obj.next.store(&pos, std::memory_order_relaxed);
+    obj.prev = pos.prev;
+    pos.prev->next.store(&obj, std::memory_order_release);
+    pos.prev = &obj;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::rcu_list_base::push_back(rcu_list_element_base& obj) noexcept
+{
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    insert_locked(fake, obj);
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::rcu_list_base::push_front(rcu_list_element_base& obj) noexcept
+{
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    insert_locked(*fake.next.load(std::memory_order_relaxed), obj);
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::rcu_list_base::erase(rcu_list_element_base& obj) noexcept
+{
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    rcu_list_element_base* next = obj.next.load(std::memory_order_relaxed);
+    assert(next != nullptr && obj.prev != nullptr);
+    obj.prev->next.store(next, std::memory_order_release);
+    next->prev = obj.prev;
+
+    /*
+    next у obj не трогаем: читатель, который стоит на obj, должен
+    дойти до конца списка.
+    */
+    obj.prev = retired;
+    retired = &obj;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::rcu_list_base::clear() noexcept
+{
+    std::lock_guard<std::mutex> lock(writer_mutex);
+    rcu_list_element_base* p = fake.next.load(std::memory_order_relaxed);
+    fake.next.store(&fake, std::memory_order_release);
+    fake.prev = &fake;
+
+    while (p != &fake)
+    {
+        rcu_list_element_base* next = p->next.load(std::memory_order_relaxed);
+        p->prev = retired;
+        retired = p;
+        p = next;
+    }
+}
+
+INTRUSIVE_LIST_INLINE intrusive::rcu_list_element_base* intrusive::detail::rcu_list_base::take_retired() noexcept
+{
+    rcu_list_element_base* chain;
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex);
+        chain = retired;
+        retired = nullptr;
+    }
+
+    if (chain == nullptr)
+        return nullptr;
+
+    /*
+    Все элементы цепочки были отвязаны до этого вызова, так что одного
+    grace period хватает на всю цепочку.
+    */
+    domain.synchronize();
+    for (rcu_list_element_base* p = chain; p != nullptr; p = p->prev)
+        p->next.store(nullptr, std::memory_order_relaxed);
+    return chain;
+}
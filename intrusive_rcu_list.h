@@ -0,0 +1,419 @@
+#pragma once
+#include "intrusive_list.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+/*
+Список для сценария "много читателей, редкие писатели". Читатели
+обходят его без локов: обход -- это только acquire-чтения next. За это
+писатели не могут переиспользовать выкинутый элемент сразу: читатель
+может как раз на нем стоять. Выкинутые элементы копятся в списке и
+отдаются пользователю через reclaim(), когда закончился grace period --
+все читатели, которые могли их видеть, вышли из своих секций.
+
+intrusive::rcu_domain domain;
+intrusive::rcu_list<subscriber> list(domain);
+
+// поток-читатель
+intrusive::rcu_reader reader(domain);
+{
+    intrusive::rcu_read_guard guard(reader);
+    for (subscriber& s : list)
+        s.notify();
+}
+
+// поток-писатель
+list.erase(s);
+list.reclaim([](subscriber* p) { delete p; });
+
+Grace period считается через эпохи. У каждого читателя есть слот в
+отдельной кеш-линии: при входе в секцию он записывает туда текущую
+эпоху и делает один fence, при выходе -- обнуляет. synchronize()
+увеличивает эпоху и ждет, пока не выйдут все, кто вошел раньше.
+
+Писатели сериализуются мьютексом внутри списка. Пока элемент лежит в
+списке или ждет reclaim, его нельзя удалять и вставлять снова, поэтому
+auto_unlink режима нет: ~rcu_list_element проверяет это assert'ом.
+*/
+namespace intrusive
+{
+    struct rcu_domain;
+
+    namespace detail
+    {
+        struct rcu_reader_tag;
+    }
+
+    /*
+    Регистрация потока-читателя в домене. Объект создается один раз на
+    поток и живет, пока поток читает.
+    */
+    struct rcu_reader : list_element<detail::rcu_reader_tag>
+    {
+        explicit rcu_reader(rcu_domain&);
+        ~rcu_reader();
+        rcu_reader(rcu_reader const&) = delete;
+        rcu_reader& operator=(rcu_reader const&) = delete;
+
+        void lock() noexcept;
+        void unlock() noexcept;
+
+    private:
+        rcu_domain& domain;
+        unsigned depth;
+        alignas(64) std::atomic<std::uint64_t> active_epoch;
+
+        friend struct rcu_domain;
+    };
+
+    struct rcu_domain
+    {
+        rcu_domain() noexcept;
+        ~rcu_domain();
+        rcu_domain(rcu_domain const&) = delete;
+        rcu_domain& operator=(rcu_domain const&) = delete;
+
+        /*
+        Ждет, пока все читатели, вошедшие в секцию до вызова, из нее
+        не выйдут. Нельзя звать изнутри читающей секции.
+        */
+        void synchronize() noexcept;
+
+    private:
+        /*
+        0 в слоте читателя значит "вне секции", поэтому эпохи
+        начинаются с 1.
+        */
+        alignas(64) std::atomic<std::uint64_t> epoch;
+        std::mutex readers_mutex;
+        list<rcu_reader, detail::rcu_reader_tag> readers;
+
+        friend struct rcu_reader;
+    };
+
+    /*
+    Читающая секция. Вложенные секции разрешены.
+    */
+    struct rcu_read_guard
+    {
+        explicit rcu_read_guard(rcu_reader&) noexcept;
+        ~rcu_read_guard();
+        rcu_read_guard(rcu_read_guard const&) = delete;
+        rcu_read_guard& operator=(rcu_read_guard const&) = delete;
+
+    private:
+        rcu_reader& reader;
+    };
+
+    /*
+    next пишется release-записью, читатели читают его acquire'ом. prev
+    читают только писатели. У выкинутого элемента next сохраняется,
+    чтобы стоящий на нем читатель мог идти дальше, а prev связывает
+    элементы, ждущие reclaim.
+    */
+    struct rcu_list_element_base
+    {
+        rcu_list_element_base* prev;
+        std::atomic<rcu_list_element_base*> next;
+    };
+
+    namespace detail
+    {
+        struct rcu_list_base
+        {
+            explicit rcu_list_base(rcu_domain&) noexcept;
+            ~rcu_list_base();
+            rcu_list_base(rcu_list_base const&) = delete;
+            rcu_list_base& operator=(rcu_list_base const&) = delete;
+
+            void push_back(rcu_list_element_base&) noexcept;
+            void push_front(rcu_list_element_base&) noexcept;
+            void erase(rcu_list_element_base&) noexcept;
+            void clear() noexcept;
+
+            /*
+            Дожидается grace period и забирает цепочку выкинутых
+            элементов (связанную через prev). Хуки уже обнулены, кроме
+            prev, который указывает на следующий элемент цепочки.
+            */
+            rcu_list_element_base* take_retired() noexcept;
+
+            void insert_locked(rcu_list_element_base& pos, rcu_list_element_base&) noexcept;
+
+            rcu_domain& domain;
+            std::mutex writer_mutex;
+            rcu_list_element_base* retired;
+            rcu_list_element_base fake;
+        };
+    }
+
+    template <typename Tag>
+    struct rcu_list_element;
+
+    namespace detail
+    {
+        template <typename Tag>
+        rcu_list_element<Tag>& find_rcu_hook(rcu_list_element<Tag>&) noexcept;
+
+        template <typename T, typename Tag>
+        using rcu_hook_t = std::remove_reference_t<decltype(find_rcu_hook<Tag>(std::declval<std::remove_const_t<T>&>()))>;
+
+        template <typename T, typename Tag, typename = void>
+        constexpr bool has_rcu_hook_v = false;
+
+        template <typename T, typename Tag>
+        constexpr bool has_rcu_hook_v<T, Tag, std::void_t<rcu_hook_t<T, Tag>>> = true;
+    }
+
+    template <typename Tag = default_tag>
+    struct rcu_list_element : private rcu_list_element_base
+    {
+        rcu_list_element() noexcept;
+        ~rcu_list_element() noexcept;
+        rcu_list_element(rcu_list_element const&) = delete;
+        rcu_list_element& operator=(rcu_list_element const&) = delete;
+
+        /*
+        true и пока элемент лежит в списке, и пока он ждет reclaim.
+        Звать можно только из потока писателя.
+        */
+        bool is_linked() const noexcept;
+
+        template <typename T, typename Tag1>
+        friend struct rcu_list;
+
+        template <typename T, typename Tag1>
+        friend struct rcu_list_iterator;
+
+        template <typename Tag1, typename T>
+        friend std::enable_if_t<detail::has_rcu_hook_v<T, Tag1>, rcu_list_element_base&> to_base(T&) noexcept;
+
+        template <typename T1, typename Tag1>
+        friend T1& from_base(rcu_list_element_base&) noexcept;
+    };
+
+    template <typename Tag, typename T>
+    std::enable_if_t<detail::has_rcu_hook_v<T, Tag>, rcu_list_element_base&> to_base(T&) noexcept;
+
+    template <typename T, typename Tag>
+    T& from_base(rcu_list_element_base&) noexcept;
+
+    /*
+    Однонаправленный итератор. Пользоваться им можно только внутри
+    читающей секции, в том числе из потока писателя: иначе элемент под
+    итератором может забрать reclaim() другого писателя.
+    */
+    template <typename T, typename Tag>
+    struct rcu_list_iterator
+    {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
+        rcu_list_iterator() = default;
+
+        T& operator*() const noexcept;
+        T* operator->() const noexcept;
+
+        rcu_list_iterator& operator++() & noexcept;
+        rcu_list_iterator operator++(int) & noexcept;
+
+        bool operator==(rcu_list_iterator const& rhs) const& noexcept;
+        bool operator!=(rcu_list_iterator const& rhs) const& noexcept;
+
+    private:
+        explicit rcu_list_iterator(rcu_list_element_base* current) noexcept;
+
+    private:
+        rcu_list_element_base* current;
+
+        template <typename T1, typename Tag1>
+        friend struct rcu_list;
+    };
+
+    template <typename T, typename Tag = default_tag>
+    struct rcu_list : private detail::rcu_list_base
+    {
+        static_assert(detail::has_rcu_hook_v<T, Tag>,
+            "value type is not convertible to rcu_list_element");
+
+        using iterator = rcu_list_iterator<T, Tag>;
+
+        explicit rcu_list(rcu_domain&) noexcept;
+
+        /*
+        В момент разрушения читателей быть не должно. Элементы, которые
+        еще лежат в списке или ждут reclaim, просто отвязываются.
+        */
+        ~rcu_list() = default;
+
+        /*
+        Операции писателя. Их можно звать из разных потоков, они
+        сериализуются мьютексом. Снаружи читающих секций.
+        */
+        void push_back(T&) noexcept;
+        void push_front(T&) noexcept;
+
+        /*
+        Элемент пропадает для новых читателей сразу, но переиспользовать
+        его можно только после reclaim().
+        */
+        void erase(T&) noexcept;
+        void clear() noexcept;
+
+        /*
+        Ждет grace period и отдает все выкинутые к этому моменту
+        элементы в disposer(T*). После этого их можно удалять или
+        вставлять снова. Выкидывать элементы пачкой, а reclaim звать
+        один раз, дешевле: grace period на всю пачку один.
+        */
+        template <typename Disposer>
+        void reclaim(Disposer disposer);
+
+        void reclaim();
+
+        iterator begin() const noexcept;
+        iterator end() const noexcept;
+    };
+}
+
+template <typename Tag>
+intrusive::rcu_list_element<Tag>::rcu_list_element() noexcept
+    : rcu_list_element_base{nullptr, {nullptr}}
+{}
+
+template <typename Tag>
+intrusive::rcu_list_element<Tag>::~rcu_list_element() noexcept
+{
+    assert(!is_linked() && "rcu_list_element is destroyed while linked or not reclaimed");
+}
+
+template <typename Tag>
+bool intrusive::rcu_list_element<Tag>::is_linked() const noexcept
+{
+    return next.load(std::memory_order_relaxed) != nullptr || prev != nullptr;
+}
+
+template <typename Tag, typename T>
+std::enable_if_t<intrusive::detail::has_rcu_hook_v<T, Tag>, intrusive::rcu_list_element_base&> intrusive::to_base(T& obj) noexcept
+{
+    return static_cast<detail::rcu_hook_t<T, Tag>&>(obj);
+}
+
+template <typename T, typename Tag>
+T& intrusive::from_base(rcu_list_element_base& base) noexcept
+{
+    return static_cast<T&>(static_cast<detail::rcu_hook_t<T, Tag>&>(base));
+}
+
+template <typename T, typename Tag>
+T& intrusive::rcu_list_iterator<T, Tag>::operator*() const noexcept
+{
+    return from_base<T, Tag>(*current);
+}
+
+template <typename T, typename Tag>
+T* intrusive::rcu_list_iterator<T, Tag>::operator->() const noexcept
+{
+    return &from_base<T, Tag>(*current);
+}
+
+template <typename T, typename Tag>
+intrusive::rcu_list_iterator<T, Tag>& intrusive::rcu_list_iterator<T, Tag>::operator++() & noexcept
+{
+    current = current->next.load(std::memory_order_acquire);
+    return *this;
+}
+
+template <typename T, typename Tag>
+intrusive::rcu_list_iterator<T, Tag> intrusive::rcu_list_iterator<T, Tag>::operator++(int) & noexcept
+{
+    rcu_list_iterator copy = *this;
+    ++*this;
+    return copy;
+}
+
+template <typename T, typename Tag>
+bool intrusive::rcu_list_iterator<T, Tag>::operator==(rcu_list_iterator const& rhs) const& noexcept
+{
+    return current == rhs.current;
+}
+
+template <typename T, typename Tag>
+bool intrusive::rcu_list_iterator<T, Tag>::operator!=(rcu_list_iterator const& rhs) const& noexcept
+{
+    return current != rhs.current;
+}
+
+template <typename T, typename Tag>
+intrusive::rcu_list_iterator<T, Tag>::rcu_list_iterator(rcu_list_element_base* current) noexcept
+    : current(current)
+{}
+
+template <typename T, typename Tag>
+intrusive::rcu_list<T, Tag>::rcu_list(rcu_domain& domain) noexcept
+    : detail::rcu_list_base(domain)
+{}
+
+template <typename T, typename Tag>
+void intrusive::rcu_list<T, Tag>::push_back(T& obj) noexcept
+{
+    detail::rcu_list_base::push_back(to_base<Tag>(obj));
+}
+
+template <typename T, typename Tag>
+void intrusive::rcu_list<T, Tag>::push_front(T& obj) noexcept
+{
+    detail::rcu_list_base::push_front(to_base<Tag>(obj));
+}
+
+template <typename T, typename Tag>
+void intrusive::rcu_list<T, Tag>::erase(T& obj) noexcept
+{
+    detail::rcu_list_base::erase(to_base<Tag>(obj));
+}
+
+template <typename T, typename Tag>
+void intrusive::rcu_list<T, Tag>::clear() noexcept
+{
+    detail::rcu_list_base::clear();
+}
+
+template <typename T, typename Tag>
+template <typename Disposer>
+void intrusive::rcu_list<T, Tag>::reclaim(Disposer disposer)
+{
+    rcu_list_element_base* p = take_retired();
+    while (p != nullptr)
+    {
+        rcu_list_element_base* next = p->prev;
+        p->prev = nullptr;
+        disposer(&from_base<T, Tag>(*p));
+        p = next;
+    }
+}
+
+template <typename T, typename Tag>
+void intrusive::rcu_list<T, Tag>::reclaim()
+{
+    reclaim([](T*) {});
+}
+
+template <typename T, typename Tag>
+typename intrusive::rcu_list<T, Tag>::iterator intrusive::rcu_list<T, Tag>::begin() const noexcept
+{
+    return iterator(fake.next.load(std::memory_order_acquire));
+}
+
+template <typename T, typename Tag>
+typename intrusive::rcu_list<T, Tag>::iterator intrusive::rcu_list<T, Tag>::end() const noexcept
+{
+    return iterator(const_cast<rcu_list_element_base*>(&fake));
+}
+
+#ifdef INTRUSIVE_LIST_HEADER_ONLY
+#include "intrusive_rcu_list.cpp"
+#endif
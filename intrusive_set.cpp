@@ -0,0 +1,439 @@
+#include "intrusive_set.h"
+#include <cassert>
+#include <utility>
+
+/*
+Балансировка -- классические алгоритмы красно-черного дерева с
+головой, как _Rb_tree_insert_and_rebalance и
+_Rb_tree_rebalance_for_erase из libstdc++. root -- это ссылка на
+header.parent, поэтому повороты у корня обновляют и голову.
+*/
+namespace
+{
+    using node = intrusive::set_element_base;
+
+    bool is_red(node const* x) noexcept
+    {
+        return x != nullptr && x->red;
+    }
+
+    node* minimum(node* x) noexcept
+    {
+        while (x->left != nullptr)
+            x = x->left;
+        return x;
+    }
+
+    node* maximum(node* x) noexcept
+    {
+        while (x->right != nullptr)
+            x = x->right;
+        return x;
+    }
+
+    void rotate_left(node* x, node*& root) noexcept
+    {
+        node* y = x->right;
+        x->right = y->left;
+        if (y->left != nullptr)
+            y->left->parent = x;
+        y->parent = x->parent;
+
+        if (x == root)
+            root = y;
+        else if (x == x->parent->left)
+            x->parent->left = y;
+        else
+            x->parent->right = y;
+        y->left = x;
+        x->parent = y;
+    }
+
+    void rotate_right(node* x, node*& root) noexcept
+    {
+        node* y = x->left;
+        x->left = y->right;
+        if (y->right != nullptr)
+            y->right->parent = x;
+        y->parent = x->parent;
+
+        if (x == root)
+            root = y;
+        else if (x == x->parent->right)
+            x->parent->right = y;
+        else
+            x->parent->left = y;
+        y->right = x;
+        x->parent = y;
+    }
+
+    void insert_and_rebalance(bool insert_left, node* x, node* p, node& header) noexcept
+    {
+        node*& root = header.parent;
+
+        x->parent = p;
+        x->left = nullptr;
+        x->right = nullptr;
+        x->red = true;
+
+        if (insert_left)
+        {
+            /*
+            Если p -- голова, это первый элемент, и header.left
+            присваивается тут же.
+            */
+            p->left = x;
+            if (p == &header)
+            {
+                header.parent = x;
+                header.right = x;
+            }
+            else if (p == header.left)
+            {
+                header.left = x;
+            }
+        }
+        else
+        {
+            p->right = x;
+            if (p == header.right)
+                header.right = x;
+        }
+
+        while (x != root && x->parent->red)
+        {
+            node* const xpp = x->parent->parent;
+            if (x->parent == xpp->left)
+            {
+                node* const y = xpp->right;
+                if (is_red(y))
+                {
+                    x->parent->red = false;
+                    y->red = false;
+                    xpp->red = true;
+                    x = xpp;
+                }
+                else
+                {
+                    if (x == x->parent->right)
+                    {
+                        x = x->parent;
+                        rotate_left(x, root);
+                    }
+                    x->parent->red = false;
+                    xpp->red = true;
+                    rotate_right(xpp, root);
+                }
+            }
+            else
+            {
+                node* const y = xpp->left;
+                if (is_red(y))
+                {
+                    x->parent->red = false;
+                    y->red = false;
+                    xpp->red = true;
+                    x = xpp;
+                }
+                else
+                {
+                    if (x == x->parent->left)
+                    {
+                        x = x->parent;
+                        rotate_right(x, root);
+                    }
+                    x->parent->red = false;
+                    xpp->red = true;
+                    rotate_left(xpp, root);
+                }
+            }
+        }
+        root->red = false;
+    }
+
+    void erase_and_rebalance(node* const z, node& header) noexcept
+    {
+        node*& root = header.parent;
+        node*& leftmost = header.left;
+        node*& rightmost = header.right;
+
+        node* y = z;
+        node* x = nullptr;
+        node* x_parent = nullptr;
+
+        if (y->left == nullptr)
+            x = y->right;
+        else if (y->right == nullptr)
+            x = y->left;
+        else
+        {
+            y = minimum(y->right);
+            x = y->right;
+        }
+
+        if (y != z)
+        {
+            /*
+            У z два ребенка: на его место встает y, следующий за ним
+            элемент, а y лишается своей позиции и правого ребенка x.
+            */
+            z->left->parent = y;
+            y->left = z->left;
+            if (y != z->right)
+            {
+                x_parent = y->parent;
+                if (x != nullptr)
+                    x->parent = y->parent;
+                y->parent->left = x;
+                y->right = z->right;
+                z->right->parent = y;
+            }
+            else
+            {
+                x_parent = y;
+            }
+
+            if (root == z)
+                root = y;
+            else if (z->parent->left == z)
+                z->parent->left = y;
+            else
+                z->parent->right = y;
+            y->parent = z->parent;
+            std::swap(y->red, z->red);
+            y = z;
+        }
+        else
+        {
+            x_parent = y->parent;
+            if (x != nullptr)
+                x->parent = y->parent;
+
+            if (root == z)
+                root = x;
+            else if (z->parent->left == z)
+                z->parent->left = x;
+            else
+                z->parent->right = x;
+
+            if (leftmost == z)
+                leftmost = z->right == nullptr ? z->parent : minimum(x);
+            if (rightmost == z)
+                rightmost = z->left == nullptr ? z->parent : maximum(x);
+        }
+
+        if (y->red)
+            return;
+
+        while (x != root && !is_red(x))
+        {
+            if (x == x_parent->left)
+            {
+                node* w = x_parent->right;
+                if (w->red)
+                {
+                    w->red = false;
+                    x_parent->red = true;
+                    rotate_left(x_parent, root);
+                    w = x_parent->right;
+                }
+
+                if (!is_red(w->left) && !is_red(w->right))
+                {
+                    w->red = true;
+                    x = x_parent;
+                    x_parent = x_parent->parent;
+                }
+                else
+                {
+                    if (!is_red(w->right))
+                    {
+                        w->left->red = false;
+                        w->red = true;
+                        rotate_right(w, root);
+                        w = x_parent->right;
+                    }
+                    w->red = x_parent->red;
+                    x_parent->red = false;
+                    if (w->right != nullptr)
+                        w->right->red = false;
+                    rotate_left(x_parent, root);
+                    break;
+                }
+            }
+            else
+            {
+                node* w = x_parent->left;
+                if (w->red)
+                {
+                    w->red = false;
+                    x_parent->red = true;
+                    rotate_right(x_parent, root);
+                    w = x_parent->left;
+                }
+
+                if (!is_red(w->right) && !is_red(w->left))
+                {
+                    w->red = true;
+                    x = x_parent;
+                    x_parent = x_parent->parent;
+                }
+                else
+                {
+                    if (!is_red(w->left))
+                    {
+                        w->right->red = false;
+                        w->red = true;
+                        rotate_left(w, root);
+                        w = x_parent->left;
+                    }
+                    w->red = x_parent->red;
+                    x_parent->red = false;
+                    if (w->left != nullptr)
+                        w->left->red = false;
+                    rotate_right(x_parent, root);
+                    break;
+                }
+            }
+        }
+        if (x != nullptr)
+            x->red = false;
+    }
+}
+
+INTRUSIVE_LIST_INLINE intrusive::set_element_base* intrusive::set_element_base::next(set_element_base* x) noexcept
+{
+    if (x->right != nullptr)
+        return minimum(x->right);
+
+    set_element_base* y = x->parent;
+    while (x == y->right)
+    {
+        x = y;
+        y = y->parent;
+    }
+
+    /*
+    От максимального элемента подъем заканчивается на x == голова,
+    y == корень. Если у корня нет правого поддерева, header.right ==
+    корень, и результат -- сама голова, а не корень.
+    */
+    if (x->right != y)
+        x = y;
+    return x;
+}
+
+INTRUSIVE_LIST_INLINE intrusive::set_element_base* intrusive::set_element_base::prev(set_element_base* x) noexcept
+{
+    if (x->is_header())
+        return x->right;
+    if (x->left != nullptr)
+        return maximum(x->left);
+
+    set_element_base* y = x->parent;
+    while (x == y->left)
+    {
+        x = y;
+        y = y->parent;
+    }
+    return y;
+}
+
+/*
+Голова -- единственный красный узел, у которого дед -- он сам.
+Подъем к ней от элемента -- O(log n).
+*/
+INTRUSIVE_LIST_INLINE void intrusive::set_element_base::unlink() noexcept
+{
+    assert(parent != nullptr && "element is not linked");
+    set_element_base* header = parent;
+    while (!header->is_header())
+        header = header->parent;
+
+    erase_and_rebalance(this, *header);
+    parent = nullptr;
+    left = nullptr;
+    right = nullptr;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::set_element_base::try_unlink() noexcept
+{
+    if (parent != nullptr)
+        unlink();
+}
+
+INTRUSIVE_LIST_INLINE intrusive::detail::rbtree_base::rbtree_base() noexcept
+    : header{nullptr, &header, &header, true}
+{}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::rbtree_base::insert_at(set_element_base* parent, bool insert_left, set_element_base& obj) noexcept
+{
+    insert_and_rebalance(insert_left, &obj, parent, header);
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::rbtree_base::erase(set_element_base& obj) noexcept
+{
+    assert(obj.parent != nullptr && "element is not linked");
+    erase_and_rebalance(&obj, header);
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::rbtree_base::reset_all() noexcept
+{
+    set_element_base* p = header.parent;
+    forget();
+    while (p != nullptr)
+    {
+        if (p->left != nullptr)
+        {
+            p = p->left;
+            continue;
+        }
+        if (p->right != nullptr)
+        {
+            p = p->right;
+            continue;
+        }
+
+        set_element_base* up = p->parent;
+        if (up == &header)
+            up = nullptr;
+        else if (up->left == p)
+            up->left = nullptr;
+        else
+            up->right = nullptr;
+
+        p->parent = nullptr;
+        p = up;
+    }
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::rbtree_base::forget() noexcept
+{
+    header.parent = nullptr;
+    header.left = &header;
+    header.right = &header;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::rbtree_base::swap(rbtree_base& other) noexcept
+{
+    std::swap(header.parent, other.header.parent);
+    std::swap(header.left, other.header.left);
+    std::swap(header.right, other.header.right);
+
+    /*
+    У пустого дерева left и right указывают на его же голову, у
+    непустого корень ссылается на голову.
+    */
+    for (rbtree_base* t : {this, &other})
+    {
+        if (t->header.parent == nullptr)
+        {
+            t->header.left = &t->header;
+            t->header.right = &t->header;
+        }
+        else
+        {
+            t->header.parent->parent = &t->header;
+        }
+    }
+}
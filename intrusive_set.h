@@ -0,0 +1,962 @@
+#pragma once
+#include "intrusive_list.h"
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+/*
+Упорядоченные интрузивные контейнеры на красно-черном дереве: set
+(ключи уникальны) и multiset.
+
+struct timer : intrusive::set_element<>
+{
+    std::uint64_t deadline;
+    friend bool operator<(timer const& a, timer const& b) { return a.deadline < b.deadline; }
+};
+
+intrusive::multiset<timer> timers;
+timers.insert(t);
+timer& next = *timers.begin();
+
+Устроено так же, как list: хук set_element<Tag> приватно наследуется
+от нешаблонной set_element_base, и все алгоритмы дерева (вставка с
+балансировкой, удаление, шаг итератора) написаны для нее один раз в
+intrusive_set.cpp, независимо от T и Tag. Шаблон только сравнивает
+элементы при спуске по дереву и переводит базы в T через
+to_base/from_base.
+
+Дерево с головой, как в libstdc++: header.parent -- корень,
+header.left и header.right -- минимальный и максимальный элементы,
+end() -- сам header. Поэтому begin() и --end() -- O(1), а обход всего
+дерева -- O(n), то есть O(1) на шаг в среднем.
+
+Сложность:
+- insert, erase, find, lower_bound, upper_bound -- O(log n);
+- insert_hint(pos, x) -- O(1) амортизированно, если x встает прямо
+  перед pos (для почти отсортированного ввода -- insert_hint(end(), x)),
+  иначе как insert;
+- unlink() auto_unlink элемента -- O(log n): элемент не знает своего
+  дерева, и голову приходится искать, поднимаясь к корню;
+- size() -- O(n), как у slim_list: с auto_unlink счетчик не
+  поддержать;
+- clear() -- O(n), кроме normal_link.
+
+Хук занимает 32 байта: parent, left, right и цвет.
+*/
+namespace intrusive
+{
+    struct set_element_base
+    {
+        set_element_base* parent;
+        set_element_base* left;
+        set_element_base* right;
+        bool red;
+
+        /*
+        Следующий и предыдущий в порядке обхода. От header (end())
+        назад -- максимальный элемент.
+        */
+        static set_element_base* next(set_element_base*) noexcept;
+        static set_element_base* prev(set_element_base*) noexcept;
+
+        bool is_header() const noexcept
+        {
+            return red && parent != nullptr && parent->parent == this;
+        }
+
+        /*
+        Выкидывает элемент из дерева, в котором он лежит.
+        */
+        void unlink() noexcept;
+        void try_unlink() noexcept;
+    };
+
+    namespace detail
+    {
+        /*
+        Голова дерева и операции, которым нужен только порядок, уже
+        найденный шаблоном.
+        */
+        struct rbtree_base
+        {
+            rbtree_base() noexcept;
+            rbtree_base(rbtree_base const&) = delete;
+            rbtree_base& operator=(rbtree_base const&) = delete;
+
+            /*
+            Вставляет obj левым (insert_left) или правым ребенком
+            parent, у которого этого ребенка нет, и балансирует дерево.
+            parent может быть header, если дерево пусто.
+            */
+            void insert_at(set_element_base* parent, bool insert_left, set_element_base& obj) noexcept;
+
+            /*
+            Вынимает obj из дерева и балансирует его. Поля самого obj
+            не трогает.
+            */
+            void erase(set_element_base& obj) noexcept;
+
+            /*
+            Обнуляет все элементы (в порядке обхода снизу вверх) и
+            делает дерево пустым.
+            */
+            void reset_all() noexcept;
+
+            /*
+            Дерево становится пустым, элементы не трогаются.
+            */
+            void forget() noexcept;
+
+            void swap(rbtree_base& other) noexcept;
+
+            set_element_base* root() const noexcept
+            {
+                return header.parent;
+            }
+
+            set_element_base header;
+        };
+    }
+
+    template <typename Tag = default_tag, typename... Options>
+    struct set_element;
+
+    namespace detail
+    {
+        template <typename Tag, typename... Options>
+        set_element<Tag, Options...>& find_set_hook(set_element<Tag, Options...>&) noexcept;
+
+        template <typename T, typename Tag>
+        using set_hook_t = std::remove_reference_t<decltype(find_set_hook<Tag>(std::declval<std::remove_const_t<T>&>()))>;
+
+        template <typename T, typename Tag, typename = void>
+        constexpr bool has_set_hook_v = false;
+
+        template <typename T, typename Tag>
+        constexpr bool has_set_hook_v<T, Tag, std::void_t<set_hook_t<T, Tag>>> = true;
+
+        template <typename Compare, typename = void>
+        constexpr bool is_transparent_v = false;
+
+        template <typename Compare>
+        constexpr bool is_transparent_v<Compare, std::void_t<typename Compare::is_transparent>> = true;
+    }
+
+    template <typename Tag, typename... Options>
+    struct set_element : private set_element_base
+    {
+        using link_mode = detail::find_option_t<detail::link_mode_kind, auto_unlink, Options...>;
+
+        set_element() noexcept;
+        ~set_element() noexcept;
+        set_element(set_element const&) = delete;
+        set_element& operator=(set_element const&) = delete;
+
+        /*
+        Как у list_element, только для auto_unlink. O(log n).
+        */
+        void unlink() noexcept;
+
+        bool is_linked() const noexcept;
+
+        template <typename T, typename Tag1, typename Compare, bool Multi>
+        friend struct basic_set;
+
+        template <typename Tag1, typename T>
+        friend std::enable_if_t<detail::has_set_hook_v<T, Tag1>, set_element_base&> to_base(T&) noexcept;
+
+        template <typename Tag1, typename T>
+        friend std::enable_if_t<detail::has_set_hook_v<T, Tag1>, set_element_base const&> to_base(T const&) noexcept;
+
+        template <typename T1, typename Tag1>
+        friend T1& from_base(set_element_base&) noexcept;
+
+        template <typename T1, typename Tag1>
+        friend T1 const& from_base(set_element_base const&) noexcept;
+    };
+
+    template <typename Tag, typename T>
+    std::enable_if_t<detail::has_set_hook_v<T, Tag>, set_element_base&> to_base(T&) noexcept;
+
+    template <typename Tag, typename T>
+    std::enable_if_t<detail::has_set_hook_v<T, Tag>, set_element_base const&> to_base(T const&) noexcept;
+
+    template <typename T, typename Tag>
+    T& from_base(set_element_base&) noexcept;
+
+    template <typename T, typename Tag>
+    T const& from_base(set_element_base const&) noexcept;
+
+    template <typename T, typename Tag>
+    struct set_iterator
+    {
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = std::remove_const_t<T>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = value_type*;
+        using reference = value_type&;
+
+        set_iterator() = default;
+        template <typename NonConstIterator>
+        set_iterator(NonConstIterator other,
+            std::enable_if_t<
+                std::is_same_v<NonConstIterator, set_iterator<std::remove_const_t<T>, Tag>> &&
+                std::is_const_v<T>>* = nullptr) noexcept
+            : current(other.current)
+        {}
+
+        T& operator*() const noexcept;
+        T* operator->() const noexcept;
+
+        set_iterator& operator++() & noexcept;
+        set_iterator& operator--() & noexcept;
+
+        set_iterator operator++(int) & noexcept;
+        set_iterator operator--(int) & noexcept;
+
+        bool operator==(set_iterator const& rhs) const& noexcept;
+        bool operator!=(set_iterator const& rhs) const& noexcept;
+
+    private:
+        explicit set_iterator(set_element_base* current) noexcept;
+
+    private:
+        set_element_base* current;
+
+        template <typename T1, typename Tag1>
+        friend struct set_iterator;
+
+        template <typename T1, typename Tag1, typename Compare, bool Multi>
+        friend struct basic_set;
+    };
+
+    /*
+    Общая реализация set и multiset. Compare сравнивает T const&; если
+    у него есть is_transparent, find, lower_bound и т. п. принимают и
+    ключи других типов.
+    */
+    template <typename T, typename Tag, typename Compare, bool Multi>
+    struct basic_set : private detail::rbtree_base
+    {
+        using iterator = set_iterator<T, Tag>;
+        using const_iterator = set_iterator<T const, Tag>;
+        using size_type = std::size_t;
+        using value_compare = Compare;
+
+        static_assert(detail::has_set_hook_v<T, Tag>,
+            "value type is not convertible to set_element");
+
+        using link_mode = typename detail::set_hook_t<T, Tag>::link_mode;
+
+        /*
+        set: пара из итератора на элемент с таким ключом и признака,
+        вставлен ли x. multiset: итератор на x.
+        */
+        using insert_return_type = std::conditional_t<Multi, iterator, std::pair<iterator, bool>>;
+
+        basic_set() noexcept(std::is_nothrow_default_constructible_v<Compare>) = default;
+        explicit basic_set(Compare comp) noexcept(std::is_nothrow_move_constructible_v<Compare>);
+        basic_set(basic_set const&) = delete;
+        basic_set(basic_set&&) noexcept;
+        ~basic_set();
+
+        basic_set& operator=(basic_set const&) = delete;
+        basic_set& operator=(basic_set&&) noexcept;
+
+        /*
+        Компаратор может бросать исключения: дерево меняется только
+        после того, как место для вставки найдено, и если сравнение
+        бросило, дерево остается прежним.
+        */
+        insert_return_type insert(T&);
+
+        /*
+        Вставка как можно ближе перед pos. Если pos -- правильное
+        место, это O(1) амортизированно. У set, если элемент с таким
+        ключом уже есть, возвращает итератор на него.
+        */
+        iterator insert_hint(const_iterator pos, T&);
+
+        iterator erase(const_iterator pos) noexcept;
+        void erase(T&) noexcept;
+
+        /*
+        Выкидывает все элементы с ключом key, возвращает их количество.
+        */
+        template <typename Key>
+        size_type erase_key(Key const& key);
+
+        template <typename Disposer>
+        iterator erase_and_dispose(const_iterator pos, Disposer disposer);
+
+        template <typename Disposer>
+        void clear_and_dispose(Disposer disposer);
+
+        void clear() noexcept;
+        void swap(basic_set& other) noexcept;
+
+        template <typename Key>
+        iterator find(Key const& key);
+        template <typename Key>
+        const_iterator find(Key const& key) const;
+
+        template <typename Key>
+        iterator lower_bound(Key const& key);
+        template <typename Key>
+        const_iterator lower_bound(Key const& key) const;
+
+        template <typename Key>
+        iterator upper_bound(Key const& key);
+        template <typename Key>
+        const_iterator upper_bound(Key const& key) const;
+
+        template <typename Key>
+        std::pair<iterator, iterator> equal_range(Key const& key);
+
+        template <typename Key>
+        size_type count(Key const& key) const;
+
+        template <typename Key>
+        bool contains(Key const& key) const;
+
+        iterator begin() noexcept;
+        const_iterator begin() const noexcept;
+        iterator end() noexcept;
+        const_iterator end() const noexcept;
+
+        T& front() noexcept;
+        T& back() noexcept;
+
+        bool empty() const noexcept;
+
+        /*
+        O(n).
+        */
+        size_type size() const noexcept;
+
+        static iterator iterator_to(T&) noexcept;
+        static const_iterator iterator_to(T const&) noexcept;
+
+        value_compare value_comp() const
+        {
+            return comp;
+        }
+
+    private:
+        template <typename Key>
+        static constexpr bool is_key_v = std::is_same_v<std::remove_cv_t<Key>, T> || detail::is_transparent_v<Compare>;
+
+        T const& value(set_element_base const* p) const noexcept
+        {
+            return from_base<T, Tag>(*p);
+        }
+
+        template <typename Key>
+        set_element_base* lower_bound_node(Key const& key) const;
+
+        template <typename Key>
+        set_element_base* upper_bound_node(Key const& key) const;
+
+        void insert_equal(set_element_base& obj);
+        iterator insert_before(set_element_base* pos, set_element_base& obj) noexcept;
+        void unlink_node(set_element_base& obj) noexcept;
+
+        set_element_base* header_ptr() const noexcept
+        {
+            return const_cast<set_element_base*>(&header);
+        }
+
+        Compare comp{};
+    };
+
+    template <typename T, typename Tag = default_tag, typename Compare = std::less<T>>
+    using set = basic_set<T, Tag, Compare, false>;
+
+    template <typename T, typename Tag = default_tag, typename Compare = std::less<T>>
+    using multiset = basic_set<T, Tag, Compare, true>;
+}
+
+template <typename Tag, typename... Options>
+intrusive::set_element<Tag, Options...>::set_element() noexcept
+    : set_element_base{nullptr, nullptr, nullptr, false}
+{}
+
+template <typename Tag, typename... Options>
+intrusive::set_element<Tag, Options...>::~set_element() noexcept
+{
+    if constexpr (std::is_same_v<link_mode, auto_unlink>)
+        this->try_unlink();
+    else if constexpr (std::is_same_v<link_mode, safe_link>)
+        assert(this->parent == nullptr && "safe_link element is destroyed while linked");
+}
+
+template <typename Tag, typename... Options>
+void intrusive::set_element<Tag, Options...>::unlink() noexcept
+{
+    static_assert(std::is_same_v<link_mode, auto_unlink>,
+        "unlink() is available only for auto_unlink elements, use set::erase()");
+    set_element_base::unlink();
+}
+
+template <typename Tag, typename... Options>
+bool intrusive::set_element<Tag, Options...>::is_linked() const noexcept
+{
+    static_assert(!std::is_same_v<link_mode, normal_link>,
+        "is_linked() is not available for normal_link elements");
+    return this->parent != nullptr;
+}
+
+template <typename Tag, typename T>
+std::enable_if_t<intrusive::detail::has_set_hook_v<T, Tag>, intrusive::set_element_base&> intrusive::to_base(T& obj) noexcept
+{
+    return static_cast<detail::set_hook_t<T, Tag>&>(obj);
+}
+
+template <typename Tag, typename T>
+std::enable_if_t<intrusive::detail::has_set_hook_v<T, Tag>, intrusive::set_element_base const&> intrusive::to_base(T const& obj) noexcept
+{
+    return static_cast<detail::set_hook_t<T, Tag> const&>(obj);
+}
+
+template <typename T, typename Tag>
+T& intrusive::from_base(set_element_base& base) noexcept
+{
+    return static_cast<T&>(static_cast<detail::set_hook_t<T, Tag>&>(base));
+}
+
+template <typename T, typename Tag>
+T const& intrusive::from_base(set_element_base const& base) noexcept
+{
+    return static_cast<T const&>(static_cast<detail::set_hook_t<T, Tag> const&>(base));
+}
+
+template <typename T, typename Tag>
+T& intrusive::set_iterator<T, Tag>::operator*() const noexcept
+{
+    return from_base<std::remove_const_t<T>, Tag>(*current);
+}
+
+template <typename T, typename Tag>
+T* intrusive::set_iterator<T, Tag>::operator->() const noexcept
+{
+    return &from_base<std::remove_const_t<T>, Tag>(*current);
+}
+
+template <typename T, typename Tag>
+intrusive::set_iterator<T, Tag>& intrusive::set_iterator<T, Tag>::operator++() & noexcept
+{
+    current = set_element_base::next(current);
+    return *this;
+}
+
+template <typename T, typename Tag>
+intrusive::set_iterator<T, Tag>& intrusive::set_iterator<T, Tag>::operator--() & noexcept
+{
+    current = set_element_base::prev(current);
+    return *this;
+}
+
+template <typename T, typename Tag>
+intrusive::set_iterator<T, Tag> intrusive::set_iterator<T, Tag>::operator++(int) & noexcept
+{
+    set_iterator copy = *this;
+    ++*this;
+    return copy;
+}
+
+template <typename T, typename Tag>
+intrusive::set_iterator<T, Tag> intrusive::set_iterator<T, Tag>::operator--(int) & noexcept
+{
+    set_iterator copy = *this;
+    --*this;
+    return copy;
+}
+
+template <typename T, typename Tag>
+bool intrusive::set_iterator<T, Tag>::operator==(set_iterator const& rhs) const& noexcept
+{
+    return current == rhs.current;
+}
+
+template <typename T, typename Tag>
+bool intrusive::set_iterator<T, Tag>::operator!=(set_iterator const& rhs) const& noexcept
+{
+    return current != rhs.current;
+}
+
+template <typename T, typename Tag>
+intrusive::set_iterator<T, Tag>::set_iterator(set_element_base* current) noexcept
+    : current(current)
+{}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+intrusive::basic_set<T, Tag, Compare, Multi>::basic_set(Compare comp) noexcept(std::is_nothrow_move_constructible_v<Compare>)
+    : comp(std::move(comp))
+{}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+intrusive::basic_set<T, Tag, Compare, Multi>::basic_set(basic_set&& other) noexcept
+    : comp(other.comp)
+{
+    swap(other);
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+intrusive::basic_set<T, Tag, Compare, Multi>::~basic_set()
+{
+    clear();
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+intrusive::basic_set<T, Tag, Compare, Multi>& intrusive::basic_set<T, Tag, Compare, Multi>::operator=(basic_set&& other) noexcept
+{
+    if (&other != this)
+    {
+        clear();
+        swap(other);
+    }
+    return *this;
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+typename intrusive::basic_set<T, Tag, Compare, Multi>::insert_return_type intrusive::basic_set<T, Tag, Compare, Multi>::insert(T& obj)
+{
+    set_element_base& base = to_base<Tag>(obj);
+    if constexpr (!std::is_same_v<link_mode, normal_link>)
+        assert(base.parent == nullptr && "element is already linked");
+
+    if constexpr (Multi)
+    {
+        insert_equal(base);
+        return iterator(&base);
+    }
+    else
+    {
+        /*
+        Спуск как в libstdc++: запоминаем, куда свернули в последний
+        раз. Равный элемент, если он есть, -- это предшественник места
+        вставки.
+        */
+        set_element_base* parent = &header;
+        set_element_base* x = root();
+        bool less = true;
+        while (x != nullptr)
+        {
+            parent = x;
+            less = comp(obj, value(x));
+            x = less ? x->left : x->right;
+        }
+
+        set_element_base* before = parent;
+        if (less)
+        {
+            if (before == header.left)
+            {
+                insert_at(parent, true, base);
+                return {iterator(&base), true};
+            }
+            before = set_element_base::prev(before);
+        }
+
+        if (comp(value(before), obj))
+        {
+            insert_at(parent, less, base);
+            return {iterator(&base), true};
+        }
+        return {iterator(before), false};
+    }
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+typename intrusive::basic_set<T, Tag, Compare, Multi>::iterator intrusive::basic_set<T, Tag, Compare, Multi>::insert_hint(const_iterator pos, T& obj)
+{
+    set_element_base& base = to_base<Tag>(obj);
+    if constexpr (!std::is_same_v<link_mode, normal_link>)
+        assert(base.parent == nullptr && "element is already linked");
+
+    set_element_base* p = pos.current;
+
+    /*
+    obj встает перед p, если prev(p) <= obj <= p (для set -- строго).
+    Тогда место -- правый ребенок prev(p) или левый ребенок p: одно
+    из них всегда свободно.
+    */
+    bool fits_before_p;
+    if constexpr (Multi)
+        fits_before_p = p == &header || !comp(value(p), obj);
+    else
+        fits_before_p = p == &header || comp(obj, value(p));
+
+    if (fits_before_p)
+    {
+        if (p == header.left)
+            return insert_before(p, base);
+
+        set_element_base* before = set_element_base::prev(p);
+        bool fits_after_before;
+        if constexpr (Multi)
+            fits_after_before = !comp(obj, value(before));
+        else
+            fits_after_before = comp(value(before), obj);
+
+        if (fits_after_before)
+            return insert_before(p, base);
+    }
+
+    if constexpr (Multi)
+    {
+        insert_equal(base);
+        return iterator(&base);
+    }
+    else
+    {
+        return insert(obj).first;
+    }
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+typename intrusive::basic_set<T, Tag, Compare, Multi>::iterator intrusive::basic_set<T, Tag, Compare, Multi>::erase(const_iterator pos) noexcept
+{
+    assert(pos.current != &header);
+    set_element_base* next = set_element_base::next(pos.current);
+    unlink_node(*pos.current);
+    return iterator(next);
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+void intrusive::basic_set<T, Tag, Compare, Multi>::erase(T& obj) noexcept
+{
+    unlink_node(to_base<Tag>(obj));
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+template <typename Key>
+typename intrusive::basic_set<T, Tag, Compare, Multi>::size_type intrusive::basic_set<T, Tag, Compare, Multi>::erase_key(Key const& key)
+{
+    static_assert(is_key_v<Key>, "heterogeneous lookup requires Compare::is_transparent");
+    set_element_base* p = lower_bound_node(key);
+    set_element_base* last = upper_bound_node(key);
+    size_type n = 0;
+    while (p != last)
+    {
+        set_element_base* next = set_element_base::next(p);
+        unlink_node(*p);
+        p = next;
+        ++n;
+    }
+    return n;
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+template <typename Disposer>
+typename intrusive::basic_set<T, Tag, Compare, Multi>::iterator intrusive::basic_set<T, Tag, Compare, Multi>::erase_and_dispose(const_iterator pos, Disposer disposer)
+{
+    set_element_base* p = pos.current;
+    iterator next = erase(pos);
+    disposer(&from_base<T, Tag>(*p));
+    return next;
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+template <typename Disposer>
+void intrusive::basic_set<T, Tag, Compare, Multi>::clear_and_dispose(Disposer disposer)
+{
+    /*
+    Снизу вверх, без балансировки: у каждого элемента к моменту
+    вызова disposer'а уже нет детей, и до него больше никто не
+    дотронется.
+    */
+    set_element_base* p = root();
+    forget();
+    while (p != nullptr)
+    {
+        if (p->left != nullptr)
+        {
+            p = p->left;
+            continue;
+        }
+        if (p->right != nullptr)
+        {
+            p = p->right;
+            continue;
+        }
+
+        set_element_base* parent = p->parent;
+        if (parent != &header && parent != nullptr)
+        {
+            if (parent->left == p)
+                parent->left = nullptr;
+            else
+                parent->right = nullptr;
+        }
+        else
+        {
+            parent = nullptr;
+        }
+
+        if constexpr (!std::is_same_v<link_mode, normal_link>)
+        {
+            p->parent = nullptr;
+            p->left = nullptr;
+            p->right = nullptr;
+        }
+        disposer(&from_base<T, Tag>(*p));
+        p = parent;
+    }
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+void intrusive::basic_set<T, Tag, Compare, Multi>::clear() noexcept
+{
+    if constexpr (std::is_same_v<link_mode, normal_link>)
+        forget();
+    else
+        reset_all();
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+void intrusive::basic_set<T, Tag, Compare, Multi>::swap(basic_set& other) noexcept
+{
+    using std::swap;
+    detail::rbtree_base::swap(other);
+    swap(comp, other.comp);
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+template <typename Key>
+typename intrusive::basic_set<T, Tag, Compare, Multi>::iterator intrusive::basic_set<T, Tag, Compare, Multi>::find(Key const& key)
+{
+    static_assert(is_key_v<Key>, "heterogeneous lookup requires Compare::is_transparent");
+    set_element_base* p = lower_bound_node(key);
+    if (p == &header || comp(key, value(p)))
+        return end();
+    return iterator(p);
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+template <typename Key>
+typename intrusive::basic_set<T, Tag, Compare, Multi>::const_iterator intrusive::basic_set<T, Tag, Compare, Multi>::find(Key const& key) const
+{
+    return const_cast<basic_set&>(*this).find(key);
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+template <typename Key>
+typename intrusive::basic_set<T, Tag, Compare, Multi>::iterator intrusive::basic_set<T, Tag, Compare, Multi>::lower_bound(Key const& key)
+{
+    static_assert(is_key_v<Key>, "heterogeneous lookup requires Compare::is_transparent");
+    return iterator(lower_bound_node(key));
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+template <typename Key>
+typename intrusive::basic_set<T, Tag, Compare, Multi>::const_iterator intrusive::basic_set<T, Tag, Compare, Multi>::lower_bound(Key const& key) const
+{
+    static_assert(is_key_v<Key>, "heterogeneous lookup requires Compare::is_transparent");
+    return const_iterator(lower_bound_node(key));
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+template <typename Key>
+typename intrusive::basic_set<T, Tag, Compare, Multi>::iterator intrusive::basic_set<T, Tag, Compare, Multi>::upper_bound(Key const& key)
+{
+    static_assert(is_key_v<Key>, "heterogeneous lookup requires Compare::is_transparent");
+    return iterator(upper_bound_node(key));
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+template <typename Key>
+typename intrusive::basic_set<T, Tag, Compare, Multi>::const_iterator intrusive::basic_set<T, Tag, Compare, Multi>::upper_bound(Key const& key) const
+{
+    static_assert(is_key_v<Key>, "heterogeneous lookup requires Compare::is_transparent");
+    return const_iterator(upper_bound_node(key));
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+template <typename Key>
+std::pair<typename intrusive::basic_set<T, Tag, Compare, Multi>::iterator, typename intrusive::basic_set<T, Tag, Compare, Multi>::iterator>
+intrusive::basic_set<T, Tag, Compare, Multi>::equal_range(Key const& key)
+{
+    return {lower_bound(key), upper_bound(key)};
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+template <typename Key>
+typename intrusive::basic_set<T, Tag, Compare, Multi>::size_type intrusive::basic_set<T, Tag, Compare, Multi>::count(Key const& key) const
+{
+    static_assert(is_key_v<Key>, "heterogeneous lookup requires Compare::is_transparent");
+    size_type n = 0;
+    set_element_base* last = upper_bound_node(key);
+    for (set_element_base* p = lower_bound_node(key); p != last; p = set_element_base::next(p))
+        ++n;
+    return n;
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+template <typename Key>
+bool intrusive::basic_set<T, Tag, Compare, Multi>::contains(Key const& key) const
+{
+    return find(key) != end();
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+typename intrusive::basic_set<T, Tag, Compare, Multi>::iterator intrusive::basic_set<T, Tag, Compare, Multi>::begin() noexcept
+{
+    return iterator(header.left);
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+typename intrusive::basic_set<T, Tag, Compare, Multi>::const_iterator intrusive::basic_set<T, Tag, Compare, Multi>::begin() const noexcept
+{
+    return const_iterator(header.left);
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+typename intrusive::basic_set<T, Tag, Compare, Multi>::iterator intrusive::basic_set<T, Tag, Compare, Multi>::end() noexcept
+{
+    return iterator(&header);
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+typename intrusive::basic_set<T, Tag, Compare, Multi>::const_iterator intrusive::basic_set<T, Tag, Compare, Multi>::end() const noexcept
+{
+    return const_iterator(header_ptr());
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+T& intrusive::basic_set<T, Tag, Compare, Multi>::front() noexcept
+{
+    assert(!empty());
+    return from_base<T, Tag>(*header.left);
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+T& intrusive::basic_set<T, Tag, Compare, Multi>::back() noexcept
+{
+    assert(!empty());
+    return from_base<T, Tag>(*header.right);
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+bool intrusive::basic_set<T, Tag, Compare, Multi>::empty() const noexcept
+{
+    return root() == nullptr;
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+typename intrusive::basic_set<T, Tag, Compare, Multi>::size_type intrusive::basic_set<T, Tag, Compare, Multi>::size() const noexcept
+{
+    size_type n = 0;
+    for (set_element_base* p = header.left; p != &header; p = set_element_base::next(p))
+        ++n;
+    return n;
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+typename intrusive::basic_set<T, Tag, Compare, Multi>::iterator intrusive::basic_set<T, Tag, Compare, Multi>::iterator_to(T& obj) noexcept
+{
+    return iterator(&to_base<Tag>(obj));
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+typename intrusive::basic_set<T, Tag, Compare, Multi>::const_iterator intrusive::basic_set<T, Tag, Compare, Multi>::iterator_to(T const& obj) noexcept
+{
+    return const_iterator(const_cast<set_element_base*>(&to_base<Tag>(obj)));
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+template <typename Key>
+intrusive::set_element_base* intrusive::basic_set<T, Tag, Compare, Multi>::lower_bound_node(Key const& key) const
+{
+    set_element_base* result = header_ptr();
+    set_element_base* x = root();
+    while (x != nullptr)
+    {
+        if (!comp(value(x), key))
+        {
+            result = x;
+            x = x->left;
+        }
+        else
+        {
+            x = x->right;
+        }
+    }
+    return result;
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+template <typename Key>
+intrusive::set_element_base* intrusive::basic_set<T, Tag, Compare, Multi>::upper_bound_node(Key const& key) const
+{
+    set_element_base* result = header_ptr();
+    set_element_base* x = root();
+    while (x != nullptr)
+    {
+        if (comp(key, value(x)))
+        {
+            result = x;
+            x = x->left;
+        }
+        else
+        {
+            x = x->right;
+        }
+    }
+    return result;
+}
+
+/*
+Равные элементы идут в порядке вставки: новый встает после них.
+*/
+template <typename T, typename Tag, typename Compare, bool Multi>
+void intrusive::basic_set<T, Tag, Compare, Multi>::insert_equal(set_element_base& obj)
+{
+    T const& v = from_base<T, Tag>(obj);
+    set_element_base* parent = &header;
+    set_element_base* x = root();
+    while (x != nullptr)
+    {
+        parent = x;
+        x = comp(v, value(x)) ? x->left : x->right;
+    }
+    insert_at(parent, parent == &header || comp(v, value(parent)), obj);
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+typename intrusive::basic_set<T, Tag, Compare, Multi>::iterator intrusive::basic_set<T, Tag, Compare, Multi>::insert_before(set_element_base* pos, set_element_base& obj) noexcept
+{
+    if (pos == &header)
+    {
+        if (root() == nullptr)
+            insert_at(&header, true, obj);
+        else
+            insert_at(header.right, false, obj);
+    }
+    else if (pos->left == nullptr)
+    {
+        insert_at(pos, true, obj);
+    }
+    else
+    {
+        insert_at(set_element_base::prev(pos), false, obj);
+    }
+    return iterator(&obj);
+}
+
+template <typename T, typename Tag, typename Compare, bool Multi>
+void intrusive::basic_set<T, Tag, Compare, Multi>::unlink_node(set_element_base& obj) noexcept
+{
+    detail::rbtree_base::erase(obj);
+    if constexpr (!std::is_same_v<link_mode, normal_link>)
+    {
+        obj.parent = nullptr;
+        obj.left = nullptr;
+        obj.right = nullptr;
+    }
+}
+
+#ifdef INTRUSIVE_LIST_HEADER_ONLY
+#include "intrusive_set.cpp"
+#endif
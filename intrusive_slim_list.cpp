@@ -0,0 +1,63 @@
+#include "intrusive_slim_list.h"
+#include <cassert>
+
+INTRUSIVE_LIST_INLINE void intrusive::slim_list_element_base::link_front(slim_list_element_base*& head) noexcept
+{
+    next = head;
+    if (head != nullptr)
+        head->pprev = &next;
+    head = this;
+    pprev = &head;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::slim_list_element_base::link_before(slim_list_element_base& pos) noexcept
+{
+    assert(pos.pprev != nullptr);
+    pprev = pos.pprev;
+    next = &pos;
+    pos.pprev = &next;
+    *pprev = this;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::slim_list_element_base::link_after(slim_list_element_base& pos) noexcept
+{
+    next = pos.next;
+    if (next != nullptr)
+        next->pprev = &next;
+    pos.next = this;
+    pprev = &pos.next;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::slim_list_element_base::unlink() noexcept
+{
+    detach();
+    next = nullptr;
+    pprev = nullptr;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::slim_list_element_base::try_unlink() noexcept
+{
+    if (pprev != nullptr)
+        unlink();
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::slim_list_element_base::detach() noexcept
+{
+    assert(pprev != nullptr);
+    *pprev = next;
+    if (next != nullptr)
+        next->pprev = pprev;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::slim_list_clear(slim_list_element_base*& head) noexcept
+{
+    slim_list_element_base* p = head;
+    head = nullptr;
+    while (p != nullptr)
+    {
+        slim_list_element_base* next = p->next;
+        p->next = nullptr;
+        p->pprev = nullptr;
+        p = next;
+    }
+}
@@ -0,0 +1,538 @@
+#pragma once
+#include "intrusive_list.h"
+#include <utility>
+
+/*
+Двусвязный список с головой в один указатель, как hlist в ядре Linux.
+Голова slim_list -- это только указатель на первый элемент, 8 байт
+вместо 16 у list. В больших массивах списков, которые почти все пустые
+(бакеты хеш-таблиц, очереди по приоритетам или по процессорам), это
+вдвое меньше памяти на головы и вдвое меньше кеш-линий при их обходе.
+
+Хук -- next и pprev, где pprev указывает на указатель, который
+ссылается на этот элемент: на next предыдущего элемента или на голову
+списка. Списки не кольцевые, последний элемент ссылается в nullptr, и
+end() -- это nullptr. Элемент отвязывается сам за O(1), не зная, в
+каком списке лежит, поэтому auto_unlink остается режимом по умолчанию.
+
+Чем приходится платить по сравнению с list:
+- back(), push_back и pop_back нет: до последнего элемента только
+  дойти;
+- итератор однонаправленный, от end() назад не шагнуть;
+- вставка возможна перед любым элементом и после любого элемента,
+  но не перед end(), если список не пуст;
+- size() всегда O(n), constant_time_size нет;
+- первый элемент ссылается на голову, поэтому move-конструктор и
+  move-присваивание перевязывают его pprev, и голова не может лежать в
+  памяти, которая перемещается без move (std::vector<slim_list> при
+  этом безопасен).
+*/
+namespace intrusive
+{
+    struct slim_list_element_base
+    {
+        /*
+        Вставляет *this в начало списка с головой head.
+        */
+        void link_front(slim_list_element_base*& head) noexcept;
+
+        /*
+        Вставляет *this перед pos или после pos.
+        */
+        void link_before(slim_list_element_base& pos) noexcept;
+        void link_after(slim_list_element_base& pos) noexcept;
+
+        void unlink() noexcept;
+        void try_unlink() noexcept;
+
+        /*
+        Только перевязывает соседей, next и pprev не трогает.
+        */
+        void detach() noexcept;
+
+        slim_list_element_base* next;
+        slim_list_element_base** pprev;
+    };
+
+    template <typename Tag, typename... Options>
+    struct slim_list_element;
+
+    namespace detail
+    {
+        template <typename Tag, typename... Options>
+        slim_list_element<Tag, Options...>& find_slim_list_hook(slim_list_element<Tag, Options...>&) noexcept;
+
+        template <typename T, typename Tag>
+        using slim_list_hook_t = std::remove_reference_t<decltype(find_slim_list_hook<Tag>(std::declval<std::remove_const_t<T>&>()))>;
+
+        template <typename T, typename Tag, typename = void>
+        constexpr bool has_slim_list_hook_v = false;
+
+        template <typename T, typename Tag>
+        constexpr bool has_slim_list_hook_v<T, Tag, std::void_t<slim_list_hook_t<T, Tag>>> = true;
+
+        /*
+        Отвязывает и обнуляет все элементы списка с головой head.
+        */
+        void slim_list_clear(slim_list_element_base*& head) noexcept;
+    }
+
+    template <typename Tag = default_tag, typename... Options>
+    struct slim_list_element : private slim_list_element_base
+    {
+        using link_mode = detail::find_option_t<detail::link_mode_kind, auto_unlink, Options...>;
+
+        slim_list_element() noexcept;
+        ~slim_list_element() noexcept;
+        slim_list_element(slim_list_element const&) = delete;
+        slim_list_element& operator=(slim_list_element const&) = delete;
+
+        /*
+        Как у list_element, только для auto_unlink.
+        */
+        void unlink() noexcept;
+
+        bool is_linked() const noexcept;
+
+        template <typename T, typename Tag1>
+        friend struct slim_list;
+
+        template <typename Tag1, typename T>
+        friend std::enable_if_t<detail::has_slim_list_hook_v<T, Tag1>, slim_list_element_base&> to_base(T&) noexcept;
+
+        template <typename Tag1, typename T>
+        friend std::enable_if_t<detail::has_slim_list_hook_v<T, Tag1>, slim_list_element_base const&> to_base(T const&) noexcept;
+
+        template <typename T1, typename Tag1>
+        friend T1& from_base(slim_list_element_base&) noexcept;
+
+        template <typename T1, typename Tag1>
+        friend T1 const& from_base(slim_list_element_base const&) noexcept;
+    };
+
+    template <typename T, typename Tag>
+    struct slim_list_iterator
+    {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::remove_const_t<T>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = value_type*;
+        using reference = value_type&;
+
+        slim_list_iterator() = default;
+        template <typename NonConstIterator>
+        slim_list_iterator(NonConstIterator other,
+            std::enable_if_t<
+                std::is_same_v<NonConstIterator, slim_list_iterator<std::remove_const_t<T>, Tag>> &&
+                std::is_const_v<T>>* = nullptr) noexcept
+            : current(other.current)
+        {}
+
+        T& operator*() const noexcept;
+        T* operator->() const noexcept;
+
+        slim_list_iterator& operator++() & noexcept;
+        slim_list_iterator operator++(int) & noexcept;
+
+        bool operator==(slim_list_iterator const& rhs) const& noexcept;
+        bool operator!=(slim_list_iterator const& rhs) const& noexcept;
+
+    private:
+        explicit slim_list_iterator(slim_list_element_base* current) noexcept;
+
+    private:
+        /*
+        nullptr у end().
+        */
+        slim_list_element_base* current;
+
+        template <typename T1, typename Tag1>
+        friend struct slim_list_iterator;
+
+        template <typename T1, typename Tag1>
+        friend struct slim_list;
+    };
+
+    template <typename Tag, typename T>
+    std::enable_if_t<detail::has_slim_list_hook_v<T, Tag>, slim_list_element_base&> to_base(T&) noexcept;
+
+    template <typename Tag, typename T>
+    std::enable_if_t<detail::has_slim_list_hook_v<T, Tag>, slim_list_element_base const&> to_base(T const&) noexcept;
+
+    template <typename T, typename Tag>
+    T& from_base(slim_list_element_base&) noexcept;
+
+    template <typename T, typename Tag>
+    T const& from_base(slim_list_element_base const&) noexcept;
+
+    template <typename T, typename Tag = default_tag>
+    struct slim_list
+    {
+        using iterator = slim_list_iterator<T, Tag>;
+        using const_iterator = slim_list_iterator<T const, Tag>;
+        using size_type = std::size_t;
+
+        static_assert(detail::has_slim_list_hook_v<T, Tag>,
+            "value type is not convertible to slim_list_element");
+
+        using link_mode = typename detail::slim_list_hook_t<T, Tag>::link_mode;
+
+        slim_list() noexcept;
+        slim_list(slim_list const&) = delete;
+        slim_list(slim_list&&) noexcept;
+        ~slim_list();
+
+        slim_list& operator=(slim_list const&) = delete;
+        slim_list& operator=(slim_list&&) noexcept;
+
+        void clear() noexcept;
+
+        template <typename Disposer>
+        void clear_and_dispose(Disposer disposer);
+
+        void push_front(T&) noexcept;
+        void pop_front() noexcept;
+        T& front() noexcept;
+        T const& front() const noexcept;
+
+        bool empty() const noexcept;
+
+        /*
+        Всегда O(n).
+        */
+        size_type size() const noexcept;
+
+        iterator begin() noexcept;
+        const_iterator begin() const noexcept;
+
+        iterator end() noexcept;
+        const_iterator end() const noexcept;
+
+        /*
+        Вставка перед pos. pos == end() допустим только для пустого
+        списка: последний элемент без обхода не найти.
+        */
+        iterator insert(const_iterator pos, T&) noexcept;
+        iterator insert_after(const_iterator pos, T&) noexcept;
+
+        iterator erase(const_iterator pos) noexcept;
+
+        template <typename Disposer>
+        iterator erase_and_dispose(const_iterator pos, Disposer disposer);
+
+        void swap(slim_list&) noexcept;
+
+        static iterator iterator_to(T&) noexcept;
+        static const_iterator iterator_to(T const&) noexcept;
+
+    private:
+        void unlink_node(slim_list_element_base&) noexcept;
+
+    private:
+        slim_list_element_base* first;
+    };
+}
+
+template <typename Tag, typename... Options>
+intrusive::slim_list_element<Tag, Options...>::slim_list_element() noexcept
+    : slim_list_element_base{nullptr, nullptr}
+{}
+
+template <typename Tag, typename... Options>
+intrusive::slim_list_element<Tag, Options...>::~slim_list_element() noexcept
+{
+    if constexpr (std::is_same_v<link_mode, auto_unlink>)
+        this->try_unlink();
+    else if constexpr (std::is_same_v<link_mode, safe_link>)
+        assert(this->pprev == nullptr && "safe_link element is destroyed while linked");
+}
+
+template <typename Tag, typename... Options>
+void intrusive::slim_list_element<Tag, Options...>::unlink() noexcept
+{
+    static_assert(std::is_same_v<link_mode, auto_unlink>,
+        "unlink() is available only for auto_unlink elements, use slim_list::erase()");
+    slim_list_element_base::unlink();
+}
+
+template <typename Tag, typename... Options>
+bool intrusive::slim_list_element<Tag, Options...>::is_linked() const noexcept
+{
+    static_assert(!std::is_same_v<link_mode, normal_link>,
+        "is_linked() is not available for normal_link elements");
+    return this->pprev != nullptr;
+}
+
+template <typename T, typename Tag>
+T& intrusive::slim_list_iterator<T, Tag>::operator*() const noexcept
+{
+    return from_base<T, Tag>(*current);
+}
+
+template <typename T, typename Tag>
+T* intrusive::slim_list_iterator<T, Tag>::operator->() const noexcept
+{
+    return &from_base<T, Tag>(*current);
+}
+
+template <typename T, typename Tag>
+intrusive::slim_list_iterator<T, Tag>& intrusive::slim_list_iterator<T, Tag>::operator++() & noexcept
+{
+    current = current->next;
+    return *this;
+}
+
+template <typename T, typename Tag>
+intrusive::slim_list_iterator<T, Tag> intrusive::slim_list_iterator<T, Tag>::operator++(int) & noexcept
+{
+    slim_list_iterator copy = *this;
+    ++*this;
+    return copy;
+}
+
+template <typename T, typename Tag>
+bool intrusive::slim_list_iterator<T, Tag>::operator==(slim_list_iterator const& rhs) const& noexcept
+{
+    return current == rhs.current;
+}
+
+template <typename T, typename Tag>
+bool intrusive::slim_list_iterator<T, Tag>::operator!=(slim_list_iterator const& rhs) const& noexcept
+{
+    return current != rhs.current;
+}
+
+template <typename T, typename Tag>
+intrusive::slim_list_iterator<T, Tag>::slim_list_iterator(slim_list_element_base* current) noexcept
+    : current(current)
+{}
+
+template <typename Tag, typename T>
+std::enable_if_t<intrusive::detail::has_slim_list_hook_v<T, Tag>, intrusive::slim_list_element_base&> intrusive::to_base(T& obj) noexcept
+{
+    return static_cast<detail::slim_list_hook_t<T, Tag>&>(obj);
+}
+
+template <typename Tag, typename T>
+std::enable_if_t<intrusive::detail::has_slim_list_hook_v<T, Tag>, intrusive::slim_list_element_base const&> intrusive::to_base(T const& obj) noexcept
+{
+    return static_cast<detail::slim_list_hook_t<T, Tag> const&>(obj);
+}
+
+template <typename T, typename Tag>
+T& intrusive::from_base(slim_list_element_base& base) noexcept
+{
+    return static_cast<T&>(static_cast<detail::slim_list_hook_t<T, Tag>&>(base));
+}
+
+template <typename T, typename Tag>
+T const& intrusive::from_base(slim_list_element_base const& base) noexcept
+{
+    return static_cast<T const&>(static_cast<detail::slim_list_hook_t<T, Tag> const&>(base));
+}
+
+template <typename T, typename Tag>
+intrusive::slim_list<T, Tag>::slim_list() noexcept
+    : first(nullptr)
+{}
+
+template <typename T, typename Tag>
+intrusive::slim_list<T, Tag>::slim_list(slim_list&& other) noexcept
+    : first(nullptr)
+{
+    swap(other);
+}
+
+template <typename T, typename Tag>
+intrusive::slim_list<T, Tag>::~slim_list()
+{
+    clear();
+}
+
+template <typename T, typename Tag>
+intrusive::slim_list<T, Tag>& intrusive::slim_list<T, Tag>::operator=(slim_list&& other) noexcept
+{
+    if (&other != this)
+    {
+        clear();
+        swap(other);
+    }
+    return *this;
+}
+
+template <typename T, typename Tag>
+void intrusive::slim_list<T, Tag>::clear() noexcept
+{
+    if constexpr (std::is_same_v<link_mode, normal_link>)
+        first = nullptr;
+    else
+        detail::slim_list_clear(first);
+}
+
+template <typename T, typename Tag>
+template <typename Disposer>
+void intrusive::slim_list<T, Tag>::clear_and_dispose(Disposer disposer)
+{
+    slim_list_element_base* p = first;
+    first = nullptr;
+    while (p != nullptr)
+    {
+        slim_list_element_base* next = p->next;
+        if constexpr (!std::is_same_v<link_mode, normal_link>)
+        {
+            p->next = nullptr;
+            p->pprev = nullptr;
+        }
+        disposer(&from_base<T, Tag>(*p));
+        p = next;
+    }
+}
+
+template <typename T, typename Tag>
+void intrusive::slim_list<T, Tag>::push_front(T& obj) noexcept
+{
+    to_base<Tag>(obj).link_front(first);
+}
+
+template <typename T, typename Tag>
+void intrusive::slim_list<T, Tag>::pop_front() noexcept
+{
+    assert(!empty());
+    unlink_node(*first);
+}
+
+template <typename T, typename Tag>
+T& intrusive::slim_list<T, Tag>::front() noexcept
+{
+    assert(!empty());
+    return from_base<T, Tag>(*first);
+}
+
+template <typename T, typename Tag>
+T const& intrusive::slim_list<T, Tag>::front() const noexcept
+{
+    assert(!empty());
+    return from_base<T, Tag>(*first);
+}
+
+template <typename T, typename Tag>
+bool intrusive::slim_list<T, Tag>::empty() const noexcept
+{
+    return first == nullptr;
+}
+
+template <typename T, typename Tag>
+typename intrusive::slim_list<T, Tag>::size_type intrusive::slim_list<T, Tag>::size() const noexcept
+{
+    size_type n = 0;
+    for (slim_list_element_base* p = first; p != nullptr; p = p->next)
+        ++n;
+    return n;
+}
+
+template <typename T, typename Tag>
+typename intrusive::slim_list<T, Tag>::iterator intrusive::slim_list<T, Tag>::begin() noexcept
+{
+    return iterator(first);
+}
+
+template <typename T, typename Tag>
+typename intrusive::slim_list<T, Tag>::const_iterator intrusive::slim_list<T, Tag>::begin() const noexcept
+{
+    return const_iterator(first);
+}
+
+template <typename T, typename Tag>
+typename intrusive::slim_list<T, Tag>::iterator intrusive::slim_list<T, Tag>::end() noexcept
+{
+    return iterator(nullptr);
+}
+
+template <typename T, typename Tag>
+typename intrusive::slim_list<T, Tag>::const_iterator intrusive::slim_list<T, Tag>::end() const noexcept
+{
+    return const_iterator(nullptr);
+}
+
+template <typename T, typename Tag>
+typename intrusive::slim_list<T, Tag>::iterator intrusive::slim_list<T, Tag>::insert(const_iterator pos, T& obj) noexcept
+{
+    slim_list_element_base& node = to_base<Tag>(obj);
+    if (pos.current == nullptr)
+    {
+        assert(empty() && "slim_list can't insert before end() of a non-empty list");
+        node.link_front(first);
+    }
+    else
+    {
+        node.link_before(*pos.current);
+    }
+    return iterator(&node);
+}
+
+template <typename T, typename Tag>
+typename intrusive::slim_list<T, Tag>::iterator intrusive::slim_list<T, Tag>::insert_after(const_iterator pos, T& obj) noexcept
+{
+    assert(pos.current != nullptr);
+    slim_list_element_base& node = to_base<Tag>(obj);
+    node.link_after(*pos.current);
+    return iterator(&node);
+}
+
+template <typename T, typename Tag>
+typename intrusive::slim_list<T, Tag>::iterator intrusive::slim_list<T, Tag>::erase(const_iterator pos) noexcept
+{
+    assert(pos.current != nullptr);
+    slim_list_element_base* next = pos.current->next;
+    unlink_node(*pos.current);
+    return iterator(next);
+}
+
+template <typename T, typename Tag>
+template <typename Disposer>
+typename intrusive::slim_list<T, Tag>::iterator intrusive::slim_list<T, Tag>::erase_and_dispose(const_iterator pos, Disposer disposer)
+{
+    T& obj = from_base<T, Tag>(*pos.current);
+    iterator next = erase(pos);
+    disposer(&obj);
+    return next;
+}
+
+/*
+Голова -- единственное, что ссылается на список снаружи, поэтому
+после обмена указателями надо перевязать pprev у первых элементов.
+*/
+template <typename T, typename Tag>
+void intrusive::slim_list<T, Tag>::swap(slim_list& other) noexcept
+{
+    std::swap(first, other.first);
+    if (first != nullptr)
+        first->pprev = &first;
+    if (other.first != nullptr)
+        other.first->pprev = &other.first;
+}
+
+template <typename T, typename Tag>
+typename intrusive::slim_list<T, Tag>::iterator intrusive::slim_list<T, Tag>::iterator_to(T& obj) noexcept
+{
+    return iterator(&to_base<Tag>(obj));
+}
+
+template <typename T, typename Tag>
+typename intrusive::slim_list<T, Tag>::const_iterator intrusive::slim_list<T, Tag>::iterator_to(T const& obj) noexcept
+{
+    return const_iterator(const_cast<slim_list_element_base*>(&to_base<Tag>(obj)));
+}
+
+template <typename T, typename Tag>
+void intrusive::slim_list<T, Tag>::unlink_node(slim_list_element_base& node) noexcept
+{
+    if constexpr (std::is_same_v<link_mode, normal_link>)
+        node.detach();
+    else
+        node.unlink();
+}
+
+#ifdef INTRUSIVE_LIST_HEADER_ONLY
+#include "intrusive_slim_list.cpp"
+#endif
@@ -0,0 +1,51 @@
+#include "intrusive_slist.h"
+#include <cassert>
+
+INTRUSIVE_LIST_INLINE void intrusive::slist_element_base::insert_after(slist_element_base& obj) noexcept
+{
+    obj.next = next;
+    next = &obj;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::slist_element_base::unlink_after() noexcept
+{
+    slist_element_base* obj = next;
+    assert(obj != this);
+    next = obj->next;
+    obj->next = nullptr;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::slist_element_base::detach_after() noexcept
+{
+    assert(next != this);
+    next = next->next;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::slist_element_base::clear() noexcept
+{
+    auto* p = next;
+    while (p != this)
+    {
+        auto* n = p->next;
+        p->next = nullptr;
+        p = n;
+    }
+
+    next = this;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::slist_element_base::reset() noexcept
+{
+    next = this;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::slist_element_base::splice_after(slist_element_base& before_first, slist_element_base& before_last) noexcept
+{
+    if (&before_first == &before_last || this == &before_first || this == &before_last)
+        return;
+
+    slist_element_base* first = before_first.next;
+    before_first.next = before_last.next;
+    before_last.next = next;
+    next = first;
+}
@@ -0,0 +1,651 @@
+#pragma once
+#include "intrusive_list.h"
+
+/*
+Односвязный интрузивный список. Хук -- один указатель next, то есть
+8 байт вместо 16 у list_element. Это полезно для объектов, которые
+лежат в нескольких списках, но почти всегда используются как стек или
+очередь: push_front/pop_front, а с опцией cache_last еще и push_back.
+
+Интерфейс повторяет list, насколько это возможно для односвязного
+списка. Вставка и удаление делаются после позиции (insert_after,
+erase_after, splice_after), как у std::forward_list.
+
+Что перестает быть O(1) по сравнению с list:
+- вставка и удаление перед позицией: в slist их нет, а чтобы найти
+  предыдущий элемент, нужен previous() за O(n);
+- отвязывание элемента самого по себе, поэтому auto_unlink режима нет.
+  По умолчанию используется safe_link, можно выбрать normal_link;
+- back(), push_back и splice_after(pos, other) целиком: они O(1) только
+  с опцией cache_last, без нее push_back и back недоступны, а
+  splice_after ищет последний элемент other за O(n);
+- move-конструктор и move-присваивание: последний элемент ссылается на
+  fake, и его надо найти (O(1) с cache_last);
+- итератор только однонаправленный, operator-- нет.
+*/
+namespace intrusive
+{
+    namespace detail
+    {
+        struct cache_last_kind;
+    }
+
+    /*
+    Опция slist: хранить указатель на последний элемент.
+    */
+    struct cache_last
+    {
+        using kind = detail::cache_last_kind;
+    };
+
+    struct slist_element_base
+    {
+        void insert_after(slist_element_base&) noexcept;
+        void unlink_after() noexcept;
+        void detach_after() noexcept;
+        void clear() noexcept;
+        void reset() noexcept;
+
+        /*
+        Переносит (before_first, before_last] сразу после *this.
+        */
+        void splice_after(slist_element_base& before_first, slist_element_base& before_last) noexcept;
+
+        slist_element_base* next;
+    };
+
+    template <typename Tag, typename... Options>
+    struct slist_element;
+
+    namespace detail
+    {
+        template <typename Tag, typename... Options>
+        slist_element<Tag, Options...>& find_slist_hook(slist_element<Tag, Options...>&) noexcept;
+
+        template <typename T, typename Tag>
+        using slist_hook_t = std::remove_reference_t<decltype(find_slist_hook<Tag>(std::declval<std::remove_const_t<T>&>()))>;
+
+        template <typename T, typename Tag, typename = void>
+        constexpr bool has_slist_hook_v = false;
+
+        template <typename T, typename Tag>
+        constexpr bool has_slist_hook_v<T, Tag, std::void_t<slist_hook_t<T, Tag>>> = true;
+
+        /*
+        Указатель на последний элемент для cache_last. Как и size_counter,
+        версия без кеша пустая и не занимает места.
+        */
+        template <bool Cached>
+        struct last_cache
+        {};
+
+        template <>
+        struct last_cache<true>
+        {
+            slist_element_base* tail;
+        };
+    }
+
+    template <typename Tag = default_tag, typename... Options>
+    struct slist_element : private slist_element_base
+    {
+        using link_mode = detail::find_option_t<detail::link_mode_kind, safe_link, Options...>;
+
+        static_assert(!std::is_same_v<link_mode, auto_unlink>,
+            "slist_element can't unlink itself in O(1), use safe_link or normal_link");
+
+        slist_element() noexcept;
+        ~slist_element() noexcept;
+        slist_element(slist_element const&) = delete;
+        slist_element& operator=(slist_element const&) = delete;
+
+        bool is_linked() const noexcept;
+
+        template <typename T, typename Tag1, typename... Options1>
+        friend struct slist;
+
+        template <typename Tag1, typename T>
+        friend std::enable_if_t<detail::has_slist_hook_v<T, Tag1>, slist_element_base&> to_base(T&) noexcept;
+
+        template <typename Tag1, typename T>
+        friend std::enable_if_t<detail::has_slist_hook_v<T, Tag1>, slist_element_base const&> to_base(T const&) noexcept;
+
+        template <typename T1, typename Tag1>
+        friend T1& from_base(slist_element_base&) noexcept;
+
+        template <typename T1, typename Tag1>
+        friend T1 const& from_base(slist_element_base const&) noexcept;
+    };
+
+    template <typename T, typename Tag>
+    struct slist_iterator
+    {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::remove_const_t<T>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = value_type*;
+        using reference = value_type&;
+
+        slist_iterator() = default;
+        template <typename NonConstIterator>
+        slist_iterator(NonConstIterator other,
+            std::enable_if_t<
+                std::is_same_v<NonConstIterator, slist_iterator<std::remove_const_t<T>, Tag>> &&
+                std::is_const_v<T>>* = nullptr) noexcept
+            : current(other.current)
+        {}
+
+        T& operator*() const noexcept;
+        T* operator->() const noexcept;
+
+        slist_iterator& operator++() & noexcept;
+        slist_iterator operator++(int) & noexcept;
+
+        bool operator==(slist_iterator const& rhs) const& noexcept;
+        bool operator!=(slist_iterator const& rhs) const& noexcept;
+
+    private:
+        explicit slist_iterator(slist_element_base* current) noexcept;
+
+    private:
+        slist_element_base* current;
+
+        template <typename T1, typename Tag1>
+        friend struct slist_iterator;
+
+        template <typename T1, typename Tag1, typename... Options1>
+        friend struct slist;
+    };
+
+    template <typename Tag, typename T>
+    std::enable_if_t<detail::has_slist_hook_v<T, Tag>, slist_element_base&> to_base(T&) noexcept;
+
+    template <typename Tag, typename T>
+    std::enable_if_t<detail::has_slist_hook_v<T, Tag>, slist_element_base const&> to_base(T const&) noexcept;
+
+    template <typename T, typename Tag>
+    T& from_base(slist_element_base&) noexcept;
+
+    template <typename T, typename Tag>
+    T const& from_base(slist_element_base const&) noexcept;
+
+    template <typename T, typename Tag = default_tag, typename... Options>
+    struct slist : private detail::size_counter<detail::constant_time_size_v<Options...>>
+                 , private detail::last_cache<std::is_same_v<
+                       detail::find_option_t<detail::cache_last_kind, void, Options...>, cache_last>>
+    {
+        using iterator = slist_iterator<T, Tag>;
+        using const_iterator = slist_iterator<T const, Tag>;
+        using size_type = std::size_t;
+
+        static_assert(detail::has_slist_hook_v<T, Tag>,
+            "value type is not convertible to slist_element");
+
+        using link_mode = typename detail::slist_hook_t<T, Tag>::link_mode;
+
+        static constexpr bool has_constant_time_size = detail::constant_time_size_v<Options...>;
+        static constexpr bool has_cache_last = std::is_same_v<
+            detail::find_option_t<detail::cache_last_kind, void, Options...>, cache_last>;
+
+        slist() noexcept;
+        slist(slist const&) = delete;
+        slist(slist&&) noexcept;
+        ~slist();
+
+        slist& operator=(slist const&) = delete;
+        slist& operator=(slist&&) noexcept;
+
+        void clear() noexcept;
+
+        template <typename Disposer>
+        void clear_and_dispose(Disposer disposer);
+
+        void push_front(T&) noexcept;
+        void pop_front() noexcept;
+        T& front() noexcept;
+        T const& front() const noexcept;
+
+        /*
+        Только с опцией cache_last.
+        */
+        void push_back(T&) noexcept;
+        T& back() noexcept;
+        T const& back() const noexcept;
+
+        bool empty() const noexcept;
+
+        /*
+        O(1) с опцией constant_time_size и O(n) без нее.
+        */
+        size_type size() const noexcept;
+
+        iterator before_begin() noexcept;
+        const_iterator before_begin() const noexcept;
+
+        iterator begin() noexcept;
+        const_iterator begin() const noexcept;
+
+        iterator end() noexcept;
+        const_iterator end() const noexcept;
+
+        iterator insert_after(const_iterator pos, T&) noexcept;
+
+        /*
+        Возвращают итератор на элемент, следующий за удаленными.
+        erase_after(before_first, last) удаляет (before_first, last).
+        */
+        iterator erase_after(const_iterator pos) noexcept;
+        iterator erase_after(const_iterator before_first, const_iterator last) noexcept;
+
+        /*
+        Переносит все элементы other после pos. O(1) с cache_last,
+        иначе O(длины other): нужен последний элемент other.
+        */
+        void splice_after(const_iterator pos, slist& other) noexcept;
+
+        /*
+        Переносит (before_first, before_last] из other после pos.
+        Считает элементы только с constant_time_size, если списки разные.
+        */
+        void splice_after(const_iterator pos, slist& other, const_iterator before_first, const_iterator before_last) noexcept;
+
+        /*
+        Итератор на элемент перед pos, за O(n).
+        */
+        iterator previous(const_iterator pos) noexcept;
+        const_iterator previous(const_iterator pos) const noexcept;
+
+        static iterator iterator_to(T&) noexcept;
+        static const_iterator iterator_to(T const&) noexcept;
+
+    private:
+        slist_element_base* find_last() const noexcept;
+        void unlink_after_node(slist_element_base&) noexcept;
+
+    private:
+        mutable slist_element_base fake;
+    };
+}
+
+template <typename Tag, typename... Options>
+intrusive::slist_element<Tag, Options...>::slist_element() noexcept
+    : slist_element_base{nullptr}
+{}
+
+template <typename Tag, typename... Options>
+intrusive::slist_element<Tag, Options...>::~slist_element() noexcept
+{
+    if constexpr (std::is_same_v<link_mode, safe_link>)
+        assert(next == nullptr && "safe_link element is destroyed while linked");
+}
+
+template <typename Tag, typename... Options>
+bool intrusive::slist_element<Tag, Options...>::is_linked() const noexcept
+{
+    static_assert(!std::is_same_v<link_mode, normal_link>,
+        "is_linked() is not available for normal_link elements");
+    return next != nullptr;
+}
+
+template <typename T, typename Tag>
+T& intrusive::slist_iterator<T, Tag>::operator*() const noexcept
+{
+    return from_base<T, Tag>(*current);
+}
+
+template <typename T, typename Tag>
+T* intrusive::slist_iterator<T, Tag>::operator->() const noexcept
+{
+    return &from_base<T, Tag>(*current);
+}
+
+template <typename T, typename Tag>
+intrusive::slist_iterator<T, Tag>& intrusive::slist_iterator<T, Tag>::operator++() & noexcept
+{
+    current = current->next;
+    return *this;
+}
+
+template <typename T, typename Tag>
+intrusive::slist_iterator<T, Tag> intrusive::slist_iterator<T, Tag>::operator++(int) & noexcept
+{
+    slist_iterator copy = *this;
+    ++*this;
+    return copy;
+}
+
+template <typename T, typename Tag>
+bool intrusive::slist_iterator<T, Tag>::operator==(slist_iterator const& rhs) const& noexcept
+{
+    return current == rhs.current;
+}
+
+template <typename T, typename Tag>
+bool intrusive::slist_iterator<T, Tag>::operator!=(slist_iterator const& rhs) const& noexcept
+{
+    return current != rhs.current;
+}
+
+template <typename T, typename Tag>
+intrusive::slist_iterator<T, Tag>::slist_iterator(slist_element_base* current) noexcept
+    : current(current)
+{}
+
+template <typename Tag, typename T>
+std::enable_if_t<intrusive::detail::has_slist_hook_v<T, Tag>, intrusive::slist_element_base&> intrusive::to_base(T& obj) noexcept
+{
+    return static_cast<detail::slist_hook_t<T, Tag>&>(obj);
+}
+
+template <typename Tag, typename T>
+std::enable_if_t<intrusive::detail::has_slist_hook_v<T, Tag>, intrusive::slist_element_base const&> intrusive::to_base(T const& obj) noexcept
+{
+    return static_cast<detail::slist_hook_t<T, Tag> const&>(obj);
+}
+
+template <typename T, typename Tag>
+T& intrusive::from_base(slist_element_base& base) noexcept
+{
+    return static_cast<T&>(static_cast<detail::slist_hook_t<T, Tag>&>(base));
+}
+
+template <typename T, typename Tag>
+T const& intrusive::from_base(slist_element_base const& base) noexcept
+{
+    return static_cast<T const&>(static_cast<detail::slist_hook_t<T, Tag> const&>(base));
+}
+
+template <typename T, typename Tag, typename... Options>
+intrusive::slist<T, Tag, Options...>::slist() noexcept
+    : fake{&fake}
+{
+    if constexpr (has_cache_last)
+        this->tail = &fake;
+}
+
+template <typename T, typename Tag, typename... Options>
+intrusive::slist<T, Tag, Options...>::slist(slist&& other) noexcept
+    : slist()
+{
+    splice_after(before_begin(), other);
+}
+
+template <typename T, typename Tag, typename... Options>
+intrusive::slist<T, Tag, Options...>::~slist()
+{
+    clear();
+}
+
+template <typename T, typename Tag, typename... Options>
+intrusive::slist<T, Tag, Options...>& intrusive::slist<T, Tag, Options...>::operator=(slist&& other) noexcept
+{
+    clear();
+    splice_after(before_begin(), other);
+    return *this;
+}
+
+template <typename T, typename Tag, typename... Options>
+void intrusive::slist<T, Tag, Options...>::clear() noexcept
+{
+    if constexpr (std::is_same_v<link_mode, normal_link>)
+        fake.reset();
+    else
+        fake.clear();
+    this->set_size(0);
+    if constexpr (has_cache_last)
+        this->tail = &fake;
+}
+
+template <typename T, typename Tag, typename... Options>
+template <typename Disposer>
+void intrusive::slist<T, Tag, Options...>::clear_and_dispose(Disposer disposer)
+{
+    slist_element_base* p = fake.next;
+    fake.reset();
+    this->set_size(0);
+    if constexpr (has_cache_last)
+        this->tail = &fake;
+
+    while (p != &fake)
+    {
+        slist_element_base* next = p->next;
+        if constexpr (!std::is_same_v<link_mode, normal_link>)
+            p->next = nullptr;
+        disposer(&from_base<T, Tag>(*p));
+        p = next;
+    }
+}
+
+template <typename T, typename Tag, typename... Options>
+void intrusive::slist<T, Tag, Options...>::push_front(T& obj) noexcept
+{
+    insert_after(before_begin(), obj);
+}
+
+template <typename T, typename Tag, typename... Options>
+void intrusive::slist<T, Tag, Options...>::pop_front() noexcept
+{
+    erase_after(before_begin());
+}
+
+template <typename T, typename Tag, typename... Options>
+T& intrusive::slist<T, Tag, Options...>::front() noexcept
+{
+    return from_base<T, Tag>(*fake.next);
+}
+
+template <typename T, typename Tag, typename... Options>
+T const& intrusive::slist<T, Tag, Options...>::front() const noexcept
+{
+    return from_base<T, Tag>(*fake.next);
+}
+
+template <typename T, typename Tag, typename... Options>
+void intrusive::slist<T, Tag, Options...>::push_back(T& obj) noexcept
+{
+    static_assert(has_cache_last, "push_back() requires cache_last option");
+    insert_after(iterator(this->tail), obj);
+}
+
+template <typename T, typename Tag, typename... Options>
+T& intrusive::slist<T, Tag, Options...>::back() noexcept
+{
+    static_assert(has_cache_last, "back() requires cache_last option");
+    return from_base<T, Tag>(*this->tail);
+}
+
+template <typename T, typename Tag, typename... Options>
+T const& intrusive::slist<T, Tag, Options...>::back() const noexcept
+{
+    static_assert(has_cache_last, "back() requires cache_last option");
+    return from_base<T, Tag>(*this->tail);
+}
+
+template <typename T, typename Tag, typename... Options>
+bool intrusive::slist<T, Tag, Options...>::empty() const noexcept
+{
+    return fake.next == &fake;
+}
+
+template <typename T, typename Tag, typename... Options>
+typename intrusive::slist<T, Tag, Options...>::size_type intrusive::slist<T, Tag, Options...>::size() const noexcept
+{
+    if constexpr (has_constant_time_size)
+        return this->count;
+    else
+        return static_cast<size_type>(std::distance(begin(), end()));
+}
+
+template <typename T, typename Tag, typename... Options>
+typename intrusive::slist<T, Tag, Options...>::iterator intrusive::slist<T, Tag, Options...>::before_begin() noexcept
+{
+    return iterator(&fake);
+}
+
+template <typename T, typename Tag, typename... Options>
+typename intrusive::slist<T, Tag, Options...>::const_iterator intrusive::slist<T, Tag, Options...>::before_begin() const noexcept
+{
+    return const_iterator(&fake);
+}
+
+template <typename T, typename Tag, typename... Options>
+typename intrusive::slist<T, Tag, Options...>::iterator intrusive::slist<T, Tag, Options...>::begin() noexcept
+{
+    return iterator(fake.next);
+}
+
+template <typename T, typename Tag, typename... Options>
+typename intrusive::slist<T, Tag, Options...>::const_iterator intrusive::slist<T, Tag, Options...>::begin() const noexcept
+{
+    return const_iterator(fake.next);
+}
+
+template <typename T, typename Tag, typename... Options>
+typename intrusive::slist<T, Tag, Options...>::iterator intrusive::slist<T, Tag, Options...>::end() noexcept
+{
+    return iterator(&fake);
+}
+
+template <typename T, typename Tag, typename... Options>
+typename intrusive::slist<T, Tag, Options...>::const_iterator intrusive::slist<T, Tag, Options...>::end() const noexcept
+{
+    return const_iterator(&fake);
+}
+
+template <typename T, typename Tag, typename... Options>
+typename intrusive::slist<T, Tag, Options...>::iterator intrusive::slist<T, Tag, Options...>::insert_after(const_iterator pos, T& obj) noexcept
+{
+    slist_element_base& base = to_base<Tag>(obj);
+    if constexpr (!std::is_same_v<link_mode, normal_link>)
+        assert(base.next == nullptr && "element is already linked");
+    pos.current->insert_after(base);
+    if constexpr (has_cache_last)
+        if (pos.current == this->tail)
+            this->tail = &base;
+    this->add_size(1);
+    return iterator(&base);
+}
+
+template <typename T, typename Tag, typename... Options>
+typename intrusive::slist<T, Tag, Options...>::iterator intrusive::slist<T, Tag, Options...>::erase_after(const_iterator pos) noexcept
+{
+    if constexpr (has_cache_last)
+        if (pos.current->next == this->tail)
+            this->tail = pos.current;
+    unlink_after_node(*pos.current);
+    return iterator(pos.current->next);
+}
+
+template <typename T, typename Tag, typename... Options>
+typename intrusive::slist<T, Tag, Options...>::iterator intrusive::slist<T, Tag, Options...>::erase_after(const_iterator before_first, const_iterator last) noexcept
+{
+    while (before_first.current->next != last.current)
+        erase_after(before_first);
+    return iterator(last.current);
+}
+
+template <typename T, typename Tag, typename... Options>
+void intrusive::slist<T, Tag, Options...>::splice_after(const_iterator pos, slist& other) noexcept
+{
+    if (other.empty())
+        return;
+
+    slist_element_base* before_last = other.find_last();
+    if constexpr (has_constant_time_size)
+    {
+        this->add_size(other.size());
+        other.set_size(0);
+    }
+    if constexpr (has_cache_last)
+    {
+        if (pos.current == this->tail)
+            this->tail = before_last;
+        other.tail = &other.fake;
+    }
+    pos.current->splice_after(other.fake, *before_last);
+}
+
+template <typename T, typename Tag, typename... Options>
+void intrusive::slist<T, Tag, Options...>::splice_after(const_iterator pos, slist& other, const_iterator before_first, const_iterator before_last) noexcept
+{
+    if (before_first == before_last || pos == before_first || pos == before_last)
+        return;
+
+    if constexpr (has_constant_time_size)
+    {
+        if (&other != this)
+        {
+            size_type n = static_cast<size_type>(std::distance(before_first, before_last));
+            other.sub_size(n);
+            this->add_size(n);
+        }
+    }
+    if constexpr (has_cache_last)
+    {
+        if (before_last.current == other.tail)
+            other.tail = before_first.current;
+        if (pos.current == this->tail)
+            this->tail = before_last.current;
+    }
+    pos.current->splice_after(*before_first.current, *before_last.current);
+}
+
+template <typename T, typename Tag, typename... Options>
+typename intrusive::slist<T, Tag, Options...>::iterator intrusive::slist<T, Tag, Options...>::previous(const_iterator pos) noexcept
+{
+    slist_element_base* p = &fake;
+    while (p->next != pos.current)
+        p = p->next;
+    return iterator(p);
+}
+
+template <typename T, typename Tag, typename... Options>
+typename intrusive::slist<T, Tag, Options...>::const_iterator intrusive::slist<T, Tag, Options...>::previous(const_iterator pos) const noexcept
+{
+    slist_element_base* p = &fake;
+    while (p->next != pos.current)
+        p = p->next;
+    return const_iterator(p);
+}
+
+template <typename T, typename Tag, typename... Options>
+typename intrusive::slist<T, Tag, Options...>::iterator intrusive::slist<T, Tag, Options...>::iterator_to(T& obj) noexcept
+{
+    return iterator(&to_base<Tag>(obj));
+}
+
+template <typename T, typename Tag, typename... Options>
+typename intrusive::slist<T, Tag, Options...>::const_iterator intrusive::slist<T, Tag, Options...>::iterator_to(T const& obj) noexcept
+{
+    return const_iterator(const_cast<slist_element_base*>(&to_base<Tag>(obj)));
+}
+
+template <typename T, typename Tag, typename... Options>
+intrusive::slist_element_base* intrusive::slist<T, Tag, Options...>::find_last() const noexcept
+{
+    if constexpr (has_cache_last)
+    {
+        return this->tail;
+    }
+    else
+    {
+        slist_element_base* p = &fake;
+        while (p->next != &fake)
+            p = p->next;
+        return p;
+    }
+}
+
+template <typename T, typename Tag, typename... Options>
+void intrusive::slist<T, Tag, Options...>::unlink_after_node(slist_element_base& base) noexcept
+{
+    if constexpr (std::is_same_v<link_mode, normal_link>)
+        base.detach_after();
+    else
+        base.unlink_after();
+    this->sub_size(1);
+}
+
+#ifdef INTRUSIVE_LIST_HEADER_ONLY
+#include "intrusive_slist.cpp"
+#endif
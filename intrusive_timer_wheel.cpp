@@ -0,0 +1,73 @@
+#include "intrusive_timer_wheel.h"
+
+INTRUSIVE_LIST_INLINE intrusive::detail::timer_wheel_base::timer_wheel_base(std::uint64_t now) noexcept
+    : next(now + 1)
+    , pending{}
+{}
+
+/*
+Уровень -- номер старшей восьмерки бит в расстоянии до срока: до 256
+тиков уровень 0, до 65536 уровень 1 и так далее. Слот внутри уровня --
+те же биты самого срока, поэтому таймеры с одинаковыми старшими битами
+срока делят слот, а когда до них доходит очередь, отличаются уже только
+младшими битами и раскладываются по уровню ниже.
+*/
+INTRUSIVE_LIST_INLINE std::size_t intrusive::detail::timer_wheel_base::slot_for(std::uint64_t expires) noexcept
+{
+    constexpr std::uint64_t max_delta = (std::uint64_t(1) << (timer_wheel_levels * timer_wheel_level_bits)) - 1;
+
+    std::uint64_t delta = 0;
+    if (expires < next)
+        expires = next;
+    else
+        delta = expires - next;
+
+    if (delta > max_delta)
+    {
+        delta = max_delta;
+        expires = next + delta;
+    }
+
+    unsigned level = unsigned(63 - __builtin_clzll(delta | 1)) / timer_wheel_level_bits;
+    std::size_t slot = (expires >> (level * timer_wheel_level_bits)) & timer_wheel_slot_mask;
+    if (level == 0)
+        pending[slot / 64] |= std::uint64_t(1) << (slot % 64);
+    return level * timer_wheel_slots_per_level + slot;
+}
+
+INTRUSIVE_LIST_INLINE bool intrusive::detail::timer_wheel_base::skip_to(std::uint64_t to) noexcept
+{
+    while (next <= to)
+    {
+        std::size_t index = next & timer_wheel_slot_mask;
+        if (index == 0)
+            return true;
+
+        std::uint64_t bits = pending[index / 64] & (~std::uint64_t(0) << (index % 64));
+        if (bits != 0)
+        {
+            std::uint64_t due = next - index % 64 + unsigned(__builtin_ctzll(bits));
+            if (due > to)
+                break;
+            next = due;
+            return true;
+        }
+
+        /*
+        В этом слове карты ничего нет, переходим к следующему. После
+        последнего слова next попадает на начало оборота.
+        */
+        next += 64 - index % 64;
+    }
+
+    next = to + 1;
+    return false;
+}
+
+INTRUSIVE_LIST_INLINE bool intrusive::detail::timer_wheel_base::take_pending(std::size_t index) noexcept
+{
+    std::uint64_t bit = std::uint64_t(1) << (index % 64);
+    bool was = (pending[index / 64] & bit) != 0;
+    pending[index / 64] &= ~bit;
+    return was;
+}
@@ -0,0 +1,287 @@
+#pragma once
+#include "intrusive_list.h"
+#include <cstddef>
+#include <cstdint>
+
+/*
+Иерархическое колесо таймеров (Varghese & Lauck, как timer wheel в
+старых ядрах Linux) поверх list. Таймер -- это объект с хуком
+timer_wheel_element<Tag>, то есть обычным auto_unlink list_element<Tag>
+и сроком срабатывания. Памяти колесо не выделяет: слоты -- это list'ы
+внутри самого колеса.
+
+struct connection : intrusive::timer_wheel_element<>
+{
+    ...
+};
+
+intrusive::timer_wheel<connection> timeouts(now);
+timeouts.schedule(conn, now + idle_timeout);
+...
+auto expired = timeouts.advance(now);
+while (!expired.empty())
+    close(expired.front());       // close() удаляет соединение
+
+Отмена -- это unlink() из того слота, где таймер сейчас лежит, O(1) и
+без обращения к колесу. Соединение, удаленное раньше таймаута, само
+отвязывается в деструкторе. Перепланирование -- отвязать и положить в
+другой слот, тоже O(1).
+
+Уровней четыре по 256 слотов. Слот уровня k покрывает 256^k тиков,
+так что колесо держит сроки до 2^32 тиков вперед. Более далекие сроки
+кладутся в самый дальний слот и, дойдя до него, раскладываются заново.
+Когда уровень ниже проходит полный оборот, очередной слот уровня выше
+целиком вырезается одним splice'ом и раскладывается по уровням ниже.
+Перекладывание поштучное: у таймеров одного слота уровня выше разные
+слоты уровня ниже. Но каждый таймер перекладывается не больше трех раз
+за жизнь, а отмененный до этого -- ни разу.
+
+Сработавшие таймеры вырезаются из слотов уровня 0 целыми слотами и
+возвращаются одним list'ом. Пока пользователь его не разобрал, таймеры
+лежат там, и их по-прежнему можно отменить или перепланировать.
+
+Колесо не считает таймеры: при auto_unlink они могут отвязываться
+сами, и уменьшить счетчик было бы некому. Вместо этого у уровня 0 есть
+битовая карта слотов, в которые что-то клали, и advance() перепрыгивает
+пустые слоты по ней, останавливаясь только в начале каждого оборота
+уровня 0 (раз в 256 тиков), чтобы разложить слоты уровней выше.
+*/
+namespace intrusive
+{
+    template <typename T, typename Tag>
+    struct timer_wheel;
+
+    /*
+    Хук таймера. Options передаются в list_element, но список таймеров
+    должен быть auto_unlink: на нем держится отмена.
+    */
+    template <typename Tag = default_tag, typename... Options>
+    struct timer_wheel_element : list_element<Tag, Options...>
+    {
+        static_assert(std::is_same_v<typename list_element<Tag, Options...>::link_mode, auto_unlink>,
+            "timer_wheel_element requires auto_unlink");
+
+        /*
+        Срок, с которым таймер был запланирован последний раз.
+        */
+        std::uint64_t expires() const noexcept;
+
+    private:
+        std::uint64_t deadline = 0;
+
+        template <typename T, typename Tag1>
+        friend struct timer_wheel;
+    };
+
+    namespace detail
+    {
+        template <typename Tag, typename... Options>
+        timer_wheel_element<Tag, Options...>& find_timer_hook(timer_wheel_element<Tag, Options...>& hook) noexcept
+        {
+            return hook;
+        }
+
+        template <typename Tag, typename... Options>
+        timer_wheel_element<Tag, Options...> const& find_timer_hook(timer_wheel_element<Tag, Options...> const& hook) noexcept
+        {
+            return hook;
+        }
+
+        template <typename T, typename Tag>
+        using timer_hook_t = std::remove_reference_t<decltype(find_timer_hook<Tag>(std::declval<T&>()))>;
+
+        template <typename T, typename Tag, typename = void>
+        constexpr bool has_timer_hook_v = false;
+
+        template <typename T, typename Tag>
+        constexpr bool has_timer_hook_v<T, Tag, std::void_t<timer_hook_t<T, Tag>>> = true;
+
+        constexpr unsigned timer_wheel_level_bits = 8;
+        constexpr unsigned timer_wheel_levels = 4;
+        constexpr std::size_t timer_wheel_slots_per_level = std::size_t(1) << timer_wheel_level_bits;
+        constexpr std::size_t timer_wheel_slot_mask = timer_wheel_slots_per_level - 1;
+
+        /*
+        Все, что не зависит от T: текущее время, выбор слота и поиск
+        следующего тика, на котором есть что делать.
+        */
+        struct timer_wheel_base
+        {
+            explicit timer_wheel_base(std::uint64_t now) noexcept;
+
+            /*
+            Номер слота (уровень * 256 + слот внутри уровня) для таймера
+            со сроком expires. Просроченные таймеры попадают в слот тика
+            next. Слот уровня 0 помечается в pending.
+            */
+            std::size_t slot_for(std::uint64_t expires) noexcept;
+
+            /*
+            Сдвигает next на ближайший тик не позже to, который нельзя
+            пропустить: помеченный слот уровня 0 или начало оборота, на
+            котором раскладываются уровни выше. false, если такого нет,
+            тогда next становится to + 1.
+            */
+            bool skip_to(std::uint64_t to) noexcept;
+
+            /*
+            Снимает пометку со слота уровня 0 и говорит, стояла ли она.
+            */
+            bool take_pending(std::size_t index) noexcept;
+
+            /*
+            Ближайший еще не обработанный тик, now() + 1.
+            */
+            std::uint64_t next;
+
+            /*
+            Битовая карта слотов уровня 0, в которые что-то клали. Бит
+            может остаться стоять после отмены таймера, тогда слот просто
+            проверяется зря. Снятый бит значит, что слот пуст.
+            */
+            std::uint64_t pending[timer_wheel_slots_per_level / 64];
+        };
+    }
+
+    template <typename T, typename Tag = default_tag>
+    struct timer_wheel : private detail::timer_wheel_base
+    {
+        static_assert(detail::has_timer_hook_v<T, Tag>,
+            "value type is not convertible to timer_wheel_element");
+
+        using tick_type = std::uint64_t;
+        using list_type = list<T, Tag>;
+
+        /*
+        now -- текущее время в тиках. Единицу тика выбирает пользователь.
+        */
+        explicit timer_wheel(tick_type now = 0) noexcept;
+        timer_wheel(timer_wheel const&) = delete;
+        timer_wheel& operator=(timer_wheel const&) = delete;
+
+        /*
+        Планирует таймер на тик expires. Уже запланированный таймер
+        перепланируется: сначала отвязывается от старого слота. Срок в
+        прошлом или равный now() сработает на следующем advance().
+        */
+        void schedule(T&, tick_type expires) noexcept;
+
+        static void cancel(T&) noexcept;
+        static bool is_scheduled(T const&) noexcept;
+
+        /*
+        Продвигает время до to и возвращает все таймеры со сроком не
+        позже to. Порядок внутри результата -- по слотам уровня 0, то
+        есть по сроку с точностью до раскладывания при перепланировании.
+        */
+        list_type advance(tick_type to) noexcept;
+
+        tick_type now() const noexcept;
+
+    private:
+        void place(T&) noexcept;
+        void cascade(unsigned level, std::size_t slot) noexcept;
+
+    private:
+        list_type slots[detail::timer_wheel_levels * detail::timer_wheel_slots_per_level];
+    };
+}
+
+template <typename Tag, typename... Options>
+std::uint64_t intrusive::timer_wheel_element<Tag, Options...>::expires() const noexcept
+{
+    return deadline;
+}
+
+template <typename T, typename Tag>
+intrusive::timer_wheel<T, Tag>::timer_wheel(tick_type now) noexcept
+    : detail::timer_wheel_base(now)
+{}
+
+template <typename T, typename Tag>
+void intrusive::timer_wheel<T, Tag>::schedule(T& timer, tick_type expires) noexcept
+{
+    auto& hook = detail::find_timer_hook<Tag>(timer);
+    if (hook.is_linked())
+        hook.unlink();
+    hook.deadline = expires;
+    place(timer);
+}
+
+template <typename T, typename Tag>
+void intrusive::timer_wheel<T, Tag>::cancel(T& timer) noexcept
+{
+    auto& hook = detail::find_timer_hook<Tag>(timer);
+    if (hook.is_linked())
+        hook.unlink();
+}
+
+template <typename T, typename Tag>
+bool intrusive::timer_wheel<T, Tag>::is_scheduled(T const& timer) noexcept
+{
+    return detail::find_timer_hook<Tag>(timer).is_linked();
+}
+
+template <typename T, typename Tag>
+typename intrusive::timer_wheel<T, Tag>::list_type intrusive::timer_wheel<T, Tag>::advance(tick_type to) noexcept
+{
+    list_type expired;
+    for (; skip_to(to); ++next)
+    {
+        std::size_t index = next & detail::timer_wheel_slot_mask;
+
+        /*
+        Уровень 0 прошел оборот: раскладываем очередной слот уровня 1, а
+        если и он прошел оборот, то и уровня 2, и так далее.
+        */
+        if (index == 0)
+        {
+            for (unsigned level = 1; level != detail::timer_wheel_levels; ++level)
+            {
+                std::size_t slot = (next >> (level * detail::timer_wheel_level_bits)) & detail::timer_wheel_slot_mask;
+                cascade(level, slot);
+                if (slot != 0)
+                    break;
+            }
+        }
+
+        list_type& due = slots[index];
+        if (take_pending(index) && !due.empty())
+            expired.splice(expired.end(), due, due.begin(), due.end());
+    }
+    return expired;
+}
+
+template <typename T, typename Tag>
+typename intrusive::timer_wheel<T, Tag>::tick_type intrusive::timer_wheel<T, Tag>::now() const noexcept
+{
+    return next - 1;
+}
+
+template <typename T, typename Tag>
+void intrusive::timer_wheel<T, Tag>::place(T& timer) noexcept
+{
+    std::size_t slot = slot_for(detail::find_timer_hook<Tag>(timer).deadline);
+    slots[slot].push_back(timer);
+}
+
+template <typename T, typename Tag>
+void intrusive::timer_wheel<T, Tag>::cascade(unsigned level, std::size_t slot) noexcept
+{
+    list_type& source = slots[level * detail::timer_wheel_slots_per_level + slot];
+    if (source.empty())
+        return;
+
+    list_type pending;
+    pending.splice(pending.end(), source, source.begin(), source.end());
+    while (!pending.empty())
+    {
+        T& timer = pending.front();
+        pending.pop_front();
+        place(timer);
+    }
+}
+
+#ifdef INTRUSIVE_LIST_HEADER_ONLY
+#include "intrusive_timer_wheel.cpp"
+#endif
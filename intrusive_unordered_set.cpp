@@ -0,0 +1,121 @@
+#include "intrusive_unordered_set.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+/*
+Бакеты разложены по сегментам. Сегмент 0 -- начальные 2^initial_level
+бакетов, сегмент k -- бакеты [2^(initial_level + k - 1), 2^(initial_level + k)).
+Бакетов сейчас 2^level + split: бакеты [0, split) уже поделены на
+этом уровне, и для них номер берется по level + 1 младшим битам.
+*/
+#ifndef INTRUSIVE_LIST_HEADER_ONLY
+intrusive::unordered_set_element_base intrusive::detail::unordered_set_base::end_marker{nullptr};
+#endif
+
+INTRUSIVE_LIST_INLINE intrusive::detail::unordered_set_base::unordered_set_base(std::size_t bucket_count)
+    : initial_level(0)
+    , split(0)
+    , count(0)
+{
+    while ((std::size_t(1) << initial_level) < bucket_count)
+        ++initial_level;
+    level = initial_level;
+
+    std::size_t n = std::size_t(1) << initial_level;
+    segments[0].reset(new unordered_set_element_base*[n]);
+    std::fill_n(segments[0].get(), n, &end_marker);
+}
+
+INTRUSIVE_LIST_INLINE std::size_t intrusive::detail::unordered_set_base::mix(std::size_t hash) noexcept
+{
+    std::uint64_t h = hash;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return std::size_t(h);
+}
+
+INTRUSIVE_LIST_INLINE std::size_t intrusive::detail::unordered_set_base::index_of(std::size_t hash) const noexcept
+{
+    std::size_t h = mix(hash);
+    std::size_t index = h & ((std::size_t(1) << level) - 1);
+    if (index < split)
+        index = h & ((std::size_t(2) << level) - 1);
+    return index;
+}
+
+INTRUSIVE_LIST_INLINE intrusive::unordered_set_element_base*& intrusive::detail::unordered_set_base::bucket_at(std::size_t index) const noexcept
+{
+    if (index < (std::size_t(1) << initial_level))
+        return segments[0][index];
+
+    unsigned top = 63 - unsigned(__builtin_clzll(index));
+    return segments[top - initial_level + 1][index - (std::size_t(1) << top)];
+}
+
+INTRUSIVE_LIST_INLINE intrusive::unordered_set_element_base*& intrusive::detail::unordered_set_base::bucket(std::size_t hash) const noexcept
+{
+    return bucket_at(index_of(hash));
+}
+
+INTRUSIVE_LIST_INLINE std::size_t intrusive::detail::unordered_set_base::bucket_count() const noexcept
+{
+    return (std::size_t(1) << level) + split;
+}
+
+INTRUSIVE_LIST_INLINE intrusive::unordered_set_element_base* intrusive::detail::unordered_set_base::first_from(std::size_t& index) const noexcept
+{
+    std::size_t n = bucket_count();
+    for (; index < n; ++index)
+    {
+        unordered_set_element_base* head = bucket_at(index);
+        if (head != &end_marker)
+            return head;
+    }
+    return nullptr;
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::unordered_set_base::reserve_split()
+{
+    if (split != 0)
+        return;
+
+    unsigned segment = level - initial_level + 1;
+    assert(segment < max_segments);
+    if (segments[segment])
+        return;
+
+    std::size_t n = std::size_t(1) << level;
+    segments[segment].reset(new unordered_set_element_base*[n]);
+    std::fill_n(segments[segment].get(), n, &end_marker);
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::unordered_set_base::advance_split() noexcept
+{
+    if (++split == (std::size_t(1) << level))
+    {
+        ++level;
+        split = 0;
+    }
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::unordered_set_base::clear_buckets(bool reset_nodes) noexcept
+{
+    std::size_t n = bucket_count();
+    for (std::size_t i = 0; i != n; ++i)
+    {
+        unordered_set_element_base*& head = bucket_at(i);
+        if (reset_nodes)
+        {
+            for (unordered_set_element_base* p = head; p != &end_marker;)
+            {
+                unordered_set_element_base* next = p->next;
+                p->next = nullptr;
+                p = next;
+            }
+        }
+        head = &end_marker;
+    }
+    count = 0;
+}
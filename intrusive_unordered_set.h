@@ -0,0 +1,574 @@
+#pragma once
+#include "intrusive_list.h"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+
+/*
+Интрузивная хеш-таблица с цепочками. Раньше ее собирали из
+std::vector<intrusive::list<T, bucket_tag>>, и у такой таблицы два
+недостатка: голова каждого бакета -- 16-байтный fake, а рехеш
+перекладывает все элементы разом.
+
+Здесь голова бакета -- один указатель, а цепочка односвязная через
+хук unordered_set_element<Tag> (8 байт, 16 с опцией store_hash). Таблица
+растет по схеме линейного хеширования (Litwin): когда элементов
+становится больше, чем бакетов, вставка делит ровно один бакет, так
+что ни одна вставка не платит за полный рехеш, а бюджет на деление --
+в среднем один элемент. Бакеты лежат в сегментах, каждый следующий
+вдвое больше предыдущего, поэтому при росте старые бакеты никуда не
+копируются: одна из вставок только выделяет новый сегмент.
+
+Хук может лежать в объекте рядом с другими хуками под другими тегами,
+например с list_element<lru_tag>: тогда объект одновременно и в
+таблице, и в списке.
+
+Hash и Eq -- функторы без состояния, таблица создает их на каждый
+вызов. auto_unlink режима нет: из односвязной цепочки элемент себя за
+O(1) не удалит. По умолчанию safe_link.
+
+Итераторы и ссылки на элементы после вставки остаются валидными, но
+вставка может переложить элементы между бакетами, так что итератор,
+которым в этот момент обходили таблицу, использовать нельзя.
+*/
+namespace intrusive
+{
+    namespace detail
+    {
+        struct store_hash_kind;
+    }
+
+    /*
+    Опция unordered_set_element: хранить хеш в хуке. Поиск сначала
+    сравнивает хеши, а деление бакета и удаление не вызывают Hash.
+    */
+    struct store_hash
+    {
+        using kind = detail::store_hash_kind;
+    };
+
+    /*
+    next последнего элемента цепочки указывает не в nullptr, а на
+    общий маркер конца. Так у привязанного элемента next всегда не
+    nullptr, и safe_link может это проверить.
+    */
+    struct unordered_set_element_base
+    {
+        unordered_set_element_base* next;
+    };
+
+    struct hashed_unordered_set_element_base : unordered_set_element_base
+    {
+        std::size_t hash;
+    };
+
+    namespace detail
+    {
+        template <typename... Options>
+        constexpr bool store_hash_v =
+            std::is_same_v<find_option_t<store_hash_kind, void, Options...>, intrusive::store_hash>;
+
+        struct unordered_set_base
+        {
+            explicit unordered_set_base(std::size_t bucket_count);
+            unordered_set_base(unordered_set_base const&) = delete;
+            unordered_set_base& operator=(unordered_set_base const&) = delete;
+
+            INTRUSIVE_LIST_INLINE static unordered_set_element_base end_marker;
+
+            /*
+            Перемешивает биты пользовательского хеша: номер бакета берется
+            из младших битов, а std::hash для целых и указателей --
+            тождественная функция.
+            */
+            static std::size_t mix(std::size_t hash) noexcept;
+
+            std::size_t index_of(std::size_t hash) const noexcept;
+            unordered_set_element_base*& bucket_at(std::size_t index) const noexcept;
+            unordered_set_element_base*& bucket(std::size_t hash) const noexcept;
+            std::size_t bucket_count() const noexcept;
+
+            /*
+            Первый элемент в бакетах начиная с index. Если элементов
+            дальше нет, index становится равным bucket_count().
+            */
+            unordered_set_element_base* first_from(std::size_t& index) const noexcept;
+
+            /*
+            Деление бакета split на split и split + 2^level. Сегмент
+            под новый бакет выделяется заранее (может бросить
+            std::bad_alloc), перекладывание элементов делает шаблон,
+            потому что ему нужен хеш, а advance_split сдвигает границу.
+            */
+            void reserve_split();
+            void advance_split() noexcept;
+
+            /*
+            Делает все бакеты пустыми. Если reset_nodes, обнуляет next у
+            элементов.
+            */
+            void clear_buckets(bool reset_nodes) noexcept;
+
+            static constexpr unsigned max_segments = 48;
+
+            std::unique_ptr<unordered_set_element_base*[]> segments[max_segments];
+            unsigned initial_level;
+            unsigned level;
+            std::size_t split;
+            std::size_t count;
+        };
+    }
+
+    template <typename Tag, typename... Options>
+    struct unordered_set_element;
+
+    namespace detail
+    {
+        template <typename Tag, typename... Options>
+        unordered_set_element<Tag, Options...>& find_unordered_hook(unordered_set_element<Tag, Options...>&) noexcept;
+
+        template <typename T, typename Tag>
+        using unordered_hook_t = std::remove_reference_t<decltype(find_unordered_hook<Tag>(std::declval<std::remove_const_t<T>&>()))>;
+
+        template <typename T, typename Tag, typename = void>
+        constexpr bool has_unordered_hook_v = false;
+
+        template <typename T, typename Tag>
+        constexpr bool has_unordered_hook_v<T, Tag, std::void_t<unordered_hook_t<T, Tag>>> = true;
+
+        template <typename... Options>
+        using unordered_node_t = std::conditional_t<store_hash_v<Options...>,
+            hashed_unordered_set_element_base, unordered_set_element_base>;
+    }
+
+    template <typename Tag = default_tag, typename... Options>
+    struct unordered_set_element : private detail::unordered_node_t<Options...>
+    {
+        using link_mode = detail::find_option_t<detail::link_mode_kind, safe_link, Options...>;
+
+        static_assert(!std::is_same_v<link_mode, auto_unlink>,
+            "unordered_set_element can't unlink itself in O(1), use safe_link or normal_link");
+
+        static constexpr bool stores_hash = detail::store_hash_v<Options...>;
+
+        unordered_set_element() noexcept;
+        ~unordered_set_element() noexcept;
+        unordered_set_element(unordered_set_element const&) = delete;
+        unordered_set_element& operator=(unordered_set_element const&) = delete;
+
+        bool is_linked() const noexcept;
+
+        template <typename T, typename Tag1, typename Hash, typename Eq>
+        friend struct unordered_set;
+
+        template <typename Tag1, typename T>
+        friend std::enable_if_t<detail::has_unordered_hook_v<T, Tag1>, unordered_set_element_base&> to_base(T&) noexcept;
+
+        template <typename T1, typename Tag1>
+        friend T1& from_base(unordered_set_element_base&) noexcept;
+    };
+
+    template <typename Tag, typename T>
+    std::enable_if_t<detail::has_unordered_hook_v<T, Tag>, unordered_set_element_base&> to_base(T&) noexcept;
+
+    template <typename T, typename Tag>
+    T& from_base(unordered_set_element_base&) noexcept;
+
+    /*
+    Однонаправленный итератор: номер бакета и элемент в нем.
+    */
+    template <typename T, typename Tag>
+    struct unordered_set_iterator
+    {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
+        unordered_set_iterator() = default;
+
+        T& operator*() const noexcept;
+        T* operator->() const noexcept;
+
+        unordered_set_iterator& operator++() & noexcept;
+        unordered_set_iterator operator++(int) & noexcept;
+
+        bool operator==(unordered_set_iterator const& rhs) const& noexcept;
+        bool operator!=(unordered_set_iterator const& rhs) const& noexcept;
+
+    private:
+        unordered_set_iterator(detail::unordered_set_base const* set, std::size_t index, unordered_set_element_base* current) noexcept;
+
+    private:
+        detail::unordered_set_base const* set;
+        std::size_t index;
+        unordered_set_element_base* current;
+
+        template <typename T1, typename Tag1, typename Hash, typename Eq>
+        friend struct unordered_set;
+    };
+
+    template <typename T, typename Tag = default_tag, typename Hash = std::hash<T>, typename Eq = std::equal_to<T>>
+    struct unordered_set : private detail::unordered_set_base
+    {
+        static_assert(detail::has_unordered_hook_v<T, Tag>,
+            "value type is not convertible to unordered_set_element");
+
+        using iterator = unordered_set_iterator<T, Tag>;
+        using size_type = std::size_t;
+        using hasher = Hash;
+        using key_equal = Eq;
+
+        using link_mode = typename detail::unordered_hook_t<T, Tag>::link_mode;
+        static constexpr bool stores_hash = detail::unordered_hook_t<T, Tag>::stores_hash;
+
+        /*
+        bucket_count округляется вверх до степени двойки. Дальше
+        таблица растет сама, по одному бакету. Не уменьшается.
+        */
+        explicit unordered_set(size_type bucket_count = 8);
+
+        /*
+        Как ~list(): элементы отвязываются (кроме normal_link), но не
+        удаляются.
+        */
+        ~unordered_set();
+
+        /*
+        Если эквивалентный элемент уже есть, ничего не вставляет и
+        возвращает итератор на него и false. Бросает std::bad_alloc,
+        только если не удалось выделить очередной сегмент бакетов;
+        тогда элемент не вставлен.
+        */
+        std::pair<iterator, bool> insert(T&);
+
+        void erase(T&) noexcept;
+        iterator erase(iterator) noexcept;
+
+        iterator find(T const&) noexcept;
+
+        /*
+        Поиск по другому типу ключа. hash(key) должен совпадать с
+        Hash()(x) для элемента x, равного key, а eq(x, key) сравнивает
+        элемент с ключом.
+        */
+        template <typename Key, typename KeyHash, typename KeyEq>
+        iterator find(Key const& key, KeyHash hash, KeyEq eq) noexcept;
+
+        bool contains(T const&) const noexcept;
+
+        void clear() noexcept;
+
+        template <typename Disposer>
+        void clear_and_dispose(Disposer disposer);
+
+        iterator begin() noexcept;
+        iterator end() noexcept;
+
+        size_type size() const noexcept;
+        bool empty() const noexcept;
+        size_type bucket_count() const noexcept;
+        float load_factor() const noexcept;
+
+    private:
+        static std::size_t hash_of(unordered_set_element_base&) noexcept;
+
+        template <typename Key, typename KeyEq>
+        unordered_set_element_base* lookup(std::size_t hash, Key const& key, KeyEq& eq) const noexcept;
+
+        void split_one() noexcept;
+    };
+}
+
+template <typename Tag, typename... Options>
+intrusive::unordered_set_element<Tag, Options...>::unordered_set_element() noexcept
+    : detail::unordered_node_t<Options...>{}
+{}
+
+template <typename Tag, typename... Options>
+intrusive::unordered_set_element<Tag, Options...>::~unordered_set_element() noexcept
+{
+    if constexpr (std::is_same_v<link_mode, safe_link>)
+        assert(this->next == nullptr && "safe_link element is destroyed while linked");
+}
+
+template <typename Tag, typename... Options>
+bool intrusive::unordered_set_element<Tag, Options...>::is_linked() const noexcept
+{
+    static_assert(!std::is_same_v<link_mode, normal_link>,
+        "is_linked() is not available for normal_link elements");
+    return this->next != nullptr;
+}
+
+template <typename Tag, typename T>
+std::enable_if_t<intrusive::detail::has_unordered_hook_v<T, Tag>, intrusive::unordered_set_element_base&> intrusive::to_base(T& obj) noexcept
+{
+    return static_cast<detail::unordered_hook_t<T, Tag>&>(obj);
+}
+
+template <typename T, typename Tag>
+T& intrusive::from_base(unordered_set_element_base& base) noexcept
+{
+    return static_cast<T&>(static_cast<detail::unordered_hook_t<T, Tag>&>(base));
+}
+
+template <typename T, typename Tag>
+T& intrusive::unordered_set_iterator<T, Tag>::operator*() const noexcept
+{
+    return from_base<T, Tag>(*current);
+}
+
+template <typename T, typename Tag>
+T* intrusive::unordered_set_iterator<T, Tag>::operator->() const noexcept
+{
+    return &from_base<T, Tag>(*current);
+}
+
+template <typename T, typename Tag>
+intrusive::unordered_set_iterator<T, Tag>& intrusive::unordered_set_iterator<T, Tag>::operator++() & noexcept
+{
+    current = current->next;
+    if (current == &detail::unordered_set_base::end_marker)
+    {
+        ++index;
+        current = set->first_from(index);
+    }
+    return *this;
+}
+
+template <typename T, typename Tag>
+intrusive::unordered_set_iterator<T, Tag> intrusive::unordered_set_iterator<T, Tag>::operator++(int) & noexcept
+{
+    unordered_set_iterator copy = *this;
+    ++*this;
+    return copy;
+}
+
+template <typename T, typename Tag>
+bool intrusive::unordered_set_iterator<T, Tag>::operator==(unordered_set_iterator const& rhs) const& noexcept
+{
+    return current == rhs.current;
+}
+
+template <typename T, typename Tag>
+bool intrusive::unordered_set_iterator<T, Tag>::operator!=(unordered_set_iterator const& rhs) const& noexcept
+{
+    return current != rhs.current;
+}
+
+template <typename T, typename Tag>
+intrusive::unordered_set_iterator<T, Tag>::unordered_set_iterator(detail::unordered_set_base const* set, std::size_t index, unordered_set_element_base* current) noexcept
+    : set(set)
+    , index(index)
+    , current(current)
+{}
+
+template <typename T, typename Tag, typename Hash, typename Eq>
+intrusive::unordered_set<T, Tag, Hash, Eq>::unordered_set(size_type bucket_count)
+    : detail::unordered_set_base(bucket_count)
+{}
+
+template <typename T, typename Tag, typename Hash, typename Eq>
+intrusive::unordered_set<T, Tag, Hash, Eq>::~unordered_set()
+{
+    if constexpr (!std::is_same_v<link_mode, normal_link>)
+        clear();
+}
+
+template <typename T, typename Tag, typename Hash, typename Eq>
+std::size_t intrusive::unordered_set<T, Tag, Hash, Eq>::hash_of(unordered_set_element_base& base) noexcept
+{
+    if constexpr (stores_hash)
+        return static_cast<hashed_unordered_set_element_base&>(base).hash;
+    else
+        return Hash{}(from_base<T, Tag>(base));
+}
+
+template <typename T, typename Tag, typename Hash, typename Eq>
+template <typename Key, typename KeyEq>
+intrusive::unordered_set_element_base* intrusive::unordered_set<T, Tag, Hash, Eq>::lookup(std::size_t hash, Key const& key, KeyEq& eq) const noexcept
+{
+    for (unordered_set_element_base* p = bucket(hash); p != &end_marker; p = p->next)
+    {
+        if constexpr (stores_hash)
+        {
+            if (static_cast<hashed_unordered_set_element_base*>(p)->hash != hash)
+                continue;
+        }
+        if (eq(from_base<T, Tag>(*p), key))
+            return p;
+    }
+    return nullptr;
+}
+
+template <typename T, typename Tag, typename Hash, typename Eq>
+void intrusive::unordered_set<T, Tag, Hash, Eq>::split_one() noexcept
+{
+    /*
+    Элементы, которые переезжают в новый бакет, снимаются с цепочки
+    по месту, порядок оставшихся сохраняется.
+    */
+    std::size_t from = split;
+    std::size_t high = std::size_t(1) << level;
+    unordered_set_element_base** pp = &bucket_at(from);
+    unordered_set_element_base*& to = bucket_at(from + high);
+    while (*pp != &end_marker)
+    {
+        unordered_set_element_base* p = *pp;
+        if ((mix(hash_of(*p)) & high) != 0)
+        {
+            *pp = p->next;
+            p->next = to;
+            to = p;
+        }
+        else
+        {
+            pp = &p->next;
+        }
+    }
+    advance_split();
+}
+
+template <typename T, typename Tag, typename Hash, typename Eq>
+std::pair<typename intrusive::unordered_set<T, Tag, Hash, Eq>::iterator, bool> intrusive::unordered_set<T, Tag, Hash, Eq>::insert(T& obj)
+{
+    unordered_set_element_base& base = to_base<Tag>(obj);
+    if constexpr (!std::is_same_v<link_mode, normal_link>)
+        assert(base.next == nullptr && "element is already linked");
+
+    std::size_t hash = Hash{}(obj);
+    Eq eq;
+    if (unordered_set_element_base* p = lookup(hash, obj, eq))
+        return {iterator(this, index_of(hash), p), false};
+
+    if (count >= detail::unordered_set_base::bucket_count())
+    {
+        reserve_split();
+        split_one();
+    }
+
+    if constexpr (stores_hash)
+        static_cast<hashed_unordered_set_element_base&>(base).hash = hash;
+    unordered_set_element_base*& head = bucket(hash);
+    base.next = head;
+    head = &base;
+    ++count;
+    return {iterator(this, index_of(hash), &base), true};
+}
+
+template <typename T, typename Tag, typename Hash, typename Eq>
+void intrusive::unordered_set<T, Tag, Hash, Eq>::erase(T& obj) noexcept
+{
+    unordered_set_element_base& base = to_base<Tag>(obj);
+    unordered_set_element_base** pp = &bucket(hash_of(base));
+    while (*pp != &base)
+    {
+        assert(*pp != &end_marker && "element is not in this unordered_set");
+        pp = &(*pp)->next;
+    }
+    *pp = base.next;
+    if constexpr (!std::is_same_v<link_mode, normal_link>)
+        base.next = nullptr;
+    --count;
+}
+
+template <typename T, typename Tag, typename Hash, typename Eq>
+typename intrusive::unordered_set<T, Tag, Hash, Eq>::iterator intrusive::unordered_set<T, Tag, Hash, Eq>::erase(iterator pos) noexcept
+{
+    iterator next = pos;
+    ++next;
+    erase(*pos);
+    return next;
+}
+
+template <typename T, typename Tag, typename Hash, typename Eq>
+typename intrusive::unordered_set<T, Tag, Hash, Eq>::iterator intrusive::unordered_set<T, Tag, Hash, Eq>::find(T const& key) noexcept
+{
+    return find(key, Hash{}, Eq{});
+}
+
+template <typename T, typename Tag, typename Hash, typename Eq>
+template <typename Key, typename KeyHash, typename KeyEq>
+typename intrusive::unordered_set<T, Tag, Hash, Eq>::iterator intrusive::unordered_set<T, Tag, Hash, Eq>::find(Key const& key, KeyHash hash, KeyEq eq) noexcept
+{
+    std::size_t h = hash(key);
+    unordered_set_element_base* p = lookup(h, key, eq);
+    return p != nullptr ? iterator(this, index_of(h), p) : end();
+}
+
+template <typename T, typename Tag, typename Hash, typename Eq>
+bool intrusive::unordered_set<T, Tag, Hash, Eq>::contains(T const& key) const noexcept
+{
+    Eq eq;
+    return lookup(Hash{}(key), key, eq) != nullptr;
+}
+
+template <typename T, typename Tag, typename Hash, typename Eq>
+void intrusive::unordered_set<T, Tag, Hash, Eq>::clear() noexcept
+{
+    clear_buckets(!std::is_same_v<link_mode, normal_link>);
+}
+
+template <typename T, typename Tag, typename Hash, typename Eq>
+template <typename Disposer>
+void intrusive::unordered_set<T, Tag, Hash, Eq>::clear_and_dispose(Disposer disposer)
+{
+    std::size_t n = detail::unordered_set_base::bucket_count();
+    for (std::size_t i = 0; i != n; ++i)
+    {
+        unordered_set_element_base*& head = bucket_at(i);
+        while (head != &end_marker)
+        {
+            unordered_set_element_base* p = head;
+            head = p->next;
+            if constexpr (!std::is_same_v<link_mode, normal_link>)
+                p->next = nullptr;
+            --count;
+            disposer(&from_base<T, Tag>(*p));
+        }
+    }
+}
+
+template <typename T, typename Tag, typename Hash, typename Eq>
+typename intrusive::unordered_set<T, Tag, Hash, Eq>::iterator intrusive::unordered_set<T, Tag, Hash, Eq>::begin() noexcept
+{
+    std::size_t index = 0;
+    unordered_set_element_base* first = first_from(index);
+    return iterator(this, index, first);
+}
+
+template <typename T, typename Tag, typename Hash, typename Eq>
+typename intrusive::unordered_set<T, Tag, Hash, Eq>::iterator intrusive::unordered_set<T, Tag, Hash, Eq>::end() noexcept
+{
+    return iterator(this, detail::unordered_set_base::bucket_count(), nullptr);
+}
+
+template <typename T, typename Tag, typename Hash, typename Eq>
+typename intrusive::unordered_set<T, Tag, Hash, Eq>::size_type intrusive::unordered_set<T, Tag, Hash, Eq>::size() const noexcept
+{
+    return count;
+}
+
+template <typename T, typename Tag, typename Hash, typename Eq>
+bool intrusive::unordered_set<T, Tag, Hash, Eq>::empty() const noexcept
+{
+    return count == 0;
+}
+
+template <typename T, typename Tag, typename Hash, typename Eq>
+typename intrusive::unordered_set<T, Tag, Hash, Eq>::size_type intrusive::unordered_set<T, Tag, Hash, Eq>::bucket_count() const noexcept
+{
+    return detail::unordered_set_base::bucket_count();
+}
+
+template <typename T, typename Tag, typename Hash, typename Eq>
+float intrusive::unordered_set<T, Tag, Hash, Eq>::load_factor() const noexcept
+{
+    return float(count) / float(detail::unordered_set_base::bucket_count());
+}
+
+#ifdef INTRUSIVE_LIST_HEADER_ONLY
+#include "intrusive_unordered_set.cpp"
+#endif
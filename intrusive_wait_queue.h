@@ -0,0 +1,146 @@
+#pragma once
+#include "intrusive_list.h"
+
+#ifndef __cpp_impl_coroutine
+#error "intrusive_wait_queue.h requires C++20 coroutines"
+#endif
+
+#include <coroutine>
+
+/*
+Очередь ожидающих корутин для асинхронных mutex'ов, семафоров и
+событий.
+
+intrusive::wait_queue queue;
+intrusive::wait_queue::ready_list ready;     // у executor'а
+
+task consumer()
+{
+    while (items.empty())
+        co_await queue.wait();
+    ...
+}
+
+queue.notify_one(ready);    // или notify_all(ready)
+intrusive::resume_all(ready);
+
+co_await queue.wait() создает awaiter прямо в кадре корутины, и в
+очередь встает он сам, через свой list_element. Поэтому ожидание
+ничего не аллоцирует, в отличие от std::deque<coroutine_handle<>>.
+
+notify_* не возобновляют корутины: разбуженные awaiter'ы переезжают в
+ready_list executor'а, и он возобновляет их, когда ему удобно, через
+resume_all или сам. notify_all -- это один splice всей очереди в конец
+ready_list, сколько бы корутин ни ждало.
+
+Если корутину уничтожить, пока она ждет (handle.destroy()), awaiter
+разрушается вместе с кадром и auto_unlink выкидывает его из очереди
+или из ready_list за O(1). Так отмена ожидания ничего не стоит.
+
+Ни очередь, ни ready_list не потокобезопасны: все это для
+однопоточного executor'а, как обычный list. Очередь, разрушенная с
+ожидающими, их отвязывает, и они остаются приостановленными навсегда.
+*/
+namespace intrusive
+{
+    struct wait_queue;
+
+    /*
+    Ожидание в wait_queue. Живет в кадре корутины, пока она ждет.
+    */
+    struct wait_queue_awaiter : list_element<>
+    {
+        explicit wait_queue_awaiter(wait_queue& queue) noexcept
+            : queue(queue)
+        {}
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> h) noexcept;
+
+        void await_resume() const noexcept {}
+
+        /*
+        Возобновляет корутину, которая ждет в этом awaiter'е. К этому
+        моменту он уже должен быть отвязан: после возобновления
+        awaiter разрушится.
+        */
+        void resume() const
+        {
+            assert(!is_linked());
+            handle.resume();
+        }
+
+    private:
+        wait_queue& queue;
+        std::coroutine_handle<> handle;
+    };
+
+    struct wait_queue
+    {
+        using ready_list = list<wait_queue_awaiter>;
+
+        wait_queue() noexcept = default;
+        wait_queue(wait_queue const&) = delete;
+        wait_queue& operator=(wait_queue const&) = delete;
+
+        [[nodiscard]] wait_queue_awaiter wait() noexcept
+        {
+            return wait_queue_awaiter(*this);
+        }
+
+        /*
+        Переносит первого ожидающего в конец ready. false, если никто
+        не ждет.
+        */
+        bool notify_one(ready_list& ready) noexcept
+        {
+            if (waiters.empty())
+                return false;
+            ready.splice(ready.end(), waiters, waiters.begin(), std::next(waiters.begin()));
+            return true;
+        }
+
+        /*
+        Переносит всех ожидающих в конец ready в порядке ожидания.
+        */
+        void notify_all(ready_list& ready) noexcept
+        {
+            ready.splice(ready.end(), waiters, waiters.begin(), waiters.end());
+        }
+
+        bool empty() const noexcept
+        {
+            return waiters.empty();
+        }
+
+    private:
+        list<wait_queue_awaiter> waiters;
+
+        friend struct wait_queue_awaiter;
+    };
+
+    /*
+    Возобновляет корутины из ready по одной, пока он не опустеет.
+    Возобновленная корутина может снова встать в очередь и снова
+    попасть в ready: тогда она возобновится в этом же вызове.
+    */
+    inline void resume_all(wait_queue::ready_list& ready)
+    {
+        while (!ready.empty())
+        {
+            wait_queue_awaiter& w = ready.front();
+            ready.pop_front();
+            w.resume();
+        }
+    }
+
+    inline void wait_queue_awaiter::await_suspend(std::coroutine_handle<> h) noexcept
+    {
+        handle = h;
+        queue.waiters.push_back(*this);
+    }
+}
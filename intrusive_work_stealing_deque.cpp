@@ -0,0 +1,90 @@
+#include "intrusive_work_stealing_deque.h"
+#include <cassert>
+
+/*
+count меняется только под локом, а без лока его читают pop() владельца
+и воры, чтобы не трогать лок пустой очереди. Увеличивает count только
+владелец, поэтому если владелец увидел 0, задач в очереди действительно
+нет.
+*/
+INTRUSIVE_LIST_INLINE intrusive::detail::work_stealing_deque_base::work_stealing_deque_base() noexcept
+    : count(0)
+    , fake{&fake, &fake}
+{}
+
+INTRUSIVE_LIST_INLINE intrusive::detail::work_stealing_deque_base::~work_stealing_deque_base()
+{
+    fake.clear();
+}
+
+INTRUSIVE_LIST_INLINE void intrusive::detail::work_stealing_deque_base::push(list_element_base& obj) noexcept
+{
+    lock.lock();
+    fake.insert(obj);
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    lock.unlock();
+}
+
+INTRUSIVE_LIST_INLINE intrusive::list_element_base* intrusive::detail::work_stealing_deque_base::pop() noexcept
+{
+    if (count.load(std::memory_order_relaxed) == 0)
+        return nullptr;
+
+    lock.lock();
+    list_element_base* last = fake.prev;
+    if (last == &fake)
+    {
+        last = nullptr;
+    }
+    else
+    {
+        last->unlink();
+        count.store(count.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+    }
+    lock.unlock();
+    return last;
+}
+
+INTRUSIVE_LIST_INLINE intrusive::list_element_base* intrusive::detail::work_stealing_deque_base::steal_from(work_stealing_deque_base& victim) noexcept
+{
+    assert(&victim != this);
+    if (victim.count.load(std::memory_order_relaxed) == 0 || !victim.lock.try_lock())
+        return nullptr;
+
+    std::size_t n = victim.count.load(std::memory_order_relaxed);
+    if (n == 0)
+    {
+        victim.lock.unlock();
+        return nullptr;
+    }
+
+    std::size_t k = (n + 1) / 2;
+    list_element_base* first = victim.fake.next;
+    list_element_base* last = first;
+    for (std::size_t i = 1; i != k; ++i)
+        last = last->next;
+    first->detach_range(*last->next);
+    victim.count.store(n - k, std::memory_order_relaxed);
+    victim.lock.unlock();
+
+    /*
+    Первую задачу отдаем вору, остальные k - 1 уже связаны между собой
+    и вставляются в нашу очередь целиком.
+    */
+    if (k != 1)
+    {
+        lock.lock();
+        fake.insert_chain(*first->next, *last);
+        count.store(count.load(std::memory_order_relaxed) + (k - 1), std::memory_order_relaxed);
+        lock.unlock();
+    }
+
+    first->prev = nullptr;
+    first->next = nullptr;
+    return first;
+}
+
+INTRUSIVE_LIST_INLINE std::size_t intrusive::detail::work_stealing_deque_base::size() const noexcept
+{
+    return count.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include "intrusive_list.h"
+#include "intrusive_concurrent_list.h"
+#include <atomic>
+
+/*
+Очередь задач одного worker'а планировщика, из которой другие worker'ы
+могут воровать работу. Задачи связываются через тот же list_element<Tag>,
+что и в list, поэтому push, pop и steal ничего не аллоцируют и не
+копируют указатели в кольцевой буфер.
+
+Владелец кладет и забирает задачи с конца (LIFO: последняя положенная
+задача, скорее всего, еще в кеше). Вор забирает с начала, самые старые
+задачи, и сразу половину: одним splice'ом переносит их в свою очередь.
+Так вор ходит за работой редко, а не за каждой задачей.
+
+Каждая очередь защищена своим спинлоком. Пока никто не ворует, лок
+берет только владелец, и это одна атомарная операция на кеш-линии,
+которая лежит у него в кеше. Количество задач вор читает без лока и к
+пустым очередям лок не трогает, а к занятому локу не встает в очередь,
+а идет к следующей жертве.
+
+Пока задача лежит в очереди, удалять ее нельзя: auto_unlink деструктор
+отвязал бы ее без лока. Нужны обычные указатели в хуке (pointer_link).
+*/
+namespace intrusive
+{
+    namespace detail
+    {
+        struct work_stealing_deque_base
+        {
+            work_stealing_deque_base() noexcept;
+            ~work_stealing_deque_base();
+            work_stealing_deque_base(work_stealing_deque_base const&) = delete;
+            work_stealing_deque_base& operator=(work_stealing_deque_base const&) = delete;
+
+            void push(list_element_base&) noexcept;
+            list_element_base* pop() noexcept;
+
+            /*
+            Переносит первую половину (с округлением вверх) задач victim
+            к себе. Первую из перенесенных задач не кладет в очередь, а
+            возвращает: вор выполнит ее сразу. nullptr, если красть
+            нечего или лок victim сейчас занят. Границу половины
+            приходится искать обходом от начала, и владелец victim на
+            это время ждет лок.
+            */
+            list_element_base* steal_from(work_stealing_deque_base& victim) noexcept;
+
+            std::size_t size() const noexcept;
+
+        private:
+            /*
+            Очереди разных worker'ов обычно лежат в одном массиве. Лок,
+            счетчик и fake выровнены на кеш-линию, чтобы соседние
+            очереди не делили ее между собой.
+            */
+            alignas(64) spinlock lock;
+            std::atomic<std::size_t> count;
+            list_element_base fake;
+        };
+    }
+
+    template <typename T, typename Tag = default_tag>
+    struct work_stealing_deque : private detail::work_stealing_deque_base
+    {
+        static_assert(detail::has_hook_v<T, Tag>,
+            "value type is not convertible to list_element");
+
+        static_assert(std::is_same_v<detail::hook_node_t<T, Tag>, list_element_base>,
+            "work_stealing_deque requires elements with plain pointer links");
+
+        using link_mode = typename detail::hook_t<T, Tag>::link_mode;
+
+        work_stealing_deque() noexcept = default;
+
+        /*
+        Отвязывает оставшиеся задачи. В этот момент у очереди не должно
+        быть ни владельца, ни воров.
+        */
+        ~work_stealing_deque() = default;
+
+        /*
+        Только из потока владельца.
+        */
+        void push(T&) noexcept;
+
+        /*
+        Только из потока владельца. nullptr, если очередь пуста.
+        */
+        T* pop() noexcept;
+
+        /*
+        Зовется на очереди вора: *this должна принадлежать текущему
+        потоку.
+        */
+        T* steal_from(work_stealing_deque& victim) noexcept;
+
+        /*
+        Из любого потока. Результат может устареть сразу после возврата.
+        */
+        std::size_t size() const noexcept;
+        bool empty() const noexcept;
+    };
+}
+
+template <typename T, typename Tag>
+void intrusive::work_stealing_deque<T, Tag>::push(T& obj) noexcept
+{
+    list_element_base& base = to_base<Tag>(obj);
+    if constexpr (!std::is_same_v<link_mode, normal_link>)
+        assert(base.prev == nullptr && "element is already linked");
+    detail::work_stealing_deque_base::push(base);
+}
+
+template <typename T, typename Tag>
+T* intrusive::work_stealing_deque<T, Tag>::pop() noexcept
+{
+    list_element_base* base = detail::work_stealing_deque_base::pop();
+    return base != nullptr ? &from_base<T, Tag>(*base) : nullptr;
+}
+
+template <typename T, typename Tag>
+T* intrusive::work_stealing_deque<T, Tag>::steal_from(work_stealing_deque& victim) noexcept
+{
+    list_element_base* base = detail::work_stealing_deque_base::steal_from(victim);
+    return base != nullptr ? &from_base<T, Tag>(*base) : nullptr;
+}
+
+template <typename T, typename Tag>
+std::size_t intrusive::work_stealing_deque<T, Tag>::size() const noexcept
+{
+    return detail::work_stealing_deque_base::size();
+}
+
+template <typename T, typename Tag>
+bool intrusive::work_stealing_deque<T, Tag>::empty() const noexcept
+{
+    return detail::work_stealing_deque_base::size() == 0;
+}
+
+#ifdef INTRUSIVE_LIST_HEADER_ONLY
+#include "intrusive_work_stealing_deque.cpp"
+#endif
@@ -0,0 +1,221 @@
+#include <gtest/gtest.h>
+#include "intrusive_lazy_list.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct lnode : intrusive::lazy_list_element<>
+    {
+        explicit lnode(int value = 0)
+            : value(value)
+        {}
+
+        int value;
+    };
+
+    using llist = intrusive::lazy_list<lnode>;
+
+    std::vector<int> values(llist const& list)
+    {
+        std::vector<int> result;
+        for (lnode const& x : list)
+            result.push_back(x.value);
+        return result;
+    }
+}
+
+TEST(intrusive_lazy_list_testing, push_and_iterate)
+{
+    lnode a(1), b(2), c(3), d(4);
+    llist list;
+    EXPECT_TRUE(list.empty());
+    list.push_back(b);
+    list.push_back(d);
+    list.push_front(a);
+    auto it = list.begin();
+    ++it;
+    ++it;
+    EXPECT_EQ(&c, &*list.insert(it, c));
+    EXPECT_EQ((std::vector<int>{1, 2, 3, 4}), values(list));
+    EXPECT_EQ(4u, list.size());
+    EXPECT_TRUE(a.is_linked());
+    EXPECT_FALSE(a.is_tombstone());
+}
+
+TEST(intrusive_lazy_list_testing, unlink_marks_and_iterators_skip)
+{
+    std::vector<std::unique_ptr<lnode>> nodes;
+    for (int i = 0; i != 10; ++i)
+        nodes.push_back(std::make_unique<lnode>(i));
+    llist list;
+    for (auto& x : nodes)
+        list.push_back(*x);
+
+    for (int i : {0, 3, 4, 5, 9})
+        nodes[i]->unlink();
+    nodes[3]->unlink();
+
+    EXPECT_TRUE(nodes[3]->is_linked());
+    EXPECT_TRUE(nodes[3]->is_tombstone());
+    EXPECT_EQ(5u, list.pending());
+    EXPECT_EQ((std::vector<int>{1, 2, 6, 7, 8}), values(list));
+    EXPECT_EQ(5u, list.size());
+    EXPECT_EQ(5u, list.pending());
+
+    EXPECT_EQ(5u, list.compact());
+    EXPECT_EQ(0u, list.pending());
+    EXPECT_EQ(5u, list.reclaimed());
+    EXPECT_FALSE(nodes[3]->is_linked());
+    EXPECT_FALSE(nodes[3]->is_tombstone());
+    EXPECT_EQ((std::vector<int>{1, 2, 6, 7, 8}), values(list));
+    EXPECT_EQ(0u, list.compact());
+
+    list.push_back(*nodes[4]);
+    EXPECT_EQ((std::vector<int>{1, 2, 6, 7, 8, 4}), values(list));
+}
+
+TEST(intrusive_lazy_list_testing, for_each_reclaims)
+{
+    std::vector<std::unique_ptr<lnode>> nodes;
+    for (int i = 0; i != 8; ++i)
+        nodes.push_back(std::make_unique<lnode>(i));
+    llist list;
+    for (auto& x : nodes)
+        list.push_back(*x);
+
+    nodes[1]->unlink();
+    nodes[2]->unlink();
+    nodes[7]->unlink();
+
+    std::vector<int> seen;
+    list.for_each([&](lnode& x) {
+        seen.push_back(x.value);
+        if (x.value == 3)
+        {
+            x.unlink();
+            nodes[4]->unlink();
+        }
+    });
+    EXPECT_EQ((std::vector<int>{0, 3, 5, 6}), seen);
+    EXPECT_EQ(4u, list.reclaimed());
+    EXPECT_EQ(1u, list.pending());
+    EXPECT_FALSE(nodes[4]->is_linked());
+    EXPECT_TRUE(nodes[3]->is_tombstone());
+
+    EXPECT_EQ(1u, list.compact());
+    EXPECT_EQ((std::vector<int>{0, 5, 6}), values(list));
+}
+
+TEST(intrusive_lazy_list_testing, erase_pop_and_dispose)
+{
+    lnode a(1), b(2), c(3), d(4);
+    llist list;
+    list.push_back(a);
+    list.push_back(b);
+    list.push_back(c);
+    list.push_back(d);
+
+    b.unlink();
+    list.erase(b);
+    EXPECT_FALSE(b.is_linked());
+    EXPECT_EQ(1u, list.reclaimed());
+    EXPECT_EQ(0u, list.pending());
+
+    a.unlink();
+    EXPECT_EQ(&c, list.pop_front());
+    EXPECT_FALSE(a.is_linked());
+    EXPECT_FALSE(c.is_linked());
+    EXPECT_EQ(2u, list.reclaimed());
+
+    list.erase(d);
+    EXPECT_EQ(nullptr, list.pop_front());
+    EXPECT_TRUE(list.empty());
+
+    auto* e = new lnode(5);
+    auto* f = new lnode(6);
+    list.push_back(*e);
+    list.push_back(a);
+    list.push_back(*f);
+    e->unlink();
+    f->unlink();
+    int disposed = 0;
+    EXPECT_EQ(2u, list.compact_and_dispose([&](lnode* x) {
+        EXPECT_FALSE(x->is_linked());
+        ++disposed;
+        delete x;
+    }));
+    EXPECT_EQ(2, disposed);
+    EXPECT_EQ((std::vector<int>{1}), values(list));
+
+    a.unlink();
+    EXPECT_TRUE(list.empty());
+    list.clear();
+    EXPECT_FALSE(a.is_linked());
+    EXPECT_EQ(0u, list.pending());
+}
+
+TEST(intrusive_lazy_list_testing, cancel_from_other_threads)
+{
+    constexpr int n = 20000;
+    constexpr int threads = 4;
+    auto nodes = std::make_unique<lnode[]>(n);
+    llist list;
+    for (int i = 0; i != n; ++i)
+    {
+        nodes[i].value = i;
+        list.push_back(nodes[i]);
+    }
+
+    std::atomic<int> finished{0};
+    std::vector<std::thread> cancellers;
+    for (int t = 0; t != threads; ++t)
+        cancellers.emplace_back([&, t] {
+            for (int i = t; i < n; i += threads)
+                if (i % 3 != 0)
+                    nodes[i].unlink();
+            finished.fetch_add(1);
+        });
+
+    std::size_t visits = 0;
+    while (finished.load() != threads)
+        list.for_each([&](lnode& x) { visits += std::size_t(x.value >= 0); });
+    for (std::thread& t : cancellers)
+        t.join();
+    list.compact();
+
+    EXPECT_EQ(std::size_t(n - (n + 2) / 3), list.reclaimed());
+    EXPECT_EQ(std::size_t((n + 2) / 3), list.size());
+    EXPECT_EQ(0u, list.pending());
+    for (int i = 0; i != n; ++i)
+        EXPECT_EQ(i % 3 == 0, nodes[i].is_linked());
+    list.clear();
+    EXPECT_LE(std::size_t((n + 2) / 3), visits);
+}
+
+TEST(intrusive_lazy_list_testing, clear_while_cancelling)
+{
+    constexpr int n = 20000;
+    constexpr int threads = 4;
+    auto nodes = std::make_unique<lnode[]>(n);
+    llist list;
+    for (int i = 0; i != n; ++i)
+        list.push_back(nodes[i]);
+
+    std::vector<std::thread> cancellers;
+    for (int t = 0; t != threads; ++t)
+        cancellers.emplace_back([&, t] {
+            for (int i = t; i < n; i += threads)
+                nodes[i].unlink();
+        });
+    list.clear();
+    for (std::thread& t : cancellers)
+        t.join();
+
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(0u, list.pending());
+    for (int i = 0; i != n; ++i)
+        EXPECT_FALSE(nodes[i].is_linked());
+}
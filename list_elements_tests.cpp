@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include "intrusive_list_elements.h"
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    struct tag_a;
+    struct tag_b;
+    struct tag_c;
+    struct tag_d;
+
+    struct mnode : intrusive::list_elements<tag_a, tag_b, tag_c>
+    {
+        explicit mnode(int value)
+            : value(value)
+        {}
+
+        int value;
+    };
+
+    struct aligned_node : intrusive::basic_list_elements<64, tag_a, tag_b, tag_c>
+    {
+        int value = 0;
+    };
+
+    struct mixed_node : intrusive::list_elements<tag_a, tag_b>, intrusive::list_element<tag_d>
+    {
+        explicit mixed_node(int value)
+            : value(value)
+        {}
+
+        int value;
+    };
+
+    template <typename List>
+    std::vector<int> values(List const& list)
+    {
+        std::vector<int> result;
+        for (auto const& x : list)
+            result.push_back(x.value);
+        return result;
+    }
+
+    template <typename Tag, typename T>
+    std::uintptr_t hook_address(T& obj)
+    {
+        return reinterpret_cast<std::uintptr_t>(&intrusive::to_base<Tag>(obj));
+    }
+}
+
+TEST(intrusive_list_elements_testing, layout)
+{
+    static_assert(sizeof(intrusive::list_elements<tag_a, tag_b, tag_c>) == 3 * sizeof(intrusive::list_element_base));
+    static_assert(alignof(aligned_node) == 64);
+    static_assert(sizeof(aligned_node) == 64);
+
+    mnode x(1);
+    auto base = reinterpret_cast<std::uintptr_t>(static_cast<intrusive::list_elements<tag_a, tag_b, tag_c>*>(&x));
+    EXPECT_EQ(base, hook_address<tag_a>(x));
+    EXPECT_EQ(base + sizeof(intrusive::list_element_base), hook_address<tag_b>(x));
+    EXPECT_EQ(base + 2 * sizeof(intrusive::list_element_base), hook_address<tag_c>(x));
+
+    aligned_node y;
+    EXPECT_EQ(0u, hook_address<tag_a>(y) % 64);
+    EXPECT_EQ(hook_address<tag_a>(y) / 64, hook_address<tag_c>(y) / 64);
+}
+
+TEST(intrusive_list_elements_testing, independent_lists)
+{
+    intrusive::list<mnode, tag_a> list_a;
+    intrusive::list<mnode, tag_b> list_b;
+    intrusive::list<mnode, tag_c> list_c;
+    mnode x(1), y(2), z(3);
+
+    list_a.push_back(x);
+    list_a.push_back(y);
+    list_a.push_back(z);
+    list_b.push_back(z);
+    list_b.push_back(y);
+    list_b.push_back(x);
+    list_c.push_back(y);
+
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), values(list_a));
+    EXPECT_EQ((std::vector<int>{3, 2, 1}), values(list_b));
+    EXPECT_EQ((std::vector<int>{2}), values(list_c));
+
+    list_a.erase(list_a.iterator_to(y));
+    list_b.sort([](mnode const& a, mnode const& b) { return a.value < b.value; });
+    EXPECT_EQ((std::vector<int>{1, 3}), values(list_a));
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), values(list_b));
+    EXPECT_TRUE(y.is_linked<tag_b>());
+    EXPECT_FALSE(y.is_linked<tag_a>());
+    EXPECT_TRUE(y.is_linked<tag_c>());
+}
+
+TEST(intrusive_list_elements_testing, destructor_unlinks_all_tags)
+{
+    intrusive::list<mnode, tag_a> list_a;
+    intrusive::list<mnode, tag_b> list_b;
+    intrusive::list<mnode, tag_c> list_c;
+    mnode x(1), z(3);
+    {
+        mnode y(2);
+        list_a.push_back(x);
+        list_a.push_back(y);
+        list_a.push_back(z);
+        list_b.push_back(y);
+        list_c.push_back(z);
+        list_c.push_back(y);
+    }
+    EXPECT_EQ((std::vector<int>{1, 3}), values(list_a));
+    EXPECT_TRUE(list_b.empty());
+    EXPECT_EQ((std::vector<int>{3}), values(list_c));
+
+    {
+        mnode unlinked(4);
+    }
+}
+
+TEST(intrusive_list_elements_testing, unlink_one_tag)
+{
+    intrusive::list<mnode, tag_a> list_a;
+    intrusive::list<mnode, tag_b> list_b;
+    mnode x(1), y(2);
+    list_a.push_back(x);
+    list_a.push_back(y);
+    list_b.push_back(x);
+
+    x.unlink<tag_a>();
+    EXPECT_FALSE(x.is_linked<tag_a>());
+    EXPECT_TRUE(x.is_linked<tag_b>());
+    EXPECT_EQ((std::vector<int>{2}), values(list_a));
+    EXPECT_EQ((std::vector<int>{1}), values(list_b));
+
+    list_a.push_front(x);
+    EXPECT_EQ((std::vector<int>{1, 2}), values(list_a));
+}
+
+TEST(intrusive_list_elements_testing, mixed_with_list_element)
+{
+    intrusive::list<mixed_node, tag_a> list_a;
+    intrusive::list<mixed_node, tag_b> list_b;
+    intrusive::list<mixed_node, tag_d> list_d;
+    mixed_node x(1);
+    {
+        mixed_node y(2);
+        list_a.push_back(x);
+        list_a.push_back(y);
+        list_b.push_back(y);
+        list_d.push_back(y);
+        list_d.push_back(x);
+        EXPECT_EQ((std::vector<int>{2, 1}), values(list_d));
+    }
+    EXPECT_EQ((std::vector<int>{1}), values(list_a));
+    EXPECT_TRUE(list_b.empty());
+    EXPECT_EQ((std::vector<int>{1}), values(list_d));
+}
@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+#include "intrusive_list_index.h"
+#include "test_utils.h"
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+    struct inode : intrusive::list_element<>
+    {
+        int value = 0;
+    };
+
+    using ilist = intrusive::list<inode>;
+    using index_type = intrusive::list_index<ilist>;
+
+    void expect_same(ilist& list, index_type& index, std::vector<inode*> const& expected)
+    {
+        ASSERT_EQ(expected.size(), index.size());
+        std::size_t i = 0;
+        for (inode& x : list)
+        {
+            ASSERT_LT(i, expected.size());
+            EXPECT_EQ(expected[i], &x);
+            ++i;
+        }
+        EXPECT_EQ(expected.size(), i);
+        for (std::size_t k = 0; k != expected.size(); ++k)
+            EXPECT_EQ(expected[k], &*index.nth(k));
+        EXPECT_TRUE(index.nth(expected.size()) == list.end());
+    }
+}
+
+TEST(intrusive_list_index_testing, empty)
+{
+    ilist list;
+    index_type index(list);
+    EXPECT_EQ(0u, index.size());
+    EXPECT_TRUE(index.nth(0) == list.end());
+
+    auto r = index.slice(0, 10);
+    EXPECT_TRUE(r.first == list.end());
+    EXPECT_EQ(0u, r.size);
+
+    ilist rest;
+    index.split_at(0, rest);
+    EXPECT_TRUE(rest.empty());
+}
+
+TEST(intrusive_list_index_testing, build_from_existing_list)
+{
+    auto nodes = make_nodes<inode>(1000);
+    ilist list;
+    std::vector<inode*> expected;
+    for (std::size_t i = 0; i != 1000; ++i)
+    {
+        list.push_back(nodes[i]);
+        expected.push_back(&nodes[i]);
+    }
+
+    index_type index(list, 16);
+    expect_same(list, index, expected);
+
+    auto r = index.slice(100, 250);
+    EXPECT_EQ(150u, r.size);
+    EXPECT_EQ(&nodes[100], &*r.first);
+    EXPECT_EQ(&nodes[250], &*r.last);
+    EXPECT_EQ(150, std::distance(r.first, r.last));
+}
+
+TEST(intrusive_list_index_testing, positional_edits)
+{
+    auto nodes = make_nodes<inode>(2000);
+    ilist list;
+    index_type index(list, 4);
+    std::vector<inode*> expected;
+    std::mt19937 rng(17);
+    std::size_t used = 0;
+
+    for (int step = 0; step != 4000; ++step)
+    {
+        if (expected.empty() && used == 2000)
+            break;
+
+        bool insert = used != 2000 && (expected.empty() || rng() % 3 != 0);
+        if (insert)
+        {
+            std::size_t k = rng() % (expected.size() + 1);
+            inode& x = nodes[used++];
+            EXPECT_EQ(&x, &*index.insert_at(k, x));
+            expected.insert(expected.begin() + std::ptrdiff_t(k), &x);
+        }
+        else
+        {
+            std::size_t k = rng() % expected.size();
+            index.erase_at(k);
+            expected.erase(expected.begin() + std::ptrdiff_t(k));
+        }
+
+        if (step % 97 == 0)
+            expect_same(list, index, expected);
+    }
+    expect_same(list, index, expected);
+    list.clear();
+}
+
+TEST(intrusive_list_index_testing, push_pop)
+{
+    auto nodes = make_nodes<inode>(10);
+    ilist list;
+    index_type index(list, 1);
+    std::vector<inode*> expected;
+
+    for (std::size_t i = 0; i != 5; ++i)
+    {
+        index.push_back(nodes[i]);
+        expected.push_back(&nodes[i]);
+    }
+    for (std::size_t i = 5; i != 10; ++i)
+    {
+        index.push_front(nodes[i]);
+        expected.insert(expected.begin(), &nodes[i]);
+    }
+    expect_same(list, index, expected);
+
+    index.pop_front();
+    index.pop_back();
+    expected.erase(expected.begin());
+    expected.pop_back();
+    expect_same(list, index, expected);
+}
+
+TEST(intrusive_list_index_testing, split_at)
+{
+    for (std::size_t k : {0, 1, 7, 8, 9, 63, 64, 100})
+    {
+        auto nodes = make_nodes<inode>(100);
+        ilist list;
+        for (std::size_t i = 0; i != 100; ++i)
+            list.push_back(nodes[i]);
+        index_type index(list, 8);
+
+        ilist rest;
+        index.split_at(k, rest);
+
+        std::vector<inode*> head;
+        for (std::size_t i = 0; i != k; ++i)
+            head.push_back(&nodes[i]);
+        expect_same(list, index, head);
+
+        std::size_t i = k;
+        for (inode& x : rest)
+            EXPECT_EQ(&nodes[i++], &x);
+        EXPECT_EQ(100u, i);
+
+        if (!rest.empty())
+        {
+            inode& x = rest.front();
+            rest.pop_front();
+            index.push_back(x);
+            head.push_back(&x);
+            expect_same(list, index, head);
+        }
+
+        rest.clear();
+        list.clear();
+    }
+}
+
+TEST(intrusive_list_index_testing, invalidate_after_direct_changes)
+{
+    auto nodes = make_nodes<inode>(50);
+    ilist list;
+    for (std::size_t i = 0; i != 40; ++i)
+        list.push_back(nodes[i]);
+    index_type index(list, 4);
+
+    std::vector<inode*> expected;
+    for (std::size_t i = 0; i != 40; ++i)
+        expected.push_back(&nodes[i]);
+
+    nodes[3].unlink();
+    expected.erase(expected.begin() + 3);
+    list.push_front(nodes[45]);
+    expected.insert(expected.begin(), &nodes[45]);
+    index.invalidate();
+    expect_same(list, index, expected);
+}
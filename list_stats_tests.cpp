@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include "intrusive_list.h"
+#include <memory>
+#include <vector>
+
+namespace
+{
+    struct stats_tag;
+    struct aggregate_tag;
+    struct histogram_tag;
+
+    struct snode : intrusive::list_element<stats_tag, intrusive::safe_link>
+                 , intrusive::list_element<aggregate_tag, intrusive::safe_link>
+                 , intrusive::list_element<histogram_tag, intrusive::safe_link>
+    {
+        explicit snode(int value = 0)
+            : value(value)
+        {}
+
+        int value;
+    };
+
+    struct normal_node : intrusive::list_element<stats_tag, intrusive::normal_link>
+    {};
+
+    using stats_list = intrusive::list<snode, stats_tag, intrusive::list_stats<>>;
+}
+
+TEST(intrusive_list_stats_testing, zero_cost_when_off)
+{
+    EXPECT_EQ(2 * sizeof(void*), sizeof(intrusive::list<snode, stats_tag>));
+    EXPECT_GT(sizeof(stats_list), sizeof(intrusive::list<snode, stats_tag>));
+}
+
+TEST(intrusive_list_stats_testing, counts_operations)
+{
+    std::vector<snode> nodes(10);
+    stats_list a;
+    for (int i = 0; i != 6; ++i)
+        a.push_back(nodes[i]);
+    a.pop_front();
+    a.erase(std::next(a.begin()), std::next(a.begin(), 3));
+
+    EXPECT_EQ(6u, a.stats().links);
+    EXPECT_EQ(3u, a.stats().unlinks);
+    EXPECT_EQ(3u, a.stats().length);
+    EXPECT_EQ(6u, a.stats().high_watermark);
+
+    stats_list b;
+    b.insert(b.end(), nodes.begin() + 6, nodes.end());
+    a.splice(a.end(), b, b.begin(), b.end());
+    EXPECT_EQ(1u, a.stats().splices);
+    EXPECT_EQ(4u, a.stats().spliced_elements);
+    EXPECT_EQ(7u, a.stats().length);
+    EXPECT_EQ(0u, b.stats().length);
+    EXPECT_EQ(4u, b.stats().links);
+
+    a.clear();
+    EXPECT_EQ(1u, a.stats().clears);
+    EXPECT_EQ(7u, a.stats().cleared_elements);
+    EXPECT_EQ(0u, a.stats().length);
+    EXPECT_EQ(7u, a.stats().high_watermark);
+
+    for (int i = 0; i != 3; ++i)
+        a.push_back(nodes[i]);
+    a.clear_and_dispose([](snode*) {});
+    EXPECT_EQ(2u, a.stats().clears);
+    EXPECT_EQ(10u, a.stats().cleared_elements);
+}
+
+TEST(intrusive_list_stats_testing, normal_link_clear_walks_nothing)
+{
+    normal_node nodes[4];
+    intrusive::list<normal_node, stats_tag, intrusive::list_stats<>> list;
+    for (normal_node& n : nodes)
+        list.push_back(n);
+    list.clear();
+    EXPECT_EQ(1u, list.stats().clears);
+    EXPECT_EQ(0u, list.stats().cleared_elements);
+    EXPECT_EQ(4u, list.stats().high_watermark);
+}
+
+TEST(intrusive_list_stats_testing, traversal_histogram)
+{
+    std::vector<snode> nodes(100);
+    intrusive::list<snode, histogram_tag, intrusive::list_stats<true>> list;
+
+    auto walk = [&] {
+        int sum = 0;
+        for (snode& x : list.tracked())
+            sum += x.value + 1;
+        return sum;
+    };
+
+    EXPECT_EQ(0, walk());
+    list.push_back(nodes[0]);
+    EXPECT_EQ(1, walk());
+    for (int i = 1; i != 5; ++i)
+        list.push_back(nodes[i]);
+    EXPECT_EQ(5, walk());
+    for (int i = 5; i != 100; ++i)
+        list.push_back(nodes[i]);
+    EXPECT_EQ(100, walk());
+
+    auto const& h = list.stats().traversals;
+    EXPECT_EQ(1u, h[0]);
+    EXPECT_EQ(1u, h[1]);
+    EXPECT_EQ(1u, h[3]);
+    EXPECT_EQ(1u, h[7]);
+    list.clear();
+}
+
+TEST(intrusive_list_stats_testing, aggregated_per_tag)
+{
+    std::vector<snode> nodes(8);
+    intrusive::list_statistics before = intrusive::tag_statistics<aggregate_tag>();
+    {
+        intrusive::list<snode, aggregate_tag, intrusive::list_stats<>> a, b;
+        for (int i = 0; i != 3; ++i)
+            a.push_back(nodes[i]);
+        for (int i = 3; i != 8; ++i)
+            b.push_back(nodes[i]);
+
+        a.publish_stats();
+        EXPECT_EQ(0u, a.stats().links);
+        EXPECT_EQ(3u, a.stats().length);
+        EXPECT_EQ(before.links + 3, intrusive::tag_statistics<aggregate_tag>().links);
+    }
+
+    intrusive::list_statistics after = intrusive::tag_statistics<aggregate_tag>();
+    EXPECT_EQ(before.links + 8, after.links);
+    EXPECT_EQ(before.clears + 2, after.clears);
+    EXPECT_EQ(before.cleared_elements + 8, after.cleared_elements);
+    EXPECT_LE(5u, after.high_watermark);
+}
@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+#include "intrusive_lru_cache.h"
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct entry : intrusive::lru_cache_element<>
+    {
+        explicit entry(int key)
+            : key(key)
+        {}
+
+        int key;
+    };
+
+    struct named : intrusive::lru_cache_element<>
+    {
+        explicit named(std::string name)
+            : name(std::move(name))
+        {}
+
+        std::string name;
+    };
+
+    struct name_of
+    {
+        std::string const& operator()(named const& x) const noexcept
+        {
+            return x.name;
+        }
+    };
+
+    struct bad_hash
+    {
+        std::size_t operator()(int) const noexcept
+        {
+            return 7;
+        }
+    };
+
+    using cache = intrusive::lru_cache<int, entry>;
+    using clock_cache = intrusive::lru_cache<int, entry, intrusive::default_tag, intrusive::clock_replacement>;
+
+    template <typename C>
+    std::vector<int> evict_all(C& c)
+    {
+        std::vector<int> result;
+        c.clear_and_dispose([&](entry* e) { result.push_back(e->key); });
+        return result;
+    }
+
+    template <typename C>
+    std::vector<int> evict_n(C& c, int n)
+    {
+        std::vector<int> result;
+        for (int i = 0; i != n; ++i)
+            c.evict_lru([&](entry* e) { result.push_back(e->key); });
+        return result;
+    }
+}
+
+TEST(intrusive_lru_cache_testing, insert_find_peek)
+{
+    cache c(16);
+    EXPECT_TRUE(c.empty());
+    entry a(1), b(2), dup(1);
+    EXPECT_TRUE(c.insert(a));
+    EXPECT_TRUE(c.insert(b));
+    EXPECT_FALSE(c.insert(dup));
+    EXPECT_FALSE(dup.is_linked());
+    EXPECT_EQ(2u, c.size());
+
+    EXPECT_EQ(&a, c.find(1));
+    EXPECT_EQ(&b, c.peek(2));
+    EXPECT_EQ(nullptr, c.find(3));
+    EXPECT_EQ(nullptr, c.peek(3));
+
+    c.erase(a);
+    EXPECT_FALSE(a.is_linked());
+    EXPECT_EQ(nullptr, c.find(1));
+    EXPECT_EQ(1u, c.size());
+    evict_all(c);
+}
+
+TEST(intrusive_lru_cache_testing, evicts_least_recently_used)
+{
+    cache c(16);
+    entry a(1), b(2), d(3);
+    c.insert(a);
+    c.insert(b);
+    c.insert(d);
+
+    c.find(1);
+    EXPECT_EQ((std::vector<int>{2}), evict_n(c, 1));
+    c.peek(3);
+    EXPECT_EQ((std::vector<int>{3, 1}), evict_n(c, 2));
+    EXPECT_TRUE(c.empty());
+    EXPECT_FALSE(c.evict_lru([](entry*) { FAIL(); }));
+}
+
+TEST(intrusive_lru_cache_testing, touch_first_is_noop)
+{
+    cache c(16);
+    entry a(1), b(2);
+    c.insert(a);
+    c.insert(b);
+    c.touch(b);
+    c.touch(a);
+    c.touch(a);
+    EXPECT_EQ((std::vector<int>{2, 1}), evict_all(c));
+}
+
+TEST(intrusive_lru_cache_testing, evict_to_budget)
+{
+    cache c(16);
+    std::deque<entry> entries;
+    for (int i = 0; i != 5; ++i)
+    {
+        entries.emplace_back(i);
+        c.insert(entries.back(), 100);
+    }
+    EXPECT_EQ(500u, c.charge());
+
+    std::vector<int> evicted;
+    EXPECT_EQ(3u, c.evict_to(250, [&](entry* e) { evicted.push_back(e->key); }));
+    EXPECT_EQ((std::vector<int>{0, 1, 2}), evicted);
+    EXPECT_EQ(200u, c.charge());
+    EXPECT_EQ(0u, c.evict_to(200, [](entry*) { FAIL(); }));
+    evict_all(c);
+    EXPECT_EQ(0u, c.charge());
+}
+
+TEST(intrusive_lru_cache_testing, collisions)
+{
+    intrusive::lru_cache<int, entry, intrusive::default_tag, intrusive::hash<bad_hash>> c(1);
+    entry a(1), b(2), d(3);
+    c.insert(a);
+    c.insert(b);
+    c.insert(d);
+    EXPECT_EQ(&b, c.find(2));
+    c.erase(b);
+    EXPECT_EQ(&a, c.find(1));
+    EXPECT_EQ(&d, c.find(3));
+    EXPECT_EQ(nullptr, c.find(2));
+    evict_all(c);
+}
+
+TEST(intrusive_lru_cache_testing, custom_key)
+{
+    intrusive::lru_cache<std::string, named, intrusive::default_tag, intrusive::key_of<name_of>> c(8);
+    named a("alpha"), b("beta");
+    c.insert(a);
+    c.insert(b);
+    EXPECT_EQ(&b, c.find("beta"));
+    EXPECT_EQ(nullptr, c.find("gamma"));
+    c.clear_and_dispose([](named*) {});
+    EXPECT_FALSE(a.is_linked());
+}
+
+TEST(intrusive_lru_cache_testing, clock_second_chance)
+{
+    clock_cache c(16);
+    entry a(1), b(2), d(3);
+    c.insert(a);
+    c.insert(b);
+    c.insert(d);
+
+    /*
+    Попадание не меняет порядок, а только ставит бит: 1 получает второй
+    шанс и уходит в начало, вытесняется 2.
+    */
+    EXPECT_EQ(&a, c.find(1));
+    EXPECT_EQ((std::vector<int>{2}), evict_n(c, 1));
+
+    EXPECT_EQ(&d, c.find(3));
+    EXPECT_EQ(&a, c.find(1));
+    EXPECT_EQ((std::vector<int>{3, 1}), evict_n(c, 2));
+    EXPECT_TRUE(c.empty());
+}
+
+TEST(intrusive_lru_cache_testing, destructor_unlinks)
+{
+    entry a(1);
+    {
+        cache c(4);
+        c.insert(a);
+    }
+    EXPECT_FALSE(a.is_linked());
+}
@@ -1,8 +1,11 @@
 #include <gtest/gtest.h>
 #include "intrusive_list.h"
 #include "test_utils.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
 
-struct node : intrusive::list_element<>
+struct node : intrusive::list_element<intrusive::default_tag, test_link>
 {
     explicit node(int value)
         : value(value)
@@ -840,7 +843,7 @@ TEST(intrusive_list_testing, iterator_deref_2c)
     expect_eq(list, {1, 42, 3});
 }
 
-struct multi_node : intrusive::list_element<struct tag_a>, intrusive::list_element<struct tag_b>
+struct multi_node : intrusive::list_element<struct tag_a, test_link>, intrusive::list_element<struct tag_b, test_link>
 {
     explicit multi_node(int value)
         : value(value)
@@ -862,8 +865,492 @@ TEST(intrusive_list_testing, multiple_tags)
     expect_eq(list_b, {3, 2, 1});
 }
 
+struct normal_node : intrusive::list_element<intrusive::default_tag, intrusive::normal_link, test_link>
+{
+    explicit normal_node(int value)
+        : value(value)
+    {}
+
+    int value;
+};
+
+struct safe_node : intrusive::list_element<intrusive::default_tag, intrusive::safe_link, test_link>
+{
+    explicit safe_node(int value)
+        : value(value)
+    {}
+
+    int value;
+};
+
+TEST(intrusive_list_testing, normal_link_clear)
+{
+    normal_node a(1), b(2), c(3);
+    intrusive::list<normal_node> list;
+    mass_push_back(list, a, b, c);
+    list.clear();
+    EXPECT_TRUE(list.empty());
+    mass_push_back(list, c, b);
+    expect_eq(list, {3, 2});
+}
+
+TEST(intrusive_list_testing, normal_link_erase)
+{
+    normal_node a(1), b(2), c(3), d(4);
+    intrusive::list<normal_node> list;
+    mass_push_back(list, a, b, c, d);
+    auto it = list.erase(std::next(list.begin()));
+    EXPECT_EQ(3, it->value);
+    list.pop_front();
+    list.pop_back();
+    expect_eq(list, {3});
+    list.push_front(a);
+    expect_eq(list, {1, 3});
+}
+
+TEST(intrusive_list_testing, normal_link_move_operator)
+{
+    normal_node a(1), b(2), c(3);
+    normal_node d(4), e(5), f(6);
+    intrusive::list<normal_node> list1, list2;
+    mass_push_back(list1, a, b, c);
+    mass_push_back(list2, d, e, f);
+    list1 = std::move(list2);
+    expect_eq(list1, {4, 5, 6});
+    EXPECT_TRUE(list2.empty());
+    mass_push_back(list2, a, b, c);
+    expect_eq(list2, {1, 2, 3});
+}
+
+TEST(intrusive_list_testing, safe_link_clear)
+{
+    safe_node a(1), b(2), c(3);
+    intrusive::list<safe_node> list;
+    mass_push_back(list, a, b, c);
+    list.clear();
+    EXPECT_TRUE(list.empty());
+}
+
+TEST(intrusive_list_testing, safe_link_erase)
+{
+    safe_node a(1), b(2), c(3);
+    {
+        intrusive::list<safe_node> list;
+        mass_push_back(list, a, b, c);
+        list.erase(std::next(list.begin()));
+        expect_eq(list, {1, 3});
+    }
+    intrusive::list<safe_node> list;
+    mass_push_back(list, c, b, a);
+    expect_eq(list, {3, 2, 1});
+}
+
+using counted_list = intrusive::list<safe_node, intrusive::default_tag, intrusive::constant_time_size>;
+
+TEST(intrusive_list_testing, size_uncounted)
+{
+    intrusive::list<node> list;
+    node a(1), b(2), c(3);
+    EXPECT_EQ(0u, list.size());
+    mass_push_back(list, a, b, c);
+    EXPECT_EQ(3u, list.size());
+    b.unlink();
+    EXPECT_EQ(2u, list.size());
+}
+
+TEST(intrusive_list_testing, size_counted_push_pop)
+{
+    safe_node a(1), b(2), c(3), d(4);
+    counted_list list;
+    EXPECT_EQ(0u, list.size());
+    mass_push_back(list, b, c);
+    list.push_front(a);
+    list.insert(list.end(), d);
+    EXPECT_EQ(4u, list.size());
+    list.pop_back();
+    list.pop_front();
+    EXPECT_EQ(2u, list.size());
+    list.erase(list.begin());
+    EXPECT_EQ(1u, list.size());
+    list.clear();
+    EXPECT_EQ(0u, list.size());
+    EXPECT_TRUE(list.empty());
+}
+
+TEST(intrusive_list_testing, size_counted_move)
+{
+    safe_node a(1), b(2), c(3), d(4);
+    counted_list list1;
+    mass_push_back(list1, a, b, c);
+    counted_list list2 = std::move(list1);
+    EXPECT_EQ(0u, list1.size());
+    EXPECT_EQ(3u, list2.size());
+
+    counted_list list3;
+    list3.push_back(d);
+    list3 = std::move(list2);
+    EXPECT_EQ(0u, list2.size());
+    EXPECT_EQ(3u, list3.size());
+    expect_eq(list3, {1, 2, 3});
+}
+
+TEST(intrusive_list_testing, size_counted_splice)
+{
+    safe_node a(1), b(2), c(3), d(4), e(5), f(6);
+    counted_list c1, c2;
+    mass_push_back(c1, a, b, c);
+    mass_push_back(c2, d, e, f);
+
+    c1.splice(c1.end(), c2, std::next(c2.begin()), c2.end());
+    EXPECT_EQ(5u, c1.size());
+    EXPECT_EQ(1u, c2.size());
+
+    c2.splice(c2.begin(), c1, c1.begin(), std::next(c1.begin(), 2), 2);
+    EXPECT_EQ(3u, c1.size());
+    EXPECT_EQ(3u, c2.size());
+    expect_eq(c1, {3, 5, 6});
+    expect_eq(c2, {1, 2, 4});
+
+    c1.splice(c1.begin(), c1, std::next(c1.begin()), c1.end());
+    EXPECT_EQ(3u, c1.size());
+    expect_eq(c1, {5, 6, 3});
+
+    c1.splice(c1.end(), c2, c2.begin(), c2.end());
+    EXPECT_EQ(6u, c1.size());
+    EXPECT_EQ(0u, c2.size());
+    c1.clear();
+}
+
+TEST(intrusive_list_testing, is_linked)
+{
+    node a(1), b(2);
+    EXPECT_FALSE(a.is_linked());
+    intrusive::list<node> list;
+    mass_push_back(list, a, b);
+    EXPECT_TRUE(a.is_linked());
+    list.pop_front();
+    EXPECT_FALSE(a.is_linked());
+    EXPECT_TRUE(b.is_linked());
+    list.clear();
+    EXPECT_FALSE(b.is_linked());
+}
+
+TEST(intrusive_list_testing, iterator_to)
+{
+    intrusive::list<node> list;
+    node a(1), b(2), c(3), d(4);
+    mass_push_back(list, a, b, c);
+
+    auto it = intrusive::list<node>::iterator_to(b);
+    EXPECT_EQ(&b, &*it);
+    EXPECT_TRUE(it == std::next(list.begin()));
+    list.insert(it, d);
+    expect_eq(list, {1, 4, 2, 3});
+
+    intrusive::list<node>::const_iterator cit = intrusive::list<node>::iterator_to(std::as_const(c));
+    EXPECT_EQ(3, cit->value);
+    list.erase(cit);
+    expect_eq(list, {1, 4, 2});
+}
+
+TEST(intrusive_list_testing, iterator_to_splice)
+{
+    intrusive::list<node> c1, c2;
+    node a(1), b(2), c(3), d(4);
+    mass_push_back(c1, a, b);
+    mass_push_back(c2, c, d);
+    auto first = intrusive::list<node>::iterator_to(d);
+    c1.splice(intrusive::list<node>::iterator_to(b), c2, first, std::next(first));
+    expect_eq(c1, {1, 4, 2});
+    expect_eq(c2, {3});
+}
+
+TEST(intrusive_list_testing, erase_range)
+{
+    intrusive::list<node> list;
+    node a(1), b(2), c(3), d(4), e(5);
+    mass_push_back(list, a, b, c, d, e);
+    auto it = list.erase(std::next(list.begin()), std::next(list.begin(), 4));
+    EXPECT_EQ(5, it->value);
+    expect_eq(list, {1, 5});
+    EXPECT_FALSE(b.is_linked());
+    EXPECT_FALSE(d.is_linked());
+    list.erase(list.begin(), list.begin());
+    expect_eq(list, {1, 5});
+    list.erase(list.begin(), list.end());
+    EXPECT_TRUE(list.empty());
+}
+
+TEST(intrusive_list_testing, erase_range_counted)
+{
+    safe_node a(1), b(2), c(3), d(4);
+    counted_list list;
+    mass_push_back(list, a, b, c, d);
+    list.erase(std::next(list.begin()), list.end());
+    EXPECT_EQ(1u, list.size());
+    expect_eq(list, {1});
+}
+
+TEST(intrusive_list_testing, erase_and_dispose)
+{
+    intrusive::list<node> list;
+    for (int i = 1; i <= 5; ++i)
+        list.push_back(*new node(i));
+
+    std::vector<int> disposed;
+    auto disposer = [&](node* p) {
+        disposed.push_back(p->value);
+        delete p;
+    };
+
+    auto it = list.erase_and_dispose(list.begin(), disposer);
+    EXPECT_EQ(2, it->value);
+    it = list.erase_and_dispose(std::next(it), std::prev(list.end()), disposer);
+    EXPECT_EQ(5, it->value);
+    expect_eq(list, {2, 5});
+    list.clear_and_dispose(disposer);
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ((std::vector<int>{1, 3, 4, 2, 5}), disposed);
+}
+
+TEST(intrusive_list_testing, remove_if)
+{
+    intrusive::list<node> list;
+    node a(1), b(2), c(4), d(6), e(7), f(8);
+    mass_push_back(list, a, b, c, d, e, f);
+    auto removed = list.remove_if([](node const& x) { return x.value % 2 == 0; });
+    EXPECT_EQ(4u, removed);
+    expect_eq(list, {1, 7});
+    EXPECT_FALSE(c.is_linked());
+}
+
+TEST(intrusive_list_testing, remove_and_dispose_if)
+{
+    safe_node a(1), b(2), c(3), d(4);
+    counted_list list;
+    mass_push_back(list, a, b, c, d);
+    std::vector<int> disposed;
+    auto removed = list.remove_and_dispose_if(
+        [](safe_node const& x) { return x.value != 3; },
+        [&](safe_node* p) { disposed.push_back(p->value); });
+    EXPECT_EQ(3u, removed);
+    EXPECT_EQ(1u, list.size());
+    expect_eq(list, {3});
+    EXPECT_EQ((std::vector<int>{1, 2, 4}), disposed);
+}
+
+TEST(intrusive_list_testing, insert_range)
+{
+    intrusive::list<node> list;
+    node a(1), b(5);
+    mass_push_back(list, a, b);
+    node range[] = {node(2), node(3), node(4)};
+    list.insert(std::next(list.begin()), std::begin(range), std::end(range));
+    expect_eq(list, {1, 2, 3, 4, 5});
+    list.insert(list.end(), range, range);
+    expect_eq(list, {1, 2, 3, 4, 5});
+    list.clear();
+}
+
+TEST(intrusive_list_testing, insert_range_counted)
+{
+    safe_node range[] = {safe_node(1), safe_node(2), safe_node(3)};
+    counted_list list;
+    list.insert(list.end(), std::begin(range), std::end(range));
+    EXPECT_EQ(3u, list.size());
+    expect_eq(list, {1, 2, 3});
+}
+
+TEST(intrusive_list_testing, sort_empty)
+{
+    auto less = [](node const& x, node const& y) { return x.value < y.value; };
+    intrusive::list<node> list;
+    list.sort(less);
+    EXPECT_TRUE(list.empty());
+    node a(1);
+    list.push_back(a);
+    list.sort(less);
+    expect_eq(list, {1});
+}
+
+TEST(intrusive_list_testing, sort)
+{
+    intrusive::list<node> list;
+    node a(5), b(3), c(4), d(1), e(2);
+    mass_push_back(list, a, b, c, d, e);
+    list.sort([](node const& x, node const& y) { return x.value < y.value; });
+    expect_eq(list, {1, 2, 3, 4, 5});
+    list.sort([](node const& x, node const& y) { return x.value > y.value; });
+    expect_eq(list, {5, 4, 3, 2, 1});
+}
+
+TEST(intrusive_list_testing, sort_stable)
+{
+    intrusive::list<node> list;
+    node a(31), b(12), c(33), d(14), e(25), f(11);
+    mass_push_back(list, a, b, c, d, e, f);
+    list.sort([](node const& x, node const& y) { return x.value / 10 < y.value / 10; });
+    expect_eq(list, {12, 14, 11, 25, 31, 33});
+}
+
+TEST(intrusive_list_testing, sort_large)
+{
+    std::vector<std::unique_ptr<node>> nodes;
+    intrusive::list<node> list;
+    unsigned x = 12345;
+    for (int i = 0; i != 1000; ++i)
+    {
+        x = x * 1103515245 + 12345;
+        nodes.push_back(std::make_unique<node>(int(x >> 16) % 100));
+        list.push_back(*nodes.back());
+    }
+
+    list.sort([](node const& a, node const& b) { return a.value < b.value; });
+
+    std::size_t count = 0;
+    for (auto i = list.begin(); i != list.end(); ++i, ++count)
+    {
+        if (i != list.begin())
+        {
+            EXPECT_LE(std::prev(i)->value, i->value);
+        }
+    }
+    EXPECT_EQ(1000u, count);
+}
+
+TEST(intrusive_list_testing, merge)
+{
+    intrusive::list<node> c1, c2;
+    node a(1), b(3), c(5), d(7);
+    node e(2), f(3), g(8), h(9);
+    mass_push_back(c1, a, b, c, d);
+    mass_push_back(c2, e, f, g, h);
+    auto less = [](node const& x, node const& y) { return x.value < y.value; };
+    c1.merge(c2, less);
+    expect_eq(c1, {1, 2, 3, 3, 5, 7, 8, 9});
+    EXPECT_TRUE(c2.empty());
+    EXPECT_EQ(&b, &*std::next(c1.begin(), 2));
+    c1.merge(c1, less);
+    EXPECT_EQ(8u, c1.size());
+}
+
+TEST(intrusive_list_testing, merge_counted)
+{
+    safe_node a(1), b(4), c(2), d(3);
+    counted_list c1, c2;
+    mass_push_back(c1, a, b);
+    mass_push_back(c2, c, d);
+    c1.merge(c2, [](safe_node const& x, safe_node const& y) { return x.value < y.value; });
+    EXPECT_EQ(4u, c1.size());
+    EXPECT_EQ(0u, c2.size());
+    expect_eq(c1, {1, 2, 3, 4});
+}
+
+TEST(intrusive_list_testing, unique)
+{
+    intrusive::list<node> list;
+    node a(1), b(1), c(2), d(3), e(3), f(3), g(1);
+    mass_push_back(list, a, b, c, d, e, f, g);
+    auto removed = list.unique([](node const& x, node const& y) { return x.value == y.value; });
+    EXPECT_EQ(3u, removed);
+    expect_eq(list, {1, 2, 3, 1});
+    EXPECT_FALSE(e.is_linked());
+    EXPECT_TRUE(d.is_linked());
+}
+
+struct member_node
+{
+    explicit member_node(int value)
+        : value(value)
+    {}
+
+    int value;
+    intrusive::list_element<intrusive::default_tag, test_link> hook;
+    intrusive::list_element<intrusive::default_tag, intrusive::safe_link, test_link> other_hook;
+};
+
+using member_list = intrusive::list<member_node, intrusive::member_hook<&member_node::hook, offsetof(member_node, hook)>>;
+using other_member_list = intrusive::list<member_node, intrusive::member_hook<&member_node::other_hook, offsetof(member_node, other_hook)>>;
+
+TEST(intrusive_list_testing, member_hook)
+{
+    member_list list;
+    member_node a(1), b(2), c(3);
+    mass_push_back(list, a, b, c);
+    expect_eq(list, {1, 2, 3});
+    EXPECT_EQ(&b, &*std::next(list.begin()));
+    EXPECT_EQ(&c, &list.back());
+
+    list.erase(member_list::iterator_to(b));
+    expect_eq(list, {1, 3});
+    EXPECT_FALSE(b.hook.is_linked());
+}
+
+TEST(intrusive_list_testing, member_hook_auto_unlink)
+{
+    member_list list;
+    member_node a(1);
+    {
+        member_node b(2);
+        mass_push_back(list, a, b);
+        expect_eq(list, {1, 2});
+    }
+    expect_eq(list, {1});
+}
+
+TEST(intrusive_list_testing, two_member_hooks)
+{
+    member_list list_a;
+    other_member_list list_b;
+    member_node a(1), b(2), c(3);
+    mass_push_back(list_a, a, b, c);
+    mass_push_back(list_b, c, b, a);
+
+    list_b.sort([](member_node const& x, member_node const& y) { return x.value < y.value; });
+    expect_eq(list_a, {1, 2, 3});
+    expect_eq(list_b, {1, 2, 3});
+    list_b.clear();
+    list_a.clear();
+}
+
+struct fixed_base
+{
+    int first() const
+    {
+        return 0;
+    }
+};
+
+struct member_node_with_fixed_base final : fixed_base
+{
+    explicit member_node_with_fixed_base(int value)
+        : value(value)
+    {}
+
+    intrusive::list_element<intrusive::default_tag, test_link> hook;
+    int value;
+};
+
+TEST(intrusive_list_testing, member_hook_after_base)
+{
+    using list_t = intrusive::list<member_node_with_fixed_base,
+                                   intrusive::member_hook<&member_node_with_fixed_base::hook,
+                                                          offsetof(member_node_with_fixed_base, hook)>>;
+    list_t list;
+    member_node_with_fixed_base a(1), b(2);
+    mass_push_back(list, a, b);
+    expect_eq(list, {1, 2});
+    list_t const& clist = list;
+    EXPECT_EQ(&b, &clist.back());
+    EXPECT_EQ(&a, &*list_t::iterator_to(static_cast<member_node_with_fixed_base const&>(a)));
+}
+
 int main(int argc, char** argv)
 {
     testing::InitGoogleTest(&argc, argv);
+#ifdef INTRUSIVE_LIST_TESTING_INDEX_LINK
+    return run_all_tests_in_arena();
+#else
     return RUN_ALL_TESTS();
+#endif
 }
@@ -0,0 +1,254 @@
+#include <gtest/gtest.h>
+#include "intrusive_mpsc_queue.h"
+#include "test_utils.h"
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct qnode : intrusive::list_element<>
+    {
+        explicit qnode(int value = 0)
+            : value(value)
+        {}
+
+        int value;
+    };
+
+    struct counted_qnode : intrusive::list_element<intrusive::default_tag, intrusive::safe_link>
+    {
+        explicit counted_qnode(int value = 0)
+            : value(value)
+        {}
+
+        int value;
+    };
+
+    using queue = intrusive::mpsc_queue<qnode>;
+
+    /*
+    Продюсер кладет в value свой номер в старших битах и порядковый
+    номер в младших, чтобы consumer мог проверить порядок.
+    */
+    constexpr int producer_shift = 20;
+}
+
+TEST(intrusive_mpsc_queue_testing, empty)
+{
+    queue q;
+    EXPECT_TRUE(q.empty());
+    EXPECT_EQ(nullptr, q.try_pop());
+}
+
+TEST(intrusive_mpsc_queue_testing, fifo)
+{
+    queue q;
+    qnode a(1), b(2), c(3);
+    q.push(a);
+    q.push(b);
+    EXPECT_FALSE(q.empty());
+    EXPECT_TRUE(a.is_linked());
+    EXPECT_EQ(&a, q.try_pop());
+    EXPECT_FALSE(a.is_linked());
+    q.push(c);
+    EXPECT_EQ(&b, q.try_pop());
+    EXPECT_EQ(&c, q.try_pop());
+    EXPECT_EQ(nullptr, q.try_pop());
+    EXPECT_TRUE(q.empty());
+
+    q.push(a);
+    EXPECT_EQ(&a, q.try_pop());
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(intrusive_mpsc_queue_testing, popped_element_goes_to_list)
+{
+    queue q;
+    intrusive::list<qnode> list;
+    qnode a(1), b(2);
+    q.push(a);
+    q.push(b);
+    list.push_back(*q.try_pop());
+    list.push_back(*q.try_pop());
+    expect_eq(list, {1, 2});
+}
+
+TEST(intrusive_mpsc_queue_testing, drain)
+{
+    queue q;
+    intrusive::list<qnode> list;
+    qnode a(1), b(2), c(3), d(4), e(5);
+    list.push_back(a);
+
+    q.push(b);
+    q.push(c);
+    EXPECT_EQ(2u, q.drain(list));
+    EXPECT_TRUE(q.empty());
+    expect_eq(list, {1, 2, 3});
+
+    EXPECT_EQ(0u, q.drain(list));
+
+    q.push(d);
+    q.push(e);
+    EXPECT_EQ(&d, q.try_pop());
+    EXPECT_EQ(1u, q.drain(list));
+    expect_eq(list, {1, 2, 3, 5});
+    EXPECT_FALSE(d.is_linked());
+}
+
+namespace
+{
+    /*
+    Состояние после того, как try_pop проиграл гонку: увидел
+    последний элемент a, поставил за ним stub, но между проверкой
+    головы и push(stub) producer успел положить b. try_pop отдает a,
+    tail остается на b, а stub лежит в цепочке после b.
+    */
+    struct raced_queue : queue
+    {
+        void lose_pop_race(qnode& b)
+        {
+            queue::push(b);
+            tail = &intrusive::to_base<intrusive::default_tag>(b);
+            intrusive::detail::mpsc_queue_base::push(stub);
+        }
+    };
+}
+
+TEST(intrusive_mpsc_queue_testing, drain_with_stub_at_head)
+{
+    raced_queue q;
+    intrusive::list<qnode> list;
+    qnode b(2);
+    q.lose_pop_race(b);
+    EXPECT_FALSE(q.empty());
+    EXPECT_EQ(1u, q.drain(list));
+    EXPECT_TRUE(q.empty());
+    EXPECT_EQ(nullptr, q.try_pop());
+    expect_eq(list, {2});
+
+    qnode c(3);
+    q.push(c);
+    EXPECT_EQ(1u, q.drain(list));
+    expect_eq(list, {2, 3});
+}
+
+TEST(intrusive_mpsc_queue_testing, drain_with_stub_in_chain)
+{
+    raced_queue q;
+    intrusive::list<qnode> list;
+    qnode b(2), c(3), d(4);
+    q.lose_pop_race(b);
+    q.push(c);
+    q.push(d);
+    EXPECT_EQ(3u, q.drain(list));
+    EXPECT_TRUE(q.empty());
+    expect_eq(list, {2, 3, 4});
+
+    EXPECT_EQ(0u, q.drain(list));
+    qnode e(5);
+    q.push(e);
+    EXPECT_EQ(&e, q.try_pop());
+    EXPECT_TRUE(q.empty());
+    list.clear();
+}
+
+TEST(intrusive_mpsc_queue_testing, drain_counted)
+{
+    intrusive::mpsc_queue<counted_qnode> q;
+    intrusive::list<counted_qnode, intrusive::default_tag, intrusive::constant_time_size> list;
+    counted_qnode a(1), b(2), c(3);
+    q.push(a);
+    q.push(b);
+    q.push(c);
+    EXPECT_EQ(3u, q.drain(list));
+    EXPECT_EQ(3u, list.size());
+    expect_eq(list, {1, 2, 3});
+    list.clear();
+}
+
+TEST(intrusive_mpsc_queue_testing, drain_with_stats)
+{
+    intrusive::mpsc_queue<counted_qnode> q;
+    intrusive::list<counted_qnode, intrusive::default_tag, intrusive::list_stats<>> list;
+    counted_qnode a(1), b(2), c(3);
+    list.push_back(a);
+    q.push(b);
+    q.push(c);
+    EXPECT_EQ(2u, q.drain(list));
+    EXPECT_EQ(3u, list.stats().links);
+    EXPECT_EQ(3u, list.stats().length);
+    EXPECT_EQ(3u, list.stats().high_watermark);
+    list.clear();
+}
+
+TEST(intrusive_mpsc_queue_testing, member_hook)
+{
+    struct mnode
+    {
+        intrusive::list_element<> hook;
+        int value;
+    };
+    using hook = intrusive::member_hook<&mnode::hook, offsetof(mnode, hook)>;
+    intrusive::mpsc_queue<mnode, hook> q;
+    intrusive::list<mnode, hook> list;
+    mnode a{{}, 1}, b{{}, 2};
+    q.push(a);
+    q.push(b);
+    EXPECT_EQ(&a, q.try_pop());
+    EXPECT_EQ(1u, q.drain(list));
+    expect_eq(list, {2});
+}
+
+TEST(intrusive_mpsc_queue_testing, concurrent_producers)
+{
+    constexpr int producers = 4;
+    constexpr int per_producer = 20000;
+
+    std::vector<qnode> nodes(producers * per_producer);
+    for (int p = 0; p != producers; ++p)
+        for (int i = 0; i != per_producer; ++i)
+            nodes[p * per_producer + i].value = (p << producer_shift) | i;
+
+    queue q;
+    std::vector<std::thread> threads;
+    for (int p = 0; p != producers; ++p)
+        threads.emplace_back([&, p] {
+            for (int i = 0; i != per_producer; ++i)
+                q.push(nodes[p * per_producer + i]);
+        });
+
+    std::vector<int> expected(producers, 0);
+    intrusive::list<qnode> batch;
+    int received = 0;
+    bool use_drain = false;
+    while (received != producers * per_producer)
+    {
+        if (use_drain)
+        {
+            q.drain(batch);
+        }
+        else if (qnode* x = q.try_pop())
+        {
+            batch.push_back(*x);
+        }
+        use_drain = !use_drain;
+
+        while (!batch.empty())
+        {
+            int value = batch.front().value;
+            int p = value >> producer_shift;
+            EXPECT_EQ(expected[p], value & ((1 << producer_shift) - 1));
+            ++expected[p];
+            batch.pop_front();
+            ++received;
+        }
+    }
+
+    for (auto& t : threads)
+        t.join();
+    EXPECT_TRUE(q.empty());
+    for (int p = 0; p != producers; ++p)
+        EXPECT_EQ(per_producer, expected[p]);
+}
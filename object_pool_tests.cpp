@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include "intrusive_object_pool.h"
+#include "intrusive_list.h"
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct pooled : intrusive::list_element<>
+    {
+        explicit pooled(int value)
+            : value(value)
+        {
+            ++alive;
+        }
+
+        ~pooled()
+        {
+            --alive;
+        }
+
+        int value;
+        static inline int alive = 0;
+    };
+
+    struct throwing
+    {
+        explicit throwing(bool fail)
+        {
+            if (fail)
+                throw std::runtime_error("constructor failed");
+        }
+
+        std::size_t payload[3];
+    };
+
+    struct task : intrusive::list_element<>
+    {
+        explicit task(int value)
+            : value(value)
+        {}
+
+        int value;
+    };
+}
+
+TEST(intrusive_object_pool_testing, create_destroy_reuses)
+{
+    intrusive::object_pool<pooled> pool;
+    pooled* a = pool.create(1);
+    EXPECT_EQ(1, a->value);
+    EXPECT_EQ(1, pooled::alive);
+
+    pool.destroy(a);
+    EXPECT_EQ(0, pooled::alive);
+
+    pooled* b = pool.create(2);
+    EXPECT_EQ(a, b);
+    pool.destroy(b);
+}
+
+TEST(intrusive_object_pool_testing, contiguous_allocation)
+{
+    intrusive::object_pool<pooled> pool;
+    std::vector<pooled*> objects;
+    for (int i = 0; i != 10; ++i)
+        objects.push_back(pool.create(i));
+
+    for (std::size_t i = 1; i != objects.size(); ++i)
+        EXPECT_EQ(objects[i - 1] + 1, objects[i]);
+
+    for (pooled* p : objects)
+        pool.destroy(p);
+}
+
+TEST(intrusive_object_pool_testing, slabs)
+{
+    intrusive::object_pool<char> pool(4);
+    EXPECT_EQ(0u, pool.capacity());
+
+    std::vector<char*> objects;
+    for (int i = 0; i != 10; ++i)
+        objects.push_back(pool.create(char('a' + i)));
+    EXPECT_EQ(12u, pool.capacity());
+
+    /*
+    Слот не меньше указателя, даже если объект -- один байт.
+    */
+    EXPECT_EQ(sizeof(void*), std::size_t(objects[1] - objects[0]));
+    for (int i = 0; i != 10; ++i)
+        EXPECT_EQ(char('a' + i), *objects[i]);
+
+    for (char* p : objects)
+        pool.destroy(p);
+    for (int i = 0; i != 10; ++i)
+        objects[i] = pool.create('x');
+    EXPECT_EQ(12u, pool.capacity());
+    for (char* p : objects)
+        pool.destroy(p);
+}
+
+TEST(intrusive_object_pool_testing, clear_and_dispose)
+{
+    intrusive::object_pool<pooled> pool;
+    intrusive::list<pooled> list;
+    for (int i = 0; i != 100; ++i)
+        list.push_back(*pool.create(i));
+    EXPECT_EQ(100, pooled::alive);
+
+    std::size_t capacity = pool.capacity();
+    list.clear_and_dispose(pool.disposer());
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(0, pooled::alive);
+
+    for (int i = 0; i != 100; ++i)
+        list.push_back(*pool.create(i));
+    EXPECT_EQ(capacity, pool.capacity());
+
+    list.remove_and_dispose_if([](pooled const& p) { return p.value % 2 == 0; }, pool.disposer());
+    EXPECT_EQ(50, pooled::alive);
+    list.clear_and_dispose(pool.disposer());
+}
+
+TEST(intrusive_object_pool_testing, constructor_throws)
+{
+    intrusive::object_pool<throwing> pool;
+    throwing* a = pool.create(false);
+    EXPECT_THROW(pool.create(true), std::runtime_error);
+
+    /*
+    Память из неудавшегося create() вернулась в пул.
+    */
+    throwing* b = pool.create(false);
+    EXPECT_EQ(a + 1, b);
+    pool.destroy(a);
+    pool.destroy(b);
+}
+
+TEST(intrusive_object_pool_testing, cache)
+{
+    using pool_type = intrusive::object_pool<pooled, intrusive::synchronized_pool>;
+    pool_type pool(16);
+    {
+        intrusive::object_pool_cache<pooled, intrusive::synchronized_pool> cache(pool, 4);
+        intrusive::list<pooled> list;
+        for (int i = 0; i != 10; ++i)
+            list.push_back(*cache.create(i));
+        EXPECT_EQ(16u, pool.capacity());
+
+        list.clear_and_dispose(cache.disposer());
+        EXPECT_EQ(0, pooled::alive);
+
+        pooled* p = pool.create(7);
+        cache.destroy(p);
+    }
+    EXPECT_EQ(16u, pool.capacity());
+}
+
+TEST(intrusive_object_pool_testing, cache_threads)
+{
+    constexpr int threads = 4;
+    constexpr int rounds = 200;
+    constexpr int per_round = 50;
+
+    intrusive::object_pool<task, intrusive::synchronized_pool> pool(64);
+    std::vector<std::thread> workers;
+    for (int t = 0; t != threads; ++t)
+        workers.emplace_back([&pool] {
+            intrusive::object_pool_cache<task, intrusive::synchronized_pool> cache(pool, 8);
+            intrusive::list<task> list;
+            for (int r = 0; r != rounds; ++r)
+            {
+                for (int i = 0; i != per_round; ++i)
+                    list.push_back(*cache.create(i));
+                int sum = 0;
+                for (task const& p : list)
+                    sum += p.value;
+                EXPECT_EQ(per_round * (per_round - 1) / 2, sum);
+                list.clear_and_dispose(cache.disposer());
+            }
+        });
+    for (auto& w : workers)
+        w.join();
+
+    /*
+    Каждому потоку нужно не больше per_round живых объектов и двух пачек
+    запаса, так что пул не растет с числом раундов.
+    */
+    EXPECT_LE(pool.capacity(), std::size_t(threads * (per_round + 2 * 8) + 64));
+}
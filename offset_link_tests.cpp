@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include "intrusive_offset_link.h"
+#include "test_utils.h"
+#include <cstring>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace
+{
+    struct onode : intrusive::list_element<intrusive::default_tag, intrusive::offset_link>
+    {
+        int value = 0;
+    };
+
+    using olist = intrusive::list<onode>;
+
+    /*
+    Область, которая переезжает целиком: элементы и список вместе.
+    Список объявлен после элементов, чтобы разрушаться первым.
+    */
+    struct region
+    {
+        static constexpr int capacity = 8;
+
+        onode nodes[capacity];
+        olist list;
+        olist other;
+    };
+
+    region* fill(void* memory, int n)
+    {
+        region* r = ::new (memory) region;
+        for (int i = 0; i != n; ++i)
+        {
+            r->nodes[i].value = i + 1;
+            r->list.push_back(r->nodes[i]);
+        }
+        return r;
+    }
+
+    region* relocate(void* to, region const* from)
+    {
+        std::memcpy(to, static_cast<void const*>(from), sizeof(region));
+        return std::launder(static_cast<region*>(to));
+    }
+}
+
+TEST(intrusive_offset_link_testing, sizes)
+{
+    EXPECT_EQ(2 * sizeof(void*), sizeof(intrusive::list_element<intrusive::default_tag, intrusive::offset_link>));
+    EXPECT_EQ(2 * sizeof(void*), sizeof(olist));
+}
+
+TEST(intrusive_offset_link_testing, copy_points_to_the_same_target)
+{
+    onode a;
+    intrusive::offset_link::pointer<onode> p = &a;
+    intrusive::offset_link::pointer<onode> q = p;
+    EXPECT_EQ(&a, static_cast<onode*>(p));
+    EXPECT_EQ(&a, static_cast<onode*>(q));
+    EXPECT_NE(p.offset, q.offset);
+
+    q = nullptr;
+    EXPECT_EQ(nullptr, static_cast<onode*>(q));
+    p = q;
+    EXPECT_EQ(nullptr, static_cast<onode*>(p));
+}
+
+TEST(intrusive_offset_link_testing, memcpy_relocation)
+{
+    alignas(region) unsigned char first[sizeof(region)];
+    alignas(region) unsigned char second[sizeof(region)];
+
+    region* src = fill(first, 5);
+    region* dst = relocate(second, src);
+
+    expect_eq(src->list, {1, 2, 3, 4, 5});
+    expect_eq(dst->list, {1, 2, 3, 4, 5});
+    EXPECT_EQ(&dst->nodes[0], &dst->list.front());
+    EXPECT_EQ(&dst->nodes[4], &dst->list.back());
+
+    /*
+    Копии независимы: изменения одной не видны в другой.
+    */
+    dst->list.erase(dst->list.iterator_to(dst->nodes[2]));
+    dst->nodes[5].value = 6;
+    dst->list.push_front(dst->nodes[5]);
+    expect_eq(dst->list, {6, 1, 2, 4, 5});
+    expect_eq(src->list, {1, 2, 3, 4, 5});
+
+    dst->~region();
+    src->~region();
+}
+
+TEST(intrusive_offset_link_testing, relocated_empty_list)
+{
+    alignas(region) unsigned char first[sizeof(region)];
+    alignas(region) unsigned char second[sizeof(region)];
+
+    region* src = fill(first, 0);
+    region* dst = relocate(second, src);
+    src->~region();
+
+    EXPECT_TRUE(dst->list.empty());
+    EXPECT_TRUE(dst->other.empty());
+    dst->nodes[0].value = 1;
+    dst->list.push_back(dst->nodes[0]);
+    expect_eq(dst->list, {1});
+    dst->~region();
+}
+
+TEST(intrusive_offset_link_testing, splice_and_sort_after_relocation)
+{
+    alignas(region) unsigned char first[sizeof(region)];
+    alignas(region) unsigned char second[sizeof(region)];
+
+    region* src = fill(first, 6);
+    region* dst = relocate(second, src);
+    src->~region();
+
+    auto from = dst->list.iterator_to(dst->nodes[1]);
+    auto to = dst->list.iterator_to(dst->nodes[4]);
+    dst->other.splice(dst->other.end(), dst->list, from, to);
+    expect_eq(dst->list, {1, 5, 6});
+    expect_eq(dst->other, {2, 3, 4});
+
+    dst->list.splice(dst->list.begin(), dst->other, dst->other.begin(), dst->other.end());
+    dst->list.sort([](onode const& a, onode const& b) { return a.value > b.value; });
+    expect_eq(dst->list, {6, 5, 4, 3, 2, 1});
+    EXPECT_TRUE(dst->other.empty());
+
+    dst->nodes[0].unlink();
+    expect_eq(dst->list, {6, 5, 4, 3, 2});
+    dst->~region();
+}
+
+/*
+Та же память, отображенная по двум адресам: список, собранный через
+одно отображение, обходится и меняется через другое.
+*/
+TEST(intrusive_offset_link_testing, shared_mapping_at_two_addresses)
+{
+    std::size_t size = (sizeof(region) + 4095) / 4096 * 4096;
+    int fd = memfd_create("intrusive_offset_link", 0);
+    ASSERT_NE(-1, fd);
+    ASSERT_EQ(0, ftruncate(fd, off_t(size)));
+
+    void* a = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    void* b = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ASSERT_NE(MAP_FAILED, a);
+    ASSERT_NE(MAP_FAILED, b);
+    ASSERT_NE(a, b);
+
+    region* ra = fill(a, 3);
+    region* rb = std::launder(static_cast<region*>(b));
+    expect_eq(rb->list, {1, 2, 3});
+
+    rb->list.pop_front();
+    rb->nodes[3].value = 4;
+    rb->list.push_back(rb->nodes[3]);
+    expect_eq(ra->list, {2, 3, 4});
+
+    ra->~region();
+    munmap(b, size);
+    munmap(a, size);
+    close(fd);
+}
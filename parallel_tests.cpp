@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include "intrusive_parallel.h"
+#include "test_utils.h"
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    struct pnode : intrusive::list_element<>
+    {
+        int value = 0;
+        int visits = 0;
+    };
+
+    using plist = intrusive::list<pnode>;
+}
+
+TEST(intrusive_parallel_testing, split_ranges)
+{
+    for (std::size_t n : {0, 1, 7, 16, 17, 100, 1000, 1025})
+        for (std::size_t parts : {1, 2, 3, 8})
+        {
+            plist list;
+            auto nodes = make_nodes(list, n);
+            auto bounds = intrusive::detail::split_ranges(list, parts);
+
+            ASSERT_FALSE(bounds.empty());
+            EXPECT_TRUE(bounds.front() == list.begin());
+            EXPECT_TRUE(bounds.back() == list.end());
+
+            std::size_t chunks = bounds.size() - 1;
+            if (n >= parts)
+            {
+                EXPECT_GE(chunks, parts);
+            }
+            EXPECT_LE(chunks, 2 * parts);
+
+            std::size_t total = 0;
+            std::size_t first_size = 0;
+            for (std::size_t j = 0; j != chunks; ++j)
+            {
+                std::size_t size = std::size_t(std::distance(bounds[j], bounds[j + 1]));
+                EXPECT_NE(0u, size);
+                if (j == 0)
+                    first_size = size;
+                else if (j + 1 != chunks)
+                    EXPECT_EQ(first_size, size);
+                else
+                    EXPECT_LE(size, first_size);
+                total += size;
+            }
+            EXPECT_EQ(n, total);
+            list.clear();
+        }
+}
+
+TEST(intrusive_parallel_testing, for_each_visits_each_once)
+{
+    for (std::size_t n : {0, 1, 5, 100, 10000})
+        for (std::size_t threads : {0, 1, 2, 3, 8})
+        {
+            plist list;
+            auto nodes = make_nodes(list, n);
+            intrusive::parallel::for_each(list, [](pnode& x) { ++x.visits; x.value *= 2; }, threads);
+
+            for (std::size_t i = 0; i != n; ++i)
+            {
+                EXPECT_EQ(1, nodes[i].visits);
+                EXPECT_EQ(int(2 * i), nodes[i].value);
+            }
+            list.clear();
+        }
+}
+
+TEST(intrusive_parallel_testing, transform_reduce_keeps_order)
+{
+    plist list;
+    auto nodes = make_nodes(list, 3000);
+
+    plist const& clist = list;
+    auto values = intrusive::parallel::transform_reduce(clist, std::vector<int>{-1},
+        [](std::vector<int> a, std::vector<int> b) {
+            a.insert(a.end(), b.begin(), b.end());
+            return a;
+        },
+        [](pnode const& x) { return std::vector<int>{x.value}; }, 4);
+
+    ASSERT_EQ(3001u, values.size());
+    for (std::size_t i = 0; i != values.size(); ++i)
+        EXPECT_EQ(int(i) - 1, values[i]);
+
+    long long sum = intrusive::parallel::transform_reduce(list, 7ll, std::plus<>(),
+        [](pnode const& x) { return (long long)x.value; }, 3);
+    EXPECT_EQ(7 + 2999ll * 3000 / 2, sum);
+
+    plist empty;
+    EXPECT_EQ(42, intrusive::parallel::transform_reduce(empty, 42, std::plus<>(),
+        [](pnode const& x) { return x.value; }));
+    list.clear();
+}
+
+TEST(intrusive_parallel_testing, with_list_index)
+{
+    plist list;
+    auto nodes = make_nodes(list, 1234);
+    intrusive::list_index<plist> index(list, 16);
+
+    std::atomic<int> calls{0};
+    intrusive::parallel::for_each(index, [&](pnode& x) {
+        ++x.visits;
+        calls.fetch_add(1, std::memory_order_relaxed);
+    }, 5);
+    EXPECT_EQ(1234, calls.load());
+    for (std::size_t i = 0; i != 1234; ++i)
+        EXPECT_EQ(1, nodes[i].visits);
+
+    int sum = intrusive::parallel::transform_reduce(index, 0, std::plus<>(),
+        [](pnode const& x) { return x.value; }, 4);
+    EXPECT_EQ(1233 * 1234 / 2, sum);
+
+    auto bounds = intrusive::detail::split_ranges(index, 4);
+    ASSERT_EQ(5u, bounds.size());
+    EXPECT_EQ(&nodes[617], &*bounds[2]);
+    EXPECT_TRUE(bounds[4] == list.end());
+    list.clear();
+}
+
+TEST(intrusive_parallel_testing, exception_is_rethrown)
+{
+    plist list;
+    auto nodes = make_nodes(list, 500);
+
+    for (std::size_t threads : {1, 4})
+        EXPECT_THROW(intrusive::parallel::for_each(list, [](pnode& x) {
+            if (x.value == 321)
+                throw std::runtime_error("bad node");
+        }, threads), std::runtime_error);
+
+    std::atomic<int> calls{0};
+    intrusive::parallel::for_each(list, [&](pnode&) { calls.fetch_add(1, std::memory_order_relaxed); }, 4);
+    EXPECT_EQ(500, calls.load());
+    list.clear();
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include "intrusive_prefetch.h"
+#include "intrusive_list.h"
+#include "intrusive_slim_list.h"
+#include "test_utils.h"
+#include <memory>
+#include <vector>
+
+namespace
+{
+    struct slim_tag;
+
+    struct pnode : intrusive::list_element<>
+                 , intrusive::slim_list_element<slim_tag>
+    {
+        int value = 0;
+        char payload[200] = {};
+    };
+
+    using plist = intrusive::list<pnode>;
+}
+
+TEST(intrusive_prefetch_testing, visits_all_in_order)
+{
+    for (std::size_t n : {0, 1, 5, 64, 65, 200})
+        for (std::size_t distance : {0, 1, 3, 8, 64, 1000})
+        {
+            auto nodes = make_nodes<pnode>(n);
+            plist list;
+            for (std::size_t i = 0; i != n; ++i)
+                list.push_back(nodes[i]);
+
+            std::vector<int> seen;
+            intrusive::for_each_prefetch(list, [&](pnode& x) { seen.push_back(x.value); }, distance);
+
+            ASSERT_EQ(n, seen.size());
+            for (std::size_t i = 0; i != n; ++i)
+                EXPECT_EQ(int(i), seen[i]);
+        }
+}
+
+TEST(intrusive_prefetch_testing, const_list)
+{
+    auto nodes = make_nodes<pnode>(10);
+    plist list;
+    for (std::size_t i = 0; i != 10; ++i)
+        list.push_back(nodes[i]);
+
+    plist const& clist = list;
+    int sum = 0;
+    intrusive::for_each_prefetch(clist, [&](pnode const& x) { sum += x.value; }, 4);
+    EXPECT_EQ(45, sum);
+}
+
+TEST(intrusive_prefetch_testing, unlink_current)
+{
+    auto nodes = make_nodes<pnode>(20);
+    plist list;
+    for (std::size_t i = 0; i != 20; ++i)
+        list.push_back(nodes[i]);
+
+    intrusive::for_each_prefetch(list, [](pnode& x) {
+        if (x.value % 2 == 0)
+            x.intrusive::list_element<>::unlink();
+    }, 4);
+
+    int expected = 1;
+    for (pnode const& x : list)
+    {
+        EXPECT_EQ(expected, x.value);
+        expected += 2;
+    }
+    EXPECT_EQ(21, expected);
+}
+
+TEST(intrusive_prefetch_testing, slim_list)
+{
+    auto nodes = make_nodes<pnode>(30);
+    intrusive::slim_list<pnode, slim_tag> list;
+    for (std::size_t i = 0; i != 30; ++i)
+        list.push_front(nodes[i]);
+
+    int expected = 29;
+    intrusive::for_each_prefetch(list, [&](pnode& x) { EXPECT_EQ(expected--, x.value); }, 5);
+    EXPECT_EQ(-1, expected);
+    list.clear();
+}
+
+TEST(intrusive_prefetch_testing, gather_in_chunks)
+{
+    auto nodes = make_nodes<pnode>(100);
+    plist list;
+    for (std::size_t i = 0; i != 100; ++i)
+        list.push_back(nodes[i]);
+
+    pnode* buffer[16];
+    std::vector<std::size_t> chunks;
+    int expected = 0;
+    auto pos = list.begin();
+    while (std::size_t got = intrusive::gather(pos, list.end(), buffer, 16))
+    {
+        chunks.push_back(got);
+        for (std::size_t i = 0; i != got; ++i)
+            EXPECT_EQ(expected++, buffer[i]->value);
+    }
+
+    EXPECT_EQ(100, expected);
+    EXPECT_EQ((std::vector<std::size_t>{16, 16, 16, 16, 16, 16, 4}), chunks);
+    EXPECT_TRUE(pos == list.end());
+
+    plist const& clist = list;
+    pnode const* cbuffer[3];
+    auto cpos = clist.begin();
+    EXPECT_EQ(3u, intrusive::gather(cpos, clist.end(), cbuffer, 3));
+    EXPECT_EQ(&nodes[2], cbuffer[2]);
+    EXPECT_EQ(0u, intrusive::gather(cpos, clist.end(), cbuffer, 0));
+    EXPECT_EQ(&nodes[3], &*cpos);
+}
@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+#include "intrusive_rcu_list.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct rnode : intrusive::rcu_list_element<>
+    {
+        explicit rnode(int value = 0)
+            : value(value)
+        {}
+
+        int value;
+    };
+
+    using rlist = intrusive::rcu_list<rnode>;
+
+    std::vector<int> values(intrusive::rcu_reader& reader, rlist& list)
+    {
+        intrusive::rcu_read_guard guard(reader);
+        std::vector<int> result;
+        for (rnode& x : list)
+            result.push_back(x.value);
+        return result;
+    }
+}
+
+TEST(intrusive_rcu_list_testing, push_and_iterate)
+{
+    intrusive::rcu_domain domain;
+    intrusive::rcu_reader reader(domain);
+    rlist list(domain);
+    rnode a(1), b(2), c(3);
+    list.push_back(b);
+    list.push_back(c);
+    list.push_front(a);
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), values(reader, list));
+    EXPECT_TRUE(a.is_linked());
+    list.clear();
+    list.reclaim();
+}
+
+TEST(intrusive_rcu_list_testing, erase_defers_reuse)
+{
+    intrusive::rcu_domain domain;
+    intrusive::rcu_reader reader(domain);
+    rlist list(domain);
+    rnode a(1), b(2), c(3);
+    list.push_back(a);
+    list.push_back(b);
+    list.push_back(c);
+
+    list.erase(b);
+    EXPECT_EQ((std::vector<int>{1, 3}), values(reader, list));
+    EXPECT_TRUE(b.is_linked());
+
+    list.erase(a);
+    std::vector<int> disposed;
+    list.reclaim([&](rnode* p) { disposed.push_back(p->value); });
+    EXPECT_EQ((std::vector<int>{1, 2}), disposed);
+    EXPECT_FALSE(a.is_linked());
+    EXPECT_FALSE(b.is_linked());
+
+    list.push_front(b);
+    EXPECT_EQ((std::vector<int>{2, 3}), values(reader, list));
+    list.clear();
+    list.reclaim();
+}
+
+TEST(intrusive_rcu_list_testing, reader_on_erased_element_reaches_end)
+{
+    intrusive::rcu_domain domain;
+    intrusive::rcu_reader reader(domain);
+    rlist list(domain);
+    rnode a(1), b(2), c(3);
+    list.push_back(a);
+    list.push_back(b);
+    list.push_back(c);
+
+    std::vector<int> seen;
+    {
+        intrusive::rcu_read_guard guard(reader);
+        auto i = list.begin();
+        seen.push_back(i->value);
+        list.erase(a);
+        list.erase(b);
+        for (++i; i != list.end(); ++i)
+            seen.push_back(i->value);
+    }
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), seen);
+    list.reclaim();
+    EXPECT_EQ((std::vector<int>{3}), values(reader, list));
+    list.clear();
+    list.reclaim();
+}
+
+TEST(intrusive_rcu_list_testing, nested_guards)
+{
+    intrusive::rcu_domain domain;
+    intrusive::rcu_reader reader(domain);
+    rlist list(domain);
+    rnode a(1);
+    list.push_back(a);
+    {
+        intrusive::rcu_read_guard outer(reader);
+        EXPECT_EQ((std::vector<int>{1}), values(reader, list));
+    }
+    list.erase(a);
+    list.reclaim();
+    EXPECT_FALSE(a.is_linked());
+}
+
+TEST(intrusive_rcu_list_testing, reclaim_waits_for_readers)
+{
+    intrusive::rcu_domain domain;
+    rlist list(domain);
+    rnode a(1);
+    list.push_back(a);
+
+    std::atomic<bool> inside{false};
+    std::atomic<bool> release{false};
+    std::atomic<bool> reclaimed{false};
+
+    std::thread reader_thread([&] {
+        intrusive::rcu_reader reader(domain);
+        intrusive::rcu_read_guard guard(reader);
+        inside.store(true);
+        while (!release.load())
+            std::this_thread::yield();
+        EXPECT_FALSE(reclaimed.load());
+    });
+
+    while (!inside.load())
+        std::this_thread::yield();
+    list.erase(a);
+
+    std::thread writer_thread([&] {
+        list.reclaim();
+        reclaimed.store(true);
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(reclaimed.load());
+    release.store(true);
+    writer_thread.join();
+    reader_thread.join();
+    EXPECT_TRUE(reclaimed.load());
+    EXPECT_FALSE(a.is_linked());
+}
+
+TEST(intrusive_rcu_list_testing, concurrent_readers_and_writer)
+{
+    constexpr int readers = 3;
+    constexpr int size = 64;
+    constexpr int rounds = 4000;
+
+    intrusive::rcu_domain domain;
+    rlist list(domain);
+    std::vector<rnode*> live;
+    for (int i = 0; i != size; ++i)
+    {
+        live.push_back(new rnode(i));
+        list.push_back(*live.back());
+    }
+
+    std::atomic<bool> done{false};
+    std::vector<std::thread> threads;
+    for (int r = 0; r != readers; ++r)
+        threads.emplace_back([&] {
+            intrusive::rcu_reader reader(domain);
+            while (!done.load())
+            {
+                intrusive::rcu_read_guard guard(reader);
+                for (rnode& x : list)
+                    ASSERT_GE(x.value, 0);
+            }
+        });
+
+    for (int round = 0; round != rounds; ++round)
+    {
+        rnode*& victim = live[round % size];
+        list.erase(*victim);
+        victim = new rnode(size + round);
+        list.push_back(*victim);
+        if (round % 64 == 63)
+            list.reclaim([](rnode* p) {
+                p->value = -1;
+                delete p;
+            });
+    }
+
+    done.store(true);
+    for (auto& t : threads)
+        t.join();
+
+    list.clear();
+    list.reclaim([](rnode* p) { delete p; });
+}
@@ -0,0 +1,750 @@
+#include "replay_trace.h"
+#include "intrusive_index_link.h"
+#include "intrusive_lazy_list.h"
+#include "intrusive_list.h"
+#include "intrusive_slist.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/mman.h>
+
+/*
+Воспроизведение трассы операций (см. replay_trace.h) на разных
+вариантах списков, чтобы выбирать конфигурацию по данным с нагрузки,
+похожей на настоящую, а не по микробенчмаркам.
+
+intrusive_list_replay --workload=zipf --ops=1000000
+intrusive_list_replay --trace=recorded.trace --save=baseline.csv
+intrusive_list_replay --trace=recorded.trace --baseline=baseline.csv
+
+Варианты:
+- list         -- list_element<>, auto_unlink, erase -- это unlink();
+- list_normal  -- normal_link, erase через list::erase;
+- list_counted -- safe_link и constant_time_size, splice с известным n;
+- list_index   -- index_link, хук 8 байт вместо 16;
+- slist        -- slist с cache_last, erase ищет предыдущий за O(n);
+- lazy_list    -- erase только помечает элемент, выкидывают его
+                  pop_front и scan. splice -- это pop_front + push_back
+                  по одному элементу, своего splice у lazy_list нет.
+                  Если объект вставляют обратно, пока он еще лежит
+                  помеченным в старом списке, старый список сначала
+                  сжимается через compact().
+
+Для каждого варианта печатаются:
+- пропускная способность -- лучший из трех прогонов всей трассы;
+- задержки отдельных операций (p50, p90, p99, p99.9, max) из
+  отдельного прогона, где каждая операция замеряется steady_clock.
+  Стоимость самого замера вычитается, но операции короче нескольких
+  наносекунд все равно меряются грубо;
+- RSS -- пик резидентной памяти под объекты и головы списков. Все
+  они лежат в своем mmap на каждый вариант, пик сбрасывается через
+  /proc/self/clear_refs (только Linux).
+
+Все варианты обязаны прийти к одинаковому содержимому списков: по
+ходу прогона считается хеш от порядка элементов при каждом scan и в
+конце, и если у какого-то варианта он не совпал с первым, это ошибка.
+
+--save=file пишет результаты в CSV, --baseline=file сравнивает с ранее
+сохраненными: если у какого-то варианта пропускная способность упала
+или p99 либо RSS выросли больше чем на --tolerance (по умолчанию 0.1),
+программа печатает, что именно ухудшилось, и завершается с кодом 2.
+*/
+namespace
+{
+    /*
+    Память под один вариант. index_link считает смещения от base(),
+    поэтому и элементы, и головы списков лежат здесь.
+    */
+    struct arena
+    {
+        explicit arena(std::size_t capacity)
+            : capacity(capacity)
+            , used(0)
+        {
+            void* p = mmap(nullptr, capacity, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (p == MAP_FAILED)
+                throw std::bad_alloc();
+            begin = static_cast<char*>(p);
+            current = begin;
+        }
+
+        ~arena()
+        {
+            munmap(begin, capacity);
+            current = nullptr;
+        }
+
+        arena(arena const&) = delete;
+        arena& operator=(arena const&) = delete;
+
+        template <typename T>
+        T* allocate(std::size_t n)
+        {
+            std::size_t offset = (used + alignof(T) - 1) / alignof(T) * alignof(T);
+            if (offset + n * sizeof(T) > capacity)
+                throw std::bad_alloc();
+            used = offset + n * sizeof(T);
+            return reinterpret_cast<T*>(begin + offset);
+        }
+
+        void reset() noexcept
+        {
+            used = 0;
+        }
+
+        static char* base() noexcept
+        {
+            return current;
+        }
+
+        char* begin;
+        std::size_t capacity;
+        std::size_t used;
+        static inline char* current = nullptr;
+    };
+
+    constexpr std::uint64_t hash_step(std::uint64_t h, std::uint64_t value) noexcept
+    {
+        return (h ^ value) * 0x100000001b3ull;
+    }
+
+    template <typename T>
+    struct type_tag
+    {
+        using type = T;
+    };
+
+    /*
+    Объекты и головы списков варианта в арене. Головы разрушаются
+    раньше объектов, как и положено владельцу.
+    */
+    template <typename Node, typename List>
+    struct storage
+    {
+        using node = Node;
+        using list_type = List;
+
+        storage(arena& a, replay::trace const& t)
+            : nodes(a.allocate<Node>(t.objects))
+            , lists(a.allocate<List>(t.lists))
+            , node_count(t.objects)
+            , list_count(t.lists)
+        {
+            for (std::uint32_t i = 0; i != node_count; ++i)
+                new (&nodes[i]) Node();
+            for (std::uint32_t i = 0; i != node_count; ++i)
+                nodes[i].id = i;
+            for (std::uint32_t i = 0; i != list_count; ++i)
+                new (&lists[i]) List();
+        }
+
+        ~storage()
+        {
+            for (std::uint32_t i = 0; i != list_count; ++i)
+            {
+                lists[i].clear();
+                lists[i].~List();
+            }
+            for (std::uint32_t i = 0; i != node_count; ++i)
+                nodes[i].~Node();
+        }
+
+        storage(storage const&) = delete;
+        storage& operator=(storage const&) = delete;
+
+        Node* nodes;
+        List* lists;
+        std::uint32_t node_count;
+        std::uint32_t list_count;
+    };
+
+    template <typename Hook>
+    struct hooked_node : Hook
+    {
+        std::uint32_t id = 0;
+    };
+
+    template <typename Hook, typename... ListOptions>
+    struct list_variant
+        : storage<hooked_node<Hook>, intrusive::list<hooked_node<Hook>, intrusive::default_tag, ListOptions...>>
+    {
+        using base = storage<hooked_node<Hook>, intrusive::list<hooked_node<Hook>, intrusive::default_tag, ListOptions...>>;
+        using typename base::list_type;
+        using base::base;
+        using base::nodes;
+        using base::lists;
+
+        static constexpr bool self_unlink = std::is_same_v<typename Hook::link_mode, intrusive::auto_unlink>;
+
+        void push_back(std::uint32_t l, std::uint32_t obj) noexcept
+        {
+            lists[l].push_back(nodes[obj]);
+        }
+
+        void push_front(std::uint32_t l, std::uint32_t obj) noexcept
+        {
+            lists[l].push_front(nodes[obj]);
+        }
+
+        void erase(std::uint32_t obj, std::uint32_t owner) noexcept
+        {
+            if constexpr (self_unlink)
+                nodes[obj].unlink();
+            else
+                lists[owner].erase(list_type::iterator_to(nodes[obj]));
+        }
+
+        void pop_front(std::uint32_t l) noexcept
+        {
+            lists[l].pop_front();
+        }
+
+        void splice(std::uint32_t dst, std::uint32_t src, std::uint32_t n) noexcept
+        {
+            auto& from = lists[src];
+            auto last = std::next(from.begin(), std::ptrdiff_t(n));
+            if constexpr (list_type::has_constant_time_size)
+                lists[dst].splice(lists[dst].end(), from, from.begin(), last, n);
+            else
+                lists[dst].splice(lists[dst].end(), from, from.begin(), last);
+        }
+
+        std::uint64_t scan(std::uint32_t l) noexcept
+        {
+            std::uint64_t h = 0;
+            for (auto const& x : lists[l])
+                h = hash_step(h, x.id);
+            return h;
+        }
+    };
+
+    using plain_list = list_variant<intrusive::list_element<>>;
+    using normal_list = list_variant<intrusive::list_element<intrusive::default_tag, intrusive::normal_link>>;
+    using counted_list = list_variant<intrusive::list_element<intrusive::default_tag, intrusive::safe_link>,
+                                      intrusive::constant_time_size>;
+    using index_list = list_variant<intrusive::list_element<intrusive::default_tag, intrusive::index_link<arena>>>;
+
+    using snode = hooked_node<intrusive::slist_element<>>;
+
+    struct slist_variant : storage<snode, intrusive::slist<snode, intrusive::default_tag, intrusive::cache_last>>
+    {
+        using storage::storage;
+
+        void push_back(std::uint32_t l, std::uint32_t obj) noexcept
+        {
+            lists[l].push_back(nodes[obj]);
+        }
+
+        void push_front(std::uint32_t l, std::uint32_t obj) noexcept
+        {
+            lists[l].push_front(nodes[obj]);
+        }
+
+        void erase(std::uint32_t obj, std::uint32_t owner) noexcept
+        {
+            auto& l = lists[owner];
+            l.erase_after(l.previous(list_type::iterator_to(nodes[obj])));
+        }
+
+        void pop_front(std::uint32_t l) noexcept
+        {
+            lists[l].pop_front();
+        }
+
+        void splice(std::uint32_t dst, std::uint32_t src, std::uint32_t n) noexcept
+        {
+            auto& from = lists[src];
+            auto& to = lists[dst];
+            auto before_last = std::next(from.before_begin(), std::ptrdiff_t(n));
+            auto pos = to.empty() ? to.before_begin() : list_type::iterator_to(to.back());
+            to.splice_after(pos, from, from.before_begin(), before_last);
+        }
+
+        std::uint64_t scan(std::uint32_t l) noexcept
+        {
+            std::uint64_t h = 0;
+            for (snode const& x : lists[l])
+                h = hash_step(h, x.id);
+            return h;
+        }
+    };
+
+    using lnode = hooked_node<intrusive::lazy_list_element<>>;
+
+    struct lazy_variant : storage<lnode, intrusive::lazy_list<lnode>>
+    {
+        lazy_variant(arena& a, replay::trace const& t)
+            : storage(a, t)
+            , last_list(a.allocate<std::uint32_t>(t.objects))
+        {}
+
+        void push_back(std::uint32_t l, std::uint32_t obj) noexcept
+        {
+            reclaim(obj);
+            lists[l].push_back(nodes[obj]);
+            last_list[obj] = l;
+        }
+
+        void push_front(std::uint32_t l, std::uint32_t obj) noexcept
+        {
+            reclaim(obj);
+            lists[l].push_front(nodes[obj]);
+            last_list[obj] = l;
+        }
+
+        void erase(std::uint32_t obj, std::uint32_t) noexcept
+        {
+            nodes[obj].unlink();
+        }
+
+        void pop_front(std::uint32_t l) noexcept
+        {
+            lists[l].pop_front();
+        }
+
+        void splice(std::uint32_t dst, std::uint32_t src, std::uint32_t n) noexcept
+        {
+            for (std::uint32_t i = 0; i != n; ++i)
+            {
+                lnode* x = lists[src].pop_front();
+                lists[dst].push_back(*x);
+                last_list[x->id] = dst;
+            }
+        }
+
+        std::uint64_t scan(std::uint32_t l) noexcept
+        {
+            std::uint64_t h = 0;
+            lists[l].for_each([&](lnode const& x) { h = hash_step(h, x.id); });
+            return h;
+        }
+
+    private:
+        void reclaim(std::uint32_t obj) noexcept
+        {
+            if (nodes[obj].is_linked())
+                lists[last_list[obj]].compact();
+        }
+
+        std::uint32_t* last_list;
+    };
+
+    template <typename Variant>
+    std::uint64_t apply(Variant& v, replay::op const& o) noexcept
+    {
+        switch (o.kind)
+        {
+        case replay::op_kind::push_back:
+            v.push_back(o.a, o.b);
+            break;
+        case replay::op_kind::push_front:
+            v.push_front(o.a, o.b);
+            break;
+        case replay::op_kind::erase:
+            v.erase(o.a, o.b);
+            break;
+        case replay::op_kind::pop_front:
+            v.pop_front(o.a);
+            break;
+        case replay::op_kind::splice:
+            v.splice(o.a, o.b, o.c);
+            break;
+        case replay::op_kind::scan:
+            return v.scan(o.a);
+        }
+        return 0;
+    }
+
+    template <typename Variant>
+    std::uint64_t final_state(Variant& v) noexcept
+    {
+        std::uint64_t h = 0;
+        for (std::uint32_t l = 0; l != v.list_count; ++l)
+            h = hash_step(h, v.scan(l));
+        return h;
+    }
+
+    /*
+    VmRSS или VmHWM из /proc/self/status в КиБ, -1 если их нет.
+    */
+    long read_status_kb(char const* key)
+    {
+#if defined(__linux__)
+        std::FILE* f = std::fopen("/proc/self/status", "r");
+        if (!f)
+            return -1;
+        char line[256];
+        long value = -1;
+        std::size_t len = std::strlen(key);
+        while (std::fgets(line, sizeof line, f))
+            if (std::strncmp(line, key, len) == 0 && line[len] == ':')
+            {
+                value = std::strtol(line + len + 1, nullptr, 10);
+                break;
+            }
+        std::fclose(f);
+        return value;
+#else
+        (void)key;
+        return -1;
+#endif
+    }
+
+    bool reset_peak_rss()
+    {
+#if defined(__linux__)
+        std::FILE* f = std::fopen("/proc/self/clear_refs", "w");
+        if (!f)
+            return false;
+        bool ok = std::fputs("5", f) >= 0;
+        return std::fclose(f) == 0 && ok;
+#else
+        return false;
+#endif
+    }
+
+    using clock = std::chrono::steady_clock;
+
+    /*
+    Стоимость пары clock::now(), которую вычитаем из каждого замера.
+    */
+    std::uint64_t timer_overhead_ns()
+    {
+        std::uint64_t best = std::numeric_limits<std::uint64_t>::max();
+        for (int i = 0; i != 10000; ++i)
+        {
+            auto a = clock::now();
+            auto b = clock::now();
+            best = std::min<std::uint64_t>(best, std::uint64_t((b - a).count()));
+        }
+        return best;
+    }
+
+    struct variant_result
+    {
+        std::string name;
+        std::size_t ops = 0;
+        double ops_per_sec = 0;
+        std::uint64_t p50 = 0;
+        std::uint64_t p90 = 0;
+        std::uint64_t p99 = 0;
+        std::uint64_t p999 = 0;
+        std::uint64_t max = 0;
+        long rss_kb = -1;
+        std::uint64_t checksum = 0;
+    };
+
+    constexpr int throughput_runs = 3;
+
+    struct run_context
+    {
+        replay::trace const& trace;
+        std::vector<std::uint32_t>& latencies;
+        std::uint64_t overhead_ns;
+    };
+
+    template <typename Variant>
+    variant_result run_variant(char const* name, run_context& ctx)
+    {
+        replay::trace const& t = ctx.trace;
+        std::size_t capacity = std::size_t(t.objects) * (sizeof(typename Variant::node) + sizeof(std::uint32_t))
+                             + std::size_t(t.lists) * sizeof(typename Variant::list_type) + (std::size_t(1) << 16);
+        arena a(capacity);
+        arena::current = a.begin;
+
+        variant_result r;
+        r.name = name;
+        r.ops = t.ops.size();
+
+        bool peak_reset = reset_peak_rss();
+        long rss_before = read_status_kb("VmRSS");
+
+        double best = std::numeric_limits<double>::max();
+        for (int run = 0; run != throughput_runs; ++run)
+        {
+            a.reset();
+            Variant v(a, t);
+            std::uint64_t h = 0;
+            auto start = clock::now();
+            for (replay::op const& o : t.ops)
+                h = hash_step(h, apply(v, o));
+            auto stop = clock::now();
+            best = std::min(best, std::chrono::duration<double>(stop - start).count());
+            r.checksum = hash_step(h, final_state(v));
+        }
+        r.ops_per_sec = best > 0 ? double(t.ops.size()) / best : 0.;
+
+        {
+            a.reset();
+            Variant v(a, t);
+            std::uint64_t h = 0;
+            for (std::size_t i = 0; i != t.ops.size(); ++i)
+            {
+                auto start = clock::now();
+                h = hash_step(h, apply(v, t.ops[i]));
+                auto stop = clock::now();
+                std::uint64_t ns = std::uint64_t((stop - start).count());
+                ns = ns > ctx.overhead_ns ? ns - ctx.overhead_ns : 0;
+                ctx.latencies[i] = std::uint32_t(std::min<std::uint64_t>(ns, std::numeric_limits<std::uint32_t>::max()));
+            }
+            if (hash_step(h, final_state(v)) != r.checksum)
+                throw std::runtime_error(std::string(name) + " is not deterministic: runs ended in different states");
+        }
+
+        long peak = read_status_kb("VmHWM");
+        if (peak_reset && peak >= 0 && rss_before >= 0)
+            r.rss_kb = std::max(0L, peak - rss_before);
+
+        if (!t.ops.empty())
+        {
+            auto& lat = ctx.latencies;
+            std::sort(lat.begin(), lat.end());
+            auto q = [&](double p) {
+                return lat[std::min(lat.size() - 1, std::size_t(p * double(lat.size())))];
+            };
+            r.p50 = q(0.5);
+            r.p90 = q(0.9);
+            r.p99 = q(0.99);
+            r.p999 = q(0.999);
+            r.max = lat.back();
+        }
+        return r;
+    }
+
+    void print(variant_result const& r)
+    {
+        char rss[32];
+        if (r.rss_kb >= 0)
+            std::snprintf(rss, sizeof rss, "%ld", r.rss_kb);
+        else
+            std::snprintf(rss, sizeof rss, "n/a");
+        std::printf("%-14s %10zu ops %8.2f Mops/s  p50 %6llu  p90 %6llu  p99 %6llu  p99.9 %7llu  max %9llu ns  rss %8s KiB\n",
+            r.name.c_str(), r.ops, r.ops_per_sec / 1e6,
+            (unsigned long long)r.p50, (unsigned long long)r.p90, (unsigned long long)r.p99,
+            (unsigned long long)r.p999, (unsigned long long)r.max, rss);
+        std::fflush(stdout);
+    }
+
+    void save_csv(char const* path, std::vector<variant_result> const& results)
+    {
+        std::ofstream out(path);
+        if (!out)
+            throw std::runtime_error(std::string("can't write ") + path);
+        out << "variant,ops,ops_per_sec,p50_ns,p90_ns,p99_ns,p999_ns,max_ns,rss_kb\n";
+        for (variant_result const& r : results)
+            out << r.name << ',' << r.ops << ',' << r.ops_per_sec << ',' << r.p50 << ',' << r.p90 << ','
+                << r.p99 << ',' << r.p999 << ',' << r.max << ',' << r.rss_kb << '\n';
+    }
+
+    std::map<std::string, variant_result> load_csv(char const* path)
+    {
+        std::ifstream in(path);
+        if (!in)
+            throw std::runtime_error(std::string("can't read ") + path);
+
+        std::map<std::string, variant_result> results;
+        std::string line;
+        std::getline(in, line);
+        while (std::getline(in, line))
+        {
+            char name[64];
+            variant_result r;
+            unsigned long long p[5];
+            if (std::sscanf(line.c_str(), "%63[^,],%zu,%lf,%llu,%llu,%llu,%llu,%llu,%ld",
+                    name, &r.ops, &r.ops_per_sec, &p[0], &p[1], &p[2], &p[3], &p[4], &r.rss_kb) != 9)
+                throw std::runtime_error(std::string("bad line in ") + path + ": " + line);
+            r.name = name;
+            r.p50 = p[0];
+            r.p90 = p[1];
+            r.p99 = p[2];
+            r.p999 = p[3];
+            r.max = p[4];
+            results[r.name] = r;
+        }
+        return results;
+    }
+
+    /*
+    Количество ухудшений относительно baseline.
+    */
+    int compare(std::vector<variant_result> const& results,
+                std::map<std::string, variant_result> const& baseline, double tolerance)
+    {
+        int regressions = 0;
+        for (variant_result const& r : results)
+        {
+            auto it = baseline.find(r.name);
+            if (it == baseline.end())
+                continue;
+            variant_result const& b = it->second;
+
+            if (r.ops_per_sec < b.ops_per_sec * (1 - tolerance))
+            {
+                std::printf("REGRESSION %s: %.2f Mops/s, baseline %.2f\n", r.name.c_str(), r.ops_per_sec / 1e6, b.ops_per_sec / 1e6);
+                ++regressions;
+            }
+            if (double(r.p99) > double(b.p99) * (1 + tolerance))
+            {
+                std::printf("REGRESSION %s: p99 %llu ns, baseline %llu\n", r.name.c_str(),
+                    (unsigned long long)r.p99, (unsigned long long)b.p99);
+                ++regressions;
+            }
+            if (r.rss_kb >= 0 && b.rss_kb >= 0 && double(r.rss_kb) > double(b.rss_kb) * (1 + tolerance))
+            {
+                std::printf("REGRESSION %s: rss %ld KiB, baseline %ld\n", r.name.c_str(), r.rss_kb, b.rss_kb);
+                ++regressions;
+            }
+        }
+        return regressions;
+    }
+
+    bool parse_flag(char const* arg, char const* flag, char const*& value)
+    {
+        std::size_t len = std::strlen(flag);
+        if (std::strncmp(arg, flag, len) != 0)
+            return false;
+        value = arg + len;
+        return true;
+    }
+
+    void usage(char const* self)
+    {
+        std::fprintf(stderr,
+            "usage: %s [--trace=file | --workload=zipf|bursty [--ops=N] [--lists=N] [--objects=N]\n"
+            "          [--zipf=S] [--burst-period=N] [--seed=N]] [--record=file] [--variant=substr]\n"
+            "          [--save=file] [--baseline=file] [--tolerance=F]\n",
+            self);
+    }
+
+    struct options
+    {
+        replay::synthetic_options synthetic;
+        char const* trace_path = nullptr;
+        char const* record_path = nullptr;
+        char const* save_path = nullptr;
+        char const* baseline_path = nullptr;
+        std::string filter;
+        double tolerance = 0.1;
+    };
+
+    bool parse_options(int argc, char** argv, options& opts)
+    {
+        for (int i = 1; i != argc; ++i)
+        {
+            char const* arg = argv[i];
+            char const* v = nullptr;
+            if (parse_flag(arg, "--trace=", v))
+                opts.trace_path = v;
+            else if (parse_flag(arg, "--workload=", v))
+                opts.synthetic.workload = v;
+            else if (parse_flag(arg, "--ops=", v))
+                opts.synthetic.ops = std::size_t(std::strtoull(v, nullptr, 10));
+            else if (parse_flag(arg, "--lists=", v))
+                opts.synthetic.lists = std::uint32_t(std::strtoul(v, nullptr, 10));
+            else if (parse_flag(arg, "--objects=", v))
+                opts.synthetic.objects = std::uint32_t(std::strtoul(v, nullptr, 10));
+            else if (parse_flag(arg, "--zipf=", v))
+                opts.synthetic.zipf_s = std::strtod(v, nullptr);
+            else if (parse_flag(arg, "--burst-period=", v))
+                opts.synthetic.burst_period = std::max<std::size_t>(1, std::strtoull(v, nullptr, 10));
+            else if (parse_flag(arg, "--seed=", v))
+                opts.synthetic.seed = std::uint32_t(std::strtoul(v, nullptr, 10));
+            else if (parse_flag(arg, "--record=", v))
+                opts.record_path = v;
+            else if (parse_flag(arg, "--variant=", v))
+                opts.filter = v;
+            else if (parse_flag(arg, "--save=", v))
+                opts.save_path = v;
+            else if (parse_flag(arg, "--baseline=", v))
+                opts.baseline_path = v;
+            else if (parse_flag(arg, "--tolerance=", v))
+                opts.tolerance = std::strtod(v, nullptr);
+            else
+                return false;
+        }
+        return true;
+    }
+
+    int run(options const& opts)
+    {
+        replay::trace t;
+        if (opts.trace_path)
+        {
+            std::ifstream in(opts.trace_path);
+            if (!in)
+                throw std::runtime_error(std::string("can't read ") + opts.trace_path);
+            t = replay::read_trace(in);
+        }
+        else
+            t = replay::generate(opts.synthetic);
+
+        if (opts.record_path)
+        {
+            std::ofstream out(opts.record_path);
+            replay::write_trace(out, t);
+            if (!out)
+                throw std::runtime_error(std::string("can't write ") + opts.record_path);
+        }
+
+        std::printf("# %u lists, %u objects, %zu ops\n", t.lists, t.objects, t.ops.size());
+
+        std::vector<std::uint32_t> latencies(t.ops.size());
+        run_context ctx{t, latencies, timer_overhead_ns()};
+        std::vector<variant_result> results;
+
+        auto run_one = [&](auto tag, char const* name) {
+            if (!opts.filter.empty() && std::string(name).find(opts.filter) == std::string::npos)
+                return;
+            using variant = typename decltype(tag)::type;
+            results.push_back(run_variant<variant>(name, ctx));
+            print(results.back());
+            if (results.back().checksum != results.front().checksum)
+                throw std::runtime_error(std::string(name) + " ended with different list contents than "
+                                         + results.front().name);
+        };
+
+        run_one(type_tag<plain_list>(), "list");
+        run_one(type_tag<normal_list>(), "list_normal");
+        run_one(type_tag<counted_list>(), "list_counted");
+        run_one(type_tag<index_list>(), "list_index");
+        run_one(type_tag<slist_variant>(), "slist");
+        run_one(type_tag<lazy_variant>(), "lazy_list");
+
+        if (opts.save_path)
+            save_csv(opts.save_path, results);
+        if (opts.baseline_path && compare(results, load_csv(opts.baseline_path), opts.tolerance) != 0)
+            return 2;
+        return 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    options opts;
+    if (!parse_options(argc, argv, opts))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        return run(opts);
+    }
+    catch (std::exception const& e)
+    {
+        std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+        return 1;
+    }
+}
@@ -0,0 +1,435 @@
+#include "replay_trace.h"
+#include "intrusive_list.h"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <istream>
+#include <iterator>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    constexpr std::uint32_t no_list = std::uint32_t(-1);
+
+    struct model_node : intrusive::list_element<>
+    {
+        std::uint32_t id = 0;
+        std::uint32_t owner = no_list;
+    };
+
+    /*
+    Состояние списков по ходу трассы. По нему проверяется каждая
+    следующая операция, а генератор по нему же выбирает, что удалять.
+    */
+    struct model
+    {
+        model(std::uint32_t lists, std::uint32_t objects)
+            : nodes(std::make_unique<model_node[]>(objects))
+            , lists(std::make_unique<intrusive::list<model_node>[]>(lists))
+            , sizes(lists)
+            , list_count(lists)
+            , object_count(objects)
+        {
+            for (std::uint32_t i = 0; i != objects; ++i)
+                nodes[i].id = i;
+        }
+
+        /*
+        Пустая строка, если операцию можно выполнить.
+        */
+        std::string check(replay::op const& o) const
+        {
+            switch (o.kind)
+            {
+            case replay::op_kind::push_back:
+            case replay::op_kind::push_front:
+                if (o.a >= list_count)
+                    return "no such list";
+                if (o.b >= object_count)
+                    return "no such object";
+                if (nodes[o.b].owner != no_list)
+                    return "object is already in a list";
+                return {};
+            case replay::op_kind::erase:
+                if (o.a >= object_count)
+                    return "no such object";
+                if (nodes[o.a].owner == no_list)
+                    return "object is not in a list";
+                return {};
+            case replay::op_kind::pop_front:
+                if (o.a >= list_count)
+                    return "no such list";
+                if (sizes[o.a] == 0)
+                    return "pop_front from an empty list";
+                return {};
+            case replay::op_kind::splice:
+                if (o.a >= list_count || o.b >= list_count)
+                    return "no such list";
+                if (o.a == o.b)
+                    return "splice into the same list";
+                if (o.c > sizes[o.b])
+                    return "splice of more elements than the list has";
+                return {};
+            case replay::op_kind::scan:
+                if (o.a >= list_count)
+                    return "no such list";
+                return {};
+            }
+            return "unknown operation";
+        }
+
+        /*
+        Выполняет уже проверенную операцию. У erase заполняет список.
+        */
+        void apply(replay::op& o)
+        {
+            switch (o.kind)
+            {
+            case replay::op_kind::push_back:
+                lists[o.a].push_back(nodes[o.b]);
+                nodes[o.b].owner = o.a;
+                ++sizes[o.a];
+                break;
+            case replay::op_kind::push_front:
+                lists[o.a].push_front(nodes[o.b]);
+                nodes[o.b].owner = o.a;
+                ++sizes[o.a];
+                break;
+            case replay::op_kind::erase:
+                o.b = nodes[o.a].owner;
+                remove(nodes[o.a]);
+                break;
+            case replay::op_kind::pop_front:
+                remove(lists[o.a].front());
+                break;
+            case replay::op_kind::splice:
+            {
+                auto& src = lists[o.b];
+                auto last = src.begin();
+                for (std::uint32_t i = 0; i != o.c; ++i, ++last)
+                    last->owner = o.a;
+                lists[o.a].splice(lists[o.a].end(), src, src.begin(), last);
+                sizes[o.b] -= o.c;
+                sizes[o.a] += o.c;
+                break;
+            }
+            case replay::op_kind::scan:
+                break;
+            }
+        }
+
+        void remove(model_node& x)
+        {
+            --sizes[x.owner];
+            x.owner = no_list;
+            x.unlink();
+        }
+
+        std::uint32_t at(std::uint32_t list, std::size_t pos)
+        {
+            return std::next(lists[list].begin(), std::ptrdiff_t(pos))->id;
+        }
+
+        std::unique_ptr<model_node[]> nodes;
+        std::unique_ptr<intrusive::list<model_node>[]> lists;
+        std::vector<std::size_t> sizes;
+        std::uint32_t list_count;
+        std::uint32_t object_count;
+    };
+
+    /*
+    Zipf на [0, n): P(k) пропорциональна 1 / (k + 1)^s. Таблица
+    накопленных вероятностей и двоичный поиск по ней.
+    */
+    struct zipf_distribution
+    {
+        zipf_distribution(std::size_t n, double s)
+            : cdf(n)
+        {
+            double sum = 0;
+            for (std::size_t k = 0; k != n; ++k)
+            {
+                sum += 1. / std::pow(double(k + 1), s);
+                cdf[k] = sum;
+            }
+        }
+
+        std::size_t operator()(std::mt19937_64& rng) const
+        {
+            double u = std::uniform_real_distribution<double>(0., cdf.back())(rng);
+            auto k = std::size_t(std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin());
+            return std::min(k, cdf.size() - 1);
+        }
+
+        std::vector<double> cdf;
+    };
+
+    /*
+    Генератор пишет операции в трассу и сразу применяет их к модели.
+    Свободные объекты берутся в порядке освобождения, так что объект
+    возвращается в список не сразу после удаления.
+    */
+    struct builder
+    {
+        explicit builder(replay::synthetic_options const& opts)
+            : m(opts.lists, opts.objects)
+            , rng(opts.seed)
+        {
+            t.lists = opts.lists;
+            t.objects = opts.objects;
+            t.ops.reserve(opts.ops);
+            for (std::uint32_t i = 0; i != opts.objects; ++i)
+                free.push_back(i);
+        }
+
+        void emit(replay::op o)
+        {
+            m.apply(o);
+            t.ops.push_back(o);
+        }
+
+        std::uint32_t random_list()
+        {
+            return std::uint32_t(rng() % t.lists);
+        }
+
+        /*
+        no_list, если за несколько попыток непустой не нашелся.
+        */
+        std::uint32_t random_non_empty_list()
+        {
+            for (int attempt = 0; attempt != 8; ++attempt)
+            {
+                std::uint32_t l = random_list();
+                if (m.sizes[l] != 0)
+                    return l;
+            }
+            return no_list;
+        }
+
+        void push_back(std::uint32_t list)
+        {
+            std::uint32_t obj = free.front();
+            free.pop_front();
+            emit({replay::op_kind::push_back, list, obj, 0});
+            ++live;
+        }
+
+        void erase_at(std::uint32_t list, std::size_t pos)
+        {
+            std::uint32_t obj = m.at(list, pos);
+            emit({replay::op_kind::erase, obj, 0, 0});
+            free.push_back(obj);
+            --live;
+        }
+
+        void pop_front(std::uint32_t list)
+        {
+            std::uint32_t obj = m.at(list, 0);
+            emit({replay::op_kind::pop_front, list, 0, 0});
+            free.push_back(obj);
+            --live;
+        }
+
+        void splice(std::uint32_t dst, std::uint32_t src, std::size_t count)
+        {
+            emit({replay::op_kind::splice, dst, src, std::uint32_t(count)});
+        }
+
+        std::uint32_t other_list(std::uint32_t list)
+        {
+            std::uint32_t l = std::uint32_t(rng() % (t.lists - 1));
+            return l < list ? l : l + 1;
+        }
+
+        bool done(std::size_t ops) const
+        {
+            return t.ops.size() >= ops;
+        }
+
+        model m;
+        replay::trace t;
+        std::deque<std::uint32_t> free;
+        std::size_t live = 0;
+        std::mt19937_64 rng;
+    };
+
+    void generate_zipf(builder& b, replay::synthetic_options const& opts)
+    {
+        std::size_t target = opts.objects / 2;
+        zipf_distribution position(std::max<std::size_t>(1, opts.objects / opts.lists), opts.zipf_s);
+
+        while (!b.done(opts.ops) && b.live < target)
+            b.push_back(b.random_list());
+
+        while (!b.done(opts.ops))
+        {
+            std::uint64_t r = b.rng() % 1000;
+            std::uint32_t l = b.random_non_empty_list();
+
+            if (r < 2)
+                b.emit({replay::op_kind::scan, b.random_list(), 0, 0});
+            else if (r < 40 && l != no_list && opts.lists > 1)
+                b.splice(b.other_list(l), l, 1 + position(b.rng) % b.m.sizes[l]);
+            else if ((l == no_list || b.live < target) && !b.free.empty())
+                b.push_back(b.random_list());
+            else if (l == no_list)
+                b.emit({replay::op_kind::scan, b.random_list(), 0, 0});
+            else if (r < 140)
+                b.pop_front(l);
+            else
+                b.erase_at(l, position(b.rng) % b.m.sizes[l]);
+        }
+    }
+
+    void generate_bursty(builder& b, replay::synthetic_options const& opts)
+    {
+        std::size_t target = opts.objects / 4;
+        std::uint32_t burst_splices = std::max<std::uint32_t>(1, opts.lists / 4);
+
+        while (!b.done(opts.ops) && b.live < target)
+            b.push_back(b.random_list());
+
+        for (std::size_t i = 1; !b.done(opts.ops); ++i)
+        {
+            if (i % opts.burst_period == 0 && opts.lists > 1)
+            {
+                for (std::uint32_t k = 0; k != burst_splices && !b.done(opts.ops); ++k)
+                {
+                    std::uint32_t l = b.random_non_empty_list();
+                    if (l != no_list)
+                        b.splice(b.other_list(l), l, (b.m.sizes[l] + 1) / 2);
+                }
+                for (std::size_t k = 0; k != opts.objects / 64 && !b.done(opts.ops); ++k)
+                {
+                    std::uint32_t l = b.random_non_empty_list();
+                    if (l != no_list)
+                        b.erase_at(l, b.rng() % b.m.sizes[l]);
+                }
+                continue;
+            }
+
+            std::uint32_t l = b.random_non_empty_list();
+            bool push = l == no_list || b.rng() % 100 < (b.live < target ? 60u : 40u);
+            if (push && !b.free.empty())
+                b.push_back(b.random_list());
+            else if (l != no_list)
+                b.pop_front(l);
+        }
+    }
+
+    [[noreturn]] void fail(std::size_t line, std::string const& message)
+    {
+        throw std::runtime_error("line " + std::to_string(line) + ": " + message);
+    }
+
+    struct op_name
+    {
+        char const* name;
+        replay::op_kind kind;
+        int args;
+    };
+
+    constexpr op_name op_names[] = {
+        {"push_back", replay::op_kind::push_back, 2},
+        {"push_front", replay::op_kind::push_front, 2},
+        {"erase", replay::op_kind::erase, 1},
+        {"pop_front", replay::op_kind::pop_front, 1},
+        {"splice", replay::op_kind::splice, 3},
+        {"scan", replay::op_kind::scan, 1},
+    };
+
+    bool read_header(std::istringstream& in, char const* key, std::string const& word, std::uint32_t& value)
+    {
+        if (word != key)
+            return false;
+        in >> value;
+        return bool(in);
+    }
+}
+
+replay::trace replay::read_trace(std::istream& in)
+{
+    trace t;
+    std::unique_ptr<model> m;
+    std::string line;
+    std::size_t line_number = 0;
+
+    while (std::getline(in, line))
+    {
+        ++line_number;
+        line.erase(std::find(line.begin(), line.end(), '#'), line.end());
+        std::istringstream words(line);
+        std::string word;
+        if (!(words >> word))
+            continue;
+
+        if (!m)
+        {
+            if (!read_header(words, "lists", word, t.lists) && !read_header(words, "objects", word, t.objects))
+                fail(line_number, "expected 'lists N' and 'objects N' before the first operation");
+            if (words >> word)
+                fail(line_number, "unexpected '" + word + "' after the header value");
+            if (t.lists != 0 && t.objects != 0)
+                m = std::make_unique<model>(t.lists, t.objects);
+            continue;
+        }
+
+        auto name = std::find_if(std::begin(op_names), std::end(op_names),
+                                 [&](op_name const& n) { return word == n.name; });
+        if (name == std::end(op_names))
+            fail(line_number, "unknown operation '" + word + "'");
+
+        std::uint32_t args[3] = {0, 0, 0};
+        for (int i = 0; i != name->args; ++i)
+            if (!(words >> args[i]))
+                fail(line_number, std::string(name->name) + " needs " + std::to_string(name->args) + " arguments");
+        if (words >> word)
+            fail(line_number, "unexpected '" + word + "' after the arguments of " + name->name);
+
+        op o{name->kind, args[0], args[1], args[2]};
+        std::string error = m->check(o);
+        if (!error.empty())
+            fail(line_number, error);
+        m->apply(o);
+        t.ops.push_back(o);
+    }
+
+    if (!m)
+        throw std::runtime_error("trace has no 'lists N' and 'objects N' header");
+    return t;
+}
+
+void replay::write_trace(std::ostream& out, trace const& t)
+{
+    out << "lists " << t.lists << '\n' << "objects " << t.objects << '\n';
+    for (op const& o : t.ops)
+    {
+        op_name const& name = op_names[std::size_t(o.kind)];
+        out << name.name << ' ' << o.a;
+        if (name.args > 1)
+            out << ' ' << o.b;
+        if (name.args > 2)
+            out << ' ' << o.c;
+        out << '\n';
+    }
+}
+
+replay::trace replay::generate(synthetic_options const& opts)
+{
+    if (opts.lists == 0 || opts.objects == 0)
+        throw std::runtime_error("synthetic trace needs at least one list and one object");
+
+    builder b(opts);
+    if (opts.workload == "zipf")
+        generate_zipf(b, opts);
+    else if (opts.workload == "bursty")
+        generate_bursty(b, opts);
+    else
+        throw std::runtime_error("unknown workload '" + opts.workload + "', expected zipf or bursty");
+    return std::move(b.t);
+}
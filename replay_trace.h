@@ -0,0 +1,98 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/*
+Трасса операций над множеством списков для intrusive_list_replay.
+
+Трасса -- это lists списков и objects объектов, каждый объект в любой
+момент лежит не больше чем в одном списке. Текстовый формат, одна
+операция на строку, # -- комментарий до конца строки:
+
+lists 64
+objects 100000
+push_back 3 17        объект 17 в конец списка 3
+push_front 3 18
+erase 17              объект 17 из того списка, где он лежит
+pop_front 3
+splice 5 3 10         первые 10 элементов списка 3 в конец списка 5
+scan 5                обход списка 5
+
+Строки lists и objects идут первыми, лишние слова в строке -- ошибка.
+Трасса проверяется при чтении и генерации: вставлять можно только
+свободный объект, удалять -- только лежащий в списке, pop_front --
+только из непустого, splice не может взять больше, чем есть. Поэтому реализации при воспроизведении ничего
+не проверяют, а у erase уже записано, в каком списке лежит объект:
+это нужно тем, у кого элемент не отвязывается сам.
+*/
+namespace replay
+{
+    enum class op_kind : std::uint8_t
+    {
+        push_back,
+        push_front,
+        erase,
+        pop_front,
+        splice,
+        scan,
+    };
+
+    /*
+    push_back/push_front: a -- список, b -- объект.
+    erase: a -- объект, b -- список, в котором он лежит.
+    pop_front, scan: a -- список.
+    splice: a -- куда, b -- откуда, c -- сколько.
+    */
+    struct op
+    {
+        op_kind kind;
+        std::uint32_t a;
+        std::uint32_t b;
+        std::uint32_t c;
+    };
+
+    struct trace
+    {
+        std::uint32_t lists = 0;
+        std::uint32_t objects = 0;
+        std::vector<op> ops;
+    };
+
+    /*
+    Синтетическая нагрузка. ops -- длина всей трассы, вместе с
+    начальным заполнением списков.
+
+    zipf -- списки держатся заполненными примерно наполовину objects;
+    вставки в конец случайного списка, удаления по ссылке с позиции,
+    распределенной по Zipf с показателем zipf_s на [0, objects / lists),
+    то есть на удвоенную среднюю длину списка (чаще всего удаляются
+    элементы у головы: отмена таймаутов и запросов в очередях), около
+    10% pop_front, 4% splice с длиной по тому же Zipf и 0.2% обходов.
+
+    bursty -- очереди: push_back и pop_front, а каждые burst_period
+    операций всплеск: половины нескольких списков переезжают в другие
+    списки splice'ами, и следом идет пачка удалений со случайных
+    позиций.
+    */
+    struct synthetic_options
+    {
+        std::string workload = "zipf";
+        std::size_t ops = 1000000;
+        std::uint32_t lists = 64;
+        std::uint32_t objects = 100000;
+        double zipf_s = 1.0;
+        std::size_t burst_period = 4096;
+        std::uint32_t seed = 42;
+    };
+
+    /*
+    read_trace бросает std::runtime_error с номером строки, если
+    формат неправильный или трасса некорректна.
+    */
+    trace read_trace(std::istream&);
+    void write_trace(std::ostream&, trace const&);
+    trace generate(synthetic_options const&);
+}
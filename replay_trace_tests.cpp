@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+#include "replay_trace.h"
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    replay::trace parse(std::string const& text)
+    {
+        std::istringstream in(text);
+        return replay::read_trace(in);
+    }
+
+    /*
+    Текст исключения read_trace или пустая строка, если трасса
+    прочиталась.
+    */
+    std::string read_error(std::string const& text)
+    {
+        try
+        {
+            parse(text);
+        }
+        catch (std::runtime_error const& e)
+        {
+            return e.what();
+        }
+        return {};
+    }
+
+    void expect_same(replay::trace const& expected, replay::trace const& actual)
+    {
+        EXPECT_EQ(expected.lists, actual.lists);
+        EXPECT_EQ(expected.objects, actual.objects);
+        ASSERT_EQ(expected.ops.size(), actual.ops.size());
+        for (std::size_t i = 0; i != expected.ops.size(); ++i)
+        {
+            EXPECT_EQ(expected.ops[i].kind, actual.ops[i].kind) << "op " << i;
+            EXPECT_EQ(expected.ops[i].a, actual.ops[i].a) << "op " << i;
+            EXPECT_EQ(expected.ops[i].b, actual.ops[i].b) << "op " << i;
+            EXPECT_EQ(expected.ops[i].c, actual.ops[i].c) << "op " << i;
+        }
+    }
+
+    /*
+    Сгенерированная трасса должна проходить проверку read_trace.
+    */
+    void check_generated(replay::synthetic_options const& opts)
+    {
+        replay::trace t = replay::generate(opts);
+        EXPECT_EQ(opts.ops, t.ops.size());
+        EXPECT_EQ(opts.lists, t.lists);
+        EXPECT_EQ(opts.objects, t.objects);
+
+        std::ostringstream out;
+        replay::write_trace(out, t);
+        replay::trace back;
+        ASSERT_NO_THROW(back = parse(out.str()));
+        expect_same(t, back);
+    }
+
+    char const header[] = "lists 2\nobjects 3\n";
+}
+
+TEST(intrusive_replay_trace_testing, read)
+{
+    replay::trace t = parse(
+        "# comment\n"
+        "lists 2\n"
+        "\n"
+        "objects 3   # trailing comment\n"
+        "push_back 0 1\n"
+        "push_front 0 2\n"
+        "splice 1 0 2\n"
+        "erase 1\n"
+        "scan 1\n"
+        "pop_front 1\n");
+
+    EXPECT_EQ(2u, t.lists);
+    EXPECT_EQ(3u, t.objects);
+    ASSERT_EQ(6u, t.ops.size());
+    EXPECT_EQ(replay::op_kind::push_back, t.ops[0].kind);
+    EXPECT_EQ(0u, t.ops[0].a);
+    EXPECT_EQ(1u, t.ops[0].b);
+    EXPECT_EQ(replay::op_kind::splice, t.ops[2].kind);
+    EXPECT_EQ(1u, t.ops[2].a);
+    EXPECT_EQ(0u, t.ops[2].b);
+    EXPECT_EQ(2u, t.ops[2].c);
+    EXPECT_EQ(replay::op_kind::erase, t.ops[3].kind);
+    EXPECT_EQ(1u, t.ops[3].a);
+    EXPECT_EQ(1u, t.ops[3].b);
+    EXPECT_EQ(replay::op_kind::pop_front, t.ops[5].kind);
+}
+
+TEST(intrusive_replay_trace_testing, round_trip)
+{
+    replay::trace t = parse(std::string(header) +
+        "push_back 1 0\n"
+        "push_back 1 1\n"
+        "push_front 0 2\n"
+        "erase 0\n"
+        "splice 0 1 1\n"
+        "scan 0\n"
+        "pop_front 0\n");
+
+    std::ostringstream out;
+    replay::write_trace(out, t);
+    expect_same(t, parse(out.str()));
+}
+
+TEST(intrusive_replay_trace_testing, rejects_invalid_ops)
+{
+    std::string h = header;
+    EXPECT_EQ("line 3: no such list", read_error(h + "push_back 2 0\n"));
+    EXPECT_EQ("line 3: no such object", read_error(h + "push_front 0 3\n"));
+    EXPECT_EQ("line 4: object is already in a list", read_error(h + "push_back 0 1\npush_back 1 1\n"));
+    EXPECT_EQ("line 3: no such object", read_error(h + "erase 3\n"));
+    EXPECT_EQ("line 3: object is not in a list", read_error(h + "erase 0\n"));
+    EXPECT_EQ("line 5: object is not in a list", read_error(h + "push_back 0 0\nerase 0\nerase 0\n"));
+    EXPECT_EQ("line 3: no such list", read_error(h + "pop_front 5\n"));
+    EXPECT_EQ("line 3: pop_front from an empty list", read_error(h + "pop_front 0\n"));
+    EXPECT_EQ("line 3: no such list", read_error(h + "splice 0 2 0\n"));
+    EXPECT_EQ("line 3: splice into the same list", read_error(h + "splice 1 1 0\n"));
+    EXPECT_EQ("line 4: splice of more elements than the list has", read_error(h + "push_back 0 0\nsplice 1 0 2\n"));
+    EXPECT_EQ("line 3: no such list", read_error(h + "scan 2\n"));
+}
+
+TEST(intrusive_replay_trace_testing, rejects_malformed_lines)
+{
+    std::string h = header;
+    EXPECT_EQ("line 3: unknown operation 'push'", read_error(h + "push 0 0\n"));
+    EXPECT_EQ("line 3: push_back needs 2 arguments", read_error(h + "push_back 0\n"));
+    EXPECT_EQ("line 3: splice needs 3 arguments", read_error(h + "splice 0 1 x\n"));
+    EXPECT_EQ("line 3: unexpected '1' after the arguments of push_back", read_error(h + "push_back 0 0 1\n"));
+    EXPECT_EQ("line 4: unexpected '1' after the arguments of erase", read_error(h + "push_back 0 0\nerase 0 1\n"));
+    EXPECT_EQ("line 4: unexpected '7' after the arguments of scan", read_error(h + "push_back 0 0\nscan 0 7\n"));
+    EXPECT_EQ("line 1: unexpected 'x' after the header value", read_error("lists 2 x\nobjects 3\n"));
+    EXPECT_EQ("line 1: expected 'lists N' and 'objects N' before the first operation", read_error("push_back 0 0\n"));
+    EXPECT_EQ("line 2: expected 'lists N' and 'objects N' before the first operation", read_error("lists 2\nscan 0\n"));
+    EXPECT_EQ("trace has no 'lists N' and 'objects N' header", read_error("# empty\n"));
+}
+
+TEST(intrusive_replay_trace_testing, generate_zipf)
+{
+    replay::synthetic_options opts;
+    opts.ops = 5000;
+    opts.lists = 8;
+    opts.objects = 500;
+    check_generated(opts);
+}
+
+TEST(intrusive_replay_trace_testing, generate_bursty)
+{
+    replay::synthetic_options opts;
+    opts.workload = "bursty";
+    opts.ops = 5000;
+    opts.lists = 8;
+    opts.objects = 500;
+    opts.burst_period = 100;
+    check_generated(opts);
+}
+
+TEST(intrusive_replay_trace_testing, generate_single_list)
+{
+    for (char const* workload : {"zipf", "bursty"})
+    {
+        SCOPED_TRACE(workload);
+        replay::synthetic_options opts;
+        opts.workload = workload;
+        opts.ops = 2000;
+        opts.lists = 1;
+        opts.objects = 100;
+        opts.burst_period = 50;
+        check_generated(opts);
+    }
+}
+
+TEST(intrusive_replay_trace_testing, generate_fewer_objects_than_lists)
+{
+    for (char const* workload : {"zipf", "bursty"})
+    {
+        SCOPED_TRACE(workload);
+        replay::synthetic_options opts;
+        opts.workload = workload;
+        opts.ops = 2000;
+        opts.lists = 16;
+        opts.objects = 5;
+        opts.burst_period = 50;
+        check_generated(opts);
+    }
+}
+
+TEST(intrusive_replay_trace_testing, generate_rejects_bad_options)
+{
+    replay::synthetic_options opts;
+    opts.ops = 10;
+    opts.lists = 0;
+    EXPECT_THROW(replay::generate(opts), std::runtime_error);
+
+    opts.lists = 4;
+    opts.objects = 0;
+    EXPECT_THROW(replay::generate(opts), std::runtime_error);
+
+    opts.objects = 10;
+    opts.workload = "uniform";
+    EXPECT_THROW(replay::generate(opts), std::runtime_error);
+}
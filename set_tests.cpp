@@ -0,0 +1,356 @@
+#include <gtest/gtest.h>
+#include "intrusive_set.h"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace
+{
+    struct snode : intrusive::set_element<>
+    {
+        explicit snode(int key = 0, int id = 0)
+            : key(key)
+            , id(id)
+        {}
+
+        int key;
+        int id;
+
+        friend bool operator<(snode const& a, snode const& b)
+        {
+            return a.key < b.key;
+        }
+    };
+
+    struct by_key
+    {
+        using is_transparent = void;
+
+        bool operator()(snode const& a, snode const& b) const
+        {
+            return a.key < b.key;
+        }
+
+        bool operator()(snode const& a, int b) const
+        {
+            return a.key < b;
+        }
+
+        bool operator()(int a, snode const& b) const
+        {
+            return a < b.key;
+        }
+    };
+
+    using sset = intrusive::set<snode>;
+    using smultiset = intrusive::multiset<snode, intrusive::default_tag, by_key>;
+
+    template <typename Set>
+    std::vector<int> keys(Set const& s)
+    {
+        std::vector<int> result;
+        for (snode const& x : s)
+            result.push_back(x.key);
+        return result;
+    }
+
+    /*
+    Высота по черным узлам. Проверяет, что у красных узлов черные
+    дети, что ссылки на родителей согласованы и что порядок не
+    нарушен.
+    */
+    int check_subtree(intrusive::set_element_base const* x, intrusive::set_element_base const* parent)
+    {
+        if (x == nullptr)
+            return 1;
+        EXPECT_EQ(parent, x->parent);
+        if (x->red)
+        {
+            EXPECT_TRUE(x->left == nullptr || !x->left->red);
+            EXPECT_TRUE(x->right == nullptr || !x->right->red);
+        }
+        int lh = check_subtree(x->left, x);
+        int rh = check_subtree(x->right, x);
+        EXPECT_EQ(lh, rh);
+        return lh + (x->red ? 0 : 1);
+    }
+
+    template <typename Set>
+    void check_invariants(Set& s)
+    {
+        if (s.empty())
+            return;
+        intrusive::set_element_base* header = &intrusive::to_base<intrusive::default_tag>(s.front());
+        while (!header->is_header())
+            header = header->parent;
+
+        intrusive::set_element_base* root = header->parent;
+        EXPECT_FALSE(root->red);
+        check_subtree(root, header);
+        EXPECT_EQ(&intrusive::to_base<intrusive::default_tag>(s.front()), header->left);
+        EXPECT_EQ(&intrusive::to_base<intrusive::default_tag>(s.back()), header->right);
+        EXPECT_TRUE(std::is_sorted(s.begin(), s.end(), by_key()));
+    }
+}
+
+TEST(intrusive_set_testing, unique_insert_and_lookup)
+{
+    snode a(5), b(1), c(9), d(5), e(3);
+    sset s;
+    EXPECT_TRUE(s.empty());
+    EXPECT_TRUE(s.begin() == s.end());
+
+    EXPECT_TRUE(s.insert(a).second);
+    EXPECT_TRUE(s.insert(b).second);
+    EXPECT_TRUE(s.insert(c).second);
+    auto r = s.insert(d);
+    EXPECT_FALSE(r.second);
+    EXPECT_EQ(&a, &*r.first);
+    EXPECT_FALSE(d.is_linked());
+    EXPECT_TRUE(s.insert(e).second);
+
+    EXPECT_EQ((std::vector<int>{1, 3, 5, 9}), keys(s));
+    EXPECT_EQ(4u, s.size());
+    check_invariants(s);
+
+    snode probe(5);
+    EXPECT_EQ(&a, &*s.find(probe));
+    snode missing(4);
+    EXPECT_TRUE(s.find(missing) == s.end());
+    EXPECT_EQ(&a, &*s.lower_bound(missing));
+    EXPECT_EQ(&c, &*s.upper_bound(probe));
+    EXPECT_TRUE(s.contains(probe));
+    EXPECT_EQ(0u, s.count(missing));
+
+    std::vector<int> backwards;
+    for (auto it = s.end(); it != s.begin();)
+        backwards.push_back((--it)->key);
+    EXPECT_EQ((std::vector<int>{9, 5, 3, 1}), backwards);
+
+    EXPECT_EQ(&e, &*s.erase(sset::iterator_to(b)));
+    s.erase(c);
+    EXPECT_EQ((std::vector<int>{3, 5}), keys(s));
+    check_invariants(s);
+}
+
+TEST(intrusive_set_testing, multiset_keeps_insertion_order_of_equal_keys)
+{
+    std::vector<std::unique_ptr<snode>> nodes;
+    smultiset s;
+    for (int i = 0; i != 12; ++i)
+    {
+        nodes.push_back(std::make_unique<snode>(i % 3, i));
+        s.insert(*nodes.back());
+    }
+    check_invariants(s);
+
+    EXPECT_EQ(4u, s.count(1));
+    auto range = s.equal_range(1);
+    std::vector<int> ids;
+    for (auto it = range.first; it != range.second; ++it)
+        ids.push_back(it->id);
+    EXPECT_EQ((std::vector<int>{1, 4, 7, 10}), ids);
+
+    EXPECT_EQ(&*nodes[2], &*s.find(2));
+    EXPECT_EQ(nodes[0].get(), &s.front());
+    EXPECT_EQ(nodes[11].get(), &s.back());
+
+    EXPECT_EQ(4u, s.erase_key(1));
+    EXPECT_EQ(0u, s.erase_key(7));
+    EXPECT_EQ((std::vector<int>{0, 0, 0, 0, 2, 2, 2, 2}), keys(s));
+    EXPECT_FALSE(nodes[4]->is_linked());
+    check_invariants(s);
+}
+
+TEST(intrusive_set_testing, random_operations_match_std_multiset)
+{
+    constexpr int n = 3000;
+    auto nodes = std::make_unique<snode[]>(n);
+    smultiset s;
+    std::multiset<int> expected;
+    std::mt19937 rng(7);
+
+    for (int step = 0; step != 20000; ++step)
+    {
+        snode& x = nodes[rng() % n];
+        if (!x.is_linked())
+        {
+            x.key = int(rng() % 500);
+            if (rng() % 2 == 0)
+                s.insert(x);
+            else
+                s.insert_hint(s.lower_bound(int(rng() % 500)), x);
+            expected.insert(x.key);
+        }
+        else
+        {
+            expected.erase(expected.find(x.key));
+            if (rng() % 2 == 0)
+                s.erase(x);
+            else
+                x.unlink();
+        }
+
+        if (step % 1000 == 0)
+        {
+            check_invariants(s);
+            EXPECT_EQ(std::vector<int>(expected.begin(), expected.end()), keys(s));
+        }
+    }
+    check_invariants(s);
+    EXPECT_EQ(std::vector<int>(expected.begin(), expected.end()), keys(s));
+    s.clear();
+}
+
+TEST(intrusive_set_testing, insert_hint)
+{
+    constexpr int n = 1000;
+    auto nodes = std::make_unique<snode[]>(n);
+    sset s;
+    for (int i = 0; i != n; ++i)
+    {
+        nodes[i].key = i;
+        EXPECT_EQ(&nodes[i], &*s.insert_hint(s.end(), nodes[i]));
+    }
+    check_invariants(s);
+    EXPECT_EQ(std::size_t(n), s.size());
+
+    snode dup(500);
+    EXPECT_EQ(&nodes[500], &*s.insert_hint(s.begin(), dup));
+    EXPECT_FALSE(dup.is_linked());
+
+    for (int i = 0; i != n; i += 2)
+        s.erase(nodes[i]);
+    snode wrong(10), right(12), front(-1);
+    EXPECT_EQ(&wrong, &*s.insert_hint(s.end(), wrong));
+    EXPECT_EQ(&right, &*s.insert_hint(sset::iterator_to(nodes[13]), right));
+    EXPECT_EQ(&front, &*s.insert_hint(s.begin(), front));
+    check_invariants(s);
+
+    std::vector<int> head(keys(s));
+    head.resize(8);
+    EXPECT_EQ((std::vector<int>{-1, 1, 3, 5, 7, 9, 10, 11}), head);
+    s.clear();
+
+    smultiset m;
+    snode a(1, 0), b(1, 1), c(1, 2);
+    m.insert(a);
+    m.insert(c);
+    m.insert_hint(smultiset::iterator_to(c), b);
+    std::vector<snode*> order;
+    for (snode& x : m)
+        order.push_back(&x);
+    EXPECT_EQ((std::vector<snode*>{&a, &b, &c}), order);
+}
+
+TEST(intrusive_set_testing, auto_unlink_on_destruction)
+{
+    sset s;
+    snode a(1);
+    {
+        snode b(2), c(3);
+        s.insert(a);
+        s.insert(b);
+        s.insert(c);
+        EXPECT_EQ(3u, s.size());
+    }
+    EXPECT_EQ((std::vector<int>{1}), keys(s));
+    a.unlink();
+    EXPECT_TRUE(s.empty());
+    EXPECT_FALSE(a.is_linked());
+
+    snode d(4);
+    s.insert(d);
+    s.clear();
+    EXPECT_FALSE(d.is_linked());
+}
+
+TEST(intrusive_set_testing, link_modes)
+{
+    struct safe_node : intrusive::set_element<intrusive::default_tag, intrusive::safe_link>
+    {
+        int key = 0;
+        bool operator<(safe_node const& other) const
+        {
+            return key < other.key;
+        }
+    };
+
+    struct normal_node : intrusive::set_element<intrusive::default_tag, intrusive::normal_link>
+    {
+        int key = 0;
+        bool operator<(normal_node const& other) const
+        {
+            return key < other.key;
+        }
+    };
+
+    safe_node sa[5];
+    intrusive::set<safe_node> ss;
+    for (int i = 0; i != 5; ++i)
+    {
+        sa[i].key = 4 - i;
+        ss.insert(sa[i]);
+    }
+    EXPECT_EQ(&sa[4], &*ss.begin());
+    ss.erase(sa[2]);
+    EXPECT_FALSE(sa[2].is_linked());
+    ss.clear();
+    for (safe_node& x : sa)
+        EXPECT_FALSE(x.is_linked());
+
+    normal_node na[5];
+    intrusive::set<normal_node> ns;
+    for (int i = 0; i != 5; ++i)
+    {
+        na[i].key = i;
+        ns.insert_hint(ns.end(), na[i]);
+    }
+    EXPECT_EQ(5u, ns.size());
+    ns.clear();
+    EXPECT_TRUE(ns.empty());
+}
+
+TEST(intrusive_set_testing, move_swap_and_dispose)
+{
+    sset a;
+    snode x(1), y(2), z(3);
+    a.insert(x);
+    a.insert(y);
+
+    sset b(std::move(a));
+    EXPECT_TRUE(a.empty());
+    EXPECT_EQ((std::vector<int>{1, 2}), keys(b));
+    check_invariants(b);
+
+    a.insert(z);
+    a.swap(b);
+    EXPECT_EQ((std::vector<int>{1, 2}), keys(a));
+    EXPECT_EQ((std::vector<int>{3}), keys(b));
+
+    b = std::move(a);
+    EXPECT_EQ((std::vector<int>{1, 2}), keys(b));
+    EXPECT_FALSE(z.is_linked());
+    y.unlink();
+    EXPECT_EQ((std::vector<int>{1}), keys(b));
+    b.clear();
+
+    smultiset heap;
+    for (int i = 0; i != 100; ++i)
+        heap.insert(*new snode(i % 10, i));
+    int disposed = 0;
+    heap.erase_and_dispose(heap.begin(), [&](snode* p) {
+        EXPECT_FALSE(p->is_linked());
+        ++disposed;
+        delete p;
+    });
+    heap.clear_and_dispose([&](snode* p) {
+        EXPECT_FALSE(p->is_linked());
+        ++disposed;
+        delete p;
+    });
+    EXPECT_EQ(100, disposed);
+    EXPECT_TRUE(heap.empty());
+}
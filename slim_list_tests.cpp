@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+#include "intrusive_slim_list.h"
+#include "test_utils.h"
+#include <memory>
+#include <vector>
+
+namespace
+{
+    struct hnode : intrusive::slim_list_element<>
+    {
+        explicit hnode(int value)
+            : value(value)
+        {}
+
+        int value;
+    };
+
+    struct safe_hnode : intrusive::slim_list_element<intrusive::default_tag, intrusive::safe_link>
+    {
+        explicit safe_hnode(int value)
+            : value(value)
+        {}
+
+        int value;
+    };
+
+    using slim = intrusive::slim_list<hnode>;
+    using safe_slim = intrusive::slim_list<safe_hnode>;
+
+    template <typename C>
+    void expect_forward_eq(C& cont, std::initializer_list<int> values)
+    {
+        expect_eq_impl(values.begin(), values.end(), cont.begin(), cont.end());
+    }
+}
+
+TEST(intrusive_slim_list_testing, sizes)
+{
+    EXPECT_EQ(sizeof(void*), sizeof(slim));
+    EXPECT_EQ(2 * sizeof(void*), sizeof(intrusive::slim_list_element<>));
+}
+
+TEST(intrusive_slim_list_testing, push_pop_front)
+{
+    slim list;
+    EXPECT_TRUE(list.empty());
+    EXPECT_TRUE(list.begin() == list.end());
+
+    hnode a(1), b(2), c(3);
+    list.push_front(a);
+    list.push_front(b);
+    list.push_front(c);
+    expect_forward_eq(list, {3, 2, 1});
+    EXPECT_EQ(3u, list.size());
+    EXPECT_EQ(&c, &list.front());
+
+    list.pop_front();
+    EXPECT_FALSE(c.is_linked());
+    expect_forward_eq(list, {2, 1});
+}
+
+TEST(intrusive_slim_list_testing, insert_erase)
+{
+    slim list;
+    hnode a(1), b(2), c(3), d(4);
+    list.insert(list.end(), b);
+    list.insert(list.begin(), a);
+    list.insert_after(slim::iterator_to(b), d);
+    list.insert(slim::iterator_to(d), c);
+    expect_forward_eq(list, {1, 2, 3, 4});
+
+    auto it = list.erase(slim::iterator_to(b));
+    EXPECT_EQ(&c, &*it);
+    expect_forward_eq(list, {1, 3, 4});
+
+    it = list.erase(slim::iterator_to(d));
+    EXPECT_TRUE(it == list.end());
+    list.erase(list.begin());
+    expect_forward_eq(list, {3});
+}
+
+TEST(intrusive_slim_list_testing, auto_unlink)
+{
+    slim list;
+    hnode a(1), c(3);
+    list.push_front(c);
+    {
+        hnode b(2);
+        list.push_front(b);
+        list.push_front(a);
+        expect_forward_eq(list, {1, 2, 3});
+    }
+    expect_forward_eq(list, {1, 3});
+
+    a.unlink();
+    expect_forward_eq(list, {3});
+    c.unlink();
+    EXPECT_TRUE(list.empty());
+}
+
+TEST(intrusive_slim_list_testing, safe_link)
+{
+    safe_slim list;
+    safe_hnode a(1), b(2);
+    list.push_front(a);
+    list.push_front(b);
+    EXPECT_TRUE(a.is_linked());
+
+    list.erase(list.begin());
+    EXPECT_FALSE(b.is_linked());
+    list.clear();
+    EXPECT_FALSE(a.is_linked());
+}
+
+TEST(intrusive_slim_list_testing, move_and_swap)
+{
+    slim a;
+    hnode x(1), y(2), z(3);
+    a.push_front(y);
+    a.push_front(x);
+
+    slim b(std::move(a));
+    EXPECT_TRUE(a.empty());
+    expect_forward_eq(b, {1, 2});
+
+    /*
+    Первый элемент ссылается на голову b: отвязывание должно поменять
+    именно ее.
+    */
+    x.unlink();
+    expect_forward_eq(b, {2});
+
+    slim c;
+    c.push_front(z);
+    c.swap(b);
+    expect_forward_eq(c, {2});
+    expect_forward_eq(b, {3});
+
+    b = std::move(c);
+    expect_forward_eq(b, {2});
+    EXPECT_FALSE(z.is_linked());
+    EXPECT_TRUE(c.empty());
+}
+
+TEST(intrusive_slim_list_testing, array_of_lists)
+{
+    std::vector<slim> buckets(4);
+    std::vector<std::unique_ptr<hnode>> nodes;
+    for (int i = 0; i != 20; ++i)
+    {
+        nodes.push_back(std::make_unique<hnode>(i));
+        buckets[i % 4].push_front(*nodes.back());
+    }
+
+    /*
+    Перевыделение вектора перемещает головы, и элементы должны
+    продолжать на них ссылаться.
+    */
+    buckets.resize(64);
+    for (int i = 0; i < 20; i += 4)
+        nodes[i]->unlink();
+    EXPECT_EQ(0u, buckets[0].size());
+    EXPECT_EQ(5u, buckets[1].size());
+    EXPECT_TRUE(buckets[63].empty());
+}
+
+TEST(intrusive_slim_list_testing, clear_and_dispose)
+{
+    slim list;
+    for (int i = 0; i != 5; ++i)
+        list.push_front(*new hnode(i));
+
+    std::vector<int> disposed;
+    list.clear_and_dispose([&](hnode* p) {
+        EXPECT_FALSE(p->is_linked());
+        disposed.push_back(p->value);
+        delete p;
+    });
+    EXPECT_EQ((std::vector<int>{4, 3, 2, 1, 0}), disposed);
+    EXPECT_TRUE(list.empty());
+}
@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include "intrusive_slist.h"
+#include "test_utils.h"
+#include <vector>
+
+namespace
+{
+    struct snode : intrusive::slist_element<>
+    {
+        explicit snode(int value)
+            : value(value)
+        {}
+
+        int value;
+    };
+
+    using slist = intrusive::slist<snode>;
+    using tail_slist = intrusive::slist<snode, intrusive::default_tag, intrusive::cache_last>;
+    using counted_slist = intrusive::slist<snode, intrusive::default_tag,
+                                           intrusive::cache_last, intrusive::constant_time_size>;
+
+    template <typename C>
+    void expect_forward_eq(C& cont, std::initializer_list<int> values)
+    {
+        expect_eq_impl(values.begin(), values.end(), cont.begin(), cont.end());
+    }
+}
+
+TEST(intrusive_slist_testing, hook_size)
+{
+    EXPECT_EQ(sizeof(void*), sizeof(intrusive::slist_element<>));
+}
+
+TEST(intrusive_slist_testing, default_ctor)
+{
+    slist list;
+    EXPECT_TRUE(list.empty());
+    EXPECT_TRUE(list.begin() == list.end());
+}
+
+TEST(intrusive_slist_testing, push_pop_front)
+{
+    snode a(1), b(2), c(3);
+    slist list;
+    list.push_front(c);
+    list.push_front(b);
+    list.push_front(a);
+    expect_forward_eq(list, {1, 2, 3});
+    EXPECT_EQ(1, list.front().value);
+    EXPECT_EQ(3u, list.size());
+    list.pop_front();
+    EXPECT_FALSE(a.is_linked());
+    expect_forward_eq(list, {2, 3});
+    list.clear();
+    EXPECT_TRUE(list.empty());
+    EXPECT_FALSE(b.is_linked());
+}
+
+TEST(intrusive_slist_testing, push_back_cache_last)
+{
+    snode a(1), b(2), c(3);
+    tail_slist list;
+    mass_push_back(list, a, b);
+    list.push_front(c);
+    expect_forward_eq(list, {3, 1, 2});
+    EXPECT_EQ(2, list.back().value);
+    list.pop_front();
+    list.pop_front();
+    EXPECT_EQ(2, list.back().value);
+    list.pop_front();
+    EXPECT_TRUE(list.empty());
+    list.push_back(c);
+    EXPECT_EQ(3, list.back().value);
+    EXPECT_EQ(3, list.front().value);
+}
+
+TEST(intrusive_slist_testing, insert_erase_after)
+{
+    snode a(1), b(2), c(3), d(4);
+    tail_slist list;
+    mass_push_back(list, a, c);
+    auto it = list.insert_after(list.begin(), b);
+    EXPECT_EQ(2, it->value);
+    list.insert_after(tail_slist::iterator_to(c), d);
+    EXPECT_EQ(4, list.back().value);
+    expect_forward_eq(list, {1, 2, 3, 4});
+
+    it = list.erase_after(list.previous(tail_slist::iterator_to(d)));
+    EXPECT_TRUE(it == list.end());
+    EXPECT_EQ(3, list.back().value);
+    it = list.erase_after(list.before_begin(), tail_slist::iterator_to(c));
+    EXPECT_EQ(3, it->value);
+    expect_forward_eq(list, {3});
+    EXPECT_FALSE(a.is_linked());
+    EXPECT_FALSE(b.is_linked());
+}
+
+TEST(intrusive_slist_testing, splice_after)
+{
+    snode a(1), b(2), c(3), d(4), e(5), f(6);
+    counted_slist c1, c2;
+    mass_push_back(c1, a, b, c);
+    mass_push_back(c2, d, e, f);
+
+    c1.splice_after(c1.begin(), c2, c2.begin(), counted_slist::iterator_to(f));
+    expect_forward_eq(c1, {1, 5, 6, 2, 3});
+    expect_forward_eq(c2, {4});
+    EXPECT_EQ(5u, c1.size());
+    EXPECT_EQ(1u, c2.size());
+    EXPECT_EQ(4, c2.back().value);
+
+    c2.splice_after(counted_slist::iterator_to(d), c1, counted_slist::iterator_to(b), counted_slist::iterator_to(c));
+    expect_forward_eq(c2, {4, 3});
+    EXPECT_EQ(3, c2.back().value);
+    EXPECT_EQ(2, c1.back().value);
+
+    c1.splice_after(c1.before_begin(), c2);
+    expect_forward_eq(c1, {4, 3, 1, 5, 6, 2});
+    EXPECT_TRUE(c2.empty());
+    EXPECT_EQ(6u, c1.size());
+    EXPECT_EQ(2, c1.back().value);
+}
+
+TEST(intrusive_slist_testing, splice_after_uncached)
+{
+    snode a(1), b(2), c(3), d(4);
+    slist c1, c2;
+    c1.push_front(b);
+    c1.push_front(a);
+    c2.push_front(d);
+    c2.push_front(c);
+    c1.splice_after(c1.begin(), c2);
+    expect_forward_eq(c1, {1, 3, 4, 2});
+    EXPECT_TRUE(c2.empty());
+}
+
+TEST(intrusive_slist_testing, move)
+{
+    snode a(1), b(2), c(3);
+    tail_slist list1;
+    mass_push_back(list1, a, b);
+    tail_slist list2 = std::move(list1);
+    EXPECT_TRUE(list1.empty());
+    expect_forward_eq(list2, {1, 2});
+    list2.push_back(c);
+    expect_forward_eq(list2, {1, 2, 3});
+
+    tail_slist list3;
+    list3 = std::move(list2);
+    expect_forward_eq(list3, {1, 2, 3});
+    EXPECT_EQ(3, list3.back().value);
+    EXPECT_TRUE(list2.empty());
+}
+
+TEST(intrusive_slist_testing, clear_and_dispose)
+{
+    slist list;
+    for (int i = 3; i != 0; --i)
+        list.push_front(*new snode(i));
+    std::vector<int> disposed;
+    list.clear_and_dispose([&](snode* p) {
+        disposed.push_back(p->value);
+        delete p;
+    });
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), disposed);
+}
+
+TEST(intrusive_slist_testing, multiple_tags)
+{
+    struct multi : intrusive::slist_element<struct stag_a>, intrusive::slist_element<struct stag_b>,
+                   intrusive::list_element<>
+    {
+        explicit multi(int value)
+            : value(value)
+        {}
+
+        int value;
+    };
+
+    multi x(1), y(2);
+    intrusive::slist<multi, stag_a> a;
+    intrusive::slist<multi, stag_b> b;
+    intrusive::list<multi> l;
+    a.push_front(y);
+    a.push_front(x);
+    b.push_front(x);
+    b.push_front(y);
+    l.push_back(x);
+    expect_forward_eq(a, {1, 2});
+    expect_forward_eq(b, {2, 1});
+    expect_forward_eq(l, {1});
+    a.clear();
+    b.clear();
+}
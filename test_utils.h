@@ -1,6 +1,37 @@
 #pragma once
 
 #include <gtest/gtest.h>
+#include "intrusive_list.h"
+#include <cstddef>
+#include <memory>
+
+/*
+Если определен INTRUSIVE_LIST_TESTING_INDEX_LINK, тесты main.cpp
+собираются с хуками index_link. Все ноды и списки должны лежать в
+арене, поэтому index_link_testing.cpp раздает из нее память через
+operator new и запускает тесты в потоке, стек которого тоже в арене.
+
+С INTRUSIVE_LIST_TESTING_OFFSET_LINK те же тесты собираются с хуками
+offset_link. Им арена не нужна: ссылки считаются от самих хуков.
+*/
+#ifdef INTRUSIVE_LIST_TESTING_INDEX_LINK
+#include "intrusive_index_link.h"
+
+struct testing_arena
+{
+    static char* base() noexcept;
+};
+
+using test_link = intrusive::index_link<testing_arena>;
+
+int run_all_tests_in_arena();
+#elif defined(INTRUSIVE_LIST_TESTING_OFFSET_LINK)
+#include "intrusive_offset_link.h"
+
+using test_link = intrusive::offset_link;
+#else
+using test_link = intrusive::pointer_link;
+#endif
 
 template <typename C>
 void mass_push_back(C&)
@@ -13,6 +44,28 @@ void mass_push_back(C& cont, Element& element, Elements& ...elements)
     mass_push_back(cont, elements...);
 }
 
+/*
+n нод со значениями 0, 1, ..., n - 1. Вариант со списком сразу кладет
+их в конец list.
+*/
+template <typename Node>
+std::unique_ptr<Node[]> make_nodes(std::size_t n)
+{
+    auto nodes = std::make_unique<Node[]>(n);
+    for (std::size_t i = 0; i != n; ++i)
+        nodes[i].value = int(i);
+    return nodes;
+}
+
+template <typename List>
+std::unique_ptr<typename List::iterator::value_type[]> make_nodes(List& list, std::size_t n)
+{
+    auto nodes = make_nodes<typename List::iterator::value_type>(n);
+    for (std::size_t i = 0; i != n; ++i)
+        list.push_back(nodes[i]);
+    return nodes;
+}
+
 template <typename E, typename A>
 void expect_eq_impl(E expected_first, E expected_last, A actual_first, A actual_last)
 {
@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include "intrusive_timer_wheel.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+    struct timer : intrusive::timer_wheel_element<>
+    {
+        explicit timer(int id = 0)
+            : id(id)
+        {}
+
+        int id;
+    };
+
+    using wheel = intrusive::timer_wheel<timer>;
+
+    std::vector<int> ids(wheel::list_type& expired)
+    {
+        std::vector<int> result;
+        while (!expired.empty())
+        {
+            result.push_back(expired.front().id);
+            expired.pop_front();
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+}
+
+TEST(intrusive_timer_wheel_testing, fires_at_deadline)
+{
+    wheel w(100);
+    EXPECT_EQ(100u, w.now());
+
+    timer a(1), b(2), c(3), d(4);
+    w.schedule(a, 101);
+    w.schedule(b, 105);
+    w.schedule(c, 100 + 300);
+    w.schedule(d, 100 + 70000);
+    EXPECT_TRUE(wheel::is_scheduled(a));
+    EXPECT_EQ(105u, b.expires());
+
+    for (std::uint64_t t = 101; t <= 100 + 70000; ++t)
+    {
+        auto expired = w.advance(t);
+        std::vector<int> got = ids(expired);
+        if (t == 101)
+            EXPECT_EQ((std::vector<int>{1}), got);
+        else if (t == 105)
+            EXPECT_EQ((std::vector<int>{2}), got);
+        else if (t == 400)
+            EXPECT_EQ((std::vector<int>{3}), got);
+        else if (t == 70100)
+            EXPECT_EQ((std::vector<int>{4}), got);
+        else
+            ASSERT_TRUE(got.empty()) << t;
+    }
+    EXPECT_EQ(70100u, w.now());
+    EXPECT_FALSE(wheel::is_scheduled(d));
+}
+
+TEST(intrusive_timer_wheel_testing, cancel_and_destroy)
+{
+    wheel w;
+    timer a(1), b(2);
+    w.schedule(a, 10);
+    w.schedule(b, 1000);
+    {
+        timer c(3);
+        w.schedule(c, 500);
+    }
+    wheel::cancel(a);
+    wheel::cancel(a);
+    EXPECT_FALSE(wheel::is_scheduled(a));
+
+    auto expired = w.advance(2000);
+    EXPECT_EQ((std::vector<int>{2}), ids(expired));
+}
+
+TEST(intrusive_timer_wheel_testing, reschedule)
+{
+    wheel w;
+    timer a(1), b(2);
+    w.schedule(a, 50);
+    w.schedule(b, 60);
+    w.schedule(a, 5000);
+    w.schedule(b, 20);
+
+    auto expired = w.advance(100);
+    EXPECT_EQ((std::vector<int>{2}), ids(expired));
+    expired = w.advance(4999);
+    EXPECT_TRUE(expired.empty());
+    expired = w.advance(5000);
+    EXPECT_EQ((std::vector<int>{1}), ids(expired));
+}
+
+TEST(intrusive_timer_wheel_testing, past_deadline_fires_next)
+{
+    wheel w(1000);
+    timer a(1), b(2);
+    w.schedule(a, 10);
+    w.schedule(b, 1000);
+    auto expired = w.advance(1001);
+    EXPECT_EQ((std::vector<int>{1, 2}), ids(expired));
+}
+
+TEST(intrusive_timer_wheel_testing, expired_batch_is_a_list)
+{
+    wheel w;
+    timer a(1), b(2), c(3);
+    w.schedule(a, 3);
+    w.schedule(b, 3);
+    w.schedule(c, 4);
+
+    auto expired = w.advance(10);
+    EXPECT_EQ(3u, expired.size());
+
+    /*
+    Пока таймер лежит в результате, его можно отменить или снова
+    запланировать.
+    */
+    wheel::cancel(b);
+    w.schedule(c, 20);
+    EXPECT_EQ(1u, expired.size());
+    EXPECT_EQ(&a, &expired.front());
+
+    expired = w.advance(20);
+    EXPECT_EQ((std::vector<int>{3}), ids(expired));
+}
+
+TEST(intrusive_timer_wheel_testing, random_deadlines)
+{
+    constexpr int count = 5000;
+    constexpr std::uint64_t horizon = std::uint64_t(1) << 20;
+
+    std::mt19937_64 rng(17);
+    wheel w(12345);
+    std::vector<std::unique_ptr<timer>> timers;
+    for (int i = 0; i != count; ++i)
+    {
+        timers.push_back(std::make_unique<timer>(i));
+        w.schedule(*timers.back(), w.now() + 1 + rng() % horizon);
+    }
+
+    /*
+    Каждый десятый таймер отменяется, каждый десятый перепланируется.
+    */
+    for (int i = 0; i < count; i += 10)
+        wheel::cancel(*timers[i]);
+    for (int i = 5; i < count; i += 10)
+        w.schedule(*timers[i], w.now() + 1 + rng() % horizon);
+
+    int fired = 0;
+    while (w.now() < 12345 + horizon)
+    {
+        std::uint64_t from = w.now();
+        auto expired = w.advance(from + 1 + rng() % 3000);
+        while (!expired.empty())
+        {
+            timer& t = expired.front();
+            expired.pop_front();
+            ASSERT_NE(0, t.id % 10);
+            ASSERT_GT(t.expires(), from);
+            ASSERT_LE(t.expires(), w.now());
+            ++fired;
+        }
+    }
+    EXPECT_EQ(count - count / 10, fired);
+}
+
+TEST(intrusive_timer_wheel_testing, one_long_advance)
+{
+    wheel w;
+    std::vector<std::unique_ptr<timer>> timers;
+    for (int i = 0; i != 64; ++i)
+    {
+        timers.push_back(std::make_unique<timer>(i));
+        w.schedule(*timers.back(), std::uint64_t(1) << (i % 30));
+    }
+    timer far(100);
+    w.schedule(far, std::uint64_t(1) << 40);
+
+    auto expired = w.advance(std::uint64_t(1) << 29);
+    EXPECT_EQ(64u, expired.size());
+    EXPECT_TRUE(wheel::is_scheduled(far));
+    EXPECT_EQ(std::uint64_t(1) << 29, w.now());
+}
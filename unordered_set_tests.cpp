@@ -0,0 +1,286 @@
+#include <gtest/gtest.h>
+#include "intrusive_unordered_set.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct unode : intrusive::unordered_set_element<>
+    {
+        explicit unode(int value)
+            : value(value)
+        {}
+
+        int value;
+    };
+
+    struct unode_hash
+    {
+        std::size_t operator()(unode const& x) const noexcept
+        {
+            ++calls;
+            return std::size_t(x.value);
+        }
+
+        static inline int calls = 0;
+    };
+
+    struct unode_eq
+    {
+        bool operator()(unode const& a, unode const& b) const noexcept
+        {
+            return a.value == b.value;
+        }
+    };
+
+    struct hashed_node : intrusive::unordered_set_element<intrusive::default_tag, intrusive::store_hash>
+    {
+        explicit hashed_node(int value)
+            : value(value)
+        {}
+
+        int value;
+    };
+
+    struct hashed_node_hash
+    {
+        std::size_t operator()(hashed_node const& x) const noexcept
+        {
+            ++calls;
+            return std::size_t(x.value);
+        }
+
+        static inline int calls = 0;
+    };
+
+    struct hashed_node_eq
+    {
+        bool operator()(hashed_node const& a, hashed_node const& b) const noexcept
+        {
+            return a.value == b.value;
+        }
+    };
+
+    using uset = intrusive::unordered_set<unode, intrusive::default_tag, unode_hash, unode_eq>;
+    using hashed_uset = intrusive::unordered_set<hashed_node, intrusive::default_tag, hashed_node_hash, hashed_node_eq>;
+
+    template <typename Set>
+    std::vector<int> sorted_values(Set& s)
+    {
+        std::vector<int> result;
+        for (auto& x : s)
+            result.push_back(x.value);
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+}
+
+TEST(intrusive_unordered_set_testing, hook_size)
+{
+    EXPECT_EQ(sizeof(void*), sizeof(intrusive::unordered_set_element<>));
+    EXPECT_EQ(2 * sizeof(void*), (sizeof(intrusive::unordered_set_element<intrusive::default_tag, intrusive::store_hash>)));
+}
+
+TEST(intrusive_unordered_set_testing, insert_find_erase)
+{
+    uset s;
+    EXPECT_TRUE(s.empty());
+    EXPECT_TRUE(s.begin() == s.end());
+
+    unode a(1), b(2), c(3), dup(2);
+    EXPECT_TRUE(s.insert(a).second);
+    EXPECT_TRUE(s.insert(b).second);
+    EXPECT_TRUE(s.insert(c).second);
+
+    auto r = s.insert(dup);
+    EXPECT_FALSE(r.second);
+    EXPECT_EQ(&b, &*r.first);
+    EXPECT_FALSE(dup.is_linked());
+    EXPECT_EQ(3u, s.size());
+
+    EXPECT_EQ(&c, &*s.find(unode(3)));
+    EXPECT_TRUE(s.find(unode(4)) == s.end());
+    EXPECT_TRUE(s.contains(unode(1)));
+
+    s.erase(b);
+    EXPECT_FALSE(b.is_linked());
+    EXPECT_FALSE(s.contains(unode(2)));
+    EXPECT_EQ((std::vector<int>{1, 3}), sorted_values(s));
+    s.clear();
+    EXPECT_FALSE(a.is_linked());
+    EXPECT_TRUE(s.empty());
+}
+
+TEST(intrusive_unordered_set_testing, heterogeneous_find)
+{
+    uset s;
+    unode a(10), b(20);
+    s.insert(a);
+    s.insert(b);
+
+    auto it = s.find(20, [](int key) { return std::size_t(key); },
+        [](unode const& x, int key) { return x.value == key; });
+    EXPECT_EQ(&b, &*it);
+    s.clear();
+}
+
+TEST(intrusive_unordered_set_testing, erase_iterator)
+{
+    uset s(1);
+    std::vector<std::unique_ptr<unode>> nodes;
+    for (int i = 0; i != 20; ++i)
+    {
+        nodes.push_back(std::make_unique<unode>(i));
+        s.insert(*nodes.back());
+    }
+
+    for (auto it = s.begin(); it != s.end();)
+    {
+        if (it->value % 2 == 0)
+            it = s.erase(it);
+        else
+            ++it;
+    }
+    EXPECT_EQ((std::vector<int>{1, 3, 5, 7, 9, 11, 13, 15, 17, 19}), sorted_values(s));
+    s.clear();
+}
+
+TEST(intrusive_unordered_set_testing, incremental_growth)
+{
+    constexpr int count = 10000;
+    uset s(4);
+    std::vector<std::unique_ptr<unode>> nodes;
+    std::size_t buckets = s.bucket_count();
+    for (int i = 0; i != count; ++i)
+    {
+        nodes.push_back(std::make_unique<unode>(i * 7919));
+        EXPECT_TRUE(s.insert(*nodes.back()).second);
+
+        /*
+        Вставка делит не больше одного бакета.
+        */
+        EXPECT_LE(s.bucket_count(), buckets + 1);
+        buckets = s.bucket_count();
+        EXPECT_LE(s.load_factor(), 1.f);
+    }
+
+    EXPECT_EQ(std::size_t(count), s.size());
+    for (int i = 0; i != count; ++i)
+        ASSERT_TRUE(s.contains(unode(i * 7919))) << i;
+
+    std::size_t visited = 0;
+    for (unode& x : s)
+    {
+        (void)x;
+        ++visited;
+    }
+    EXPECT_EQ(std::size_t(count), visited);
+
+    for (int i = 0; i < count; i += 2)
+        s.erase(*nodes[i]);
+    for (int i = 0; i != count; ++i)
+        ASSERT_EQ(i % 2 != 0, s.contains(unode(i * 7919))) << i;
+    s.clear();
+}
+
+TEST(intrusive_unordered_set_testing, store_hash_skips_hash_on_split)
+{
+    constexpr int count = 1000;
+    hashed_uset s(1);
+    std::vector<std::unique_ptr<hashed_node>> nodes;
+
+    hashed_node_hash::calls = 0;
+    for (int i = 0; i != count; ++i)
+    {
+        nodes.push_back(std::make_unique<hashed_node>(i));
+        s.insert(*nodes.back());
+    }
+    for (auto& n : nodes)
+        s.erase(*n);
+    EXPECT_EQ(count, hashed_node_hash::calls);
+    EXPECT_TRUE(s.empty());
+
+    unode_hash::calls = 0;
+    {
+        uset plain(1);
+        std::vector<std::unique_ptr<unode>> plain_nodes;
+        for (int i = 0; i != count; ++i)
+        {
+            plain_nodes.push_back(std::make_unique<unode>(i));
+            plain.insert(*plain_nodes.back());
+        }
+        plain.clear();
+    }
+    EXPECT_GT(unode_hash::calls, count);
+}
+
+TEST(intrusive_unordered_set_testing, clear_and_dispose)
+{
+    uset s;
+    for (int i = 0; i != 50; ++i)
+        s.insert(*new unode(i));
+
+    int disposed = 0;
+    s.clear_and_dispose([&](unode* p) {
+        EXPECT_FALSE(p->is_linked());
+        delete p;
+        ++disposed;
+    });
+    EXPECT_EQ(50, disposed);
+    EXPECT_TRUE(s.empty());
+    EXPECT_TRUE(s.begin() == s.end());
+}
+
+TEST(intrusive_unordered_set_testing, with_lru_list)
+{
+    struct lru_tag;
+    struct index_tag;
+
+    struct entry : intrusive::list_element<lru_tag>, intrusive::unordered_set_element<index_tag>
+    {
+        explicit entry(std::string key)
+            : key(std::move(key))
+        {}
+
+        std::string key;
+    };
+
+    struct entry_hash
+    {
+        std::size_t operator()(entry const& e) const noexcept
+        {
+            return std::hash<std::string>{}(e.key);
+        }
+    };
+
+    struct entry_eq
+    {
+        bool operator()(entry const& a, entry const& b) const noexcept
+        {
+            return a.key == b.key;
+        }
+    };
+
+    intrusive::list<entry, lru_tag> lru;
+    intrusive::unordered_set<entry, index_tag, entry_hash, entry_eq> index;
+    entry a("a"), b("b"), c("c");
+    for (entry* e : {&a, &b, &c})
+    {
+        index.insert(*e);
+        lru.push_front(*e);
+    }
+
+    entry& hit = *index.find(entry("a"));
+    lru.erase(lru.iterator_to(hit));
+    lru.push_front(hit);
+    EXPECT_EQ(&a, &lru.front());
+    EXPECT_EQ(&b, &lru.back());
+
+    index.erase(lru.back());
+    lru.pop_back();
+    EXPECT_FALSE(index.contains(entry("b")));
+    EXPECT_EQ(2u, index.size());
+    index.clear();
+}
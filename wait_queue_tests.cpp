@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+#include "intrusive_wait_queue.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <vector>
+
+/*
+Счетчик глобальных аллокаций, чтобы проверить, что ожидание и
+notify ничего не аллоцируют. Кадры корутин аллоцируются до замера.
+*/
+namespace
+{
+    std::atomic<std::size_t> allocations{0};
+}
+
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size != 0 ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+    /*
+    Корутина, которая начинает выполняться сразу и остается
+    приостановленной в конце, пока task не разрушится.
+    */
+    struct task
+    {
+        struct promise_type
+        {
+            task get_return_object() noexcept
+            {
+                return task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            std::suspend_never initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            std::suspend_always final_suspend() noexcept
+            {
+                return {};
+            }
+
+            void return_void() noexcept {}
+
+            void unhandled_exception()
+            {
+                std::terminate();
+            }
+        };
+
+        explicit task(std::coroutine_handle<promise_type> h) noexcept
+            : handle(h)
+        {}
+
+        task(task&& other) noexcept
+            : handle(std::exchange(other.handle, nullptr))
+        {}
+
+        ~task()
+        {
+            if (handle)
+                handle.destroy();
+        }
+
+        bool done() const noexcept
+        {
+            return handle.done();
+        }
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    task wait_times(intrusive::wait_queue& queue, int id, int times, std::vector<int>& log)
+    {
+        for (int i = 0; i != times; ++i)
+        {
+            co_await queue.wait();
+            log.push_back(id);
+        }
+    }
+}
+
+TEST(intrusive_wait_queue_testing, notify_one_in_fifo_order)
+{
+    intrusive::wait_queue queue;
+    intrusive::wait_queue::ready_list ready;
+    std::vector<int> log;
+
+    std::vector<task> tasks;
+    for (int id = 0; id != 3; ++id)
+        tasks.push_back(wait_times(queue, id, 1, log));
+    EXPECT_FALSE(queue.empty());
+    EXPECT_TRUE(log.empty());
+
+    EXPECT_TRUE(queue.notify_one(ready));
+    EXPECT_TRUE(queue.notify_one(ready));
+    EXPECT_TRUE(log.empty());
+    intrusive::resume_all(ready);
+    EXPECT_EQ((std::vector<int>{0, 1}), log);
+    EXPECT_TRUE(tasks[0].done());
+    EXPECT_FALSE(tasks[2].done());
+
+    EXPECT_TRUE(queue.notify_one(ready));
+    EXPECT_FALSE(queue.notify_one(ready));
+    EXPECT_TRUE(queue.empty());
+    intrusive::resume_all(ready);
+    EXPECT_EQ((std::vector<int>{0, 1, 2}), log);
+}
+
+TEST(intrusive_wait_queue_testing, notify_all_moves_every_waiter)
+{
+    intrusive::wait_queue queue;
+    intrusive::wait_queue::ready_list ready;
+    std::vector<int> log;
+
+    std::vector<task> tasks;
+    for (int id = 0; id != 4; ++id)
+        tasks.push_back(wait_times(queue, id, 2, log));
+
+    queue.notify_all(ready);
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(4, std::distance(ready.begin(), ready.end()));
+
+    /*
+    Каждая корутина сразу встает в очередь снова, в ready она уже не
+    попадает.
+    */
+    intrusive::resume_all(ready);
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3}), log);
+    EXPECT_FALSE(queue.empty());
+
+    queue.notify_all(ready);
+    intrusive::resume_all(ready);
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 0, 1, 2, 3}), log);
+    for (task const& t : tasks)
+        EXPECT_TRUE(t.done());
+}
+
+TEST(intrusive_wait_queue_testing, destroying_waiter_unlinks_it)
+{
+    intrusive::wait_queue queue;
+    intrusive::wait_queue::ready_list ready;
+    std::vector<int> log;
+
+    {
+        task a = wait_times(queue, 0, 1, log);
+        task b = wait_times(queue, 1, 1, log);
+        task c = wait_times(queue, 2, 1, log);
+        a.handle.destroy();
+        a.handle = nullptr;
+
+        queue.notify_one(ready);
+        queue.notify_one(ready);
+        EXPECT_TRUE(queue.empty());
+        EXPECT_EQ(2, std::distance(ready.begin(), ready.end()));
+    }
+
+    EXPECT_TRUE(ready.empty());
+    intrusive::resume_all(ready);
+    EXPECT_TRUE(log.empty());
+}
+
+TEST(intrusive_wait_queue_testing, wait_and_notify_do_not_allocate)
+{
+    intrusive::wait_queue queue;
+    intrusive::wait_queue::ready_list ready;
+    std::vector<int> log;
+    log.reserve(1000);
+
+    std::vector<task> tasks;
+    for (int id = 0; id != 10; ++id)
+        tasks.push_back(wait_times(queue, id, 100, log));
+
+    std::size_t before = allocations.load();
+    for (int round = 0; round != 100; ++round)
+    {
+        if (round % 2 == 0)
+            queue.notify_all(ready);
+        else
+            while (queue.notify_one(ready))
+            {}
+        intrusive::resume_all(ready);
+    }
+    EXPECT_EQ(before, allocations.load());
+    EXPECT_EQ(1000u, log.size());
+}
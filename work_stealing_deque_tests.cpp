@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include "intrusive_work_stealing_deque.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct ready_tag;
+
+    struct task : intrusive::list_element<ready_tag>
+    {
+        explicit task(int value = 0)
+            : value(value)
+        {}
+
+        int value;
+        std::atomic<int> runs{0};
+    };
+
+    using deque = intrusive::work_stealing_deque<task, ready_tag>;
+
+    std::vector<int> pop_all(deque& d)
+    {
+        std::vector<int> result;
+        while (task* t = d.pop())
+            result.push_back(t->value);
+        return result;
+    }
+}
+
+TEST(intrusive_work_stealing_deque_testing, push_pop_lifo)
+{
+    deque d;
+    EXPECT_TRUE(d.empty());
+    EXPECT_EQ(nullptr, d.pop());
+
+    task a(1), b(2), c(3);
+    d.push(a);
+    d.push(b);
+    d.push(c);
+    EXPECT_EQ(3u, d.size());
+    EXPECT_TRUE(b.is_linked());
+
+    EXPECT_EQ(&c, d.pop());
+    EXPECT_FALSE(c.is_linked());
+    EXPECT_EQ((std::vector<int>{2, 1}), pop_all(d));
+    EXPECT_TRUE(d.empty());
+}
+
+TEST(intrusive_work_stealing_deque_testing, steal_takes_oldest_half)
+{
+    deque victim, thief;
+    std::vector<std::unique_ptr<task>> tasks;
+    for (int i = 0; i != 5; ++i)
+    {
+        tasks.push_back(std::make_unique<task>(i));
+        victim.push(*tasks.back());
+    }
+
+    task* t = thief.steal_from(victim);
+    ASSERT_NE(nullptr, t);
+    EXPECT_EQ(0, t->value);
+    EXPECT_FALSE(t->is_linked());
+    EXPECT_EQ(2u, thief.size());
+    EXPECT_EQ(2u, victim.size());
+
+    EXPECT_EQ((std::vector<int>{2, 1}), pop_all(thief));
+    EXPECT_EQ((std::vector<int>{4, 3}), pop_all(victim));
+}
+
+TEST(intrusive_work_stealing_deque_testing, steal_single_and_empty)
+{
+    deque victim, thief;
+    EXPECT_EQ(nullptr, thief.steal_from(victim));
+
+    task a(1);
+    victim.push(a);
+    EXPECT_EQ(&a, thief.steal_from(victim));
+    EXPECT_TRUE(victim.empty());
+    EXPECT_TRUE(thief.empty());
+    EXPECT_EQ(nullptr, thief.steal_from(victim));
+}
+
+TEST(intrusive_work_stealing_deque_testing, destructor_unlinks)
+{
+    task a(1), b(2);
+    {
+        deque d;
+        d.push(a);
+        d.push(b);
+    }
+    EXPECT_FALSE(a.is_linked());
+    EXPECT_FALSE(b.is_linked());
+}
+
+TEST(intrusive_work_stealing_deque_testing, every_task_runs_once)
+{
+    constexpr int workers = 4;
+    constexpr int count = 20000;
+
+    std::vector<std::unique_ptr<task>> tasks;
+    for (int i = 0; i != count; ++i)
+        tasks.push_back(std::make_unique<task>(i));
+
+    std::vector<deque> deques(workers);
+    std::atomic<int> done{0};
+    std::atomic<bool> go{false};
+
+    std::vector<std::thread> threads;
+    for (int w = 0; w != workers; ++w)
+        threads.emplace_back([&, w] {
+            deque& own = deques[w];
+            while (!go.load())
+                std::this_thread::yield();
+
+            /*
+            Все задачи рождаются у worker'а 0, остальные получают их
+            только воровством.
+            */
+            if (w == 0)
+                for (auto& t : tasks)
+                    own.push(*t);
+
+            while (done.load() != count)
+            {
+                task* t = own.pop();
+                for (int v = 1; t == nullptr && v != workers; ++v)
+                    t = own.steal_from(deques[(w + v) % workers]);
+                if (t == nullptr)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                t->runs.fetch_add(1);
+                done.fetch_add(1);
+            }
+        });
+
+    go.store(true);
+    for (auto& t : threads)
+        t.join();
+
+    for (auto& t : tasks)
+        EXPECT_EQ(1, t->runs.load());
+    for (auto& d : deques)
+        EXPECT_TRUE(d.empty());
+}